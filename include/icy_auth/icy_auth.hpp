@@ -3,6 +3,7 @@
 #include <icy_engine/core/icy_string.hpp>
 #include <icy_engine/core/icy_json.hpp>
 #include <icy_engine/core/icy_event.hpp>
+#include <icy_engine/core/icy_future.hpp>
 #include <icy_engine/utility/icy_crypto.hpp>
 #include <cstdint>
 
@@ -243,6 +244,9 @@ namespace icy
         virtual error_type connect(const string_view hostname, const duration_type timeout) noexcept = 0;
         virtual error_type client_create(const guid guid, const uint64_t username, const crypto_key& password) noexcept = 0;
         virtual error_type client_ticket(const guid guid, const uint64_t username, const crypto_key& password) noexcept = 0;
+        //  request / response: the result completes "future" on the auth thread instead of
+        //  being broadcast as "auth_event_type" to every subscriber
+        virtual error_type client_ticket(const guid guid, const uint64_t username, const crypto_key& password, future<auth_event>& future) noexcept = 0;
         virtual error_type client_connect(const guid guid, const uint64_t username, const crypto_key& password, const uint64_t module, const crypto_msg<auth_client_ticket_server>& encrypted_server_ticket) noexcept = 0;
         virtual error_type module_create(const guid guid, const uint64_t module) noexcept = 0;
         virtual error_type module_update(const guid guid, const uint64_t module, const string_view address, const auth_clock::duration timeout, const crypto_key& password) noexcept = 0;
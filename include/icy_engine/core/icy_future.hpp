@@ -0,0 +1,268 @@
+#pragma once
+
+#include "icy_event.hpp"
+
+#if defined(__cpp_impl_coroutine)
+#include <coroutine>
+#define ICY_COROUTINE 1
+#elif defined(_RESUMABLE_FUNCTIONS_SUPPORTED)
+#include <experimental/coroutine>
+#define ICY_COROUTINE 1
+#define ICY_COROUTINE_EXPERIMENTAL 1
+#endif
+
+namespace icy
+{
+#if ICY_COROUTINE
+    namespace detail
+    {
+#if ICY_COROUTINE_EXPERIMENTAL
+        using std::experimental::coroutine_handle;
+        using std::experimental::suspend_never;
+#else
+        using std::coroutine_handle;
+        using std::suspend_never;
+#endif
+    }
+#endif
+
+    template<typename T> class future;
+    template<typename T> class promise;
+
+    namespace detail
+    {
+        //  shared by one promise and one future; "m_state" is pending, ready or the address of the listener
+        template<typename T>
+        class future_state
+        {
+            friend future<T>;
+            friend promise<T>;
+            enum : uintptr_t
+            {
+                pending,
+                ready,
+            };
+            struct listener_type
+            {
+                void(*func)(void* user) = nullptr;
+                void* user = nullptr;
+            };
+        private:
+            future_state() noexcept = default;
+            void release() noexcept
+            {
+                if (m_ref.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                {
+                    allocator_type::destroy(this);
+                    allocator_type::deallocate(this);
+                }
+            }
+            void complete() noexcept
+            {
+                const auto prev = m_state.exchange(ready, std::memory_order_acq_rel);
+                if (prev != pending && prev != ready)
+                    m_listener.func(m_listener.user);
+            }
+            //  false: already complete, "func" is not called
+            bool listen(void(*func)(void*), void* const user) noexcept
+            {
+                m_listener.func = func;
+                m_listener.user = user;
+                auto expected = uintptr_t(pending);
+                return m_state.compare_exchange_strong(expected, reinterpret_cast<uintptr_t>(&m_listener), std::memory_order_acq_rel);
+            }
+            //  false: completion is already running the listener
+            bool unlisten() noexcept
+            {
+                auto expected = reinterpret_cast<uintptr_t>(&m_listener);
+                return m_state.compare_exchange_strong(expected, pending, std::memory_order_acq_rel);
+            }
+        private:
+            std::atomic<uint32_t> m_ref = 2;
+            std::atomic<uintptr_t> m_state = pending;
+            listener_type m_listener;
+            error_type m_error;
+            T m_value;
+        };
+    }
+
+    //  one-shot result of an asynchronous request, completed by the system that served it
+    //  (no event broadcast); "then" continues on the completing thread, "wait" blocks
+    template<typename T>
+    class future
+    {
+        friend promise<T>;
+        using state_type = detail::future_state<T>;
+    public:
+        future() noexcept = default;
+        future(const future&) = delete;
+        future(future&& rhs) noexcept : m_state(rhs.m_state)
+        {
+            rhs.m_state = nullptr;
+        }
+        ICY_DEFAULT_MOVE_ASSIGN(future);
+        ~future() noexcept
+        {
+            if (m_state)
+                m_state->release();
+        }
+        explicit operator bool() const noexcept
+        {
+            return !!m_state;
+        }
+        bool ready() const noexcept
+        {
+            return m_state && m_state->m_state.load(std::memory_order_acquire) == state_type::ready;
+        }
+        //  "func(user)" runs once: right away if ready, else on the thread completing the promise.
+        //  only one continuation (or "wait" / "co_await") per future
+        void then(void(*func)(void* user), void* const user) noexcept
+        {
+            if (m_state && !m_state->listen(func, user))
+                func(user);
+        }
+        error_type wait(const duration_type timeout = max_timeout) noexcept
+        {
+            if (!m_state)
+                return make_stdlib_error(std::errc::invalid_argument);
+            if (ready())
+                return error_type();
+
+            sync_handle sync;
+            ICY_ERROR(sync.initialize());
+            if (!m_state->listen([](void* user) { static_cast<sync_handle*>(user)->wake(); }, &sync))
+                return error_type();
+
+            if (const auto error = sync.wait(timeout))
+            {
+                if (m_state->unlisten())
+                    return error;
+                //  lost the race: the listener is running and "sync" must outlive it
+                ICY_ERROR(sync.wait());
+            }
+            return error_type();
+        }
+        //  moves the result out once ready; returns the error reported by the producer
+        error_type get(T& value) noexcept
+        {
+            if (!ready())
+                return make_stdlib_error(std::errc::operation_would_block);
+            if (m_state->m_error)
+                return m_state->m_error;
+            value = std::move(m_state->m_value);
+            return error_type();
+        }
+#if ICY_COROUTINE
+        //  "const auto error = co_await future;" resumes on the completing thread, then "get"
+        bool await_ready() const noexcept
+        {
+            return !m_state || ready();
+        }
+        //  false when the result arrived meanwhile: the coroutine goes on without being resumed
+        //  from inside "await_suspend" (no stack growth in a loop over completed futures)
+        bool await_suspend(detail::coroutine_handle<> handle) noexcept
+        {
+            return m_state && m_state->listen([](void* user) { detail::coroutine_handle<>::from_address(user).resume(); }, handle.address());
+        }
+        error_type await_resume() const noexcept
+        {
+            if (!m_state)
+                return make_stdlib_error(std::errc::invalid_argument);
+            return m_state->m_error;
+        }
+#endif
+    private:
+        state_type* m_state = nullptr;
+    };
+
+    //  producer side: dropping an unfulfilled promise completes the future with "operation_canceled"
+    template<typename T>
+    class promise
+    {
+        using state_type = detail::future_state<T>;
+    public:
+        promise() noexcept = default;
+        promise(const promise&) = delete;
+        promise(promise&& rhs) noexcept : m_state(rhs.m_state)
+        {
+            rhs.m_state = nullptr;
+        }
+        ICY_DEFAULT_MOVE_ASSIGN(promise);
+        ~promise() noexcept
+        {
+            if (m_state)
+                set_error(make_stdlib_error(std::errc::operation_canceled));
+        }
+        explicit operator bool() const noexcept
+        {
+            return !!m_state;
+        }
+        error_type initialize(future<T>& future) noexcept
+        {
+            auto new_state = allocator_type::allocate<state_type>(1);
+            if (!new_state)
+                return make_stdlib_error(std::errc::not_enough_memory);
+            new (new_state) state_type;
+            *this = promise();
+            future = icy::future<T>();
+            m_state = new_state;
+            future.m_state = new_state;
+            return error_type();
+        }
+        void set_value(T&& value) noexcept
+        {
+            if (const auto state = m_state)
+            {
+                m_state = nullptr;
+                state->m_value = std::move(value);
+                state->complete();
+                state->release();
+            }
+        }
+        void set_error(const error_type error) noexcept
+        {
+            if (const auto state = m_state)
+            {
+                m_state = nullptr;
+                state->m_error = error;
+                state->complete();
+                state->release();
+            }
+        }
+    private:
+        state_type* m_state = nullptr;
+    };
+
+#if ICY_COROUTINE
+    //  return type of a fire-and-forget coroutine: "co_return error;" and an unhandled
+    //  error is reported like one from a system thread (see "post_error_event")
+    class async_task
+    {
+    public:
+        struct promise_type
+        {
+            async_task get_return_object() noexcept
+            {
+                return {};
+            }
+            detail::suspend_never initial_suspend() noexcept
+            {
+                return {};
+            }
+            detail::suspend_never final_suspend() noexcept
+            {
+                return {};
+            }
+            void return_value(const error_type error) noexcept
+            {
+                if (error)
+                    post_error_event(error);
+            }
+            void unhandled_exception() noexcept
+            {
+                std::terminate();
+            }
+        };
+    };
+#endif
+}
@@ -0,0 +1,165 @@
+#pragma once
+
+#include "icy_string.hpp"
+
+namespace icy
+{
+    class file;
+    struct hash128;
+
+    template<> inline int compare<hash128>(const hash128& lhs, const hash128& rhs) noexcept;
+
+    //  fast non-cryptographic hashing: short keys use a multiply-fold mix, long inputs
+    //  run a 64-byte stripe accumulator (SSE2/AVX2 where available); results are identical
+    //  across instruction sets and between one-shot and streaming calls.
+    //  Not a replacement for "hash"/"hash64": those remain FNV-1a because their values are persisted.
+    struct hash128
+    {
+        rel_ops(hash128);
+        uint64_t lo = 0;    //  always equal to fast_hash64 of the same input and seed
+        uint64_t hi = 0;
+    };
+    template<> inline int compare<hash128>(const hash128& lhs, const hash128& rhs) noexcept
+    {
+        if (lhs.hi != rhs.hi) return lhs.hi < rhs.hi ? -1 : 1;
+        if (lhs.lo != rhs.lo) return lhs.lo < rhs.lo ? -1 : 1;
+        return 0;
+    }
+
+    uint64_t fast_hash64(const void* const data, const size_t size, const uint64_t seed = 0) noexcept;
+    hash128 fast_hash128(const void* const data, const size_t size, const uint64_t seed = 0) noexcept;
+    inline uint64_t fast_hash64(const const_array_view<uint8_t> bytes, const uint64_t seed = 0) noexcept
+    {
+        return fast_hash64(bytes.data(), bytes.size(), seed);
+    }
+    inline uint64_t fast_hash64(const string_view str, const uint64_t seed = 0) noexcept
+    {
+        return fast_hash64(str.ubytes().data(), str.ubytes().size(), seed);
+    }
+    inline hash128 fast_hash128(const const_array_view<uint8_t> bytes, const uint64_t seed = 0) noexcept
+    {
+        return fast_hash128(bytes.data(), bytes.size(), seed);
+    }
+    inline hash128 fast_hash128(const string_view str, const uint64_t seed = 0) noexcept
+    {
+        return fast_hash128(str.ubytes().data(), str.ubytes().size(), seed);
+    }
+
+    //  incremental hasher: any split of the input into "append" calls gives the one-shot result
+    class hasher
+    {
+    public:
+        enum : size_t
+        {
+            stripe_size = 64,
+            buffer_size = 256,  //  inputs up to this size take the short path
+            secret_size = 192,
+        };
+    public:
+        hasher(const uint64_t seed = 0) noexcept
+        {
+            reset(seed);
+        }
+        void reset(const uint64_t seed = 0) noexcept;
+        void append(const void* data, size_t size) noexcept;
+        void append(const const_array_view<uint8_t> bytes) noexcept
+        {
+            append(bytes.data(), bytes.size());
+        }
+        uint64_t finish64() const noexcept;
+        hash128 finish128() const noexcept;
+        uint64_t size() const noexcept
+        {
+            return m_size;
+        }
+    private:
+        void consume(const uint8_t* data, const size_t stripes) noexcept;
+        void finish(uint64_t (&acc)[8]) const noexcept;
+    private:
+        uint64_t m_acc[8];
+        uint64_t m_seed = 0;
+        uint64_t m_size = 0;
+        size_t m_buffered = 0;
+        size_t m_stripes = 0;   //  stripes consumed in the current block
+        uint8_t m_secret[secret_size];
+        uint8_t m_buffer[buffer_size];
+        uint8_t m_last[stripe_size];
+    };
+
+    //  hash "input" from its current position to the end, reading in large chunks
+    error_type hash_file(file& input, hash128& output, const uint64_t seed = 0) noexcept;
+    error_type hash_file(const string_view path, hash128& output, const uint64_t seed = 0) noexcept;
+
+    namespace detail
+    {
+        inline constexpr uint64_t hash_mix_step(const uint64_t value, const uint64_t prime) noexcept
+        {
+            return (value ^ (value >> 33)) * prime;
+        }
+    }
+    //  64-bit finalizer (good avalanche for integer keys)
+    inline constexpr uint64_t hash_mix(const uint64_t value) noexcept
+    {
+        return detail::hash_mix_step(detail::hash_mix_step(detail::hash_mix_step(
+            value, 0xFF51AFD7ED558CCDull), 0xC4CEB9FE1A85EC53ull), 1);
+    }
+    inline constexpr uint64_t hash_combine(const uint64_t seed, const uint64_t value) noexcept
+    {
+        return hash_mix(seed ^ (value + 0x9E3779B97F4A7C15ull + (seed << 6) + (seed >> 2)));
+    }
+
+    //  hash_traits<T>::get(value) -> uint64_t; specialize for user types
+    template<typename T, typename = void> struct hash_traits;
+    template<typename T> struct hash_traits<T, std::enable_if_t<std::is_integral<T>::value || std::is_enum<T>::value>>
+    {
+        static uint64_t get(const T value) noexcept
+        {
+            return hash_mix(uint64_t(value));
+        }
+    };
+    template<typename T> struct hash_traits<T*>
+    {
+        static uint64_t get(const T* const value) noexcept
+        {
+            return hash_mix(uint64_t(reinterpret_cast<uintptr_t>(value)));
+        }
+    };
+    template<> struct hash_traits<string_view>
+    {
+        static uint64_t get(const string_view value) noexcept
+        {
+            return fast_hash64(value);
+        }
+    };
+    template<> struct hash_traits<string>
+    {
+        static uint64_t get(const string& value) noexcept
+        {
+            return fast_hash64(string_view(value));
+        }
+    };
+    template<> struct hash_traits<guid>
+    {
+        static uint64_t get(const guid& value) noexcept
+        {
+            return fast_hash64(&value, sizeof(value));
+        }
+    };
+    template<> struct hash_traits<hash128>
+    {
+        static uint64_t get(const hash128& value) noexcept
+        {
+            return hash_combine(value.lo, value.hi);
+        }
+    };
+
+    template<typename T> inline uint64_t hash_value(const T& value) noexcept
+    {
+        return hash_traits<T>::get(value);
+    }
+    template<typename T, typename U, typename... arg_types>
+    inline uint64_t hash_value(const T& value, const U& next, const arg_types&... args) noexcept
+    {
+        return hash_combine(hash_value(value), hash_value(next, args...));
+    }
+}
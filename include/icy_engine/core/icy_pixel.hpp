@@ -0,0 +1,32 @@
+#pragma once
+
+#include "icy_color.hpp"
+#include "icy_matrix.hpp"
+
+namespace icy
+{
+    //  pixel format conversion for image codecs and uploads: SSE2 kernels, plus byte-shuffle
+    //  kernels (RGB <-> BGRA, YCbCr) with AVX2; every path gives the same bytes as the scalar code.
+    enum class pixel_format : uint32_t
+    {
+        none,
+        rgb8,       //  R, G, B bytes
+        rgba8,      //  R, G, B, A bytes
+        bgra8,      //  "color"
+        rgb16,      //  R, G, B native-endian uint16_t (rounded to 8 bits)
+        rgba16,
+        ycbcr8,     //  full-range (JFIF) Y, Cb, Cr bytes
+        _total,
+    };
+    size_t pixel_size(const pixel_format format) noexcept;
+
+    //  any format -> bgra8, bgra8 -> rgb8 / rgba8 (other pairs: invalid_argument);
+    //  "src" and "dst" may only overlap for rgba8 <-> bgra8 with src == dst
+    error_type pixel_convert(const pixel_format src_format, const void* const src,
+        const pixel_format dst_format, void* const dst, const size_t count) noexcept;
+    //  "src" rows are "pitch" bytes apart
+    error_type pixel_convert(const pixel_format src_format, const void* const src, const size_t pitch, matrix_view<color> dst) noexcept;
+
+    //  color = color * alpha / 255 (rounded), alpha unchanged
+    void pixel_premultiply(color* const data, const size_t count) noexcept;
+}
@@ -107,4 +107,159 @@ namespace icy
         detail::intrusive_mpsc_queue m_queue;
         std::atomic<size_type> m_size = 0;
     };
+
+    //  bounded lock-free multi-producer / multi-consumer ring: every cell carries a sequence number,
+    //  so producers and consumers claim a position with a single CAS and never share a cell.
+    //  capacity is rounded up to a power of two; "push" returns false instead of blocking when full
+    template<typename T>
+    class mpmc_queue
+    {
+    public:
+        using allocator_type = allocator_type;
+        using type = mpmc_queue<T>;
+        using value_type = T;
+        using size_type = size_t;
+    private:
+        enum : size_t { cache_line = 64 };
+        struct cell_type
+        {
+            std::atomic<size_type> sequence;
+            union
+            {
+                T value;
+            };
+            cell_type() noexcept { }
+            ~cell_type() noexcept { }
+        };
+    public:
+        mpmc_queue() noexcept = default;
+        mpmc_queue(const mpmc_queue&) = delete;
+        mpmc_queue& operator=(const mpmc_queue&) = delete;
+        ~mpmc_queue() noexcept
+        {
+            shutdown();
+        }
+    public:
+        //  not thread safe: call before any producer or consumer starts
+        error_type initialize(const size_type capacity) noexcept
+        {
+            shutdown();
+            auto count = size_type(1);
+            while (count < capacity)
+                count <<= 1;
+
+            m_cells = allocator_type::allocate<cell_type>(count);
+            if (!m_cells)
+                return make_stdlib_error(std::errc::not_enough_memory);
+            for (auto k = 0_z; k < count; ++k)
+            {
+                new (m_cells + k) cell_type;
+                m_cells[k].sequence.store(k, std::memory_order_relaxed);
+            }
+            m_mask = count - 1;
+            m_push.store(0, std::memory_order_relaxed);
+            m_pop.store(0, std::memory_order_relaxed);
+            return error_type();
+        }
+        void shutdown() noexcept
+        {
+            if (!m_cells)
+                return;
+            clear();
+            for (auto k = 0_z; k <= m_mask; ++k)
+                m_cells[k].~cell_type();
+            allocator_type::deallocate(m_cells);
+            m_cells = nullptr;
+            m_mask = 0;
+        }
+        bool push(T&& value) noexcept
+        {
+            return emplace(std::move(value));
+        }
+        template<typename... arg_types>
+        bool emplace(arg_types&&... args) noexcept
+        {
+            auto pos = m_push.load(std::memory_order_relaxed);
+            cell_type* cell = nullptr;
+            while (true)
+            {
+                cell = &m_cells[pos & m_mask];
+                const auto seq = cell->sequence.load(std::memory_order_acquire);
+                const auto diff = ptrdiff_t(seq) - ptrdiff_t(pos);
+                if (diff == 0)
+                {
+                    if (m_push.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        break;
+                }
+                else if (diff < 0)
+                {
+                    return false;   //  full: the consumer one lap behind has not released this cell
+                }
+                else
+                {
+                    pos = m_push.load(std::memory_order_relaxed);
+                }
+            }
+            allocator_type::construct(&cell->value, std::forward<arg_types>(args)...);
+            cell->sequence.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+        bool pop(T& value) noexcept
+        {
+            auto pos = m_pop.load(std::memory_order_relaxed);
+            cell_type* cell = nullptr;
+            while (true)
+            {
+                cell = &m_cells[pos & m_mask];
+                const auto seq = cell->sequence.load(std::memory_order_acquire);
+                const auto diff = ptrdiff_t(seq) - ptrdiff_t(pos + 1);
+                if (diff == 0)
+                {
+                    if (m_pop.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        break;
+                }
+                else if (diff < 0)
+                {
+                    return false;   //  empty
+                }
+                else
+                {
+                    pos = m_pop.load(std::memory_order_relaxed);
+                }
+            }
+            value = std::move(cell->value);
+            allocator_type::destroy(&cell->value);
+            cell->sequence.store(pos + m_mask + 1, std::memory_order_release);
+            return true;
+        }
+        void clear() noexcept
+        {
+            T value;
+            while (pop(value))
+                ;
+        }
+        //  approximate while producers or consumers are running
+        size_type size() const noexcept
+        {
+            const auto push = m_push.load(std::memory_order_acquire);
+            const auto pop = m_pop.load(std::memory_order_acquire);
+            return push > pop ? push - pop : 0;
+        }
+        bool empty() const noexcept
+        {
+            return size() == 0;
+        }
+        size_type capacity() const noexcept
+        {
+            return m_cells ? m_mask + 1 : 0;
+        }
+    private:
+        cell_type* m_cells = nullptr;
+        size_type m_mask = 0;
+        char m_pad0[cache_line - sizeof(cell_type*) - sizeof(size_type)];
+        std::atomic<size_type> m_push = 0;
+        char m_pad1[cache_line - sizeof(std::atomic<size_type>)];
+        std::atomic<size_type> m_pop = 0;
+        char m_pad2[cache_line - sizeof(std::atomic<size_type>)];
+    };
 }
\ No newline at end of file
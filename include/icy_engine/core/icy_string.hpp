@@ -15,6 +15,10 @@ namespace icy
         float_type_fixed,
         float_type_exp,
     };
+    namespace detail
+    {
+        template<size_t N> struct format_table;
+    }
 	
 	class string : public string_view
 	{
@@ -53,6 +57,8 @@ namespace icy
 		error_type append(const string_view rhs) noexcept;
         template<typename... arg_types>
         error_type appendf(const string_view format, arg_types&& ... args) noexcept;
+        template<size_t N, typename... arg_types>
+        error_type appendf(const detail::format_table<N>& format, arg_types&& ... args) noexcept;
 		void clear() noexcept
 		{
 			m_ptr[m_size = 0] = '\0';
@@ -82,22 +88,6 @@ namespace icy
 		str.clear();
 		return str.append(rhs);
 	}
-	namespace detail
-	{
-		inline error_type to_string_arg(std::integral_constant<size_t, 0>, size_t, const void*, string&) noexcept
-		{
-			return make_stdlib_error(std::errc::invalid_argument);
-		}
-		template<size_t N, typename tuple_type, typename = std::enable_if_t<(N > 0)>>
-		inline error_type to_string_arg(std::integral_constant<size_t, N>, size_t index, const tuple_type * tuple, string & str) noexcept
-		{
-			if (index == N)
-				return icy::to_string(std::get<N - 1>(*tuple), str);
-			else
-				return to_string_arg(std::integral_constant<size_t, N - 1>{}, index, tuple, str);
-		}
-	}
-
 	/*inline error_type to_string(const char* const value, string& str) noexcept
 	{
 		return to_string(string_view(value, strlen(value)), str);
@@ -226,69 +216,304 @@ namespace icy
 	error_type to_string(const guid& value, string& str) noexcept;
     error_type to_string(const std::chrono::steady_clock::time_point time, string& str, const bool local = true) noexcept;
     error_type to_string(const std::chrono::system_clock::time_point time, string& str, const bool local = true) noexcept;
-	template<typename... arg_types>
-	inline error_type string::appendf(const string_view format, arg_types&& ... args) noexcept
+	namespace detail
 	{
-		ICY_ERROR(reserve(bytes().size() + format.bytes().size()));
+		using format_integer = std::integral_constant<int, 0>;
+		using format_text = std::integral_constant<int, 1>;
+		using format_other = std::integral_constant<int, 2>;
+		using format_real = std::integral_constant<int, 3>;
+		using format_guid = std::integral_constant<int, 4>;
+		template<typename T> using format_category = std::integral_constant<int,
+			std::is_base_of<string_view, T>::value ? format_text::value :
+			std::is_same<T, float>::value || std::is_same<T, double>::value ? format_real::value :
+			std::is_same<T, guid>::value ? format_guid::value :
+			std::is_same<T, int8_t>::value || std::is_same<T, int16_t>::value ||
+			std::is_same<T, int32_t>::value || std::is_same<T, int64_t>::value ||
+			std::is_same<T, uint8_t>::value || std::is_same<T, uint16_t>::value ||
+			std::is_same<T, uint32_t>::value || std::is_same<T, uint64_t>::value ? format_integer::value : format_other::value>;
 
-		//auto ptr = format.bytes().data();
-		//auto len = format.bytes().size();
-		const auto tuple = std::make_tuple(std::forward<arg_types>(args)...);
-		for (auto it = format.begin(); it != format.end(); ++it)
+		//  writes decimal digits backwards ending at "end", returns length
+		inline size_t format_uint(uint64_t value, char* const end) noexcept
 		{
-			char32_t chr = 0;
-			ICY_ERROR(it.to_char(chr));
-
-			if (chr == '%')
+			static const char digits[] =
+				"00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+				"40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+				"8081828384858687888990919293949596979899";
+			auto ptr = end;
+			while (value >= 100)
 			{
-				if (it + 1 >= format.end())
-					return make_stdlib_error(std::errc::invalid_argument);
+				const auto k = size_t(value % 100) * 2;
+				value /= 100;
+				*--ptr = digits[k + 1];
+				*--ptr = digits[k];
+			}
+			if (value >= 10)
+			{
+				const auto k = size_t(value) * 2;
+				*--ptr = digits[k + 1];
+				*--ptr = digits[k];
+			}
+			else
+			{
+				*--ptr = char('0' + value);
+			}
+			return size_t(end - ptr);
+		}
 
-				char32_t next = 0;
-				ICY_ERROR((it + 1).to_char(next));
+		//  locale-independent printf "%.Nf" / "%.Ne" (N <= DBL_DIG, correctly rounded), returns length or 0 for inf/nan
+		enum : size_t { double_chars_max = 330, guid_chars = 36 };
+		size_t double_to_chars(const double value, const float_type type, size_t precision, char* const buffer) noexcept;
+		//  "01234567-89AB-CDEF-0123-456789ABCDEF" (36 chars, no terminator)
+		size_t guid_to_chars(const guid& value, char* const buffer) noexcept;
+
+		//  upper bound of the formatted size (0 if it can't be known without formatting)
+		template<typename T> inline size_t format_size(format_integer, const T&) noexcept
+		{
+			return sizeof("-18446744073709551615") - 1;
+		}
+		template<typename T> inline size_t format_size(format_text, const T& value) noexcept
+		{
+			return value.bytes().size();
+		}
+		template<typename T> inline size_t format_size(format_real, const T&) noexcept
+		{
+			return double_chars_max;
+		}
+		template<typename T> inline size_t format_size(format_guid, const T&) noexcept
+		{
+			return guid_chars;
+		}
+		template<typename T> inline size_t format_size(format_other, const T&) noexcept
+		{
+			return 0;
+		}
+
+		//  integers, floats, guids and strings are written straight into the output, everything else goes through to_string
+		template<typename T> inline error_type format_arg(format_integer, const T value, string& str) noexcept
+		{
+			char buffer[32];
+			const auto end = buffer + _countof(buffer);
+			const auto negative = std::is_signed<T>::value && value < 0;
+			const auto abs = negative ? 0 - uint64_t(int64_t(value)) : uint64_t(value);
+			auto length = format_uint(abs, end);
+			if (negative)
+				buffer[_countof(buffer) - ++length] = '-';
+			return str.append(string_view(end - length, length, string_view::constexpr_tag()));
+		}
+		template<typename T> inline error_type format_arg(format_text, const T& value, string& str) noexcept
+		{
+			return str.append(value);
+		}
+		template<typename T> inline error_type format_arg(format_real, const T value, string& str) noexcept
+		{
+			char buffer[double_chars_max];
+			const auto length = double_to_chars(double(value), float_type_fixed, FLT_DIG, buffer);
+			if (!length)
+				return make_stdlib_error(std::errc::invalid_argument);
+			return str.append(string_view(buffer, length, string_view::constexpr_tag()));
+		}
+		template<typename T> inline error_type format_arg(format_guid, const T& value, string& str) noexcept
+		{
+			char buffer[guid_chars];
+			return str.append(string_view(buffer, guid_to_chars(value, buffer), string_view::constexpr_tag()));
+		}
+		template<typename T> inline error_type format_arg(format_other, const T& value, string& str) noexcept
+		{
+			string arg;
+			ICY_ERROR(icy::to_string(value, arg));
+			return str.append(arg);
+		}
+
+		inline error_type format_arg_at(std::integral_constant<size_t, 0>, size_t, const void*, string&) noexcept
+		{
+			return make_stdlib_error(std::errc::invalid_argument);
+		}
+		template<size_t N, typename tuple_type, typename = std::enable_if_t<(N > 0)>>
+		inline error_type format_arg_at(std::integral_constant<size_t, N>, const size_t index, const tuple_type* tuple, string& str) noexcept
+		{
+			using arg_type = std::decay_t<std::tuple_element_t<N - 1, tuple_type>>;
+			if (index == N)
+				return format_arg(format_category<arg_type>(), std::get<N - 1>(*tuple), str);
+			else
+				return format_arg_at(std::integral_constant<size_t, N - 1>{}, index, tuple, str);
+		}
 
-				if (next == '%')
+		//  splits "format" into literal runs and %N placeholders ("%%" is a literal '%');
+		//  '%' never occurs inside a multibyte UTF-8 sequence, so the scan works on bytes
+		template<typename text_func, typename arg_func>
+		inline error_type format_parse(const string_view format, const size_t count, text_func&& text, arg_func&& arg) noexcept
+		{
+			auto ptr = format.bytes().data();
+			const auto end = ptr + format.bytes().size();
+			while (ptr < end)
+			{
+				const auto next = static_cast<const char*>(memchr(ptr, '%', size_t(end - ptr)));
+				if (!next)
 				{
-					ICY_ERROR(append("%"_s));
-					++it;
+					ICY_ERROR(text(ptr, size_t(end - ptr)));
+					break;
 				}
-				else if (next  >= '0' && next <= '9')
+				if (next > ptr)
+					ICY_ERROR(text(ptr, size_t(next - ptr)));
+				ptr = next + 1;
+				if (ptr == end)
+					return make_stdlib_error(std::errc::invalid_argument);
+				if (*ptr == '%')
 				{
-					const auto beg = it + 1;
-					++it;
-					while (it != format.end())
-					{
-						ICY_ERROR(it.to_char(next));
-						if (next >= '0' && next <= '9')
-							++it;
-						else
-							break;
-					}
-					size_t index = 0;
-					ICY_ERROR(to_value_uint(string_view(beg, it), index));
-
-					if (index > sizeof...(args))
-						return make_stdlib_error(std::errc::invalid_argument);
-					string arg;
-					ICY_ERROR(detail::to_string_arg(std::integral_constant<size_t, sizeof...(args)>(), index, &tuple, arg));
-					ICY_ERROR(append(arg));
-					if (it == format.end())
-						break;
-					else
-						--it;
+					ICY_ERROR(text(ptr++, 1));
+					continue;
 				}
-				else
+				auto index = 0_z;
+				const auto digits = ptr;
+				while (ptr < end && *ptr >= '0' && *ptr <= '9' && ptr - digits < 8)
+					index = index * 10 + size_t(*ptr++ - '0');
+				if (ptr == digits || index == 0 || index > count)
 					return make_stdlib_error(std::errc::invalid_argument);
+				ICY_ERROR(arg(index));
+			}
+			return error_type();
+		}
+
+		//  a literal run (index 0) or a %N placeholder
+		struct format_segment
+		{
+			uint32_t offset;
+			uint32_t size;
+			uint32_t index;
+		};
+		template<size_t N> struct format_table
+		{
+			char text[N] = {};
+			format_segment segments[N] = {};
+			size_t count = 0;
+			size_t args = 0;    //  highest %N
+			size_t size = 0;    //  literal bytes
+			bool valid = true;
+		};
+		//  not constexpr on purpose: reaching it while evaluating a constexpr make_format fails the build
+		inline bool format_invalid() noexcept
+		{
+			return false;
+		}
+		template<size_t N>
+		inline constexpr void format_push(format_table<N>& table, const size_t offset, const size_t size, const size_t index) noexcept
+		{
+			if (!index && !size)
+				return;
+			table.segments[table.count].offset = uint32_t(offset);
+			table.segments[table.count].size = uint32_t(size);
+			table.segments[table.count].index = uint32_t(index);
+			table.count += 1;
+			table.size += size;
+			table.args = index > table.args ? index : table.args;
+		}
+	}
+
+	//  compiles a format literal into segments with the same rules as appendf;
+	//  "static constexpr auto format = make_format("%1: %2");" rejects a malformed literal at compile time
+	template<size_t N>
+	inline constexpr detail::format_table<N> make_format(const char(&format)[N]) noexcept
+	{
+		detail::format_table<N> table{};
+		for (size_t k = 0; k < N; ++k)
+			table.text[k] = format[k];
+
+		const auto end = N - 1;
+		size_t literal = 0;
+		size_t k = 0;
+		while (k < end)
+		{
+			if (format[k] != '%')
+			{
+				++k;
+				continue;
+			}
+			if (k + 1 == end)
+			{
+				table.valid = detail::format_invalid();
+				return table;
+			}
+			if (format[k + 1] == '%')
+			{
+				detail::format_push(table, literal, k + 1 - literal, 0);
+				k += 2;
+				literal = k;
+				continue;
+			}
+			detail::format_push(table, literal, k - literal, 0);
+			size_t index = 0;
+			const auto digits = ++k;
+			while (k < end && format[k] >= '0' && format[k] <= '9' && k - digits < 8)
+				index = index * 10 + size_t(format[k++] - '0');
+			if (k == digits || index == 0)
+			{
+				table.valid = detail::format_invalid();
+				return table;
+			}
+			detail::format_push(table, 0, 0, index);
+			literal = k;
+		}
+		detail::format_push(table, literal, end - literal, 0);
+		return table;
+	}
+	template<typename... arg_types>
+	inline error_type string::appendf(const string_view format, arg_types&& ... args) noexcept
+	{
+		const auto tuple = std::forward_as_tuple(args...);
+		const size_t sizes[] = { 0, detail::format_size(detail::format_category<std::decay_t<arg_types>>(), args)... };
+
+		//  first pass validates the format and sizes the output, second pass writes it
+		auto capacity = bytes().size();
+		ICY_ERROR(detail::format_parse(format, sizeof...(args),
+			[&capacity](const char*, const size_t size) { capacity += size; return error_type(); },
+			[&capacity, &sizes](const size_t index) { capacity += sizes[index]; return error_type(); }));
+		ICY_ERROR(reserve(capacity));
+
+		return detail::format_parse(format, sizeof...(args),
+			[this](const char* ptr, const size_t size) { return append(string_view(ptr, size, string_view::constexpr_tag())); },
+			[this, &tuple](const size_t index)
+		{
+			return detail::format_arg_at(std::integral_constant<size_t, sizeof...(args)>(), index, &tuple, *this);
+		});
+	}
+	template<size_t N, typename... arg_types>
+	inline error_type string::appendf(const detail::format_table<N>& format, arg_types&& ... args) noexcept
+	{
+		if (!format.valid || format.args > sizeof...(args))
+			return make_stdlib_error(std::errc::invalid_argument);
+
+		const auto tuple = std::forward_as_tuple(args...);
+		const size_t sizes[] = { 0, detail::format_size(detail::format_category<std::decay_t<arg_types>>(), args)... };
+
+		//  the table is already parsed: one pass over the segments sizes the output
+		auto capacity = bytes().size() + format.size;
+		for (auto k = 0_z; k < format.count; ++k)
+			capacity += sizes[format.segments[k].index];
+		ICY_ERROR(reserve(capacity));
+
+		for (auto k = 0_z; k < format.count; ++k)
+		{
+			const auto& segment = format.segments[k];
+			if (segment.index)
+			{
+				ICY_ERROR(detail::format_arg_at(std::integral_constant<size_t, sizeof...(args)>(), segment.index, &tuple, *this));
 			}
 			else
 			{
-				ICY_ERROR(append(string_view(it, it + 1)));
+				ICY_ERROR(append(string_view(format.text + segment.offset, segment.size, string_view::constexpr_tag())));
 			}
 		}
 		return error_type();
 	}
     template<typename... arg_types>
     inline error_type to_string(const string_view format, string& str, arg_types&& ... args) noexcept
+    {
+        str.clear();
+        ICY_ERROR(str.appendf(format, std::forward<arg_types>(args)...));
+        return error_type();
+    }
+    template<size_t N, typename... arg_types>
+    inline error_type to_string(const detail::format_table<N>& format, string& str, arg_types&& ... args) noexcept
     {
         str.clear();
         ICY_ERROR(str.appendf(format, std::forward<arg_types>(args)...));
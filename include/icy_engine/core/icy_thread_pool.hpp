@@ -0,0 +1,107 @@
+#pragma once
+
+#include "icy_event.hpp"
+#include "icy_queue.hpp"
+
+namespace icy
+{
+    enum class thread_pool_priority : uint32_t
+    {
+        high,
+        normal,
+        low,
+        _total,
+    };
+    struct thread_pool_task
+    {
+        error_type(*func)(void* user) = nullptr;
+        void* user = nullptr;
+    };
+    struct thread_pool_options
+    {
+        size_t threads = 0;         //  0: one per core
+        size_t capacity = 4096;     //  tasks per queue (rounded up to a power of two)
+        bool pin = false;           //  bind worker "k" to core "k"
+    };
+
+    //  shared worker threads fed by bounded lock-free queues: one per priority and one per worker.
+    //  A worker runs tasks from its own queue first, then the shared queues from high to low priority
+    //  (sustained high priority load starves low), then steals from other workers when idle,
+    //  so affinity is a hint rather than a guarantee. Pending tasks still run on destruction.
+    class thread_pool
+    {
+        class thread_type;
+        struct tag {};
+    public:
+        enum : uint32_t { any_thread = UINT32_MAX };
+        friend error_type create_thread_pool(shared_ptr<thread_pool>& pool, const thread_pool_options& options) noexcept;
+        friend class pool_event_system;
+    public:
+        thread_pool(tag) noexcept;
+        thread_pool(const thread_pool&) = delete;
+        ~thread_pool() noexcept;
+        //  errc::no_buffer_space when the target queue is full
+        error_type post(const thread_pool_task task, const thread_pool_priority priority = thread_pool_priority::normal, const uint32_t affinity = any_thread) noexcept;
+        size_t size() const noexcept
+        {
+            return m_threads.size();
+        }
+        //  first error returned by a task
+        error_type error() const noexcept;
+        //  index of the calling thread if it is a worker of this pool, "any_thread" otherwise
+        uint32_t this_index() const noexcept;
+    private:
+        error_type initialize(const thread_pool_options& options) noexcept;
+        bool pop(const size_t index, thread_pool_task& task) noexcept;
+        //  runs one queued task on worker "index" (the caller); false when there is none
+        bool help(const size_t index) noexcept;
+        void exec(const thread_pool_task& task) noexcept;
+        void wake(const size_t index) noexcept;
+        void work(const size_t index) noexcept;
+    private:
+        mutable mutex m_lock;
+        error_type m_error;
+        array<shared_ptr<thread_type>> m_threads;
+        mpmc_queue<thread_pool_task> m_queue[uint32_t(thread_pool_priority::_total)];
+        std::atomic<uint32_t> m_idle = 0;
+        std::atomic<bool> m_quit = false;
+    };
+    error_type create_thread_pool(shared_ptr<thread_pool>& pool, const thread_pool_options& options = {}) noexcept;
+
+    //  event_system whose handler runs as a pool task instead of on a dedicated thread: "signal"
+    //  schedules at most one drain task, so "handle" is never called concurrently for one system.
+    //  A drain task handles up to "drain_batch" events, then posts itself again to let other tasks run.
+    //  An error from "handle" ends the system like an "exec" error ends its event_thread.
+    //  Derived classes call "shutdown" first thing in their destructor.
+    class pool_event_system : public event_system
+    {
+    public:
+        ~pool_event_system() noexcept override
+        {
+            shutdown();
+        }
+        error_type exec() noexcept override
+        {
+            return make_stdlib_error(std::errc::function_not_supported);
+        }
+    protected:
+        error_type initialize(shared_ptr<thread_pool> pool, const uint64_t mask, 
+            const thread_pool_priority priority = thread_pool_priority::normal, const uint32_t affinity = thread_pool::any_thread) noexcept;
+        //  waits for a running (or queued) drain task and stops further ones.
+        //  Called from "handle" it closes the system without waiting (the running drain is the caller,
+        //  and it stops as soon as "handle" returns). Called from another task of the same pool
+        //  it runs queued pool tasks while it waits, so a drain queued behind the caller still gets to run
+        void shutdown() noexcept;
+        virtual error_type handle(event& event) noexcept = 0;
+    private:
+        enum : size_t { drain_batch = 64 };
+        error_type signal(const event_data* event) noexcept override;
+        error_type schedule() noexcept;
+        static error_type drain(void* user) noexcept;
+    private:
+        shared_ptr<thread_pool> m_pool;
+        thread_pool_priority m_priority = thread_pool_priority::normal;
+        uint32_t m_affinity = thread_pool::any_thread;
+        std::atomic<uint32_t> m_pending = 0;    //  signals since the last drain started
+    };
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "icy_core.hpp"
+
+//  build with ICY_TRACE=1 to record; otherwise every ICY_TRACE_* macro expands to nothing.
+//  ICY_TRACE=2 also records the per-event ICY_TRACE_HOT_* sites (each costs tens of ns)
+#ifndef ICY_TRACE
+#define ICY_TRACE 0
+#endif
+
+#if ICY_TRACE
+//  "NAME" must be a string literal (only the pointer is stored) without quotes or backslashes
+#define ICY_TRACE_SCOPE(NAME) icy::trace_scope ICY_ANONYMOUS_VARIABLE(ICY_TRACE_SCOPE_) { NAME }
+#define ICY_TRACE_COUNTER(NAME, VALUE) icy::trace_counter(NAME, int64_t(VALUE))
+#define ICY_TRACE_VALUE(NAME, VALUE) do { static icy::trace_histogram histogram_ { NAME }; histogram_.add(uint64_t(VALUE)); } while (false)
+#else
+#define ICY_TRACE_SCOPE(NAME)
+#define ICY_TRACE_COUNTER(NAME, VALUE)
+#define ICY_TRACE_VALUE(NAME, VALUE)
+#endif
+
+#if ICY_TRACE >= 2
+#define ICY_TRACE_HOT_SCOPE(NAME) ICY_TRACE_SCOPE(NAME)
+#define ICY_TRACE_HOT_COUNTER(NAME, VALUE) ICY_TRACE_COUNTER(NAME, VALUE)
+#else
+#define ICY_TRACE_HOT_SCOPE(NAME)
+#define ICY_TRACE_HOT_COUNTER(NAME, VALUE)
+#endif
+
+namespace icy
+{
+    class string_view;
+
+    enum class trace_type : uint32_t
+    {
+        none,
+        scope,      //  "value" is the duration in ticks
+        counter,    //  "value" is the sample
+    };
+    struct trace_event
+    {
+        const char* name = nullptr;
+        trace_type type = trace_type::none;
+        int64_t time = 0;   //  ticks
+        int64_t value = 0;
+    };
+    //  time stamp counter: a fraction of the cost of "clock_type::now", converted to ns on export
+    inline int64_t trace_now() noexcept
+    {
+        return int64_t(__rdtsc());
+    }
+    //  appends to the calling thread's ring (taken on first use and released when the thread exits;
+    //  oldest events are overwritten)
+    void trace_record(const trace_event& event) noexcept;
+    inline void trace_counter(const char* const name, const int64_t value) noexcept
+    {
+        trace_event event;
+        event.name = name;
+        event.type = trace_type::counter;
+        event.time = trace_now();
+        event.value = value;
+        trace_record(event);
+    }
+
+    class trace_scope
+    {
+    public:
+        explicit trace_scope(const char* const name) noexcept : m_name(name), m_time(trace_now())
+        {
+
+        }
+        trace_scope(const trace_scope&) = delete;
+        ~trace_scope() noexcept
+        {
+            trace_event event;
+            event.name = m_name;
+            event.type = trace_type::scope;
+            event.time = m_time;
+            event.value = trace_now() - m_time;
+            trace_record(event);
+        }
+    private:
+        const char* const m_name;
+        const int64_t m_time;
+    };
+
+    //  process-wide log2 histogram (bucket 0 holds zeros, bucket "k" holds [2^(k-1), 2^k))
+    class trace_histogram
+    {
+        friend error_type trace_export(const string_view path) noexcept;
+    public:
+        enum : size_t { buckets = 65 };
+        explicit trace_histogram(const char* const name) noexcept;
+        trace_histogram(const trace_histogram&) = delete;
+        void add(const uint64_t value) noexcept
+        {
+            m_count.fetch_add(1, std::memory_order_relaxed);
+            m_sum.fetch_add(value, std::memory_order_relaxed);
+            m_buckets[value ? detail::log2(value) + 1 : 0].fetch_add(1, std::memory_order_relaxed);
+        }
+    private:
+        const char* const m_name;
+        trace_histogram* m_next = nullptr;
+        std::atomic<uint64_t> m_count = 0;
+        std::atomic<uint64_t> m_sum = 0;
+        std::atomic<uint64_t> m_buckets[buckets] = {};
+    };
+
+    //  events recorded before this call are skipped by "trace_export"
+    void trace_clear() noexcept;
+    //  Chrome trace-event JSON (opens in chrome://tracing and Perfetto); histograms go to "icyHistograms".
+    //  Threads keep recording meanwhile: events overwritten during the copy are dropped
+    error_type trace_export(const string_view path) noexcept;
+}
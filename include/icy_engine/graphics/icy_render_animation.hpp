@@ -0,0 +1,98 @@
+#pragma once
+
+#include <icy_engine/graphics/icy_render_transform.hpp>
+
+namespace icy
+{
+    enum class render_animation_blend : uint32_t
+    {
+        nlerp,
+        slerp,
+    };
+    enum render_animation_flag : uint32_t
+    {
+        render_animation_flag_none      =   0x00,
+        render_animation_flag_quantize  =   0x01,   //  store rotation keys as snorm16
+    };
+
+    class render_animation_state;
+
+    //  immutable, shareable keyframe data: every channel keeps three tracks (world, scale, angle)
+    //  whose keys live in contiguous time/value pools
+    class render_animation_clip
+    {
+        friend render_animation_state;
+    public:
+        render_animation_clip() noexcept = default;
+        render_animation_clip(render_animation_clip&& rhs) noexcept = default;
+        ICY_DEFAULT_MOVE_ASSIGN(render_animation_clip);
+        error_type initialize(const render_animation& animation, const uint32_t flags = render_animation_flag_none) noexcept;
+        size_t size() const noexcept
+        {
+            return m_nodes.size();
+        }
+        const_array_view<guid> nodes() const noexcept
+        {
+            return m_nodes;
+        }
+        //  duration in seconds
+        double duration() const noexcept
+        {
+            return m_frames / m_fps;
+        }
+        //  evaluate every channel at "time" (seconds) into state.transforms(); only the tracks
+        //  that have keys are written. "prefix" / "suffix" apply before 0 and after "duration"
+        void sample(const double time, render_animation_state& state, const render_animation_blend blend = render_animation_blend::nlerp) const noexcept;
+    private:
+        enum { track_world, track_scale, track_angle, _track_count };
+        struct track_type
+        {
+            uint32_t time = 0;  //  offset in m_times
+            uint32_t value = 0; //  key offset in the value pool
+            uint32_t count = 0;
+        };
+        struct channel_type
+        {
+            track_type tracks[_track_count];
+            render_animation_type prefix = render_animation_type::none;
+            render_animation_type suffix = render_animation_type::none;
+        };
+    private:
+        array<guid> m_nodes;
+        array<channel_type> m_channels;
+        array<float> m_times;
+        array<float> m_vec3;
+        array<float> m_vec4;
+        array<int16_t> m_quat;
+        double m_frames = 0;
+        double m_fps = 0;
+        uint32_t m_flags = 0;
+    };
+
+    //  per-instance playback state: cached key cursors make forward playback O(1) per track
+    class render_animation_state
+    {
+        friend render_animation_clip;
+    public:
+        render_animation_state() noexcept = default;
+        render_animation_state(render_animation_state&& rhs) noexcept = default;
+        ICY_DEFAULT_MOVE_ASSIGN(render_animation_state);
+        error_type initialize(const render_animation_clip& clip) noexcept;
+        //  resolve channel targets in a transform buffer (channels without a node are skipped)
+        //  and take their current transforms as the bind pose for tracks the clip does not animate
+        error_type bind(const render_animation_clip& clip, const render_transform_buffer& buffer) noexcept;
+        void apply(render_transform_buffer& buffer) const noexcept;
+        void reset() noexcept
+        {
+            memset(m_cursor.data(), 0, m_cursor.size() * sizeof(uint32_t));
+        }
+        const_array_view<render_transform> transforms() const noexcept
+        {
+            return m_output;
+        }
+    private:
+        array<uint32_t> m_cursor;
+        array<uint32_t> m_target;
+        array<render_transform> m_output;
+    };
+}
@@ -95,8 +95,9 @@ namespace icy
     enum class render_texture_compress : uint32_t
     {
         none,
-        dds1,
-        dds5,
+        dds1,   //  BC1
+        dds5,   //  BC3
+        bc7,
         _total,
     };
     enum class render_mesh_type : uint32_t
@@ -115,7 +116,7 @@ namespace icy
         {
 
         }
-        render_vec4(const float x, const float y, const float z, const float w) : vec{ x, y, z, w}
+        render_vec4(const float x, const float y, const float z, const float w) noexcept : vec{ x, y, z, w}
         {
 
         }
@@ -134,7 +135,7 @@ namespace icy
         {
 
         }
-        render_vec3(const float x, const float y, const float z) : vec{ x, y, z }
+        render_vec3(const float x, const float y, const float z) noexcept : vec{ x, y, z }
         {
 
         }
@@ -158,7 +159,7 @@ namespace icy
         {
 
         }
-        render_vec2(const float x, const float y) : vec{ x, y }
+        render_vec2(const float x, const float y) noexcept : vec{ x, y }
         {
 
         }
@@ -241,6 +242,7 @@ namespace icy
         render_texture_compress compress = render_texture_compress::none;
         double blend = 0;
         window_size size;
+        uint32_t levels = 1;    //  mip chain in "bytes": largest first
         array<uint8_t> bytes;
     };
     struct render_material
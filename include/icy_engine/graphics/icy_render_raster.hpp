@@ -0,0 +1,56 @@
+#pragma once
+
+#include <icy_engine/core/icy_matrix.hpp>
+#include <icy_engine/core/icy_thread.hpp>
+#include <icy_engine/graphics/icy_render_core.hpp>
+
+namespace icy
+{
+    //  CPU backend for "render_gui_frame" (headless servers, CI, screenshots).
+    //  Triangles are binned into 64x64 tiles; each tile is owned by one thread and draws its
+    //  triangles in submission order, so the output does not depend on the thread count.
+    //  Coverage uses 28.4 fixed-point edge functions with the top-left fill rule (4 pixels per step
+    //  with SSE2); attributes are interpolated from float planes at pixel centers,
+    //  texture sampling is bilinear (clamp) and blending is "src alpha, inv src alpha" as in the GPU backends.
+    class render_gui_raster
+    {
+        struct triangle_type;
+        struct command_type;
+        class thread_type;
+    public:
+        enum : uint32_t
+        {
+            tile_size = 64,
+        };
+    public:
+        render_gui_raster() noexcept;
+        render_gui_raster(const render_gui_raster&) = delete;
+        ~render_gui_raster() noexcept;
+        //  threads = 0: one per core (the calling thread is one of them)
+        error_type initialize(const size_t threads = 0) noexcept;
+        //  commands using an unknown texture are skipped (as the GPU backends do until the image is loaded);
+        //  a null guid draws untextured
+        error_type texture(const guid& index, const const_matrix_view<color> image) noexcept;
+        void erase(const guid& index) noexcept;
+        //  "output" is resized to the frame viewport and cleared with "clear" first
+        error_type render(const render_gui_frame& frame, matrix<color>& output, const color clear = color()) noexcept;
+    private:
+        error_type setup(const render_gui_frame& frame, const uint32_t width, const uint32_t height) noexcept;
+        void work() noexcept;
+        void draw(const uint32_t tile) noexcept;
+    private:
+        map<guid, matrix<color>> m_textures;
+        array<shared_ptr<thread_type>> m_threads;
+        array<triangle_type> m_triangles;
+        array<command_type> m_commands;
+        array<uint32_t> m_bins;         //  tile -> first item in "m_items" (prefix sum)
+        array<uint32_t> m_items;        //  triangle indices grouped by tile
+        color* m_pixels = nullptr;
+        uint32_t m_width = 0;
+        uint32_t m_height = 0;
+        color m_clear;
+        uint32_t m_tiles_x = 0;
+        uint32_t m_tiles_y = 0;
+        std::atomic<uint32_t> m_next = 0;
+    };
+}
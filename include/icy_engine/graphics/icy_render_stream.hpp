@@ -0,0 +1,78 @@
+#pragma once
+
+#include <icy_engine/core/icy_matrix.hpp>
+#include <icy_engine/core/icy_set.hpp>
+#include <icy_engine/graphics/icy_render_core.hpp>
+
+namespace icy
+{
+    //  remote viewing of GUI draw lists: one message per "render_gui_frame", sent as bytes over
+    //  any stream transport (network_system_tcp_server::send / network_system_tcp_client::recv).
+    //  Lists the viewer got in the previous frame are referenced by hash; new lists have their
+    //  index and vertex buffers delta + varint coded (lossless); textures are sent once by guid.
+    static const auto render_gui_stream_version = 1u;
+
+    struct render_gui_stream_stats
+    {
+        uint64_t frames = 0;
+        uint64_t lists = 0;         //  sent in full
+        uint64_t cached = 0;        //  sent as a hash reference
+        uint64_t textures = 0;
+        uint64_t raw_bytes = 0;     //  same frames as flat idx/vtx/cmd arrays and pixels
+        uint64_t bytes = 0;         //  on the wire
+        uint64_t rejected = 0;      //  malformed messages skipped by "decode"
+        duration_type time = {};    //  spent in "encode" / "decode"
+    };
+
+    class render_gui_encoder
+    {
+    public:
+        //  queued for the next message; kept to be sent again after "reset"
+        error_type texture(const guid& index, const const_matrix_view<color> image) noexcept;
+        //  next message is self-contained (call when a viewer (re)connects)
+        void reset() noexcept;
+        //  appends one message to "output"
+        error_type encode(const render_gui_frame& frame, array<uint8_t>& output) noexcept;
+        const render_gui_stream_stats& stats() const noexcept
+        {
+            return m_stats;
+        }
+    private:
+        struct texture_type
+        {
+            matrix<color> image;
+            bool sent = false;
+        };
+    private:
+        map<guid, texture_type> m_textures;
+        set<uint64_t> m_lists;      //  lists the decoder has cached (previous message)
+        bool m_reset = true;
+        render_gui_stream_stats m_stats;
+    };
+
+    class render_gui_decoder
+    {
+    public:
+        //  "bytes" may split messages anywhere; each completed message appends a frame
+        //  and the guids of textures it (re)loaded. A malformed message is skipped and decoding
+        //  goes on; the first such error is returned after all of "bytes" is consumed
+        //  (std::errc::invalid_argument: a cached list is unknown, the encoder needs a "reset").
+        //  A size prefix over the limit loses framing: the stream must be reconnected
+        error_type decode(const const_array_view<uint8_t> bytes, array<render_gui_frame>& frames, array<guid>* textures = nullptr) noexcept;
+        const matrix<color>* texture(const guid& index) const noexcept
+        {
+            return m_textures.try_find(index);
+        }
+        const render_gui_stream_stats& stats() const noexcept
+        {
+            return m_stats;
+        }
+    private:
+        error_type message(const const_array_view<uint8_t> bytes, render_gui_frame& frame, array<guid>* textures) noexcept;
+    private:
+        array<uint8_t> m_buffer;    //  incomplete message
+        map<uint64_t, render_gui_list> m_lists;
+        map<guid, matrix<color>> m_textures;
+        render_gui_stream_stats m_stats;
+    };
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <icy_engine/core/icy_matrix.hpp>
+#include <icy_engine/core/icy_thread.hpp>
+#include <icy_engine/graphics/icy_render_core.hpp>
+
+namespace icy
+{
+    enum class render_texture_filter : uint32_t
+    {
+        box,        //  2x2 average
+        kaiser,     //  8-tap Kaiser-windowed sinc (sharper, slight ringing is clamped)
+        _total,
+    };
+    struct render_texture_options
+    {
+        render_texture_compress compress = render_texture_compress::bc7;
+        render_texture_filter filter = render_texture_filter::kaiser;
+        bool srgb = true;       //  filter in linear light (color channels are sRGB encoded)
+        uint32_t levels = 0;    //  0: full chain down to 1x1
+    };
+
+    //  mip chain (level 0 is a copy of "image"); color is filtered premultiplied by alpha
+    error_type render_texture_mips(const const_matrix_view<color> image, const render_texture_options& options, array<matrix<color>>& mips) noexcept;
+    //  size in bytes of one compressed level (4x4 blocks, 8 bytes for BC1, 16 for BC3 / BC7)
+    size_t render_texture_level_size(const render_texture_compress compress, const uint32_t width, const uint32_t height) noexcept;
+
+    //  import-time texture processing: mip chain, then block compression spread over worker threads.
+    //  BC1 / BC3 use principal-axis endpoints refined by least squares; BC7 emits mode 6 blocks
+    //  (one RGBA subset, 7-bit endpoints with p-bits, 4-bit indices).
+    class render_texture_encoder
+    {
+        class thread_type;
+    public:
+        render_texture_encoder() noexcept;
+        render_texture_encoder(const render_texture_encoder&) = delete;
+        ~render_texture_encoder() noexcept;
+        //  threads = 0: one per core (the calling thread is one of them)
+        error_type initialize(const size_t threads = 0) noexcept;
+        //  fills "size", "compress", "levels" and "bytes" (levels back to back, blocks in row order)
+        error_type encode(const const_matrix_view<color> image, const render_texture_options& options, render_texture& texture) noexcept;
+        //  one level: "output" must hold "render_texture_level_size" bytes
+        error_type encode(const const_matrix_view<color> image, const render_texture_compress compress, uint8_t* const output) noexcept;
+    private:
+        void work() noexcept;
+    private:
+        array<shared_ptr<thread_type>> m_threads;
+        const_matrix_view<color> m_image;
+        render_texture_compress m_compress = render_texture_compress::none;
+        uint8_t* m_output = nullptr;
+        uint32_t m_blocks_x = 0;
+        uint32_t m_blocks_y = 0;
+        std::atomic<uint32_t> m_next = 0;
+    };
+}
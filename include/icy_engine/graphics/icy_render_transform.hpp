@@ -0,0 +1,64 @@
+#pragma once
+
+#include <icy_engine/graphics/icy_render_core.hpp>
+
+namespace icy
+{
+    //  row-major 4x4 (row vectors, world = local * parent)
+    struct render_matrix
+    {
+        float row[4][4];
+    };
+    render_matrix to_matrix(const render_transform& transform) noexcept;
+    render_matrix operator*(const render_matrix& lhs, const render_matrix& rhs) noexcept;
+
+    //  flattened transform hierarchy: nodes are stored breadth-first (parent index < child index),
+    //  local transforms are kept as SoA lanes and world matrices are recomputed only for dirty subtrees
+    class render_transform_buffer
+    {
+    public:
+        static const uint32_t invalid_index = UINT32_MAX;
+    public:
+        render_transform_buffer() noexcept = default;
+        render_transform_buffer(render_transform_buffer&& rhs) noexcept = default;
+        ICY_DEFAULT_MOVE_ASSIGN(render_transform_buffer);
+        error_type initialize(const map<guid, render_node>& nodes) noexcept;
+        void clear() noexcept;
+        size_t size() const noexcept
+        {
+            return m_nodes.size();
+        }
+        uint32_t find(const guid& node) const noexcept;
+        render_transform transform(const uint32_t index) const noexcept;
+        void assign(const uint32_t index, const render_transform& transform) noexcept;
+        void update() noexcept;
+        const_array_view<guid> nodes() const noexcept
+        {
+            return m_nodes;
+        }
+        const_array_view<uint32_t> parent() const noexcept
+        {
+            return m_parent;
+        }
+        const_array_view<render_matrix> local() const noexcept
+        {
+            return m_local;
+        }
+        const_array_view<render_matrix> world() const noexcept
+        {
+            return m_world;
+        }
+    private:
+        enum { world_x, world_y, world_z, scale_x, scale_y, scale_z, angle_x, angle_y, angle_z, angle_w, _lanes };
+    private:
+        array<guid> m_keys;         //  sorted
+        array<uint32_t> m_order;    //  key index -> buffer index
+        array<guid> m_nodes;
+        array<uint32_t> m_parent;
+        array<float> m_lanes[_lanes];
+        array<uint8_t> m_dirty;
+        array<render_matrix> m_local;
+        array<render_matrix> m_world;
+        size_t m_dirty_count = 0;
+    };
+}
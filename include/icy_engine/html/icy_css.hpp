@@ -3,6 +3,8 @@
 #include "icy_html.hpp"
 
 struct css_computed_style;
+struct lwc_string_s;
+class css_handler;
 
 namespace icy
 {
@@ -55,7 +57,15 @@ namespace icy
         error_type create(const string_view url, const const_array_view<char> parse, css_style& style) noexcept;
         error_type insert(const css_style& style) noexcept;
         error_type erase(const css_style& style) noexcept;
+        //  per-document pass before selection: interns tag / id / class atoms and counts element siblings
+        //  ("apply" runs it again when nodes were added or the document was prepared by another system)
+        error_type prepare(html_document_css& doc) const noexcept;
+        //  nodes must be styled parent first; siblings in document order can then share libcss results
         error_type apply(html_document_css& doc, const uint32_t index) const noexcept;
+        //  styles every element (text nodes are skipped) on "threads" workers (0: one per core).
+        //  A sibling group becomes a task once its parent is styled; large groups are split.
+        //  A heap given to "create_css_system" must be created with "multithread".
+        error_type cascade(html_document_css& doc, const size_t threads = 0) const noexcept;
     public:
         class data_type;
         data_type* data = nullptr;  
@@ -64,12 +74,18 @@ namespace icy
     class html_node_css : public html_node
     {
         friend css_system;
+        friend html_document_css;
+        friend ::css_handler;
     public:
         using html_node::html_node;
         html_node_css(html_node_css&& rhs) noexcept : html_node(std::move(rhs)),
-            m_flags(rhs.m_flags), m_style(rhs.m_style)
+            m_flags(rhs.m_flags), m_style(rhs.m_style), m_system(rhs.m_system), m_select(rhs.m_select),
+            m_tag_atom(rhs.m_tag_atom), m_id_atom(rhs.m_id_atom), m_class_mask(rhs.m_class_mask),
+            m_class_offset(rhs.m_class_offset), m_class_count(rhs.m_class_count), m_prev(rhs.m_prev),
+            m_before(rhs.m_before), m_after(rhs.m_after), m_before_tag(rhs.m_before_tag), m_after_tag(rhs.m_after_tag)
         {
             rhs.m_style = nullptr;
+            rhs.m_select = nullptr;
         }
         ICY_DEFAULT_MOVE_ASSIGN(html_node_css);
         ~html_node_css() noexcept;
@@ -79,20 +95,35 @@ namespace icy
             return m_flags;
         }
         icy::color color() const noexcept;
-        
+    private:
+        void release() noexcept;
     private:
         css_flags m_flags = css_flags::none;
         css_computed_style* m_style = nullptr;
         css_system m_system;
+        void* m_select = nullptr;           //  libcss node data: ancestor bloom filter and partial styles to share
+        lwc_string_s* m_tag_atom = nullptr; //  atoms are interned by "css_system::prepare" and owned by the document
+        lwc_string_s* m_id_atom = nullptr;
+        uint64_t m_class_mask = 0;          //  one bit per class atom, tested before the list is scanned
+        uint32_t m_class_offset = 0;        //  class atoms range in "html_document_css::m_atoms"
+        uint32_t m_class_count = 0;
+        uint32_t m_prev = 0;                //  previous element sibling (0: none)
+        uint32_t m_before = 0;              //  element siblings before / after this node
+        uint32_t m_after = 0;
+        uint32_t m_before_tag = 0;          //  same, counting only siblings with the same tag
+        uint32_t m_after_tag = 0;
     };
 
     class html_document_css : public html_document_base
     {
+        friend css_system;
+        friend ::css_handler;
     public:
-        html_document_css(heap* const heap = nullptr) noexcept : html_document_base(heap), m_data(heap)
+        html_document_css(heap* const heap = nullptr) noexcept : html_document_base(heap), m_data(heap), m_atoms(heap)
         {
 
         }
+        ~html_document_css() noexcept;
         size_t size() const noexcept
         {
             return m_data.size();
@@ -105,12 +136,21 @@ namespace icy
         {
             return index < m_data.size() ? &m_data[index] : nullptr;
         }
+        error_type reserve(const size_t count) noexcept override
+        {
+            return m_data.reserve(count);
+        }
         error_type insert(const html_type type, const string_view tag, const uint32_t parent) noexcept override
         {
-            return m_data.emplace_back(m_heap, uint32_t(m_data.size()), type, tag, parent);
+            return m_data.emplace_back(*this, uint32_t(m_data.size()), type, tag, parent);
         }
+    private:
+        void release() noexcept;
     private:
         array<html_node_css> m_data;
+        css_system m_system;                //  owner of the atoms below
+        array<lwc_string_s*> m_atoms;       //  class atoms of all nodes, back to back
+        size_t m_prepared = 0;              //  node count at the last "prepare"
     };
 
     error_type create_css_system(heap* const heap, css_system& system) noexcept;
@@ -13,12 +13,53 @@ namespace icy
         node,
         text,
     };
+    //  bump allocator for one document: memory goes back to the heap only all at once
+    class html_arena
+    {
+        struct chunk_type;
+    public:
+        html_arena(heap* const heap = nullptr) noexcept : m_heap(heap)
+        {
+
+        }
+        html_arena(html_arena&& rhs) noexcept : m_heap(rhs.m_heap), m_chunk(rhs.m_chunk), m_bytes(rhs.m_bytes)
+        {
+            rhs.m_chunk = nullptr;
+            rhs.m_bytes = 0;
+        }
+        ICY_DEFAULT_MOVE_ASSIGN(html_arena);
+        ~html_arena() noexcept
+        {
+            clear();
+        }
+        void* allocate(const size_t size, const size_t align = alignof(std::max_align_t)) noexcept;
+        void clear() noexcept;
+        //  bytes taken from the heap
+        size_t bytes() const noexcept
+        {
+            return m_bytes;
+        }
+    private:
+        heap* m_heap = nullptr;
+        chunk_type* m_chunk = nullptr;
+        size_t m_bytes = 0;
+    };
+
+    //  offsets into the document string pool
+    struct html_attribute
+    {
+        uint32_t key = 0;
+        uint32_t key_size = 0;
+        uint32_t val = 0;
+        uint32_t val_size = 0;
+    };
+
     class html_node
     {
         friend html_document_base;
     public:
-        html_node(heap* const heap, const uint32_t index, const html_type type, const string_view tag, const uint32_t parent) noexcept : 
-            m_index(index), m_type(type), m_tag(tag), m_parent(parent), m_attributes(heap), m_text(heap), m_children(heap)
+        html_node(const html_document_base& doc, const uint32_t index, const html_type type, const string_view tag, const uint32_t parent) noexcept :
+            m_doc(&doc), m_index(index), m_type(type), m_tag(tag), m_parent(parent)
         {
 
         }
@@ -34,64 +75,116 @@ namespace icy
         {
             return m_tag;
         }
-        const_array_view<uint32_t> children() const noexcept
-        {
-            return m_children;
-        }
         uint32_t parent() const noexcept
         {
             return m_parent;
         }
-        string_view text() const noexcept
-        {
-            return m_text;
-        }
-        const_array_view<string> keys() const noexcept
+        const_array_view<uint32_t> children() const noexcept;
+        string_view text() const noexcept;
+        size_t attributes() const noexcept
         {
-            return m_attributes.keys();
-        }
-        const_array_view<string> vals() const noexcept
-        {
-            return m_attributes.vals();
-        }
-        string_view find(const string_view attribute) const noexcept
-        {
-            const auto it = m_attributes.find(attribute);
-            if (it == m_attributes.end())
-                return string_view();
-            else
-                return it->value;
-        }
-    private:
-        error_type initialize(html_node& parent) noexcept
-        {
-            ICY_ASSERT(parent.index() == m_parent, "INVALID PARENT");
-            return parent.m_children.push_back(m_index);
+            return m_attributes_count;
         }
+        string_view key(const size_t index) const noexcept;
+        string_view val(const size_t index) const noexcept;
+        //  attributes are sorted by key
+        string_view find(const string_view attribute) const noexcept;
     private:
+        const html_document_base* m_doc = nullptr;
         const uint32_t m_index;
         html_type m_type = html_type::null;
-        string_view m_tag;
-        array<uint32_t> m_children;
+        string_view m_tag;                  //  static gumbo tag names
         uint32_t m_parent = 0;
-        string m_text;
-        map<string, string> m_attributes;
+        uint32_t m_children = 0;            //  range in the document children pool
+        uint32_t m_children_count = 0;
+        uint32_t m_text = 0;                //  range in the document string pool
+        uint32_t m_text_size = 0;
+        uint32_t m_attributes = 0;          //  range in the document attribute pool
+        uint32_t m_attributes_count = 0;
     };
     string_view html_tag_normalize(const string_view tag) noexcept;
 
+    //  Text, attributes and child lists of all nodes live in three pools allocated from the document arena;
+    //  nodes are inserted once, in document order, after "reserve".
     class html_document_base
     {
+        friend html_node;
     public:
-        html_document_base(heap* heap = nullptr) noexcept : m_heap(heap)
+        html_document_base(heap* heap = nullptr) noexcept : m_heap(heap), m_arena(heap)
         {
 
         }
+        //  full HTML5 tree construction; gumbo allocates from a parse arena that is released after the copy
         error_type initialize(const const_array_view<char> parse) noexcept;
+        //  tokenizer only, gumbo never builds its tree: peak memory is the DOM plus one token.
+        //  Elements nest as written (an end tag closes up to the matching open element, void elements
+        //  and "/>" do not nest); there are no implied elements and no recovery from misnested tags.
+        //  The tree matches "initialize" only when the source spells out "html", "head", "body" (and "tbody")
+        //  and nests correctly; otherwise it is smaller and shaped as written.
+        error_type initialize_stream(const const_array_view<char> parse) noexcept;
+        //  bytes taken from the heap by the pools (nodes are owned by the derived document)
+        size_t bytes() const noexcept
+        {
+            return m_arena.bytes();
+        }
         virtual size_t size() const noexcept = 0;
         virtual const html_node* node(const size_t index) const noexcept = 0;
         virtual html_node* node(const size_t index) noexcept = 0;
+        virtual error_type reserve(const size_t count) noexcept = 0;
         virtual error_type insert(const html_type type, const string_view tag, const uint32_t parent) noexcept = 0;
+    private:
+        error_type reserve_pools(const size_t strings, const size_t attributes) noexcept;
+        error_type append(const char* const ptr, const size_t size) noexcept;
+        error_type append(html_node& node, const string_view key, const string_view val) noexcept;
+        error_type finish() noexcept;
     protected:
         heap* m_heap = nullptr;
+    private:
+        html_arena m_arena;
+        char* m_strings = nullptr;
+        size_t m_strings_size = 0;
+        size_t m_strings_capacity = 0;
+        html_attribute* m_attributes = nullptr;
+        size_t m_attributes_size = 0;
+        size_t m_attributes_capacity = 0;
+        uint32_t* m_children = nullptr;
     };
+
+    inline const_array_view<uint32_t> html_node::children() const noexcept
+    {
+        return const_array_view<uint32_t>(m_doc->m_children + m_children, m_children_count);
+    }
+    inline string_view html_node::text() const noexcept
+    {
+        return string_view(m_doc->m_strings + m_text, m_text_size, string_view::constexpr_tag());
+    }
+    inline string_view html_node::key(const size_t index) const noexcept
+    {
+        ICY_ASSERT(index < m_attributes_count, "INVALID ATTRIBUTE");
+        const auto& attribute = m_doc->m_attributes[m_attributes + index];
+        return string_view(m_doc->m_strings + attribute.key, attribute.key_size, string_view::constexpr_tag());
+    }
+    inline string_view html_node::val(const size_t index) const noexcept
+    {
+        ICY_ASSERT(index < m_attributes_count, "INVALID ATTRIBUTE");
+        const auto& attribute = m_doc->m_attributes[m_attributes + index];
+        return string_view(m_doc->m_strings + attribute.val, attribute.val_size, string_view::constexpr_tag());
+    }
+    inline string_view html_node::find(const string_view attribute) const noexcept
+    {
+        auto lo = 0_z;
+        auto hi = size_t(m_attributes_count);
+        while (lo < hi)
+        {
+            const auto mid = (lo + hi) / 2;
+            const auto cmp = key(mid);
+            if (cmp < attribute)
+                lo = mid + 1;
+            else if (attribute < cmp)
+                hi = mid;
+            else
+                return val(mid);
+        }
+        return string_view();
+    }
 }
\ No newline at end of file
@@ -206,6 +206,9 @@ namespace icy
         error_type send(const http_response& response) noexcept;
         error_type send(const http_request& request) noexcept;
         error_type recv() noexcept;
+        //  after "network_disconnect": reuse this system (and its thread) for another request;
+        //  a failed connect is reported as "network_disconnect" with an error
+        error_type connect(const network_address& address, const http_request& request) noexcept;
     private:
         error_type exec() noexcept override;
     private:
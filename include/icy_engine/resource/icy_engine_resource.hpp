@@ -1,6 +1,7 @@
 #pragma once
 
 #include <icy_engine/core/icy_event.hpp>
+#include <icy_engine/core/icy_future.hpp>
 #include <icy_engine/core/icy_string.hpp>
 #include <icy_engine/core/icy_matrix.hpp>
 #include <icy_engine/core/icy_color.hpp>
@@ -67,6 +68,7 @@ namespace icy
     struct render_material;
     struct render_mesh;
     struct render_node;
+    struct render_texture_options;
 
     struct resource_event 
     {
@@ -187,6 +189,13 @@ namespace icy
         virtual error_type store(const resource_header& header, const string_view path) noexcept = 0;
         virtual error_type store(const resource_header& header, const const_array_view<uint8_t> bytes) noexcept = 0;
         virtual error_type store(const guid& index, const const_matrix_view<color> colors) noexcept = 0;
+        //  import as resource_type::texture: mip chain and block compression run on the resource thread
+        virtual error_type store(const resource_header& header, const const_matrix_view<color> image, const render_texture_options& options) noexcept = 0;
+        //  request / response: the result completes "future" on the resource thread instead of
+        //  being broadcast as "resource_load" / "resource_store" to every subscriber
+        virtual error_type load(const resource_header& header, future<resource_event>& future) noexcept = 0;
+        virtual error_type store(const resource_header& header, const string_view path, future<resource_event>& future) noexcept = 0;
+        virtual error_type store(const resource_header& header, const const_array_view<uint8_t> bytes, future<resource_event>& future) noexcept = 0;
         virtual error_type list(map<guid, resource_data>& output) const noexcept = 0;
         virtual error_type list(const resource_locale locale, array<resource_event>& output) const noexcept = 0;
     };
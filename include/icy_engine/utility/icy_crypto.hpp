@@ -1,6 +1,6 @@
 #pragma once
 
-#include <icy_engine/core/icy_string_view.hpp>
+#include <icy_engine/core/icy_map.hpp>
 
 namespace icy
 {
@@ -105,11 +105,69 @@ namespace icy
         uint8_t m_array[16];
     };
     
+    //  precomputed X25519 shared key for a (public, private) key pair:
+    //  public-key messages encoded with a session skip the scalar multiplication
+    class crypto_session
+    {
+    public:
+        crypto_session() noexcept = default;
+        error_type initialize(const crypto_key& public_key, const crypto_key& private_key) noexcept;
+        const crypto_key& key() const noexcept
+        {
+            return m_key;
+        }
+    private:
+        crypto_key m_key;
+    };
+
+    //  thread-safe LRU-bounded cache of sessions (servers talking to many peers)
+    class crypto_session_cache
+    {
+    public:
+        crypto_session_cache() noexcept = default;
+        crypto_session_cache(const crypto_session_cache&) = delete;
+        error_type initialize(const size_t capacity) noexcept;
+        error_type find(const crypto_key& public_key, const crypto_key& private_key, crypto_session& session) noexcept;
+        void clear() noexcept;
+        //  read under the lock: safe to poll while other threads call "find"
+        size_t size() const noexcept;
+        size_t hits() const noexcept;
+        size_t misses() const noexcept;
+    private:
+        void unlink(const uint32_t index) noexcept;
+        void link(const uint32_t index) noexcept;
+        size_t find_slot(const uint64_t hash) const noexcept;
+        void erase_slot(size_t slot) noexcept;
+    private:
+        struct entry_type
+        {
+            crypto_key public_key;
+            crypto_key private_key;
+            crypto_session session;
+            uint64_t hash = 0;
+            uint32_t prev = UINT32_MAX;
+            uint32_t next = UINT32_MAX;
+        };
+        mutable mutex m_lock;
+        array<entry_type> m_entries;
+        array<uint32_t> m_slots;    //  open addressing (linear probing) over "entry_type::hash", UINT32_MAX is empty
+        size_t m_capacity = 0;
+        uint32_t m_head = UINT32_MAX;   //  most recently used
+        uint32_t m_tail = UINT32_MAX;   //  least recently used
+        size_t m_hits = 0;
+        size_t m_misses = 0;
+    };
+
     static constexpr auto crypto_msg_size = sizeof(crypto_nonce) + sizeof(crypto_mac);
     error_type crypto_msg_encode(const crypto_key& key, const const_array_view<uint8_t> input, array_view<uint8_t> output) noexcept;
     error_type crypto_msg_encode(const crypto_key& public_key, const crypto_key& private_key, const const_array_view<uint8_t> input, array_view<uint8_t> output) noexcept;
     error_type crypto_msg_decode(const crypto_key& key, const const_array_view<uint8_t> input, array_view<uint8_t> output) noexcept;
     error_type crypto_msg_decode(const crypto_key& public_key, const crypto_key& private_key, const const_array_view<uint8_t> input, array_view<uint8_t> output) noexcept;
+    error_type crypto_msg_encode(const crypto_session& session, const const_array_view<uint8_t> input, array_view<uint8_t> output) noexcept;
+    error_type crypto_msg_decode(const crypto_session& session, const const_array_view<uint8_t> input, array_view<uint8_t> output) noexcept;
+    //  batch: messages of "size" bytes packed back to back (output blocks are "size + crypto_msg_size" bytes)
+    error_type crypto_msg_encode(const crypto_session& session, const size_t size, const const_array_view<uint8_t> input, array_view<uint8_t> output) noexcept;
+    error_type crypto_msg_decode(const crypto_session& session, const size_t size, const const_array_view<uint8_t> input, array_view<uint8_t> output) noexcept;
 
     class crypto_msg_base
     {
@@ -120,8 +178,10 @@ namespace icy
         }
         crypto_msg_base(const crypto_key& key, const size_t size, const void* const input, void* const output) noexcept;
         crypto_msg_base(const crypto_key& public_key, const crypto_key& private_key, const size_t size, const void* input, void* const output) noexcept;
+        crypto_msg_base(const crypto_session& session, const size_t size, const void* input, void* const output) noexcept;
         error_type decode(const crypto_key& key, const size_t size, const void* const input, void* const output) const noexcept;
         error_type decode(const crypto_key& public_key, const crypto_key& private_key, const size_t size, const void* const input, void* const output) const noexcept;
+        error_type decode(const crypto_session& session, const size_t size, const void* const input, void* const output) const noexcept;
     private:
         const crypto_nonce m_nonce;
         crypto_mac m_mac;
@@ -148,6 +208,11 @@ namespace icy
             crypto_msg_base(public_key, private_key, sizeof(T), &input, m_value)
         {
 
+        }
+        //  public encode (precomputed)
+        crypto_msg(const crypto_session& session, const T& input) noexcept : crypto_msg_base(session, sizeof(T), &input, m_value)
+        {
+
         }
         //  private decode
         error_type decode(const crypto_key& key, T& value) const noexcept
@@ -159,7 +224,32 @@ namespace icy
         {
             return crypto_msg_base::decode(public_key, private_key, sizeof(T), m_value, &value);
         }
+        //  public decode (precomputed)
+        error_type decode(const crypto_session& session, T& value) const noexcept
+        {
+            return crypto_msg_base::decode(session, sizeof(T), m_value, &value);
+        }
     private:
         uint8_t m_value[sizeof(T)];
     };
+
+    template<typename T>
+    inline error_type crypto_msg_encode(const crypto_session& session, const const_array_view<T> input, array_view<crypto_msg<T>> output) noexcept
+    {
+        if (input.size() != output.size())
+            return make_stdlib_error(std::errc::message_size);
+        //  constructed in place: "crypto_msg" has a const nonce, so it can't be assigned
+        for (auto k = 0_z; k < input.size(); ++k)
+            new (output.data() + k) crypto_msg<T>(session, input[k]);
+        return error_type();
+    }
+    template<typename T>
+    inline error_type crypto_msg_decode(const crypto_session& session, const const_array_view<crypto_msg<T>> input, array_view<T> output) noexcept
+    {
+        if (input.size() != output.size())
+            return make_stdlib_error(std::errc::message_size);
+        for (auto k = 0_z; k < input.size(); ++k)
+            ICY_ERROR(input[k].decode(session, output[k]));
+        return error_type();
+    }
 }
\ No newline at end of file
@@ -25,6 +25,10 @@ namespace icy
     class lua_system;
     class lua_object;
     class lua_variable;
+    class json;
+    class color;
+    template<typename T> class const_matrix_view;
+    template<typename K, typename V> class map;
     using lua_cfunction = error_type(*)(void* user, const const_array_view<lua_variable> input, array<lua_variable>* output);
     using lua_cvarfunction = error_type(*)(array_view<lua_variable> user, const const_array_view<lua_variable> input, array<lua_variable>* output);
     extern const char* lua_keywords;
@@ -38,6 +42,17 @@ namespace icy
         utf8,
         table,
         threads,
+        _total,
+    };
+    //  cache counters cover every system sharing the cache (a pool), arena counters one system
+    struct lua_system_stats
+    {
+        uint64_t cache_hits = 0;
+        uint64_t cache_misses = 0;
+        uint64_t cache_evictions = 0;
+        size_t cache_chunks = 0;
+        size_t arena_pages = 0;         //  64 KB pages for blocks up to 512 bytes
+        uint64_t arena_reused = 0;      //  blocks handed out again from a free list
     };
     class lua_system
     {
@@ -46,6 +61,7 @@ namespace icy
         {
 
         }
+        //  compiled chunks are cached by a hash of "name" and "str" (one cache per pool or standalone system)
         virtual error_type parse(lua_variable& function, const string_view str, const char* const name = nullptr) const LUA_NOEXCEPT = 0;
         virtual error_type make_table(lua_variable& var) const LUA_NOEXCEPT = 0;
         virtual error_type make_string(lua_variable& var, const string_view str) const LUA_NOEXCEPT = 0;
@@ -61,6 +77,16 @@ namespace icy
         virtual error_type make_function(lua_variable& var, const lua_cfunction func, void* const data) const LUA_NOEXCEPT = 0;
         virtual error_type make_varfunction(lua_variable& var, const lua_cvarfunction func, const const_array_view<lua_variable> vars) const LUA_NOEXCEPT = 0;
         virtual error_type make_library(lua_variable& var, const lua_default_library type) const LUA_NOEXCEPT = 0;
+        //  views let scripts read the data in place: "#view", "view[index]" (1-based, nil when out of range),
+        //  "view[key]" (json objects and maps) and "pairs(view)"; nested json arrays and objects are views too.
+        //  Byte views add "view:sub(first, last)" (a string of that range), image views "view.width",
+        //  "view.height" and "view:get(x, y)" (r, g, b, a); "view[index]" of an image is the bgra value.
+        //  Nothing is copied up front: the data must stay alive and unchanged while scripts can reach the view.
+        //  The variable is a "lua_type::table" that "find" and "next" read like one; "insert" fails (read-only).
+        virtual error_type make_view(lua_variable& var, const const_array_view<uint8_t> bytes) const LUA_NOEXCEPT = 0;
+        virtual error_type make_view(lua_variable& var, const const_matrix_view<color>& image) const LUA_NOEXCEPT = 0;
+        virtual error_type make_view(lua_variable& var, const json& json) const LUA_NOEXCEPT = 0;
+        virtual error_type make_view(lua_variable& var, const map<string, lua_variable>& map) const LUA_NOEXCEPT = 0;
         virtual error_type copy(const lua_variable& src, lua_variable& dst) const LUA_NOEXCEPT = 0;
         virtual error_type post_error(const string_view str) const LUA_NOEXCEPT = 0;
         template<typename... arg_type>
@@ -73,6 +99,7 @@ namespace icy
         virtual error_type print(const lua_variable& var, error_type(*pfunc)(void* pdata, const string_view str), void* const pdata) const LUA_NOEXCEPT = 0;
         virtual realloc_func realloc() const noexcept = 0;
         virtual void* user() const noexcept = 0;
+        virtual lua_system_stats stats() const noexcept = 0;
     };
 
     error_type create_lua_system(shared_ptr<lua_system>& system, const realloc_func realloc, void* const user) noexcept;
@@ -81,6 +108,32 @@ namespace icy
         return create_lua_system(system, heap ? heap_realloc : global_realloc, heap);
     }
 
+    //  pre-initialized systems for threads running many small scripts: each has "libraries" loaded
+    //  ("make_library" returns the same table every time) and all share one compiled chunk cache
+    //  (bounded: the least recently used chunks are evicted).
+    //  A checked out system belongs to one thread; its variables must not be used after "checkin".
+    //  "checkin" puts back the fields of the global table, "package.loaded" and the preloaded library tables
+    //  as they were after creation; the reset is shallow (nested tables and metatables keep script changes).
+    class lua_pool
+    {
+    public:
+        virtual ~lua_pool() noexcept = 0
+        {
+
+        }
+        //  an idle system, or a new one when all are checked out
+        virtual error_type checkout(shared_ptr<lua_system>& system) noexcept = 0;
+        virtual error_type checkin(shared_ptr<lua_system>&& system) noexcept = 0;
+    };
+    //  "size" systems are created up front
+    error_type create_lua_pool(shared_ptr<lua_pool>& pool, const const_array_view<lua_default_library> libraries,
+        const size_t size, const realloc_func realloc, void* const user) noexcept;
+    inline error_type create_lua_pool(shared_ptr<lua_pool>& pool, const const_array_view<lua_default_library> libraries,
+        const size_t size, heap* const heap = nullptr)
+    {
+        return create_lua_pool(pool, libraries, size, heap ? heap_realloc : global_realloc, heap);
+    }
+
     class lua_object
     {
     public:
@@ -88,7 +141,8 @@ namespace icy
         virtual void release() noexcept = 0;
         virtual error_type find(const lua_variable& key, lua_variable& val) LUA_NOEXCEPT = 0;
         virtual error_type insert(const lua_variable& key, const lua_variable& val) LUA_NOEXCEPT = 0;
-        virtual error_type map(array<lua_variable>& keys, array<lua_variable>& vals) LUA_NOEXCEPT = 0;
+        //  "key" is none to start and none again after the last pair
+        virtual error_type next(lua_variable& key, lua_variable& val) LUA_NOEXCEPT = 0;
         virtual error_type operator()(const const_array_view<lua_variable> input, array<lua_variable>* output) LUA_NOEXCEPT = 0;
         virtual error_type meta(lua_variable& meta) LUA_NOEXCEPT = 0;
         virtual string_view name() const noexcept = 0;
@@ -277,10 +331,10 @@ namespace icy
             else
                 return make_stdlib_error(std::errc::invalid_argument);
         }
-        error_type map(array<lua_variable>& keys, array<lua_variable>& vals) const LUA_NOEXCEPT
+        error_type next(lua_variable& key, lua_variable& val) const LUA_NOEXCEPT
         {
             if (auto ptr = as_object())
-                return ptr->map(keys, vals);
+                return ptr->next(key, val);
             else
                 return make_stdlib_error(std::errc::invalid_argument);
         }
@@ -584,6 +584,16 @@ namespace icy
         virtual error_type modify(const gui_node node, const gui_node_prop prop, const gui_variant& value) noexcept = 0;
         virtual error_type insert(const gui_node parent, const uint32_t row, const uint32_t col, gui_node& node) noexcept = 0;
         virtual error_type destroy(const gui_node node) noexcept = 0;
+        //  changes between "begin" and "commit" reach the GUI thread as one block (nested pairs join the outer one);
+        //  repeated "modify" of the same node property keeps only the last value
+        virtual error_type begin() noexcept
+        {
+            return error_type();
+        }
+        virtual error_type commit() noexcept
+        {
+            return error_type();
+        }
     };
     struct gui_data_read_model
     {
@@ -638,6 +648,15 @@ namespace icy
             return error_type();
         }
     };
+    //  GUI thread counters: model changes applied and the time spent applying them
+    //  ("model_time") and pushing them through data binds ("bind_time")
+    struct gui_system_stats
+    {
+        uint64_t model_events = 0;
+        uint64_t model_nodes = 0;
+        duration_type model_time = {};
+        duration_type bind_time = {};
+    };
     struct gui_system : public event_system
     {
         virtual const icy::thread& thread() const noexcept = 0;
@@ -649,6 +668,7 @@ namespace icy
         virtual error_type create_model(shared_ptr<gui_data_write_model>& model) noexcept = 0;
         virtual error_type create_window(shared_ptr<gui_window>& window, shared_ptr<icy::window> handle, icy::string_view json) noexcept = 0;
         virtual error_type enum_font_names(array<string>& fonts) const noexcept = 0;
+        virtual gui_system_stats stats() const noexcept = 0;
     };
     error_type create_gui_system(shared_ptr<gui_system>& system) noexcept;
 
@@ -63,7 +63,12 @@ private:
     dictionary<string> m_data;
 };
 
+const auto street_name_max = 128u;   //  longer names are truncated before comparison
+const auto street_variants = 10u;
+
+error_type street_name_decode(const string_view utf8, char32_t(&buffer)[street_name_max], size_t& size) noexcept;
 error_type jaro_winkler_distance(const string_view utf8lhs, const string_view utf8rhs, double& distance) noexcept;
+double jaro_winkler_distance(const const_array_view<char32_t> lhs, const const_array_view<char32_t> rhs) noexcept;
 
 struct pair_type
 {
@@ -79,6 +84,171 @@ struct pair_type
     string_view name;
     double distance;
 };
+
+//  trigram inverted index: candidates sharing the most trigrams with the query
+//  are verified with Jaro-Winkler instead of scoring every name in the set
+class street_index
+{
+    struct gram_type
+    {
+        bool operator<(const gram_type& rhs) const noexcept
+        {
+            return key < rhs.key || (key == rhs.key && index < rhs.index);
+        }
+        bool operator==(const gram_type& rhs) const noexcept
+        {
+            return key == rhs.key && index == rhs.index;
+        }
+        uint64_t key;
+        uint32_t index;
+    };
+    struct score_type
+    {
+        uint32_t index;
+        uint32_t count;
+    };
+public:
+    size_t size() const noexcept
+    {
+        return m_names.size();
+    }
+    error_type initialize(const const_array_view<string> names) noexcept
+    {
+        m_names.clear();
+        m_chars.clear();
+        m_chars_offset.clear();
+        m_gram_count.clear();
+        m_grams.clear();
+        m_offset.clear();
+        m_postings.clear();
+        m_counts.clear();
+        m_scores.clear();
+
+        array<gram_type> grams;
+        for (auto&& name : names)
+        {
+            char32_t chars[street_name_max];
+            auto size = 0_z;
+            ICY_ERROR(street_name_decode(name, chars, size));
+
+            const auto index = uint32_t(m_names.size());
+            ICY_ERROR(m_names.push_back(name));
+            ICY_ERROR(m_chars_offset.push_back(uint32_t(m_chars.size())));
+            ICY_ERROR(m_chars.append(chars, chars + size));
+
+            uint64_t keys[street_name_max];
+            const auto count = make_grams(chars, size, keys);
+            ICY_ERROR(m_gram_count.push_back(uint32_t(count)));
+            for (auto k = 0_z; k < count; ++k)
+                ICY_ERROR(grams.push_back({ keys[k], index }));
+        }
+        ICY_ERROR(m_chars_offset.push_back(uint32_t(m_chars.size())));
+
+        std::sort(grams.begin(), grams.end());
+        ICY_ERROR(m_postings.reserve(grams.size()));
+        for (auto it = grams.begin(); it != grams.end(); ++it)
+        {
+            if (it == grams.begin() || it[-1].key != it->key)
+            {
+                ICY_ERROR(m_grams.push_back(it->key));
+                ICY_ERROR(m_offset.push_back(uint32_t(m_postings.size())));
+            }
+            ICY_ERROR(m_postings.push_back(it->index));
+        }
+        ICY_ERROR(m_offset.push_back(uint32_t(m_postings.size())));
+        ICY_ERROR(m_counts.resize(m_names.size()));
+        ICY_ERROR(m_scores.reserve(m_names.size()));
+        return {};
+    }
+    //  top "count" names sorted by descending Jaro-Winkler similarity
+    //  (uses the index scratch buffers: one caller at a time)
+    error_type find(const string_view name, const size_t count, array<pair_type>& output) const noexcept
+    {
+        output.clear();
+        if (m_names.empty() || !count)
+            return {};
+
+        char32_t chars[street_name_max];
+        auto size = 0_z;
+        ICY_ERROR(street_name_decode(name, chars, size));
+
+        uint64_t keys[street_name_max];
+        const auto key_count = make_grams(chars, size, keys);
+
+        //  "m_counts" stays zeroed between queries: only the entries listed in "scores" are touched
+        //  and reset, so a query costs O(postings) instead of O(names)
+        auto& counts = m_counts;
+        auto& scores = m_scores;
+        scores.clear();
+        for (auto k = 0_z; k < key_count; ++k)
+        {
+            const auto it = std::lower_bound(m_grams.begin(), m_grams.end(), keys[k]);
+            if (it == m_grams.end() || *it != keys[k])
+                continue;
+            const auto gram = size_t(it - m_grams.begin());
+            for (auto n = m_offset[gram]; n < m_offset[gram + 1]; ++n)
+            {
+                const auto index = m_postings[n];
+                if (!counts[index]++)
+                    scores.push_back({ index, 0 });     //  reserved for every name, never reallocates
+            }
+        }
+        for (auto&& score : scores)
+        {
+            score.count = counts[score.index];
+            counts[score.index] = 0;
+        }
+
+        //  rank by Dice coefficient (2 * common / (lhs + rhs)), verify only the best few
+        const auto dice = [this, key_count](const score_type& score)
+        {
+            return 2.0 * score.count / (key_count + m_gram_count[score.index]);
+        };
+        const auto verify = std::min(scores.size(), std::max(count * 4, 32_z));
+        std::partial_sort(scores.begin(), scores.begin() + verify, scores.end(),
+            [&dice](const score_type& lhs, const score_type& rhs) { return dice(lhs) > dice(rhs); });
+
+        const auto query = const_array_view<char32_t>(chars, size);
+        for (auto k = 0_z; k < verify; ++k)
+        {
+            const auto index = scores[k].index;
+            const auto value = const_array_view<char32_t>(m_chars.data() + m_chars_offset[index],
+                m_chars_offset[index + 1] - m_chars_offset[index]);
+            ICY_ERROR(output.push_back({ m_names[index], jaro_winkler_distance(query, value) }));
+        }
+        std::sort(output.begin(), output.end());
+        while (output.size() > count)
+            output.pop_back();
+        return {};
+    }
+private:
+    //  unique padded trigrams (21 bits per code point), returns count
+    static size_t make_grams(const char32_t* chars, const size_t size, uint64_t(&keys)[street_name_max]) noexcept
+    {
+        if (!size)
+            return 0;
+
+        const auto chr = [chars, size](const size_t index) -> uint64_t
+        {
+            return index == 0 || index > size ? 0 : chars[index - 1] & 0x1FFFFF;
+        };
+        const auto count = std::min(size_t(street_name_max), size);
+        for (auto k = 0_z; k < count; ++k)
+            keys[k] = (chr(k) << 42) | (chr(k + 1) << 21) | chr(k + 2);
+        std::sort(keys, keys + count);
+        return size_t(std::unique(keys, keys + count) - keys);
+    }
+private:
+    array<string_view> m_names;
+    array<char32_t> m_chars;            //  normalized code points
+    array<uint32_t> m_chars_offset;     //  name index -> m_chars (size + 1)
+    array<uint32_t> m_gram_count;       //  unique trigrams per name
+    array<uint64_t> m_grams;            //  sorted trigram keys
+    array<uint32_t> m_offset;           //  trigram -> m_postings (size + 1)
+    array<uint32_t> m_postings;         //  name indices
+    mutable array<uint32_t> m_counts;   //  query scratch: shared trigrams per name (all zero when idle)
+    mutable array<score_type> m_scores; //  query scratch: names touched by the query
+};
 struct osm_addr
 {
     uint64_t index = 0;
@@ -284,14 +454,11 @@ struct fias_city
     {
         if (street == streets.end())
         {
+            if (fuzzy.size() != streets.size())
+                ICY_ERROR(fuzzy.initialize(streets.keys()));
+
             array<pair_type> vec;
-            for (auto&& pair : streets)
-            {
-                auto distance = 0.0;
-                ICY_ERROR(jaro_winkler_distance(pair.key, street_name, distance));
-                ICY_ERROR(vec.push_back({ pair.key, distance }));
-            }
-            std::sort(vec.begin(), vec.end());
+            ICY_ERROR(fuzzy.find(street_name, street_variants, vec));
             string msg;
             ICY_ERROR(msg.appendf("\r\nStreet \"%1\" not found. Variants:"_s, string_view(street_name)));
             for (auto k = vec.size(); k--; )
@@ -333,7 +500,7 @@ struct fias_city
 
     uint64_t index = 0;
     dictionary<fias_street> streets;
-
+    street_index fuzzy;
 };
 struct coords_addr
 {
@@ -388,12 +555,65 @@ private:
     array<osm_addr> m_ways;
     array<osm_addr> m_rels;
 };
+//  permutation that sorts "keys" (empty if they are already sorted); duplicate ids are rejected
+//  with "invalid_argument", like the map inserts these tables replaced
+error_type sort_order(const const_array_view<uint64_t> keys, array<uint32_t>& order) noexcept
+{
+    order.clear();
+    if (std::adjacent_find(keys.begin(), keys.end(), std::greater_equal<uint64_t>()) == keys.end())
+        return {};
+
+    ICY_ERROR(order.resize(keys.size()));
+    for (auto k = 0u; k < order.size(); ++k)
+        order[k] = k;
+    //  ids are unique, so the order does not need to be stable (std::sort needs no temporary buffer)
+    std::sort(order.begin(), order.end(), [&keys](const uint32_t lhs, const uint32_t rhs) { return keys[lhs] < keys[rhs]; });
+    if (std::adjacent_find(order.begin(), order.end(), [&keys](const uint32_t lhs, const uint32_t rhs) { return keys[lhs] == keys[rhs]; }) != order.end())
+    {
+        order.clear();
+        return make_stdlib_error(std::errc::invalid_argument);
+    }
+    return {};
+}
+
+//  packed id -> coord table: parsed rows are appended and sorted once by id, lookups are binary searches
 class osm_node_parser : public csv_parser
 {
 public:
     const osm_coord* find(const uint64_t index) const noexcept
     {
-        return m_data.try_find(index);
+        const auto it = std::lower_bound(m_keys.begin(), m_keys.end(), index);
+        if (it == m_keys.end() || *it != index)
+            return nullptr;
+        return &m_vals[size_t(it - m_keys.begin())];
+    }
+    const_array_view<uint64_t> keys() const noexcept
+    {
+        return m_keys;
+    }
+    error_type operator()(const const_array_view<char> buffer) noexcept override
+    {
+        ICY_ERROR(csv_parser::operator()(buffer));
+        if (buffer.empty())
+        {
+            array<uint32_t> order;
+            ICY_ERROR(sort_order(m_keys, order));
+            if (order.empty())
+                return {};
+
+            array<uint64_t> keys;
+            array<osm_coord> vals;
+            ICY_ERROR(keys.reserve(order.size()));
+            ICY_ERROR(vals.reserve(order.size()));
+            for (auto&& k : order)
+            {
+                ICY_ERROR(keys.push_back(m_keys[k]));
+                ICY_ERROR(vals.push_back(m_vals[k]));
+            }
+            m_keys = std::move(keys);
+            m_vals = std::move(vals);
+        }
+        return {};
     }
 private:
     error_type callback(const const_array_view<string_view> tabs) noexcept override
@@ -406,19 +626,57 @@ private:
         ICY_ERROR(tabs[0].to_value(index));
         ICY_ERROR(tabs[1].to_value(coord.lat));
         ICY_ERROR(tabs[2].to_value(coord.lng));
-        ICY_ERROR(m_data.insert(index, coord));
+        ICY_ERROR(m_keys.push_back(index));
+        ICY_ERROR(m_vals.push_back(coord));
         return {};
     }
 private:
-    map<uint64_t, osm_coord> m_data;
+    array<uint64_t> m_keys;
+    array<osm_coord> m_vals;
 };
+//  packed way -> node list table (ids sorted once parsing finishes, node lists share one pool)
 class osm_way_parser : public csv_parser
 {
 public:
     const_array_view<uint64_t> find(const uint64_t index) const noexcept
     {
-        const auto ptr = m_data.try_find(index);
-        return ptr ? *ptr : const_array_view<uint64_t>{};
+        const auto it = std::lower_bound(m_keys.begin(), m_keys.end(), index);
+        if (it == m_keys.end() || *it != index)
+            return {};
+        const auto k = size_t(it - m_keys.begin());
+        return const_array_view<uint64_t>(m_nodes.data() + m_offset[k], m_offset[k + 1] - m_offset[k]);
+    }
+    error_type operator()(const const_array_view<char> buffer) noexcept override
+    {
+        ICY_ERROR(csv_parser::operator()(buffer));
+        if (buffer.empty())
+        {
+            if (m_offset.size() == m_keys.size())
+                ICY_ERROR(m_offset.push_back(uint32_t(m_nodes.size())));
+
+            array<uint32_t> order;
+            ICY_ERROR(sort_order(m_keys, order));
+            if (order.empty())
+                return {};
+
+            array<uint64_t> keys;
+            array<uint32_t> offset;
+            array<uint64_t> nodes;
+            ICY_ERROR(keys.reserve(order.size()));
+            ICY_ERROR(offset.reserve(order.size() + 1));
+            ICY_ERROR(nodes.reserve(m_nodes.size()));
+            for (auto&& k : order)
+            {
+                ICY_ERROR(keys.push_back(m_keys[k]));
+                ICY_ERROR(offset.push_back(uint32_t(nodes.size())));
+                ICY_ERROR(nodes.append(m_nodes.begin() + m_offset[k], m_nodes.begin() + m_offset[k + 1]));
+            }
+            ICY_ERROR(offset.push_back(uint32_t(nodes.size())));
+            m_keys = std::move(keys);
+            m_offset = std::move(offset);
+            m_nodes = std::move(nodes);
+        }
+        return {};
     }
 private:
     error_type callback(const const_array_view<string_view> tabs) noexcept override
@@ -428,18 +686,20 @@ private:
 
         uint64_t index = 0;
         ICY_ERROR(tabs[0].to_value(index));
-        array<uint64_t> nodes;
+        ICY_ERROR(m_keys.push_back(index));
+        ICY_ERROR(m_offset.push_back(uint32_t(m_nodes.size())));
         for (auto k = 1_z; k < tabs.size(); ++k)
         {
             uint64_t node = 0;
             ICY_ERROR(tabs[k].to_value(node));
-            ICY_ERROR(nodes.push_back(node));
+            ICY_ERROR(m_nodes.push_back(node));
         }
-        ICY_ERROR(m_data.insert(index, std::move(nodes)));
         return {};
     }
 private:
-    map<uint64_t, array<uint64_t>> m_data;
+    array<uint64_t> m_keys;
+    array<uint32_t> m_offset;   //  size + 1
+    array<uint64_t> m_nodes;
 };
 class osm_rel_parser : public csv_parser
 {
@@ -490,6 +750,216 @@ private:
 private:
     map<uint64_t, tuple_type> m_data;
 };
+//  STR-packed R-tree over bounding boxes: point, box and k-nearest queries
+class osm_bounds_tree
+{
+    struct entry_type
+    {
+        osm_bounds bounds;
+        uint32_t index;
+    };
+    struct node_type
+    {
+        osm_bounds bounds;
+        uint32_t first;     //  offset in m_refs
+        uint32_t count;
+    };
+    struct queue_type
+    {
+        bool operator<(const queue_type& rhs) const noexcept
+        {
+            return distance > rhs.distance;
+        }
+        double distance;
+        uint32_t index;
+        bool item;
+    };
+public:
+    static const auto fanout = 16u;
+public:
+    size_t size() const noexcept
+    {
+        return m_bounds.size();
+    }
+    error_type initialize(const const_array_view<osm_bounds> items) noexcept
+    {
+        m_bounds.clear();
+        m_nodes.clear();
+        m_refs.clear();
+        m_leaf_count = 0;
+        if (items.empty())
+            return {};
+
+        ICY_ERROR(m_bounds.append(items.begin(), items.end()));
+
+        array<entry_type> level;
+        for (auto k = 0u; k < items.size(); ++k)
+            ICY_ERROR(level.push_back({ items[k], k }));
+
+        //  leaves reference items, upper levels reference nodes
+        auto leaf = true;
+        while (true)
+        {
+            str_sort(level);
+            array<entry_type> parents;
+            for (auto k = 0_z; k < level.size(); k += fanout)
+            {
+                node_type node;
+                node.bounds = level[k].bounds;
+                node.first = uint32_t(m_refs.size());
+                node.count = uint32_t(std::min(size_t(fanout), level.size() - k));
+                for (auto n = k; n < k + node.count; ++n)
+                {
+                    node.bounds = merge(node.bounds, level[n].bounds);
+                    ICY_ERROR(m_refs.push_back(level[n].index));
+                }
+                ICY_ERROR(parents.push_back({ node.bounds, uint32_t(m_nodes.size()) }));
+                ICY_ERROR(m_nodes.push_back(node));
+            }
+            if (leaf)
+                m_leaf_count = uint32_t(m_nodes.size());
+            leaf = false;
+            if (parents.size() == 1)
+                break;
+            level = std::move(parents);
+        }
+        return {};
+    }
+    //  items containing the point
+    error_type find(const osm_coord& coord, array<uint32_t>& output) const noexcept
+    {
+        osm_bounds bounds;
+        bounds.lower = coord;
+        bounds.upper = coord;
+        return find(bounds, output);
+    }
+    //  items intersecting the box
+    error_type find(const osm_bounds& bounds, array<uint32_t>& output) const noexcept
+    {
+        output.clear();
+        if (m_nodes.empty())
+            return {};
+
+        array<uint32_t> stack;
+        ICY_ERROR(stack.push_back(uint32_t(m_nodes.size() - 1)));
+        while (!stack.empty())
+        {
+            const auto& node = m_nodes[stack.back()];
+            const auto leaf = stack.back() < m_leaf_count;
+            stack.pop_back();
+            if (!intersect(node.bounds, bounds))
+                continue;
+
+            for (auto k = node.first; k < node.first + node.count; ++k)
+            {
+                const auto ref = m_refs[k];
+                if (!leaf)
+                {
+                    ICY_ERROR(stack.push_back(ref));
+                }
+                else if (intersect(m_bounds[ref], bounds))
+                {
+                    ICY_ERROR(output.push_back(ref));
+                }
+            }
+        }
+        return {};
+    }
+    //  "count" items with the nearest centers, ordered by distance (best-first search)
+    error_type nearest(const osm_coord& coord, const size_t count, array<uint32_t>& output) const noexcept
+    {
+        return nearest(coord, count, [](const uint32_t) { return true; }, output);
+    }
+    //  same, counting only the items accepted by "filter(index)"
+    template<typename filter_type>
+    error_type nearest(const osm_coord& coord, const size_t count, filter_type&& filter, array<uint32_t>& output) const noexcept
+    {
+        output.clear();
+        if (m_nodes.empty() || !count)
+            return {};
+
+        //  equirectangular projection around the query: good enough for ranking
+        const auto scale = cos(coord.lat * 3.14159265358979 / 180);
+        const auto box_distance = [&coord, scale](const osm_bounds& bounds)
+        {
+            const auto dx = std::max(std::max(bounds.lower.lng - coord.lng, coord.lng - bounds.upper.lng), 0.0) * scale;
+            const auto dy = std::max(std::max(bounds.lower.lat - coord.lat, coord.lat - bounds.upper.lat), 0.0);
+            return dx * dx + dy * dy;
+        };
+        const auto center_distance = [&coord, scale](const osm_bounds& bounds)
+        {
+            const auto dx = ((bounds.lower.lng + bounds.upper.lng) / 2 - coord.lng) * scale;
+            const auto dy = (bounds.lower.lat + bounds.upper.lat) / 2 - coord.lat;
+            return dx * dx + dy * dy;
+        };
+
+        array<queue_type> queue;
+        const auto root = uint32_t(m_nodes.size() - 1);
+        ICY_ERROR(queue.push_back({ box_distance(m_nodes[root].bounds), root, false }));
+        while (!queue.empty() && output.size() < count)
+        {
+            std::pop_heap(queue.begin(), queue.end());
+            const auto next = queue.back();
+            queue.pop_back();
+            if (next.item)
+            {
+                if (filter(next.index))
+                    ICY_ERROR(output.push_back(next.index));
+                continue;
+            }
+            const auto& node = m_nodes[next.index];
+            const auto leaf = next.index < m_leaf_count;
+            for (auto k = node.first; k < node.first + node.count; ++k)
+            {
+                const auto ref = m_refs[k];
+                const auto distance = leaf ? center_distance(m_bounds[ref]) : box_distance(m_nodes[ref].bounds);
+                ICY_ERROR(queue.push_back({ distance, ref, leaf }));
+                std::push_heap(queue.begin(), queue.end());
+            }
+        }
+        return {};
+    }
+private:
+    static osm_bounds merge(const osm_bounds& lhs, const osm_bounds& rhs) noexcept
+    {
+        osm_bounds bounds;
+        bounds.lower.lng = std::min(lhs.lower.lng, rhs.lower.lng);
+        bounds.lower.lat = std::min(lhs.lower.lat, rhs.lower.lat);
+        bounds.upper.lng = std::max(lhs.upper.lng, rhs.upper.lng);
+        bounds.upper.lat = std::max(lhs.upper.lat, rhs.upper.lat);
+        return bounds;
+    }
+    static bool intersect(const osm_bounds& lhs, const osm_bounds& rhs) noexcept
+    {
+        return lhs.lower.lng <= rhs.upper.lng && rhs.lower.lng <= lhs.upper.lng &&
+            lhs.lower.lat <= rhs.upper.lat && rhs.lower.lat <= lhs.upper.lat;
+    }
+    //  Sort-Tile-Recursive: vertical slices by center longitude, each slice by center latitude
+    static void str_sort(array<entry_type>& entries) noexcept
+    {
+        const auto size = entries.size();
+        const auto node_count = (size + fanout - 1) / fanout;
+        const auto slice_count = size_t(ceil(sqrt(double(node_count))));
+        const auto slice_size = std::max(slice_count, 1_z) * fanout;
+
+        std::sort(entries.begin(), entries.end(), [](const entry_type& lhs, const entry_type& rhs)
+        {
+            return lhs.bounds.lower.lng + lhs.bounds.upper.lng < rhs.bounds.lower.lng + rhs.bounds.upper.lng;
+        });
+        for (auto k = 0_z; k < size; k += slice_size)
+        {
+            std::sort(entries.begin() + k, entries.begin() + std::min(k + slice_size, size), [](const entry_type& lhs, const entry_type& rhs)
+            {
+                return lhs.bounds.lower.lat + lhs.bounds.upper.lat < rhs.bounds.lower.lat + rhs.bounds.upper.lat;
+            });
+        }
+    }
+private:
+    array<osm_bounds> m_bounds;
+    array<node_type> m_nodes;   //  root is the last node
+    array<uint32_t> m_refs;
+    uint32_t m_leaf_count = 0;
+};
 class osm_bounds_parser : public csv_parser
 {
 public:
@@ -499,38 +969,54 @@ public:
     }
     error_type find(const osm_coord& coord, map<string_view, osm_coord>& cities) const noexcept
     {
-        //auto distance = DBL_MAX;
-        //auto city_size = DBL_MAX;
-        for (auto&& pair : m_data)
+        array<uint32_t> indices;
+        ICY_ERROR(m_tree.find(coord, indices));
+        for (auto&& index : indices)
         {
-            const auto& lower = pair.value.lower;
-            const auto& upper = pair.value.upper;
-            if (coord.lng >= lower.lng && coord.lng <= upper.lng &&
-                coord.lat >= lower.lat && coord.lat <= upper.lat)
-                ;
-            else
-                continue;
+            const auto& bounds = m_data.vals()[index];
             osm_coord center;
-            center.lng = (lower.lng + upper.lng) / 2;
-            center.lat = (lower.lat + upper.lat) / 2;
-            //const auto dx = coord.lng - ;
-            //const auto dy = coord.lat - (lower.lat + upper.lat) / 2;
-            //const auto new_distance = dx * dx + dy * dy;
-            ICY_ERROR(cities.insert(pair.key, center));
-            //const auto new_size = abs(upper.lng - lower.lng) * abs(upper.lat - lower.lat);
-            /*if (new_size < city_size)
-            {
-                output = pair.key;
-                distance = new_distance;
-                city_size = new_size;
-            }*/
+            center.lng = (bounds.lower.lng + bounds.upper.lng) / 2;
+            center.lat = (bounds.lower.lat + bounds.upper.lat) / 2;
+            ICY_ERROR(cities.insert(m_data.keys()[index], center));
         }
         return {};
     }
+    error_type nearest(const osm_coord& coord, const size_t count, array<string_view>& cities) const noexcept
+    {
+        array<uint32_t> indices;
+        ICY_ERROR(m_tree.nearest(coord, count, indices));
+        for (auto&& index : indices)
+            ICY_ERROR(cities.push_back(m_data.keys()[index]));
+        return {};
+    }
+    //  "names" (usually the result of "find") ordered by the distance to their centers
+    error_type nearest(const osm_coord& coord, const map<string_view, osm_coord>& names, array<string_view>& cities) const noexcept
+    {
+        const auto filter = [this, &names](const uint32_t index)
+        {
+            return names.try_find(string_view(m_data.keys()[index])) != nullptr;
+        };
+        array<uint32_t> indices;
+        ICY_ERROR(m_tree.nearest(coord, names.size(), filter, indices));
+        for (auto&& index : indices)
+            ICY_ERROR(cities.push_back(m_data.keys()[index]));
+        return {};
+    }
     const_array_view<string> keys() const noexcept
     {
         return m_data.keys();
     }
+    const_array_view<osm_bounds> vals() const noexcept
+    {
+        return m_data.vals();
+    }
+    error_type operator()(const const_array_view<char> buffer) noexcept override
+    {
+        ICY_ERROR(csv_parser::operator()(buffer));
+        if (buffer.empty())
+            ICY_ERROR(m_tree.initialize(m_data.vals()));
+        return {};
+    }
 private:
     error_type callback(const const_array_view<string_view> tabs) noexcept override
     {
@@ -554,10 +1040,15 @@ private:
     }
 private:
     dictionary<osm_bounds> m_data;
+    osm_bounds_tree m_tree;
 };
 class fias_addr_parser : public csv_parser
 {
 public:
+    array_view<fias_city> cities() noexcept
+    {
+        return m_data.vals();
+    }
     fias_city* find(const string_view name) noexcept
     {
         const auto it = m_data.find(name);        
@@ -710,48 +1201,61 @@ private:
     array<data_type> m_data;
 };
 
-error_type jaro_winkler_distance(const string_view utf8lhs, const string_view utf8rhs, double& distance) noexcept
+error_type street_name_decode(const string_view utf8, char32_t(&buffer)[street_name_max], size_t& size) noexcept
 {
-    // Exit early if either are empty
-    if (utf8lhs.empty() || utf8rhs.empty())
+    size = 0;
+    for (auto it = utf8.begin(); it != utf8.end() && size < street_name_max; ++it)
     {
-        distance = 0;
-        return {};
+        char32_t chr = 0;
+        ICY_ERROR(it.to_char(chr));
+        if (chr >= U'A' && chr <= U'Z')
+            chr += U'a' - U'A';
+        else if (chr >= 0x0410 && chr <= 0x042F)    //  А-Я
+            chr += 0x20;
+        if (chr == 0x0401 || chr == 0x0451)         //  Ё, ё -> е
+            chr = 0x0435;
+        buffer[size++] = chr;
     }
+    return {};
+}
+error_type jaro_winkler_distance(const string_view utf8lhs, const string_view utf8rhs, double& distance) noexcept
+{
+    char32_t lhs[street_name_max];
+    char32_t rhs[street_name_max];
+    auto lhs_size = 0_z;
+    auto rhs_size = 0_z;
+    ICY_ERROR(street_name_decode(utf8lhs, lhs, lhs_size));
+    ICY_ERROR(street_name_decode(utf8rhs, rhs, rhs_size));
+    distance = jaro_winkler_distance(const_array_view<char32_t>(lhs, lhs_size), const_array_view<char32_t>(rhs, rhs_size));
+    return {};
+}
+double jaro_winkler_distance(const const_array_view<char32_t> lhs, const const_array_view<char32_t> rhs) noexcept
+{
+    // Exit early if either are empty
+    if (lhs.empty() || rhs.empty())
+        return 0;
 
     // Exit early if they're an exact match.
-    if (utf8lhs == utf8rhs)
-    {
-        distance = 1;
-        return {};
-    }
-
-    array<char32_t> lhs;
-    array<char32_t> rhs;
-    for (auto&& chr : utf8lhs) ICY_ERROR(lhs.push_back(chr));
-    for (auto&& chr : utf8rhs) ICY_ERROR(rhs.push_back(chr));
+    if (lhs.size() == rhs.size() && memcmp(lhs.data(), rhs.data(), lhs.size() * sizeof(char32_t)) == 0)
+        return 1;
 
-    const auto lhs_size = static_cast<int>(lhs.size());
-    const auto rhs_size = static_cast<int>(rhs.size());
-    const auto range = std::max(lhs_size, rhs_size) / 2 - 1;
+    const auto lhs_size = static_cast<int>(std::min(lhs.size(), size_t(street_name_max)));
+    const auto rhs_size = static_cast<int>(std::min(rhs.size(), size_t(street_name_max)));
+    const auto range = std::max(std::max(lhs_size, rhs_size) / 2 - 1, 0);
 
-    array<bool> lhs_matches;
-    array<bool> rhs_matches;
-    ICY_ERROR(lhs_matches.resize(lhs.size()));
-    ICY_ERROR(rhs_matches.resize(rhs.size()));
-
-    auto num_match = 0.0;
-    auto num_trans = 0.0;
+    bool lhs_matches[street_name_max] = {};
+    bool rhs_matches[street_name_max] = {};
 
+    auto num_match = 0;
     for (auto i = 0; i < lhs_size; ++i)
     {
         const auto lower = std::max(i - range, 0);
-        const auto upper = std::min(i + range, rhs_size);
+        const auto upper = std::min(i + range + 1, rhs_size);
         for (auto j = lower; j < upper; ++j)
         {
-            if (!lhs_matches[i] && !rhs_matches[j] && lhs[i] == rhs[j])
+            if (!rhs_matches[j] && lhs[i] == rhs[j])
             {
-                num_match += 1;
+                ++num_match;
                 lhs_matches[i] = true;
                 rhs_matches[j] = true;
                 break;
@@ -761,34 +1265,34 @@ error_type jaro_winkler_distance(const string_view utf8lhs, const string_view ut
 
     // Exit early if no matches were found
     if (num_match == 0)
-    {
-        distance = 0;
-        return {};
-    }
+        return 0;
 
+    auto num_trans = 0;
     for (auto i = 0, j = 0; i < lhs_size; ++i)
     {
         if (!lhs_matches[i])
             continue;
-
-        for (; j < rhs_size; ++j)
-        {
-            if (!rhs_matches[j])
-                continue;
-        }
-        if (j >= rhs_size)
-            break;
-
-        num_trans += lhs[i] != rhs[j];
+        while (!rhs_matches[j])
+            ++j;
+        num_trans += lhs[i] != rhs[j++];
     }
-    num_trans /= 2;
 
-    distance = 0;
-    distance += num_match / lhs_size;
-    distance += num_match / rhs_size;
-    distance += (num_match - num_trans) / num_match;
+    const auto match = double(num_match);
+    auto distance = 0.0;
+    distance += match / lhs_size;
+    distance += match / rhs_size;
+    distance += (match - num_trans / 2.0) / match;
     distance /= 3;
-    return {};
+
+    // Winkler boost for a common prefix (up to 4 characters)
+    if (distance > 0.7)
+    {
+        auto prefix = 0;
+        while (prefix < 4 && prefix < lhs_size && prefix < rhs_size && lhs[prefix] == rhs[prefix])
+            ++prefix;
+        distance += prefix * 0.1 * (1 - distance);
+    }
+    return distance;
 }
 
 osm_coord way_coord(const osm_node_parser& node, const osm_way_parser& way, const uint64_t index)
@@ -1048,9 +1552,17 @@ error_type main2(heap& heap)
                 if (city_names.size() > 1 && city_name.empty())
                 {
                     if (const auto ptr = street_to_city.try_find(new_street))
+                    {
                         city_name = *ptr;
+                    }
                     else if (always_one)
-                        city_name = city_names.front().key;
+                    {
+                        //  same choice as answer "1": the nearest city
+                        array<string_view> nearest;
+                        ICY_ERROR(bounds.nearest(coord, city_names, nearest));
+                        if (!nearest.empty())
+                            city_name = nearest.front();
+                    }
                 }
 
                 if (city_names.size() > 1 && city_name.empty())
@@ -1061,10 +1573,6 @@ error_type main2(heap& heap)
 
                     struct pair_type
                     {
-                        bool operator<(const pair_type& rhs) const noexcept
-                        {
-                            return distance < rhs.distance;
-                        }
                         string_view name;
                         double distance;
                     };
@@ -1087,11 +1595,13 @@ error_type main2(heap& heap)
                         return CpGeoRadius * c;
                     };
 
+                    //  the R-tree returns the candidates nearest first; distances are only for display
+                    array<string_view> nearest;
+                    ICY_ERROR(bounds.nearest(coord, city_names, nearest));
                     array<pair_type> vec;
-                    for (auto&& pair : city_names)
-                        ICY_ERROR(vec.push_back({ pair.key, calc_dst(coord, pair.value) }));
+                    for (auto&& name : nearest)
+                        ICY_ERROR(vec.push_back({ name, calc_dst(coord, *city_names.try_find(name)) }));
 
-                    std::sort(vec.begin(), vec.end());
                     for (auto k = vec.size(); k--;)
                     {
                         ICY_ERROR(msg.appendf("\r\n[%1]. %2 (km) - \"%3\" (%4)"_s,
@@ -1376,6 +1886,160 @@ error_type main4(heap& heap)
 
     return {};
 }
+error_type main5(heap& heap)
+{
+    //  street matcher benchmark: every FIAS street with its last character dropped is
+    //  matched against its city using the trigram index and the full Jaro-Winkler scan
+    string dir;
+    string fias_path;
+    ICY_ERROR(to_string("%1/%2", dir, root_dir, region));
+    ICY_ERROR(to_string("%1/fias.txt"_s, fias_path, string_view(dir)));
+
+    fias_addr_parser fias;
+    ICY_ERROR(parse(fias, fias_path, buffer_size));
+
+    using clock_type = std::chrono::high_resolution_clock;
+    auto build_time = clock_type::duration();
+    auto index_time = clock_type::duration();
+    auto scan_time = clock_type::duration();
+    auto query_count = 0_z;
+    auto hit_count = 0_z;
+
+    for (auto&& city : fias.cities())
+    {
+        auto time = clock_type::now();
+        ICY_ERROR(city.fuzzy.initialize(city.streets.keys()));
+        build_time += clock_type::now() - time;
+
+        for (auto&& name : city.streets.keys())
+        {
+            if (name.empty())
+                continue;
+            const auto query = string_view(name.begin(), name.end() - 1);
+
+            array<pair_type> index_vec;
+            time = clock_type::now();
+            ICY_ERROR(city.fuzzy.find(query, street_variants, index_vec));
+            index_time += clock_type::now() - time;
+
+            array<pair_type> scan_vec;
+            time = clock_type::now();
+            for (auto&& pair : city.streets)
+            {
+                auto distance = 0.0;
+                ICY_ERROR(jaro_winkler_distance(pair.key, query, distance));
+                ICY_ERROR(scan_vec.push_back({ pair.key, distance }));
+            }
+            std::sort(scan_vec.begin(), scan_vec.end());
+            scan_time += clock_type::now() - time;
+
+            ++query_count;
+            if (!index_vec.empty() && !scan_vec.empty() && index_vec[0].name == scan_vec[0].name)
+                ++hit_count;
+        }
+    }
+    const auto msec = [](const clock_type::duration duration)
+    {
+        return uint64_t(std::chrono::duration_cast<std::chrono::milliseconds>(duration).count());
+    };
+    string msg;
+    ICY_ERROR(to_string("\r\nStreets: %1\r\nIndex build: %2 ms\r\nIndex query: %3 ms\r\nFull scan: %4 ms\r\nSame best match: %5"_s,
+        msg, query_count, msec(build_time), msec(index_time), msec(scan_time), hit_count));
+    ICY_ERROR(console_write(msg));
+    return {};
+}
+error_type main6(heap& heap)
+{
+    //  spatial lookup benchmark: node id lookups, city point queries (R-tree vs full scan) and k-nearest cities
+    string dir;
+    string bounds_path;
+    string node_path;
+    ICY_ERROR(to_string("%1/%2", dir, root_dir, region));
+    ICY_ERROR(to_string("%1/bounds.txt"_s, bounds_path, string_view(dir)));
+    ICY_ERROR(to_string("%1/node.txt"_s, node_path, string_view(dir)));
+
+    using clock_type = std::chrono::high_resolution_clock;
+    const auto msec = [](const clock_type::duration duration)
+    {
+        return uint64_t(std::chrono::duration_cast<std::chrono::milliseconds>(duration).count());
+    };
+    const auto per_sec = [](const size_t count, const clock_type::duration duration)
+    {
+        const auto usec = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+        return uint64_t(usec ? count * 1000000.0 / usec : 0);
+    };
+
+    auto time = clock_type::now();
+    osm_bounds_parser bounds;
+    ICY_ERROR(parse(bounds, bounds_path, buffer_size));
+    const auto bounds_time = clock_type::now() - time;
+
+    time = clock_type::now();
+    osm_node_parser node;
+    ICY_ERROR(parse(node, node_path, buffer_size));
+    const auto node_time = clock_type::now() - time;
+
+    osm_bounds_tree tree;
+    time = clock_type::now();
+    ICY_ERROR(tree.initialize(bounds.vals()));
+    const auto tree_time = clock_type::now() - time;
+
+    //  node coordinates in pseudo-random order are the query set
+    array<osm_coord> coords;
+    auto found = 0_z;
+    auto seed = 0x2545F4914F6CDD1Dui64;
+    time = clock_type::now();
+    for (auto k = 0_z; k < node.keys().size(); ++k)
+    {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        if (const auto coord = node.find(node.keys()[seed % node.keys().size()]))
+        {
+            ICY_ERROR(coords.push_back(*coord));
+            ++found;
+        }
+    }
+    const auto lookup_time = clock_type::now() - time;
+
+    auto tree_count = 0_z;
+    array<uint32_t> indices;
+    time = clock_type::now();
+    for (auto&& coord : coords)
+    {
+        ICY_ERROR(tree.find(coord, indices));
+        tree_count += indices.size();
+    }
+    const auto query_time = clock_type::now() - time;
+
+    auto scan_count = 0_z;
+    time = clock_type::now();
+    for (auto&& coord : coords)
+    {
+        for (auto&& box : bounds.vals())
+        {
+            if (coord.lng >= box.lower.lng && coord.lng <= box.upper.lng &&
+                coord.lat >= box.lower.lat && coord.lat <= box.upper.lat)
+                ++scan_count;
+        }
+    }
+    const auto scan_time = clock_type::now() - time;
+
+    time = clock_type::now();
+    for (auto&& coord : coords)
+        ICY_ERROR(tree.nearest(coord, 4, indices));
+    const auto nearest_time = clock_type::now() - time;
+
+    string msg;
+    ICY_ERROR(to_string("\r\nBounds: %1 (parse %2 ms, R-tree build %3 ms)\r\nNodes: %4 (parse and sort %5 ms)"_s, msg,
+        bounds.vals().size(), msec(bounds_time), msec(tree_time), node.keys().size(), msec(node_time)));
+    ICY_ERROR(msg.appendf("\r\nNode lookup: %1/sec (%2 found)"_s, per_sec(node.keys().size(), lookup_time), found));
+    ICY_ERROR(msg.appendf("\r\nCity point query: %1/sec (R-tree), %2/sec (full scan), results %3/%4"_s,
+        per_sec(coords.size(), query_time), per_sec(coords.size(), scan_time), tree_count, scan_count));
+    ICY_ERROR(msg.appendf("\r\nNearest 4 cities: %1/sec"_s, per_sec(coords.size(), nearest_time)));
+    ICY_ERROR(console_write(msg));
+    return {};
+}
 int main()
 {
     heap gheap;
@@ -18,44 +18,343 @@ const auto max_str_length = 500;
 
 shared_ptr<console_system> con;
 
-struct house_type1
+error_type console_write(const string_view msg)
+{
+    return con->write(msg);   
+    
+}
+
+//  columnar binary table (per region intermediate):
+//  header | key[count] | par[count] | level[count] | text[count + 1] (heap offsets) | heap
+//  records are sorted by key and unique, so later stages map the file and binary search it
+const auto fias_table_magic = 0x53414946u;  //  "FIAS"
+const auto fias_table_version = 1u;
+const auto fias_table_run = 0x100000u;      //  records per in-memory sorted run
+const auto fias_street_level = 7u;
+
+enum class fias_table_type : uint32_t
+{
+    house,  //  key, parent, text
+    addr,   //  key, parent, level, text
+};
+struct fias_table_header
 {
-    friend int compare(const house_type1& lhs, const house_type1& rhs) noexcept
+    uint32_t magic;
+    uint32_t version;
+    uint32_t count;
+    uint32_t heap;
+};
+
+class fias_table
+{
+public:
+    error_type initialize(const string_view path) noexcept
+    {
+        ICY_ERROR(m_file.open(path, file_access::read, file_open::open_existing, file_share::read));
+        const auto size = m_file.info().size;
+        if (size < sizeof(fias_table_header))
+            return make_stdlib_error(std::errc::illegal_byte_sequence);
+
+        ICY_ERROR(m_map.initialize(m_file));
+        ICY_ERROR(m_view.initialize(m_map, 0, size));
+
+        const auto header = reinterpret_cast<const fias_table_header*>(m_view.data());
+        if (header->magic != fias_table_magic || header->version != fias_table_version ||
+            size != sizeof(fias_table_header) + (4_z * header->count + 1) * sizeof(uint32_t) + header->heap)
+            return make_stdlib_error(std::errc::illegal_byte_sequence);
+
+        m_size = header->count;
+        m_key = reinterpret_cast<const uint32_t*>(header + 1);
+        m_par = m_key + m_size;
+        m_level = m_par + m_size;
+        m_text = m_level + m_size;
+        m_heap = reinterpret_cast<const char*>(m_text + m_size + 1);
+        return {};
+    }
+    size_t size() const noexcept
+    {
+        return m_size;
+    }
+    uint32_t key(const size_t index) const noexcept
     {
-        return icy::compare(lhs.key, rhs.key);
+        return m_key[index];
     }
-    rel_ops(house_type1);
-    uint32_t key;
-    string text;
+    uint32_t par(const size_t index) const noexcept
+    {
+        return m_par[index];
+    }
+    uint32_t level(const size_t index) const noexcept
+    {
+        return m_level[index];
+    }
+    string_view text(const size_t index) const noexcept
+    {
+        string_view str;
+        to_string(const_array_view<char>(m_heap + m_text[index], m_heap + m_text[index + 1]), str);
+        return str;
+    }
+    //  index of the record or size() if not found
+    size_t find(const uint32_t key) const noexcept
+    {
+        const auto it = std::lower_bound(m_key, m_key + m_size, key);
+        return it != m_key + m_size && *it == key ? size_t(it - m_key) : m_size;
+    }
+private:
+    file m_file;
+    file_const_map m_map;
+    file_const_view m_view;
+    size_t m_size = 0;
+    const uint32_t* m_key = nullptr;
+    const uint32_t* m_par = nullptr;
+    const uint32_t* m_level = nullptr;
+    const uint32_t* m_text = nullptr;
+    const char* m_heap = nullptr;
 };
-struct addr_type2
+
+//  appends records in key order: fixed-width columns stay in memory, the string heap is streamed to a temporary file
+class fias_table_output
 {
-    friend int compare(const addr_type2& lhs, const addr_type2& rhs) noexcept
+public:
+    ~fias_table_output() noexcept
     {
-        return icy::compare(lhs.key, rhs.key);
+        m_heap.close();
+        if (!m_heap_path.empty())
+            file::remove(m_heap_path);
+    }
+    error_type initialize() noexcept
+    {
+        ICY_ERROR(file::tmpname(m_heap_path));
+        ICY_ERROR(m_heap.open(m_heap_path, file_access::app, file_open::create_always, file_share::none));
+        ICY_ERROR(m_text.push_back(0));
+        return {};
+    }
+    error_type append(const uint32_t key, const uint32_t par, const uint32_t level, const const_array_view<char> text) noexcept
+    {
+        ICY_ERROR(m_key.push_back(key));
+        ICY_ERROR(m_par.push_back(par));
+        ICY_ERROR(m_level.push_back(level));
+        ICY_ERROR(m_heap.append(text.data(), text.size()));
+        ICY_ERROR(m_text.push_back(m_text.back() + uint32_t(text.size())));
+        return {};
+    }
+    error_type save(const string_view path) noexcept
+    {
+        m_heap.close();
+
+        string tname;
+        ICY_ERROR(file::tmpname(tname));
+        {
+            file output;
+            ICY_ERROR(output.open(tname, file_access::app, file_open::create_always, file_share::none));
+
+            fias_table_header header = {};
+            header.magic = fias_table_magic;
+            header.version = fias_table_version;
+            header.count = uint32_t(m_key.size());
+            header.heap = m_text.back();
+            ICY_ERROR(output.append(&header, sizeof(header)));
+            ICY_ERROR(output.append(m_key.data(), m_key.size() * sizeof(uint32_t)));
+            ICY_ERROR(output.append(m_par.data(), m_par.size() * sizeof(uint32_t)));
+            ICY_ERROR(output.append(m_level.data(), m_level.size() * sizeof(uint32_t)));
+            ICY_ERROR(output.append(m_text.data(), m_text.size() * sizeof(uint32_t)));
+
+            file heap;
+            ICY_ERROR(heap.open(m_heap_path, file_access::read, file_open::open_existing, file_share::read));
+            while (true)
+            {
+                char buffer[0x10000];
+                auto size = _countof(buffer);
+                ICY_ERROR(heap.read(buffer, size));
+                if (!size)
+                    break;
+                ICY_ERROR(output.append(buffer, size));
+            }
+        }
+        ICY_ERROR(file::replace(tname, path));
+        return {};
     }
-    rel_ops(addr_type2);
-    uint32_t key;
-    uint32_t par;
-    uint32_t level;
-    string text;
+private:
+    array<uint32_t> m_key;
+    array<uint32_t> m_par;
+    array<uint32_t> m_level;
+    array<uint32_t> m_text;
+    string m_heap_path;
+    file m_heap;
 };
-struct house_type2
+
+//  external merge sort: records are buffered up to fias_table_run, sorted and spilled as tables;
+//  save() merges the runs (first record wins for a duplicate key)
+class fias_table_writer
 {
-    friend int compare(const house_type2& lhs, const house_type2& rhs) noexcept
+    struct record_type
+    {
+        bool operator<(const record_type& rhs) const noexcept
+        {
+            return key < rhs.key;
+        }
+        uint32_t key;
+        uint32_t par;
+        uint32_t level;
+        uint32_t text;
+        uint32_t size;
+    };
+    struct cursor_type
+    {
+        bool operator<(const cursor_type& rhs) const noexcept
+        {
+            return key > rhs.key || (key == rhs.key && run > rhs.run);
+        }
+        uint32_t key;
+        uint32_t run;
+        size_t index;
+    };
+public:
+    ~fias_table_writer() noexcept
+    {
+        for (auto&& run : m_runs)
+            file::remove(run);
+    }
+    size_t size() const noexcept
+    {
+        return m_count;
+    }
+    error_type append(const uint32_t key, const uint32_t par, const uint32_t level, const string_view text) noexcept
+    {
+        record_type record = {};
+        record.key = key;
+        record.par = par;
+        record.level = level;
+        record.text = uint32_t(m_heap.size());
+        record.size = uint32_t(text.bytes().size());
+        ICY_ERROR(m_heap.append(text.bytes().begin(), text.bytes().end()));
+        ICY_ERROR(m_records.push_back(record));
+        ++m_count;
+        if (m_records.size() >= fias_table_run)
+            ICY_ERROR(flush());
+        return {};
+    }
+    error_type save(const string_view path) noexcept
+    {
+        if (!m_records.empty() || m_runs.empty())
+            ICY_ERROR(flush());
+
+        if (m_runs.size() == 1)
+        {
+            ICY_ERROR(file::replace(m_runs[0], path));
+            m_runs.clear();
+            return {};
+        }
+
+        array<unique_ptr<fias_table>> runs;
+        array<cursor_type> queue;
+        for (auto k = 0u; k < m_runs.size(); ++k)
+        {
+            auto run = make_unique<fias_table>();
+            if (!run)
+                return make_stdlib_error(std::errc::not_enough_memory);
+            ICY_ERROR(run->initialize(m_runs[k]));
+            if (run->size())
+                ICY_ERROR(queue.push_back({ run->key(0), k, 0 }));
+            ICY_ERROR(runs.push_back(std::move(run)));
+        }
+        std::make_heap(queue.begin(), queue.end());
+
+        fias_table_output output;
+        ICY_ERROR(output.initialize());
+        auto first = true;
+        auto last = 0u;
+        while (!queue.empty())
+        {
+            std::pop_heap(queue.begin(), queue.end());
+            auto& next = queue.back();
+            const auto& run = *runs[next.run];
+            if (first || next.key != last)
+            {
+                ICY_ERROR(output.append(next.key, run.par(next.index), run.level(next.index), run.text(next.index).bytes()));
+                last = next.key;
+                first = false;
+            }
+            if (++next.index < run.size())
+            {
+                next.key = run.key(next.index);
+                std::push_heap(queue.begin(), queue.end());
+            }
+            else
+            {
+                queue.pop_back();
+            }
+        }
+        ICY_ERROR(output.save(path));
+        return {};
+    }
+private:
+    error_type flush() noexcept
     {
-        return icy::compare(lhs.key, rhs.key);
+        std::stable_sort(m_records.begin(), m_records.end());
+
+        fias_table_output output;
+        ICY_ERROR(output.initialize());
+        for (auto it = m_records.begin(); it != m_records.end(); ++it)
+        {
+            if (it != m_records.begin() && it[-1].key == it->key)
+                continue;
+            const auto text = const_array_view<char>(m_heap.data() + it->text, it->size);
+            ICY_ERROR(output.append(it->key, it->par, it->level, text));
+        }
+        string path;
+        ICY_ERROR(file::tmpname(path));
+        ICY_ERROR(m_runs.push_back(std::move(path)));
+        ICY_ERROR(output.save(m_runs.back()));
+        m_records.clear();
+        m_heap.clear();
+        return {};
     }
-    rel_ops(house_type2);
-    uint32_t key;
-    uint32_t par;
-    char text[28];
+private:
+    array<record_type> m_records;
+    array<char> m_heap;
+    array<string> m_runs;
+    size_t m_count = 0;
 };
 
-error_type console_write(const string_view msg)
+//  calls "func(line)" for every non-empty line of a text file
+template<typename func_type>
+error_type read_lines(const string_view path, func_type&& func) noexcept
 {
-    return con->write(msg);   
-    
+    file input;
+    ICY_ERROR(input.open(path, file_access::read, file_open::open_existing, file_share::read));
+
+    array<char> str;
+    const auto process = [&str, &func]
+    {
+        if (str.empty())
+            return error_type();
+        string_view line;
+        ICY_ERROR(to_string(str, line));
+        ICY_ERROR(func(line));
+        str.clear();
+        return error_type();
+    };
+    while (true)
+    {
+        char buffer[0x4000];
+        auto size = _countof(buffer);
+        ICY_ERROR(input.read(buffer, size));
+        if (!size)
+            break;
+
+        for (auto k = 0_z; k < size; ++k)
+        {
+            if (buffer[k] == '\r' || buffer[k] == '\n')
+            {
+                ICY_ERROR(process());
+            }
+            else if (str.size() < max_str_length)
+            {
+                ICY_ERROR(str.push_back(buffer[k]));
+            }
+        }
+    }
+    return process();
 }
 
 error_type parse_houses(const size_t region, const string_view path_input, const string_view dir_output)
@@ -365,144 +664,62 @@ error_type parse_addrobj(const size_t region, const string_view path_addrobj, co
     ICY_ERROR(console_write(msg));
     return {};
 }
-error_type remove_duplicate_houses(const string_view path_house, const string_view dir_output, const uint32_t n)
+//  text intermediate "<path_input><n>.txt" -> sorted unique table "<dir_output><n>.bin"
+error_type make_table(const string_view path_input, const string_view dir_output, const uint32_t n, const fias_table_type type)
 {
-
     auto now = clock_type::now();
-
     {
-        string file_name_house;
+        string file_name_input;
         string file_name_output;
-        ICY_ERROR(to_string("%1%2.txt"_s, file_name_house, path_house, n));
-        ICY_ERROR(to_string("%1%2.txt"_s, file_name_output, dir_output, n));
+        ICY_ERROR(to_string("%1%2.txt"_s, file_name_input, path_input, n));
+        ICY_ERROR(to_string("%1%2.bin"_s, file_name_output, dir_output, n));
 
-        file input_house;
-        file output;
-        ICY_ERROR(input_house.open(file_name_house, file_access::read, file_open::open_existing, file_share::read));
-        ICY_ERROR(output.open(file_name_output, file_access::app, file_open::create_always, file_share::read));
-
-        array<house_type1> houses;
-    
-        auto done = false;
-        array<char> str;
-
-        const auto max_file = input_house.info().size;
-        auto old_percent = 0ui64;
-        auto new_percent = 0ui64;
-        auto offset = 0_z;
-
-        while (true)
+        fias_table_writer writer;
+        ICY_ERROR(read_lines(file_name_input, [type, &writer](const string_view line)
         {
-            char buffer[0x4000];
-            auto size = _countof(buffer);
-            ICY_ERROR(input_house.read(buffer, size));
-
-            if (!size)
-                break;
-
-            auto k = 0u;
-            while (k < size)
+            array<string_view> tabs;
+            ICY_ERROR(split(line, tabs, '\t'));
+
+            auto key = 0u;
+            auto par = 0u;
+            auto level = 0u;
+            auto text = 2_z;
+            if (type == fias_table_type::addr)
             {
-                for (; k < size; ++k)
-                {
-                    if (str.empty())
-                    {
-                        if (buffer[k] == '\r' || buffer[k] == '\n')
-                            continue;
-
-                        str.push_back(buffer[k]);
-                    }
-                    else
-                    {
-                        if (buffer[k] == '\n' || buffer[k] == '\r')
-                        {
-                            done = true;
-                            break;
-                        }
-                        else if (str.size() < max_str_length)
-                        {
-                            str.push_back(buffer[k]);
-                        }
-                    }
-                }
-                if (k == size && offset + k == max_file)
-                    done = true;
-
-                if (done)
-                {
-                    string str_tabs;
-                    array<string_view> tabs;
-                    ICY_ERROR(to_string(str, str_tabs));
-                    ICY_ERROR(split(str_tabs, tabs));
-
-                    if (tabs.size() < 3)
-                        continue;
-
-                    house_type1 new_house = {};
-                    new_house.key = hash(tabs[0]);
-                    new_house.text = std::move(str_tabs);
-                    ICY_ERROR(houses.push_back(std::move(new_house)));
-                    str.clear();
-                    done = false;
-                }
+                if (tabs.size() < 4 || to_value(tabs[2], level))
+                    return error_type();
+                text = 3;
             }
-            offset += k;
-
-            new_percent = offset * 100ui64 / max_file;
-            if (new_percent > old_percent)
+            else if (tabs.size() < 3)
             {
-                string msg;
-                ICY_ERROR(to_string("\r\nRegion %1: Parse house: %2%%..."_s, msg, n, new_percent));
-                ICY_ERROR(console_write(msg));
-                old_percent = new_percent;
+                return error_type();
             }
-        }
+            to_value(tabs[0], key);
+            to_value(tabs[1], par);
+            return writer.append(key, par, level, tabs[text]);
+        }));
         {
             string msg;
-            ICY_ERROR(to_string("\r\nRegion %1: Found %2 total houses. Sorting..."_s, msg, n, houses.size()));
+            ICY_ERROR(to_string("\r\nRegion %1: Found %2 total records. Sorting..."_s, msg, n, writer.size()));
             ICY_ERROR(console_write(msg));
         }
-        std::sort(houses.begin(), houses.end());
-        auto jt = std::unique(houses.begin(), houses.end());
-        houses.pop_back(std::distance(jt, houses.end()));
+        ICY_ERROR(writer.save(file_name_output));
+
+        fias_table table;
+        ICY_ERROR(table.initialize(file_name_output));
         {
             string msg;
-            ICY_ERROR(to_string("\r\nRegion %1: Found %2 unique houses."_s, msg, n, houses.size()));
+            ICY_ERROR(to_string("\r\nRegion %1: Found %2 unique records."_s, msg, n, table.size()));
             ICY_ERROR(console_write(msg));
         }
-
-        offset = 0_z;
-        old_percent = 0_z;
-        new_percent = 0_z;
-
-        for (auto&& house : houses)
-        {
-            if (offset)
-                ICY_ERROR(output.append("\r\n", 2));
-            
-            ICY_ERROR(output.append(house.text.bytes().data(), house.text.bytes().size()));
-            ++offset;
-            new_percent = offset * 10ui64 / houses.size();
-            if (new_percent > old_percent)
-            {
-                string msg;
-                ICY_ERROR(to_string("\r\nRegion %1: Output house: %2%%..."_s, msg, n, new_percent * 100 / 10));
-                ICY_ERROR(console_write(msg));
-                old_percent = new_percent;
-            }
-        }
-
     }
-
     const auto time = clock_type::now() - now;
     string msg;
     ICY_ERROR(to_string("\r\nParse done after [%1] ms."_s, msg, std::chrono::duration_cast<std::chrono::milliseconds>(time).count()));
     ICY_ERROR(console_write(msg));
-
     return {};
 }
 
-
 error_type make_list(const string_view path_house, const string_view path_addr, const string_view dir_output, const uint32_t n)
 {
 
@@ -512,277 +729,63 @@ error_type make_list(const string_view path_house, const string_view path_addr,
         string file_name_house;
         string file_name_addr;
         string file_name_output;
-        ICY_ERROR(to_string("%1%2.txt"_s, file_name_house, path_house, n));
-        ICY_ERROR(to_string("%1%2.txt"_s, file_name_addr, path_addr, n));
+        ICY_ERROR(to_string("%1%2.bin"_s, file_name_house, path_house, n));
+        ICY_ERROR(to_string("%1%2.bin"_s, file_name_addr, path_addr, n));
         ICY_ERROR(to_string("%1%2.txt"_s, file_name_output, dir_output, n));
 
-        file input_house;
-        file input_addr;
+        fias_table addr;
+        fias_table houses;
         file output;
-        ICY_ERROR(input_house.open(file_name_house, file_access::read, file_open::open_existing, file_share::read));
-        ICY_ERROR(input_addr.open(file_name_addr, file_access::read, file_open::open_existing, file_share::read));
+        ICY_ERROR(addr.initialize(file_name_addr));
+        ICY_ERROR(houses.initialize(file_name_house));
         ICY_ERROR(output.open(file_name_output, file_access::app, file_open::create_always, file_share::read));
-
-        array<addr_type2> addr;
-        array<house_type2> houses;
-        {
-            auto done = false;
-            array<char> str;
-
-            const auto max_file = input_addr.info().size;
-            auto old_percent = 0ui64;
-            auto new_percent = 0ui64;
-            auto offset = 0ui64;
-
-            while (true)
-            {
-                char buffer[0x4000];
-                auto size = _countof(buffer);
-                ICY_ERROR(input_addr.read(buffer, size));
-
-                if (!size)
-                    break;
-
-                auto k = 0u;
-                while (k < size)
-                {
-                    for (; k < size; ++k)
-                    {
-                        if (str.empty())
-                        {
-                            if (buffer[k] == '\r' || buffer[k] == '\n')
-                                continue;
-
-                            str.push_back(buffer[k]);
-                        }
-                        else
-                        {
-                            if (buffer[k] == '\n' || buffer[k] == '\r')
-                            {
-                                done = true;
-                                break;
-                            }
-                            else if (str.size() < max_str_length)
-                            {
-                                str.push_back(buffer[k]);
-                            }
-                        }
-                    }
-                    if (k == size && offset + k == max_file)
-                        done = true;
-
-                    if (done)
-                    {
-                        string str_tabs;
-                        array<string_view> tabs;
-                        ICY_ERROR(to_string(str, str_tabs));
-                        ICY_ERROR(split(str_tabs, tabs, '\t'));
-
-                        if (tabs.size() < 4)
-                            continue;
-
-                        addr_type2 new_addr = {};
-                        to_value(tabs[0], new_addr.key);
-                        to_value(tabs[1], new_addr.par);
-                        if (to_value(tabs[2], new_addr.level) == error_type{})
-                        {
-                            ICY_ERROR(to_string(tabs[3], new_addr.text));
-                            ICY_ERROR(addr.push_back(std::move(new_addr)));
-                        }
-                        str.clear();
-                        done = false;
-                    }
-                }
-                offset += k;
-
-                new_percent = offset * 100ui64 / max_file;
-                if (new_percent > old_percent)
-                {
-                    string msg;
-                    ICY_ERROR(to_string("\r\nRegion %1: Parse address: %2%%..."_s, msg, n, new_percent));
-                    ICY_ERROR(console_write(msg));
-                    old_percent = new_percent;
-                }
-            }
-        }
-        {
-            string msg;
-            ICY_ERROR(to_string("\r\nRegion %1: Found %2 total objects. Sorting..."_s, msg, n, addr.size()));
-            ICY_ERROR(console_write(msg));
-        }
-        std::sort(addr.begin(), addr.end());
-        auto it = std::unique(addr.begin(), addr.end());
-        addr.pop_back(std::distance(it, addr.end()));
         {
             string msg;
-            ICY_ERROR(to_string("\r\nRegion %1: Found %2 unique objects."_s, msg, n, addr.size()));
+            ICY_ERROR(to_string("\r\nRegion %1: Mapped %2 objects and %3 houses."_s, msg, n, addr.size(), houses.size()));
             ICY_ERROR(console_write(msg));
         }
 
-        {
-            auto done = false;
-            array<char> str;
-
-            const auto max_file = input_house.info().size;
-            auto old_percent = 0ui64;
-            auto new_percent = 0ui64;
-            auto offset = 0ui64;
-
-            while (true)
-            {
-                char buffer[0x4000];
-                auto size = _countof(buffer);
-                ICY_ERROR(input_house.read(buffer, size));
-
-                if (!size)
-                    break;
-
-                auto k = 0u;
-                while (k < size)
-                {
-                    for (; k < size; ++k)
-                    {
-                        if (str.empty())
-                        {
-                            if (buffer[k] == '\r' || buffer[k] == '\n')
-                                continue;
-
-                            str.push_back(buffer[k]);
-                        }
-                        else
-                        {
-                            if (buffer[k] == '\n' || buffer[k] == '\r')
-                            {
-                                done = true;
-                                break;
-                            }
-                            else if (str.size() < max_str_length)
-                            {
-                                str.push_back(buffer[k]);
-                            }
-                        }
-                    }
-                    if (k == size && offset + k == max_file)
-                        done = true;
-
-                    if (done)
-                    {
-                        string str_tabs;
-                        array<string_view> tabs;
-                        ICY_ERROR(to_string(str, str_tabs));
-                        ICY_ERROR(split(str_tabs, tabs, '\t'));
-
-                        if (tabs.size() < 3)
-                            continue;
-
-                        house_type2 new_house = {};
-                        to_value(tabs[0], new_house.key);
-                        to_value(tabs[1], new_house.par);
-                        while (true)
-                        {
-                            if (tabs[2].bytes().size() < _countof(new_house.text))
-                                break;
-
-                            auto end = tabs[2].end();
-                            --end;
-                            tabs[2] = string_view(tabs[2].begin(), end);
-                        }
-
-                        strncpy_s(new_house.text, tabs[2].bytes().data(), tabs[2].bytes().size());
-                        ICY_ERROR(houses.push_back(std::move(new_house)));
-                        str.clear();
-                        done = false;
-                    }
-                }
-                offset += k;
-
-                new_percent = offset * 100ui64 / max_file;
-                if (new_percent > old_percent)
-                {
-                    string msg;
-                    ICY_ERROR(to_string("\r\nRegion %1: Parse house: %2%%..."_s, msg, n, new_percent));
-                    ICY_ERROR(console_write(msg));
-                    old_percent = new_percent;
-                }
-            }
-        }
-        {
-            string msg;
-            ICY_ERROR(to_string("\r\nRegion %1: Found %2 total houses. Sorting..."_s, msg, n, houses.size()));
-            ICY_ERROR(console_write(msg));
-        }
-        std::sort(houses.begin(), houses.end());
-        auto jt = std::unique(houses.begin(), houses.end());
-        houses.pop_back(std::distance(jt, houses.end()));
-        {
-            string msg;
-            ICY_ERROR(to_string("\r\nRegion %1: Found %2 unique houses."_s, msg, n, houses.size()));
-            ICY_ERROR(console_write(msg));
-        }
-
-        auto offset = 0_z;
         auto old_percent = 0_z;
         auto new_percent = 0_z;
         array<string> output_str;
-        output_str.reserve(houses.size());
+        ICY_ERROR(output_str.reserve(houses.size()));
 
-        for (auto&& house : houses)
+        for (auto k = 0_z; k < houses.size(); ++k)
         {
-            addr_type2 new_addr = {};
-            new_addr.key = house.par;
-            auto street = binary_search(addr.begin(), addr.end(), new_addr);
-            if (street == addr.end())
-                continue;
-            if (street->level != 7)
+            new_percent = (k + 1) * 100ui64 / houses.size();
+            if (new_percent > old_percent)
+            {
+                string msg;
+                ICY_ERROR(to_string("\r\nRegion %1: Making records (town/street/house): %2%%..."_s, msg, n, new_percent));
+                ICY_ERROR(console_write(msg));
+                old_percent = new_percent;
+            }
+
+            const auto street = addr.find(houses.par(k));
+            if (street == addr.size() || addr.level(street) != fias_street_level)
                 continue;
 
-            new_addr.key = street->par;
-            auto town = binary_search(addr.begin(), addr.end(), new_addr);
+            const auto town = addr.find(addr.par(street));
+            if (town == addr.size())
+                continue;
 
             string town_str;
-            town_str.appendf(town->text);
-            if (town != addr.end() && town->level > 4)
+            ICY_ERROR(town_str.append(addr.text(town)));
+            if (addr.level(town) > 4)
             {
-                auto open = false;
-                for (; town != addr.end() && town->level > 2;)
-                {                    
-                    new_addr.key = town->par;
-                    auto bigger_town = binary_search(addr.begin(), addr.end(), new_addr);
-                    if (bigger_town == addr.end())
-                        break;
-
-                    if (bigger_town->level <= 2)
-                        break;
-
-                    town = bigger_town;
-                    town_str.append(" ("_s);
-                    open = true;
-                    town_str.append(town->text);
-                    break;
+                const auto bigger_town = addr.find(addr.par(town));
+                if (bigger_town != addr.size() && addr.level(bigger_town) > 2)
+                {
+                    ICY_ERROR(town_str.append(" ("_s));
+                    ICY_ERROR(town_str.append(addr.text(bigger_town)));
+                    ICY_ERROR(town_str.append(")"_s));
                 }
-                if (open)
-                    town_str.append(")"_s);
             }
 
-
-            if (town != addr.end())
-            {
-                string_view house_text;
-                to_string(const_array_view<char>(house.text), house_text);
-
-                string out_str;
-                ICY_ERROR(to_string("%1\t%2\t%3\t%4\t%5\t%6"_s, out_str, 
-                    string_view(town_str), string_view(street->text), house_text, street->par, street->key, house.key));
-                output_str.push_back(std::move(out_str));
-            }   
-            new_percent = offset * 100ui64 / output_str.size();
-            if (new_percent > old_percent)
-            {
-                string msg;
-                ICY_ERROR(to_string("\r\nRegion %1: Making records (town/street/house): %2%%..."_s, msg, n, new_percent));
-                ICY_ERROR(console_write(msg));
-                old_percent = new_percent;
-            }
+            string out_str;
+            ICY_ERROR(to_string("%1\t%2\t%3\t%4\t%5\t%6"_s, out_str,
+                string_view(town_str), addr.text(street), houses.text(k), addr.par(street), addr.key(street), houses.key(k)));
+            ICY_ERROR(output_str.push_back(std::move(out_str)));
         }
         {
             string msg;
@@ -792,7 +795,7 @@ error_type make_list(const string_view path_house, const string_view path_addr,
         std::sort(output_str.begin(), output_str.end());
         
         old_percent = 0;
-        offset = 0_z;
+        auto offset = 0_z;
         for (auto&& str : output_str)
         {
             if (offset)
@@ -838,11 +841,16 @@ int main()
     return 0;
     for (auto k = 77; k < 77 + 1; ++k)
     {
-        const auto error = make_list(
-            "C:/VS2015/dat/fias/test_house/"_s,
-            "C:/VS2015/dat/fias/test_addrobj/"_s,
-            "C:/VS2015/dat/fias/test_result/"_s, k);
-        //const auto error = remove_duplicate_houses("D:/Downloads/fias_xml/test_house/"_s, "D:/Downloads/fias_xml/test_house2/"_s, k);
+        auto error = make_table("C:/VS2015/dat/fias/test_house/"_s, "C:/VS2015/dat/fias/test_house/"_s, k, fias_table_type::house);
+        if (!error)
+            error = make_table("C:/VS2015/dat/fias/test_addrobj/"_s, "C:/VS2015/dat/fias/test_addrobj/"_s, k, fias_table_type::addr);
+        if (!error)
+        {
+            error = make_list(
+                "C:/VS2015/dat/fias/test_house/"_s,
+                "C:/VS2015/dat/fias/test_addrobj/"_s,
+                "C:/VS2015/dat/fias/test_result/"_s, k);
+        }
         if (error)
         {
             string err_str;
@@ -0,0 +1,146 @@
+#include "engine_test.hpp"
+#include <icy_engine/core/icy_array.hpp>
+#include <cstdio>
+#if _DEBUG
+#pragma comment(lib, "icy_engine_cored")
+#pragma comment(lib, "icy_engine_graphicsd")
+#pragma comment(lib, "icy_guid")
+#else
+#pragma comment(lib, "icy_engine_core")
+#pragma comment(lib, "icy_engine_graphics")
+#pragma comment(lib, "icy_gui")
+#endif
+
+using namespace icy;
+
+static size_t g_failed = 0;
+
+static const test_entry g_tests[] =
+{
+    { "render_animation", test_render_animation },
+    { "string_convert", test_string_convert },
+    { "string_format", test_string_format },
+    { "crypto_session", test_crypto_session },
+    { "future", test_future },
+    { "hash", test_hash },
+    { "auth_cache", test_auth_cache },
+    { "render_raster", test_render_raster },
+    { "render_stream", test_render_stream },
+    { "pixel", test_pixel },
+    { "render_texture", test_render_texture },
+    { "html_parse", test_html_parse },
+    { "lua_pool", test_lua_pool },
+    { "lua_view", test_lua_view },
+    { "mpmc_queue", test_mpmc_queue },
+    { "thread_pool", test_thread_pool },
+};
+static const test_entry g_bench[] =
+{
+    { "render_transform", bench_render_transform },
+    { "render_animation", bench_render_animation },
+    { "string_appendf", bench_string_appendf },
+    { "crypto_session", bench_crypto_session },
+    { "hash", bench_hash },
+    { "auth_cache", bench_auth_cache },
+    { "render_raster", bench_render_raster },
+    { "pixel", bench_pixel },
+    { "render_texture", bench_render_texture },
+    { "gui_model", bench_gui_model },
+    { "gui_node_pool", bench_gui_node_pool },
+    { "css_prepare", bench_css_prepare },
+    { "css_cascade", bench_css_cascade },
+    { "html_parse", bench_html_parse },
+    { "lua_pool", bench_lua_pool },
+    { "lua_view", bench_lua_view },
+    { "thread_pool", bench_thread_pool },
+    { "future", bench_future },
+};
+
+void icy::test_check(const bool value, const char* const text, const char* const file, const int line) noexcept
+{
+    if (value)
+        return;
+    ++g_failed;
+    fprintf(stdout, "%s(%d): check failed: %s\n", file, line, text);
+    fflush(stdout);
+}
+error_type icy::test_print(const string_view str) noexcept
+{
+    const auto bytes = str.bytes();
+    if (fwrite(bytes.data(), 1, bytes.size(), stdout) != bytes.size())
+        return make_stdlib_error(std::errc::io_error);
+    fflush(stdout);
+    return error_type();
+}
+error_type icy::test_report(const string_view name, const size_t count, const duration_type time) noexcept
+{
+    const auto ns = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(time).count());
+    string str;
+    ICY_ERROR(to_string("%1: %2 items in %3 ms (%4 ns/item)\n"_s, str, name,
+        uint64_t(count), ns / 1'000'000, count ? ns / count : 0));
+    return test_print(str);
+}
+error_type icy::test_report_bytes(const string_view name, const uint64_t bytes, const duration_type time) noexcept
+{
+    const auto ns = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(time).count());
+    string str;
+    ICY_ERROR(to_string("%1: %2 bytes in %3 ms (%4 MB/s)\n"_s, str, name,
+        bytes, ns / 1'000'000, ns ? uint64_t(double(bytes) / 1_mb * 1e9 / double(ns)) : 0));
+    return test_print(str);
+}
+
+static error_type run(const const_array_view<test_entry> list, const string_view filter) noexcept
+{
+    for (auto&& entry : list)
+    {
+        if (!entry.func)
+            continue;
+        const auto name = string_view(entry.name, strlen(entry.name), string_view::constexpr_tag());
+        if (!filter.empty() && filter != name)
+            continue;
+
+        const auto failed = g_failed;
+        string str;
+        if (const auto error = entry.func())
+        {
+            ++g_failed;
+            ICY_ERROR(to_string("%1: error %2\n"_s, str, name, error));
+        }
+        else
+        {
+            ICY_ERROR(to_string("%1: %2\n"_s, str, name, g_failed == failed ? "ok"_s : "failed"_s));
+        }
+        ICY_ERROR(test_print(str));
+    }
+    return error_type();
+}
+
+//  "engine_test [name]" runs the tests, "engine_test bench [name]" runs the benchmarks (use a release build)
+static error_type main_ex() noexcept
+{
+    array<string> args;
+    ICY_ERROR(win32_parse_cargs(args));
+
+    auto bench = false;
+    auto filter = string_view();
+    for (auto k = 1_z; k < args.size(); ++k)
+    {
+        if (args[k] == "bench"_s)
+            bench = true;
+        else
+            filter = args[k];
+    }
+    return bench ? run(g_bench, filter) : run(g_tests, filter);
+}
+
+int main()
+{
+    heap gheap;
+    if (gheap.initialize(heap_init::global(1_gb)))
+        return ENOMEM;
+
+    if (auto error = main_ex())
+        return int(error.code);
+
+    return g_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <icy_engine/core/icy_string.hpp>
+
+//  records a failed check (with the expression and location) and keeps going
+#define ICY_TEST(X) icy::test_check(!!(X), #X, __FILE__, __LINE__)
+
+namespace icy
+{
+    using test_func = error_type(*)();
+    struct test_entry
+    {
+        const char* name;
+        test_func func;
+    };
+
+    void test_check(const bool value, const char* const text, const char* const file, const int line) noexcept;
+    error_type test_print(const string_view str) noexcept;
+    //  one line: "name: count items in ms (ns/item)"
+    error_type test_report(const string_view name, const size_t count, const duration_type time) noexcept;
+    //  one line: "name: bytes in ms (MB/s)"
+    error_type test_report_bytes(const string_view name, const uint64_t bytes, const duration_type time) noexcept;
+
+    error_type test_render_animation() noexcept;
+    error_type test_string_convert() noexcept;
+    error_type test_string_format() noexcept;
+    error_type test_crypto_session() noexcept;
+    error_type test_future() noexcept;
+    error_type test_hash() noexcept;
+    error_type test_auth_cache() noexcept;
+    error_type test_render_raster() noexcept;
+    error_type test_render_stream() noexcept;
+    error_type test_pixel() noexcept;
+    error_type test_render_texture() noexcept;
+    error_type test_html_parse() noexcept;
+    error_type test_lua_pool() noexcept;
+    error_type test_lua_view() noexcept;
+    error_type test_mpmc_queue() noexcept;
+    error_type test_thread_pool() noexcept;
+
+    error_type bench_render_transform() noexcept;
+    error_type bench_render_animation() noexcept;
+    error_type bench_string_appendf() noexcept;
+    error_type bench_crypto_session() noexcept;
+    error_type bench_hash() noexcept;
+    error_type bench_auth_cache() noexcept;
+    error_type bench_render_raster() noexcept;
+    error_type bench_pixel() noexcept;
+    error_type bench_render_texture() noexcept;
+    error_type bench_gui_model() noexcept;
+    error_type bench_gui_node_pool() noexcept;
+    error_type bench_css_prepare() noexcept;
+    error_type bench_css_cascade() noexcept;
+    error_type bench_html_parse() noexcept;
+    error_type bench_lua_pool() noexcept;
+    error_type bench_lua_view() noexcept;
+    error_type bench_thread_pool() noexcept;
+    error_type bench_future() noexcept;
+}
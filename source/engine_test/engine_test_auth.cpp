@@ -0,0 +1,202 @@
+#include "engine_test.hpp"
+#include <icy_engine/core/icy_array.hpp>
+#include <icy_engine/core/icy_thread.hpp>
+#include "../icy_auth/server/icy_auth_cache.hpp"
+#include <algorithm>
+#include <cmath>
+
+using namespace icy;
+
+ICY_STATIC_NAMESPACE_BEG
+//  same layout as "auth_client_data" (the server header pulls in LMDB)
+struct auth_test_record
+{
+    crypto_key password;
+    icy::guid guid;
+    char date[sizeof("YYYY-MM-DD HH:MM:SS")] = {};
+};
+static uint64_t next_random(uint64_t& state) noexcept
+{
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+static uint64_t auth_test_key(const uint32_t client) noexcept
+{
+    return uint64_t(client) * 0x9E3779B97F4A7C15ull + 1;
+}
+//  "count" client indices out of "clients": uniform, or Zipf-distributed by rank with exponent "skew"
+static error_type auth_test_sequence(const size_t clients, const size_t count, const double skew, array<uint32_t>& output) noexcept
+{
+    ICY_ERROR(output.resize(count));
+    auto state = 0x2545F4914F6CDD1Dull;
+    if (skew == 0)
+    {
+        for (auto&& index : output)
+            index = uint32_t(next_random(state) % clients);
+        return error_type();
+    }
+    array<double> cdf;
+    ICY_ERROR(cdf.resize(clients));
+    auto sum = 0.0;
+    for (auto k = 0_z; k < clients; ++k)
+        cdf[k] = sum += 1 / std::pow(double(k + 1), skew);
+    for (auto&& index : output)
+    {
+        const auto value = double(next_random(state) >> 11) / double(1ull << 53) * sum;
+        index = uint32_t(std::lower_bound(cdf.begin(), cdf.end(), value) - cdf.begin());
+        index = std::min(index, uint32_t(clients - 1));
+    }
+    return error_type();
+}
+//  a lookup as client_ticket does it: on a miss the record is "read from the database" and cached
+static size_t auth_test_lookup(auth_cache<auth_test_record>& cache, const const_array_view<uint32_t> sequence,
+    const auth_clock::time_point now) noexcept
+{
+    auto misses = 0_z;
+    auth_test_record record;
+    for (auto&& client : sequence)
+    {
+        const auto key = auth_test_key(client);
+        if (cache.find(key, record, now))
+            continue;
+        const auto generation = cache.generation(key);
+        record.date[0] = char(client);
+        cache.insert(key, record, now + std::chrono::hours(1), generation);
+        ++misses;
+    }
+    return misses;
+}
+class auth_test_thread : public thread
+{
+public:
+    error_type run() noexcept override
+    {
+        misses = auth_test_lookup(*cache, sequence, now);
+        return error_type();
+    }
+public:
+    auth_cache<auth_test_record>* cache = nullptr;
+    const_array_view<uint32_t> sequence;
+    auth_clock::time_point now;
+    size_t misses = 0;
+};
+ICY_STATIC_NAMESPACE_END
+
+error_type icy::test_auth_cache() noexcept
+{
+    auth_cache<auth_test_record> cache;
+    ICY_ERROR(cache.initialize(1024));
+    const auto now = auth_clock::now();
+    auth_test_record record;
+    record.date[0] = 'a';
+
+    //  miss, insert, hit, expiry
+    ICY_TEST(!cache.find(1, record, now));
+    cache.insert(1, record, now + std::chrono::seconds(10), cache.generation(1));
+    record.date[0] = 0;
+    ICY_TEST(cache.find(1, record, now) && record.date[0] == 'a');
+    ICY_TEST(!cache.find(1, record, now + std::chrono::seconds(10)));
+    ICY_TEST(!cache.find(1, record, now));
+
+    //  an insert that raced with "erase" or "clear" is dropped
+    auto generation = cache.generation(2);
+    cache.erase(2);
+    cache.insert(2, record, now + std::chrono::seconds(10), generation);
+    ICY_TEST(!cache.find(2, record, now));
+    generation = cache.generation(2);
+    cache.insert(2, record, now + std::chrono::seconds(10), generation);
+    ICY_TEST(cache.find(2, record, now));
+    generation = cache.generation(3);
+    cache.clear();
+    cache.insert(3, record, now + std::chrono::seconds(10), generation);
+    ICY_TEST(!cache.find(2, record, now) && !cache.find(3, record, now));
+
+    //  more keys than slots: lookups keep working, entries closest to expiry go first
+    for (auto k = 0u; k < 10'000; ++k)
+        cache.insert(auth_test_key(k), record, now + std::chrono::seconds(1 + k), cache.generation(auth_test_key(k)));
+    auto found = 0_z;
+    for (auto k = 0u; k < 10'000; ++k)
+        found += cache.find(auth_test_key(k), record, now);
+    ICY_TEST(found > 0 && found <= 1024);
+    ICY_TEST(cache.find(auth_test_key(9'999), record, now));
+
+    string status;
+    ICY_ERROR(cache.status(status));
+    ICY_TEST(!status.empty());
+    return error_type();
+}
+
+//  1M registered clients, 4M lookups: hit rate and lookup cost by capacity and access pattern
+error_type icy::bench_auth_cache() noexcept
+{
+    const auto clients = 1'000'000_z;
+    const auto lookups = 4'000'000_z;
+    const auto now = auth_clock::now();
+
+    struct pattern_type
+    {
+        const char* name;
+        double skew;
+    };
+    const pattern_type patterns[] = { { "uniform", 0 }, { "zipf 0.9", 0.9 } };
+    const size_t capacities[] = { 64 * 1024, 1'000'000, 2'000'000 };
+    for (auto&& pattern : patterns)
+    {
+        array<uint32_t> sequence;
+        ICY_ERROR(auth_test_sequence(clients, lookups, pattern.skew, sequence));
+        const auto pattern_name = string_view(pattern.name, strlen(pattern.name), string_view::constexpr_tag());
+
+        for (auto&& capacity : capacities)
+        {
+            auth_cache<auth_test_record> cache;
+            ICY_ERROR(cache.initialize(capacity));
+
+            const auto beg = clock_type::now();
+            const auto misses = auth_test_lookup(cache, sequence, now);
+            const auto time = clock_type::now() - beg;
+
+            string name;
+            ICY_ERROR(to_string("auth cache, 1 thread, %1, capacity %2, hit rate %3 pct"_s, name, pattern_name,
+                uint64_t(capacity), 100.0 * double(lookups - misses) / double(lookups)));
+            ICY_ERROR(test_report(name, lookups, time));
+        }
+
+        //  the same lookups split over 4 threads (shards take the contention)
+        {
+            const auto thread_count = 4_z;
+            auth_cache<auth_test_record> cache;
+            ICY_ERROR(cache.initialize(1'000'000));
+
+            array<shared_ptr<auth_test_thread>> threads;
+            const auto slice = lookups / thread_count;
+            for (auto k = 0_z; k < thread_count; ++k)
+            {
+                shared_ptr<auth_test_thread> new_thread;
+                ICY_ERROR(make_shared(new_thread));
+                new_thread->cache = &cache;
+                new_thread->sequence = const_array_view<uint32_t>(sequence.data() + k * slice, slice);
+                new_thread->now = now;
+                ICY_ERROR(threads.push_back(std::move(new_thread)));
+            }
+            const auto beg = clock_type::now();
+            for (auto&& thread : threads)
+                ICY_ERROR(thread->launch());
+            auto misses = 0_z;
+            for (auto&& thread : threads)
+            {
+                ICY_ERROR(thread->wait());
+                ICY_ERROR(thread->error());
+                misses += thread->misses;
+            }
+            const auto time = clock_type::now() - beg;
+
+            string name;
+            ICY_ERROR(to_string("auth cache, 4 threads, %1, capacity 1000000, hit rate %2 pct"_s, name, pattern_name,
+                100.0 * double(lookups - misses) / double(lookups)));
+            ICY_ERROR(test_report(name, lookups, time));
+        }
+    }
+    return error_type();
+}
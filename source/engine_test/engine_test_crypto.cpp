@@ -0,0 +1,250 @@
+#include "engine_test.hpp"
+#include <icy_engine/core/icy_array.hpp>
+#include <icy_engine/core/icy_smart_pointer.hpp>
+#include <icy_engine/core/icy_thread.hpp>
+#include <icy_engine/utility/icy_crypto.hpp>
+
+using namespace icy;
+
+ICY_STATIC_NAMESPACE_BEG
+struct crypto_test_msg
+{
+    uint32_t index = 0;
+    uint64_t value = 0;
+    char text[20] = {};
+};
+class crypto_test_thread : public thread
+{
+public:
+    error_type run() noexcept override
+    {
+        crypto_session session;
+        for (auto k = 0_z; k < lookups; ++k)
+            ICY_ERROR(cache->find(peers[(k * 7 + offset) % peer_count], *private_key, session));
+        return error_type();
+    }
+public:
+    crypto_session_cache* cache = nullptr;
+    const crypto_key* peers = nullptr;
+    size_t peer_count = 0;
+    const crypto_key* private_key = nullptr;
+    size_t lookups = 0;
+    size_t offset = 0;
+};
+ICY_STATIC_NAMESPACE_END
+
+error_type icy::test_crypto_session() noexcept
+{
+    crypto_key public_a, private_a;
+    crypto_key public_b, private_b;
+    crypto_key::pair(public_a, private_a);
+    crypto_key::pair(public_b, private_b);
+
+    //  both sides derive the same shared key
+    crypto_session session_ab;
+    crypto_session session_ba;
+    ICY_ERROR(session_ab.initialize(public_b, private_a));
+    ICY_ERROR(session_ba.initialize(public_a, private_b));
+    ICY_TEST(memcmp(session_ab.key().data(), session_ba.key().data(), sizeof(crypto_key)) == 0);
+
+    //  typed batch
+    array<crypto_test_msg> input;
+    ICY_ERROR(input.resize(100));
+    for (auto k = 0_z; k < input.size(); ++k)
+    {
+        input[k].index = uint32_t(k);
+        input[k].value = k * 0x9E3779B97F4A7C15ull;
+        input[k].text[k % sizeof(input[k].text)] = char('a' + k % 26);
+    }
+    array<crypto_msg<crypto_test_msg>> msgs;
+    array<crypto_test_msg> output;
+    ICY_ERROR(msgs.resize(input.size()));
+    ICY_ERROR(output.resize(input.size()));
+    ICY_ERROR(crypto_msg_encode<crypto_test_msg>(session_ab, input, msgs));
+    ICY_ERROR(crypto_msg_decode<crypto_test_msg>(session_ba, msgs, output));
+    ICY_TEST(memcmp(input.data(), output.data(), input.size() * sizeof(crypto_test_msg)) == 0);
+
+    //  a message also decodes with the per-message (non-session) keys
+    crypto_test_msg single;
+    ICY_ERROR(msgs[7].decode(public_a, private_b, single));
+    ICY_TEST(single.index == 7 && single.value == input[7].value);
+
+    ICY_TEST(crypto_msg_encode<crypto_test_msg>(session_ab, input, array_view<crypto_msg<crypto_test_msg>>(msgs.data(), 1))
+        == make_stdlib_error(std::errc::message_size));
+
+    //  byte batch
+    const auto size = 48_z;
+    const auto count = 100_z;
+    array<uint8_t> bytes;
+    array<uint8_t> packed;
+    array<uint8_t> unpacked;
+    ICY_ERROR(bytes.resize(size * count));
+    ICY_ERROR(packed.resize((size + crypto_msg_size) * count));
+    ICY_ERROR(unpacked.resize(size * count));
+    for (auto k = 0_z; k < bytes.size(); ++k)
+        bytes[k] = uint8_t(k * 31);
+    ICY_ERROR(crypto_msg_encode(session_ab, size, bytes, packed));
+    ICY_ERROR(crypto_msg_decode(session_ba, size, packed, unpacked));
+    ICY_TEST(memcmp(bytes.data(), unpacked.data(), bytes.size()) == 0);
+
+    //  nonces are unique within a batch
+    auto unique = true;
+    for (auto k = 1_z; k < count; ++k)
+        unique &= memcmp(packed.data(), packed.data() + k * (size + crypto_msg_size), sizeof(crypto_nonce)) != 0;
+    ICY_TEST(unique);
+
+    packed[packed.size() - 1] ^= 1;
+    ICY_TEST(crypto_msg_decode(session_ba, size, packed, unpacked) == make_stdlib_error(std::errc::illegal_byte_sequence));
+    ICY_TEST(crypto_msg_decode(session_ba, size + 1, packed, unpacked) == make_stdlib_error(std::errc::message_size));
+
+    //  session cache: LRU eviction, hit/miss counters, clear
+    crypto_key peers[6];
+    crypto_key unused;
+    for (auto&& peer : peers)
+        crypto_key::pair(peer, unused);
+
+    crypto_session_cache cache;
+    ICY_ERROR(cache.initialize(4));
+    crypto_session session;
+    for (auto&& peer : peers)
+    {
+        ICY_ERROR(cache.find(peer, private_a, session));
+        crypto_session expected;
+        ICY_ERROR(expected.initialize(peer, private_a));
+        ICY_TEST(memcmp(session.key().data(), expected.key().data(), sizeof(crypto_key)) == 0);
+    }
+    ICY_TEST(cache.size() == 4 && cache.hits() == 0 && cache.misses() == 6);
+
+    ICY_ERROR(cache.find(peers[5], private_a, session));
+    ICY_ERROR(cache.find(peers[2], private_a, session));
+    ICY_TEST(cache.hits() == 2 && cache.misses() == 6);
+
+    //  peers 0 and 1 were evicted: 0 comes back in place of 3 (least recently used), so 3 misses again
+    ICY_ERROR(cache.find(peers[0], private_a, session));
+    ICY_ERROR(cache.find(peers[4], private_a, session));
+    ICY_ERROR(cache.find(peers[3], private_a, session));
+    ICY_TEST(cache.size() == 4 && cache.hits() == 3 && cache.misses() == 8);
+
+    cache.clear();
+    ICY_TEST(cache.size() == 0 && cache.hits() == 0 && cache.misses() == 0);
+    ICY_ERROR(cache.find(peers[2], private_a, session));
+    ICY_TEST(cache.size() == 1 && cache.misses() == 1);
+
+    //  the counters are polled while other threads look up (and evict) sessions
+    {
+        const auto thread_count = 4_z;
+        const auto lookups = 500_z;
+        cache.clear();
+        array<shared_ptr<crypto_test_thread>> threads;
+        for (auto k = 0_z; k < thread_count; ++k)
+        {
+            shared_ptr<crypto_test_thread> new_thread;
+            ICY_ERROR(make_shared(new_thread));
+            new_thread->cache = &cache;
+            new_thread->peers = peers;
+            new_thread->peer_count = _countof(peers);
+            new_thread->private_key = &private_a;
+            new_thread->lookups = lookups;
+            new_thread->offset = k;
+            ICY_ERROR(threads.push_back(std::move(new_thread)));
+        }
+        for (auto&& thread : threads)
+            ICY_ERROR(thread->launch());
+
+        auto last = 0_z;
+        auto running = true;
+        while (running)
+        {
+            running = false;
+            for (auto&& thread : threads)
+                running |= thread->state() != thread_state::done;
+            const auto total = cache.hits() + cache.misses();
+            ICY_TEST(cache.size() <= 4);
+            ICY_TEST(total >= last);
+            last = total;
+        }
+        for (auto&& thread : threads)
+        {
+            ICY_ERROR(thread->wait());
+            ICY_TEST(!thread->error());
+        }
+        ICY_TEST(cache.hits() + cache.misses() == thread_count * lookups);
+    }
+    return error_type();
+}
+
+error_type icy::bench_crypto_session() noexcept
+{
+    crypto_key public_a, private_a;
+    crypto_key public_b, private_b;
+    crypto_key::pair(public_a, private_a);
+    crypto_key::pair(public_b, private_b);
+    crypto_session session;
+    ICY_ERROR(session.initialize(public_b, private_a));
+
+    const auto size = 64_z;
+    const auto count = 4096_z;
+    array<uint8_t> input;
+    array<uint8_t> output;
+    ICY_ERROR(input.resize(size * count));
+    ICY_ERROR(output.resize((size + crypto_msg_size) * count));
+    const auto block = size + crypto_msg_size;
+
+    //  one X25519 scalar multiplication per message
+    {
+        const auto slow = count / 16;
+        const auto beg = clock_type::now();
+        for (auto k = 0_z; k < slow; ++k)
+        {
+            ICY_ERROR(crypto_msg_encode(public_b, private_a, const_array_view<uint8_t>(input.data() + k * size, size),
+                array_view<uint8_t>(output.data() + k * block, block)));
+        }
+        ICY_ERROR(test_report("crypto encode 64 bytes, key pair"_s, slow, clock_type::now() - beg));
+    }
+    {
+        const auto beg = clock_type::now();
+        for (auto k = 0_z; k < count; ++k)
+        {
+            ICY_ERROR(crypto_msg_encode(session, const_array_view<uint8_t>(input.data() + k * size, size),
+                array_view<uint8_t>(output.data() + k * block, block)));
+        }
+        ICY_ERROR(test_report("crypto encode 64 bytes, session"_s, count, clock_type::now() - beg));
+    }
+    {
+        const auto beg = clock_type::now();
+        ICY_ERROR(crypto_msg_encode(session, size, input, output));
+        ICY_ERROR(test_report("crypto encode 64 bytes, session batch"_s, count, clock_type::now() - beg));
+    }
+    {
+        const auto beg = clock_type::now();
+        ICY_ERROR(crypto_msg_decode(session, size, output, input));
+        ICY_ERROR(test_report("crypto decode 64 bytes, session batch"_s, count, clock_type::now() - beg));
+    }
+
+    //  cache lookups over a working set that fits (hits) and one that doesn't (every lookup evicts)
+    const size_t peer_counts[] = { 1000, 8192 };
+    for (auto&& peer_count : peer_counts)
+    {
+        array<crypto_key> peers;
+        ICY_ERROR(peers.resize(peer_count));
+        crypto_key unused;
+        for (auto&& peer : peers)
+            crypto_key::pair(peer, unused);
+
+        crypto_session_cache cache;
+        ICY_ERROR(cache.initialize(4096));
+        for (auto&& peer : peers)
+            ICY_ERROR(cache.find(peer, private_a, session));
+
+        const auto lookups = 20'000_z;
+        const auto beg = clock_type::now();
+        for (auto k = 0_z; k < lookups; ++k)
+            ICY_ERROR(cache.find(peers[k * 7919 % peer_count], private_a, session));
+
+        string str;
+        ICY_ERROR(to_string("crypto session cache find (%1 peers, %2 hits)"_s, str,
+            uint64_t(peer_count), uint64_t(cache.hits())));
+        ICY_ERROR(test_report(str, lookups, clock_type::now() - beg));
+    }
+    return error_type();
+}
@@ -0,0 +1,380 @@
+#include "engine_test.hpp"
+#include <icy_engine/core/icy_array.hpp>
+#include <icy_engine/core/icy_future.hpp>
+#include <icy_engine/core/icy_thread.hpp>
+#include <windows.h>
+
+using namespace icy;
+
+ICY_STATIC_NAMESPACE_BEG
+class future_test_thread : public thread
+{
+public:
+    error_type run() noexcept override
+    {
+        sleep(std::chrono::milliseconds(20));
+        output.set_value(42);
+        return error_type();
+    }
+public:
+    promise<uint32_t> output;
+};
+static void future_test_count(void* user) noexcept
+{
+    ++*static_cast<size_t*>(user);
+}
+
+//  round trip: a client sends "index" to the server thread and waits for it to come back
+struct future_test_request
+{
+    uint32_t client = 0;
+    uint32_t index = 0;
+    promise<uint32_t> result;   //  empty: broadcast the response
+};
+struct future_test_response
+{
+    uint32_t client = 0;
+    uint32_t index = 0;
+};
+class future_test_server : public event_system
+{
+public:
+    error_type initialize(const event_type type) noexcept
+    {
+        m_type = type;
+        return m_sync.initialize();
+    }
+    error_type exec() noexcept override
+    {
+        while (*this)
+        {
+            while (auto event = pop())
+            {
+                auto& request = event->data<future_test_request>();
+                if (request.result)
+                    request.result.set_value(uint32_t(request.index));
+                else
+                    ICY_ERROR(event::post(this, m_type, future_test_response{ request.client, request.index }));
+            }
+            ICY_ERROR(m_sync.wait());
+        }
+        return error_type();
+    }
+    error_type signal(const event_data* event) noexcept override
+    {
+        return m_sync.wake();
+    }
+private:
+    event_type m_type = event_type::none;
+    sync_handle m_sync;
+};
+class future_test_client : public thread
+{
+public:
+    error_type run() noexcept override
+    {
+        for (auto k = 0u; k < count; ++k)
+        {
+            const auto beg = clock_type::now();
+            future_test_request request;
+            request.client = index;
+            request.index = k;
+            if (queue)
+            {
+                ICY_ERROR(server->post(nullptr, event_type::system_internal, std::move(request)));
+                //  every subscriber gets every response and keeps only its own
+                while (true)
+                {
+                    event event;
+                    ICY_ERROR(queue->pop(event));
+                    if (!event)
+                        return make_stdlib_error(std::errc::operation_canceled);
+                    const auto& response = event->data<future_test_response>();
+                    if (response.client == index && response.index == k)
+                        break;
+                }
+            }
+            else
+            {
+                future<uint32_t> output;
+                ICY_ERROR(request.result.initialize(output));
+                ICY_ERROR(server->post(nullptr, event_type::system_internal, std::move(request)));
+                ICY_ERROR(output.wait());
+                auto value = 0u;
+                ICY_ERROR(output.get(value));
+                if (value != k)
+                    return make_unexpected_error();
+            }
+            latency += clock_type::now() - beg;
+        }
+        return error_type();
+    }
+public:
+    future_test_server* server = nullptr;
+    event_queue* queue = nullptr;       //  null: wait on a future
+    uint32_t index = 0;
+    uint32_t count = 0;
+    duration_type latency = {};
+};
+//  a subscriber that is not waiting for anything: it still wakes up for every response
+class future_test_listener : public thread
+{
+public:
+    error_type run() noexcept override
+    {
+        while (true)
+        {
+            event event;
+            ICY_ERROR(queue->pop(event));
+            if (!event)
+                break;
+        }
+        return error_type();
+    }
+public:
+    shared_ptr<event_queue> queue;
+};
+//  user + kernel time of the process
+static duration_type future_test_cpu() noexcept
+{
+    FILETIME create, exit, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &create, &exit, &kernel, &user))
+        return {};
+    const auto ticks = (uint64_t(kernel.dwHighDateTime) << 32 | kernel.dwLowDateTime)
+        + (uint64_t(user.dwHighDateTime) << 32 | user.dwLowDateTime);
+    return std::chrono::duration_cast<duration_type>(std::chrono::duration<uint64_t, std::ratio<1, 10000000>>(ticks));
+}
+static error_type future_test_round_trip(const bool broadcast) noexcept
+{
+    static const auto type = next_event_user();
+    const auto client_count = 4u;
+    const auto listener_count = 4u;
+    const auto count = 20u * 1000;
+
+    shared_ptr<future_test_server> server;
+    ICY_ERROR(make_shared(server));
+    ICY_ERROR(server->initialize(type));
+    shared_ptr<event_thread> server_thread;
+    ICY_ERROR(make_shared(server_thread));
+    server_thread->system = server.get();
+    ICY_ERROR(server_thread->launch());
+    ICY_SCOPE_EXIT{ server_thread->wait(); };
+    ICY_SCOPE_EXIT{ server->post_quit_event(); };
+
+    array<shared_ptr<event_queue>> queues;
+    array<shared_ptr<future_test_listener>> listeners;
+    ICY_SCOPE_EXIT
+    {
+        for (auto&& listener : listeners)
+        {
+            listener->queue->post_quit_event();
+            listener->wait();
+        }
+    };
+    if (broadcast)
+    {
+        for (auto k = 0u; k < client_count; ++k)
+        {
+            shared_ptr<event_queue> queue;
+            ICY_ERROR(create_event_system(queue, type));
+            ICY_ERROR(queues.push_back(std::move(queue)));
+        }
+        for (auto k = 0u; k < listener_count; ++k)
+        {
+            shared_ptr<future_test_listener> listener;
+            ICY_ERROR(make_shared(listener));
+            ICY_ERROR(create_event_system(listener->queue, type));
+            ICY_ERROR(listener->launch());
+            ICY_ERROR(listeners.push_back(std::move(listener)));
+        }
+    }
+
+    array<shared_ptr<future_test_client>> clients;
+    for (auto k = 0u; k < client_count; ++k)
+    {
+        shared_ptr<future_test_client> client;
+        ICY_ERROR(make_shared(client));
+        client->server = server.get();
+        client->queue = broadcast ? queues[k].get() : nullptr;
+        client->index = k;
+        client->count = count;
+        ICY_ERROR(clients.push_back(std::move(client)));
+    }
+
+    const auto cpu = future_test_cpu();
+    const auto beg = clock_type::now();
+    for (auto&& client : clients)
+        ICY_ERROR(client->launch());
+    duration_type latency = {};
+    for (auto&& client : clients)
+    {
+        ICY_ERROR(client->wait());
+        ICY_ERROR(client->error());
+        latency += client->latency;
+    }
+    const auto time = clock_type::now() - beg;
+    const auto requests = size_t(client_count) * count;
+
+    string name;
+    const auto mode = broadcast ? "broadcast + filter"_s : "future"_s;
+    ICY_ERROR(to_string("round trip, %1, %2 clients"_s, name, mode, uint64_t(client_count)));
+    ICY_ERROR(test_report(name, requests, time));
+    ICY_ERROR(to_string("round trip latency, %1"_s, name, mode));
+    ICY_ERROR(test_report(name, requests, latency));
+    ICY_ERROR(to_string("round trip CPU, %1"_s, name, mode));
+    ICY_ERROR(test_report(name, requests, future_test_cpu() - cpu));
+    return error_type();
+}
+#if ICY_COROUTINE
+static async_task future_test_await(array<future<uint32_t>>& futures, uint64_t& sum, error_type& result) noexcept
+{
+    for (auto&& item : futures)
+    {
+        auto value = 0u;
+        auto error = co_await item;
+        if (!error)
+            error = item.get(value);
+        if (error)
+        {
+            result = error;
+            co_return error_type();
+        }
+        sum += value;
+    }
+    co_return error_type();
+}
+#endif
+ICY_STATIC_NAMESPACE_END
+
+error_type icy::test_future() noexcept
+{
+    //  empty future
+    {
+        future<uint32_t> output;
+        auto value = 0u;
+        ICY_TEST(!output && !output.ready());
+        ICY_TEST(output.wait() == make_stdlib_error(std::errc::invalid_argument));
+        ICY_TEST(output.get(value) == make_stdlib_error(std::errc::operation_would_block));
+    }
+
+    //  value, error and a dropped promise
+    {
+        promise<uint32_t> input;
+        future<uint32_t> output;
+        ICY_ERROR(input.initialize(output));
+        ICY_TEST(input && output && !output.ready());
+        auto value = 0u;
+        ICY_TEST(output.get(value) == make_stdlib_error(std::errc::operation_would_block));
+        input.set_value(7);
+        ICY_TEST(!input && output.ready());
+        ICY_TEST(!output.get(value) && value == 7);
+        ICY_TEST(!output.wait());
+    }
+    {
+        promise<uint32_t> input;
+        future<uint32_t> output;
+        ICY_ERROR(input.initialize(output));
+        input.set_error(make_stdlib_error(std::errc::no_such_device));
+        auto value = 0u;
+        ICY_TEST(output.get(value) == make_stdlib_error(std::errc::no_such_device));
+    }
+    {
+        future<uint32_t> output;
+        {
+            promise<uint32_t> input;
+            ICY_ERROR(input.initialize(output));
+        }
+        auto value = 0u;
+        ICY_TEST(output.ready() && output.get(value) == make_stdlib_error(std::errc::operation_canceled));
+    }
+
+    //  "then" runs once: on completion if attached first, right away otherwise
+    {
+        promise<uint32_t> input;
+        future<uint32_t> output;
+        ICY_ERROR(input.initialize(output));
+        auto count = 0_z;
+        output.then(future_test_count, &count);
+        ICY_TEST(count == 0);
+        input.set_value(1);
+        ICY_TEST(count == 1);
+
+        auto late = 0_z;
+        future<uint32_t> ready_future;
+        promise<uint32_t> ready_promise;
+        ICY_ERROR(ready_promise.initialize(ready_future));
+        ready_promise.set_value(2);
+        ready_future.then(future_test_count, &late);
+        ICY_TEST(late == 1);
+    }
+
+    //  "wait" times out and detaches, a later completion is still seen; then one from another thread
+    {
+        promise<uint32_t> input;
+        future<uint32_t> output;
+        ICY_ERROR(input.initialize(output));
+        ICY_TEST(output.wait(std::chrono::milliseconds(1)) == make_stdlib_error(std::errc::timed_out));
+        input.set_value(3);
+        auto value = 0u;
+        ICY_TEST(!output.wait() && !output.get(value) && value == 3);
+    }
+    {
+        shared_ptr<future_test_thread> thread;
+        ICY_ERROR(make_shared(thread));
+        future<uint32_t> output;
+        ICY_ERROR(thread->output.initialize(output));
+        ICY_ERROR(thread->launch());
+        ICY_TEST(!output.wait());
+        ICY_ERROR(thread->wait());
+        ICY_TEST(!thread->error());
+        auto value = 0u;
+        ICY_TEST(!output.get(value) && value == 42);
+    }
+
+#if ICY_COROUTINE
+    //  "co_await" on completed futures continues without suspending (100k in a row)
+    {
+        const auto count = 100'000_z;
+        array<promise<uint32_t>> promises;
+        array<future<uint32_t>> futures;
+        ICY_ERROR(promises.resize(count));
+        ICY_ERROR(futures.resize(count));
+        for (auto k = 0_z; k < count; ++k)
+        {
+            ICY_ERROR(promises[k].initialize(futures[k]));
+            promises[k].set_value(1);
+        }
+        auto sum = 0ull;
+        error_type result;
+        future_test_await(futures, sum, result);
+        ICY_TEST(!result && sum == count);
+    }
+    //  a pending future resumes the coroutine on completion
+    {
+        array<promise<uint32_t>> promises;
+        array<future<uint32_t>> futures;
+        ICY_ERROR(promises.resize(2));
+        ICY_ERROR(futures.resize(2));
+        ICY_ERROR(promises[0].initialize(futures[0]));
+        ICY_ERROR(promises[1].initialize(futures[1]));
+        auto sum = 0ull;
+        error_type result;
+        future_test_await(futures, sum, result);
+        ICY_TEST(sum == 0);
+        promises[0].set_value(5);
+        ICY_TEST(sum == 5);
+        promises[1].set_error(make_stdlib_error(std::errc::operation_canceled));
+        ICY_TEST(sum == 5 && result == make_stdlib_error(std::errc::operation_canceled));
+    }
+#endif
+    return error_type();
+}
+
+//  4 clients x 20k sequential requests to one server thread: the response broadcast to 8 subscribers
+//  (the 4 clients and 4 idle listeners), each filtering for its own, vs a future completed by the server
+error_type icy::bench_future() noexcept
+{
+    ICY_ERROR(future_test_round_trip(true));
+    ICY_ERROR(future_test_round_trip(false));
+    return error_type();
+}
@@ -0,0 +1,205 @@
+#include "engine_test.hpp"
+#include <icy_engine/core/icy_array.hpp>
+#include <icy_engine/core/icy_thread.hpp>
+#include <icy_engine/graphics/icy_window.hpp>
+#include <icy_gui/icy_gui.hpp>
+#include "../icy_gui/icy_gui_model.hpp"
+
+using namespace icy;
+
+ICY_STATIC_NAMESPACE_BEG
+//  one list view bound to the model root: every change that reaches the root goes through "process_binds"
+static const auto gui_test_window = R"({ "type": "window_main", "widgets": [ { "type": "view_list", "class": "list" } ] })";
+
+//  user-side cost of populating "count" cells (1000 per row node); with "batch" the rows and
+//  the cells go out as one commit and the second "data" write of each cell is coalesced;
+//  "events" is the number of model events the GUI thread will see
+static error_type gui_test_populate(gui_data_write_model& model, const size_t count, const bool batch, size_t& events) noexcept
+{
+    if (batch)
+        ICY_ERROR(model.begin());
+
+    gui_node row;
+    for (auto k = 0_z; k < count; ++k)
+    {
+        if (k % 1000 == 0)
+            ICY_ERROR(model.insert(gui_node(), uint32_t(k / 1000), 0, row));
+
+        gui_node cell;
+        ICY_ERROR(model.insert(row, uint32_t(k % 1000), 0, cell));
+        ICY_ERROR(model.modify(cell, gui_node_prop::data, uint32_t(k)));
+        ICY_ERROR(model.modify(cell, gui_node_prop::data, uint32_t(k + 1)));
+    }
+    if (batch)
+        ICY_ERROR(model.commit());
+    events = batch ? 1 : (count + 999) / 1000 + 3 * count;
+    return error_type();
+}
+//  waits until the GUI thread has applied "events" model events since "base"
+static error_type gui_test_wait(const gui_system& system, const gui_system_stats& base, const size_t events, gui_system_stats& stats) noexcept
+{
+    while (true)
+    {
+        stats = system.stats();
+        if (stats.model_events - base.model_events >= events)
+            break;
+        if (system.thread().state() == thread_state::done)
+        {
+            if (const auto error = system.thread().error())
+                return error;
+            return make_stdlib_error(std::errc::operation_canceled);
+        }
+        sleep(std::chrono::milliseconds(1));
+    }
+    stats.model_events -= base.model_events;
+    stats.model_nodes -= base.model_nodes;
+    stats.model_time -= base.model_time;
+    stats.bind_time -= base.bind_time;
+    return error_type();
+}
+static error_type gui_test_run(gui_system& system, const shared_ptr<window> handle, const size_t count, const bool batch) noexcept
+{
+    shared_ptr<gui_data_write_model> model;
+    ICY_ERROR(system.create_model(model));
+
+    shared_ptr<gui_window> window;
+    if (handle)
+    {
+        ICY_ERROR(system.create_window(window, handle, string_view(gui_test_window, strlen(gui_test_window), string_view::constexpr_tag())));
+        array<gui_widget> list;
+        ICY_ERROR(window->find("class"_s, "list"_s, list));
+        if (list.empty())
+            return make_unexpected_error();
+        unique_ptr<gui_data_bind> bind;
+        ICY_ERROR(make_unique(gui_data_bind(), bind));
+        ICY_ERROR(system.create_bind(std::move(bind), *model, *window, gui_node(), list[0]));
+    }
+    //  one change to make sure the model (and the bind) are installed before timing
+    {
+        const auto base = system.stats();
+        gui_node node;
+        ICY_ERROR(model->insert(gui_node(), 0, 0, node));
+        ICY_ERROR(model->destroy(node));
+        gui_system_stats stats;
+        ICY_ERROR(gui_test_wait(system, base, 2, stats));
+    }
+
+    const auto base = system.stats();
+    const auto beg = clock_type::now();
+    auto events = 0_z;
+    ICY_ERROR(gui_test_populate(*model, count, batch, events));
+    const auto mid = clock_type::now();
+    gui_system_stats stats;
+    ICY_ERROR(gui_test_wait(system, base, events, stats));
+    const auto end = clock_type::now();
+
+    string name;
+    ICY_ERROR(to_string("gui model %1, %2, user"_s, name, batch ? "batch"_s : "single"_s, handle ? "bound"_s : "unbound"_s));
+    ICY_ERROR(test_report(name, count, mid - beg));
+    ICY_ERROR(to_string("gui model %1, %2, GUI apply"_s, name, batch ? "batch"_s : "single"_s, handle ? "bound"_s : "unbound"_s));
+    ICY_ERROR(test_report(name, count, stats.model_time));
+    ICY_ERROR(to_string("gui model %1, %2, GUI process_binds"_s, name, batch ? "batch"_s : "single"_s, handle ? "bound"_s : "unbound"_s));
+    ICY_ERROR(test_report(name, stats.model_nodes, stats.bind_time));
+    ICY_ERROR(to_string("gui model %1, %2, end to end"_s, name, batch ? "batch"_s : "single"_s, handle ? "bound"_s : "unbound"_s));
+    ICY_ERROR(test_report(name, count, end - beg));
+    return error_type();
+}
+ICY_STATIC_NAMESPACE_END
+
+//  producer (user thread) and consumer (GUI thread apply and "process_binds") cost of populating a model:
+//  1M cells without a view, then 100K cells with a list view bound to the root (every change re-sends the list)
+error_type icy::bench_gui_model() noexcept
+{
+    shared_ptr<gui_system> gui_system;
+    ICY_ERROR(create_gui_system(gui_system));
+    ICY_ERROR(gui_system->thread().launch());
+    ICY_ERROR(gui_system->thread().rename("GUI Thread"_s));
+    ICY_SCOPE_EXIT{ gui_system->thread().wait(); };
+    ICY_SCOPE_EXIT{ gui_system->post_quit_event(); };
+
+    shared_ptr<window_system> window_system;
+    ICY_ERROR(create_window_system(window_system));
+    ICY_ERROR(window_system->thread().launch());
+    ICY_ERROR(window_system->thread().rename("Window Thread"_s));
+    ICY_SCOPE_EXIT{ window_system->thread().wait(); };
+    ICY_SCOPE_EXIT{ window_system->post_quit_event(); };
+
+    shared_ptr<window> window;
+    ICY_ERROR(window_system->create(window));
+
+    for (auto batch = 0u; batch < 2; ++batch)
+        ICY_ERROR(gui_test_run(*gui_system, nullptr, 1000_z * 1000, batch != 0));
+    for (auto batch = 0u; batch < 2; ++batch)
+        ICY_ERROR(gui_test_run(*gui_system, window, 100_z * 1000, batch != 0));
+    return error_type();
+}
+
+//  GUI-thread node storage: bytes per node ("memory") and a full depth-first walk over 1M nodes
+//  (1000 rows of 999 cells), the order "send_data" and the proxies visit the model in
+error_type icy::bench_gui_node_pool() noexcept
+{
+    const auto rows = 1000u;
+    const auto cols = 999u;
+
+    gui_node_pool pool;
+    ICY_ERROR(pool.initialize());
+
+    const auto beg = clock_type::now();
+    auto index = 1u;
+    for (auto row = 0u; row < rows; ++row)
+    {
+        const auto parent = index++;
+        ICY_ERROR(pool.insert(0, parent, { row, 0 }));
+        for (auto col = 0u; col < cols; ++col)
+        {
+            const auto cell = index++;
+            ICY_ERROR(pool.insert(parent, cell, { row, col }));
+            ICY_ERROR(pool.modify(cell, gui_node_prop::data, cell));
+        }
+    }
+    ICY_ERROR(test_report("gui node pool insert"_s, pool.size() - 1, clock_type::now() - beg));
+
+    string str;
+    ICY_ERROR(to_string("gui node pool memory: %1 nodes, %2 MB (%3 bytes/node)\n"_s, str,
+        uint64_t(pool.size()), uint64_t(pool.memory() / 1_mb), uint64_t(pool.memory() / pool.size())));
+    ICY_ERROR(test_print(str));
+
+    //  stackless pre-order walk: first child, else next sibling, else climb until a parent has one
+    for (auto pass = 0u; pass < 3; ++pass)
+    {
+        auto count = 0_z;
+        auto sum = 0ull;
+        const auto walk = clock_type::now();
+        auto node = pool.first_child(0);
+        while (node != gui_node_pool::npos)
+        {
+            ++count;
+            auto value = 0u;
+            if (pool.data(node).get(value))
+                sum += value;
+
+            auto next = pool.first_child(node);
+            while (next == gui_node_pool::npos && node != gui_node_pool::npos)
+            {
+                next = pool.next_sibling(node);
+                if (next == gui_node_pool::npos)
+                {
+                    node = pool.parent(node);
+                    if (node == 0)
+                        node = gui_node_pool::npos;
+                }
+            }
+            node = next;
+        }
+        const auto time = clock_type::now() - walk;
+        if (count + 1 != pool.size() || sum == 0)
+            return make_unexpected_error();
+        ICY_ERROR(test_report("gui node pool walk"_s, count, time));
+    }
+
+    array<uint32_t> freed;
+    const auto erase = clock_type::now();
+    ICY_ERROR(pool.erase(0, freed));
+    ICY_ERROR(test_report("gui node pool erase"_s, freed.size(), clock_type::now() - erase));
+    return error_type();
+}
@@ -0,0 +1,160 @@
+#include "engine_test.hpp"
+#include <icy_engine/core/icy_array.hpp>
+#include <icy_engine/core/icy_hash.hpp>
+
+using namespace icy;
+
+ICY_STATIC_NAMESPACE_BEG
+static uint64_t next_random(uint64_t& state) noexcept
+{
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+static error_type make_input(const size_t size, array<uint8_t>& bytes) noexcept
+{
+    ICY_ERROR(bytes.resize(size));
+    auto state = 0x9E3779B97F4A7C15ull;
+    for (auto&& byte : bytes)
+        byte = uint8_t(next_random(state));
+    return error_type();
+}
+ICY_STATIC_NAMESPACE_END
+
+error_type icy::test_hash() noexcept
+{
+    //  a few blocks (16 stripes of 64 bytes each) plus a tail, so splits land in the short buffer,
+    //  mid-stripe, on stripe and block boundaries and in the last partial stripe
+    array<uint8_t> bytes;
+    ICY_ERROR(make_input(3 * 1024 + 37, bytes));
+    const auto data = bytes.data();
+    const uint64_t seeds[] = { 0, 1, 0x9E3779B97F4A7C15ull, UINT64_MAX };
+
+    //  every prefix: 128-bit "lo" is the 64-bit hash, the hasher matches the one-shot call
+    for (auto&& seed : seeds)
+    {
+        for (auto size = 0_z; size <= bytes.size(); ++size)
+        {
+            const auto value64 = fast_hash64(data, size, seed);
+            const auto value128 = fast_hash128(data, size, seed);
+            ICY_TEST(value128.lo == value64);
+
+            hasher stream(seed);
+            stream.append(data, size);
+            ICY_TEST(stream.size() == size);
+            ICY_TEST(stream.finish64() == value64);
+            ICY_TEST(stream.finish128() == value128);
+        }
+    }
+
+    //  every split point of the full input, and byte-by-byte
+    for (auto&& seed : seeds)
+    {
+        const auto expect64 = fast_hash64(data, bytes.size(), seed);
+        const auto expect128 = fast_hash128(data, bytes.size(), seed);
+        for (auto split = 0_z; split <= bytes.size(); ++split)
+        {
+            hasher stream(seed);
+            stream.append(data, split);
+            stream.append(data + split, bytes.size() - split);
+            ICY_TEST(stream.finish64() == expect64 && stream.finish128() == expect128);
+        }
+        hasher stream(seed);
+        for (auto&& byte : bytes)
+            stream.append(&byte, 1);
+        ICY_TEST(stream.finish64() == expect64 && stream.finish128() == expect128);
+
+        //  random chunking, finishing in between must not disturb the state
+        auto state = seed | 1;
+        stream.reset(seed);
+        for (auto offset = 0_z; offset < bytes.size(); )
+        {
+            const auto chunk = std::min(size_t(next_random(state) % 300), bytes.size() - offset);
+            stream.append(data + offset, chunk);
+            offset += chunk;
+            ICY_TEST(stream.finish64() == fast_hash64(data, offset, seed));
+        }
+        ICY_TEST(stream.finish128() == expect128);
+    }
+
+    //  seeds: deterministic, distinct, and "reset" reuses a hasher like a new one
+    for (auto&& size : { 0_z, 1_z, 3_z, 8_z, 16_z, 17_z, 128_z, 129_z, 240_z, 256_z, 257_z, 1024_z, 3000_z })
+    {
+        ICY_TEST(fast_hash64(data, size, 7) == fast_hash64(data, size, 7));
+        ICY_TEST(fast_hash64(data, size, 7) != fast_hash64(data, size, 8));
+        ICY_TEST(fast_hash128(data, size, 7) != fast_hash128(data, size, 8));
+        ICY_TEST(fast_hash64(data, size, 0) == fast_hash64(data, size));
+
+        hasher stream(1);
+        stream.append(data, bytes.size());
+        stream.reset(7);
+        stream.append(data, size);
+        ICY_TEST(stream.finish64() == fast_hash64(data, size, 7));
+    }
+
+    //  a single flipped bit changes both halves
+    for (auto&& size : { 1_z, 64_z, 255_z, 256_z, 1000_z, 3000_z })
+    {
+        const auto before = fast_hash128(data, size);
+        bytes[size / 2] ^= 0x10;
+        const auto after = fast_hash128(data, size);
+        bytes[size / 2] ^= 0x10;
+        ICY_TEST(before.lo != after.lo && before.hi != after.hi);
+    }
+
+    //  views and strings hash their bytes
+    const auto str = "render_transform"_s;
+    ICY_TEST(fast_hash64(str) == fast_hash64(str.bytes().data(), str.bytes().size()));
+    ICY_TEST(hash_value(str) == fast_hash64(str));
+    ICY_TEST(hash_value(1, 2) != hash_value(2, 1));
+    return error_type();
+}
+
+error_type icy::bench_hash() noexcept
+{
+    const auto chunk = 16_mb;
+    array<uint8_t> bytes;
+    ICY_ERROR(make_input(chunk, bytes));
+    const auto data = bytes.data();
+
+    //  one-shot calls: each size repeated over 256 MB of input
+    for (auto&& size : { 8_z, 16_z, 64_z, 256_z, 1_kb, 4_kb, 64_kb, 1_mb, 16_mb })
+    {
+        const auto count = 256_mb / size;
+        auto sum = 0ull;
+        const auto beg = clock_type::now();
+        for (auto k = 0_z; k < count; ++k)
+            sum += fast_hash64(data + (k * 64) % (chunk - size + 1), size);
+        const auto time = clock_type::now() - beg;
+        ICY_TEST(sum != 0);
+
+        string name;
+        ICY_ERROR(to_string("fast_hash64, %1 bytes"_s, name, uint64_t(size)));
+        ICY_ERROR(test_report_bytes(name, uint64_t(count) * size, time));
+        ICY_ERROR(test_report(name, count, time));
+    }
+
+    //  1 GB through the streaming hasher, 16 MB per append
+    {
+        const auto total = 1_gb;
+        hasher stream;
+        const auto beg = clock_type::now();
+        for (auto offset = 0_z; offset < total; offset += chunk)
+            stream.append(data, chunk);
+        const auto value = stream.finish128();
+        const auto time = clock_type::now() - beg;
+        ICY_TEST(value.lo == stream.finish64());
+        ICY_ERROR(test_report_bytes("hasher, 1 GB in 16 MB appends"_s, total, time));
+    }
+
+    //  reference: the FNV-1a "hash64" that persisted hashes still use
+    {
+        const auto beg = clock_type::now();
+        const auto value = hash64(data, chunk);
+        const auto time = clock_type::now() - beg;
+        ICY_TEST(value != 0);
+        ICY_ERROR(test_report_bytes("hash64 (FNV-1a), 16 MB"_s, chunk, time));
+    }
+    return error_type();
+}
@@ -0,0 +1,254 @@
+#include "engine_test.hpp"
+#include <icy_engine/core/icy_array.hpp>
+#include <icy_engine/core/icy_color.hpp>
+#include <icy_engine/core/icy_thread.hpp>
+#include <icy_engine/html/icy_css.hpp>
+
+using namespace icy;
+
+ICY_STATIC_NAMESPACE_BEG
+//  report-style document: "sections" blocks with a heading and a "rows" x 8 table (one link per row);
+//  no whitespace between tags and explicit "head", "body" and "tbody", so both parse paths build the same tree
+static error_type html_test_document(const uint32_t sections, const uint32_t rows, string& str) noexcept
+{
+    ICY_ERROR(str.append("<!DOCTYPE html><html><head><title>report</title></head><body><div id=\"report\" class=\"report\">"_s));
+    for (auto s = 0u; s < sections; ++s)
+    {
+        ICY_ERROR(str.appendf("<div id=\"section%1\" class=\"section s%2\"><h2 class=\"title\">Section %1</h2>"_s, s, s % 8));
+        ICY_ERROR(str.append("<table class=\"grid\"><tbody>"_s));
+        for (auto r = 0u; r < rows; ++r)
+        {
+            ICY_ERROR(str.appendf("<tr class=\"row %1\">"_s, r % 2 ? "odd"_s : "even"_s));
+            for (auto c = 0u; c < 8; ++c)
+                ICY_ERROR(str.appendf("<td class=\"cell c%1\">%2.%3</td>"_s, c % 5, r, c));
+            ICY_ERROR(str.appendf("<td class=\"cell link\"><a href=\"#r%1\" class=\"link\">row %1</a></td></tr>"_s, r));
+        }
+        ICY_ERROR(str.append("</tbody></table></div>"_s));
+    }
+    return str.append("</div></body></html>"_s);
+}
+//  about 330 rules: class, id, attribute, child, sibling and structural selectors
+static error_type html_test_stylesheet(string& str) noexcept
+{
+    ICY_ERROR(str.append("body { color: #101010; } .report { color: #202020; } h2.title { color: #303030; }"_s));
+    ICY_ERROR(str.append("tr.odd td { color: #404040; } tr + tr td.c1 { color: #505050; } td ~ td.c2 { color: #606060; }"_s));
+    ICY_ERROR(str.append("a[href^=\"#r1\"] { color: #707070; } div.section > h2 { color: #808080; }"_s));
+    for (auto k = 0u; k < 64; ++k)
+    {
+        ICY_ERROR(str.appendf(".s%1 td.c%2:nth-child(%3) { color: #%4%4%5; }"_s, k % 8, k % 5, k % 7 + 1, 10 + k % 80, 10 + k));
+        ICY_ERROR(str.appendf("#section%1 tr.even td.c%2 { color: #%3%3%3; }"_s, k, k % 5, 10 + k));
+        ICY_ERROR(str.appendf("div.s%1 table.grid tr:first-child td { color: #%2%2%2; }"_s, k % 8, 20 + k));
+        ICY_ERROR(str.appendf("#section%1 > table > tbody > tr:nth-child(%2n) > td.link > a { color: #%3%3%3; }"_s, k, k % 9 + 2, 30 + k));
+        ICY_ERROR(str.appendf(".row.odd > td.cell.c%1 ~ td.c%2 { color: #%3%3%3; }"_s, k % 5, (k + 1) % 5, 40 + k % 50));
+    }
+    return error_type();
+}
+//  a styled "html_document_css" over the test document
+struct html_test_input
+{
+    css_system system;
+    css_style style;
+    string text;
+    html_document_css doc;
+};
+static error_type html_test_input_make(const uint32_t sections, const uint32_t rows, html_test_input& input) noexcept
+{
+    string sheet;
+    ICY_ERROR(html_test_stylesheet(sheet));
+    ICY_ERROR(create_css_system(nullptr, input.system));
+    ICY_ERROR(input.system.create("test.css"_s, sheet.bytes(), input.style));
+    ICY_ERROR(input.system.insert(input.style));
+
+    ICY_ERROR(html_test_document(sections, rows, input.text));
+    ICY_ERROR(input.doc.initialize(input.text.bytes()));
+    return error_type();
+}
+//  stands in for the global heap while a document is parsed: forwards to the previous heap and
+//  keeps the live and peak bytes (single thread only, nothing else may allocate meanwhile)
+struct html_test_heap
+{
+    global_heap_type prev;
+    size_t bytes = 0;
+    size_t peak = 0;
+};
+static void* html_test_heap_realloc(const void* const old_ptr, const size_t new_size, void* user) noexcept
+{
+    auto& heap = *static_cast<html_test_heap*>(user);
+    const auto old_size = old_ptr ? heap.prev.memsize(old_ptr, heap.prev.user) : 0_z;
+    const auto new_ptr = heap.prev.realloc(old_ptr, new_size, heap.prev.user);
+    if (new_size && !new_ptr)
+        return nullptr;
+    heap.bytes = heap.bytes > old_size ? heap.bytes - old_size : 0_z;
+    if (new_ptr)
+        heap.bytes += heap.prev.memsize(new_ptr, heap.prev.user);
+    heap.peak = std::max(heap.peak, heap.bytes);
+    return new_ptr;
+}
+static size_t html_test_heap_memsize(const void* const ptr, void* user) noexcept
+{
+    const auto& heap = *static_cast<html_test_heap*>(user);
+    return heap.prev.memsize(ptr, heap.prev.user);
+}
+//  "stream" selects "initialize_stream"; "bytes" is what the document keeps, "peak" the most it held during the parse
+static error_type html_test_parse(const const_array_view<char> text, const bool stream, duration_type& time, size_t& nodes, size_t& bytes, size_t& peak) noexcept
+{
+    html_test_heap heap;
+    heap.prev = detail::global_heap;
+    if (!heap.prev.realloc || !heap.prev.memsize)
+        return make_stdlib_error(std::errc::function_not_supported);
+
+    detail::global_heap = { html_test_heap_realloc, html_test_heap_memsize, &heap };
+    ICY_SCOPE_EXIT{ detail::global_heap = heap.prev; };
+    {
+        html_document_css doc;
+        const auto beg = clock_type::now();
+        ICY_ERROR(stream ? doc.initialize_stream(text) : doc.initialize(text));
+        time = clock_type::now() - beg;
+        nodes = doc.size();
+        bytes = heap.bytes;
+    }
+    peak = heap.peak;
+    return error_type();
+}
+ICY_STATIC_NAMESPACE_END
+
+//  "initialize" and "initialize_stream" build the same tree only when the source spells out every
+//  element the HTML5 tree builder would otherwise imply
+error_type icy::test_html_parse() noexcept
+{
+    string text;
+    ICY_ERROR(html_test_document(3, 4, text));
+    html_document_css full;
+    html_document_css stream;
+    ICY_ERROR(full.initialize(text.bytes()));
+    ICY_ERROR(stream.initialize_stream(text.bytes()));
+    ICY_TEST(full.size() == stream.size());
+    for (auto k = 0_z; k < std::min(full.size(), stream.size()); ++k)
+    {
+        const auto lhs = full.node(k);
+        const auto rhs = stream.node(k);
+        ICY_TEST(lhs->type() == rhs->type() && lhs->tag() == rhs->tag() && lhs->parent() == rhs->parent());
+        ICY_TEST(lhs->text() == rhs->text() && lhs->children().size() == rhs->children().size());
+        ICY_TEST(lhs->attributes() == rhs->attributes());
+        for (auto n = 0_z; n < std::min(lhs->attributes(), rhs->attributes()); ++n)
+            ICY_TEST(lhs->key(n) == rhs->key(n) && lhs->val(n) == rhs->val(n));
+    }
+
+    //  no "html", "head" or "body" in the source: only the full parser adds them
+    const auto fragment = "<div>a<b>c</b></div>"_s;
+    html_document_css full_fragment;
+    html_document_css stream_fragment;
+    ICY_ERROR(full_fragment.initialize(fragment.bytes()));
+    ICY_ERROR(stream_fragment.initialize_stream(fragment.bytes()));
+    ICY_TEST(full_fragment.size() == 7 && stream_fragment.size() == 5);
+    ICY_TEST(full_fragment.size() > 2 && full_fragment.node(1)->tag() == "head"_s && full_fragment.node(2)->tag() == "body"_s);
+    ICY_TEST(stream_fragment.size() > 1 && stream_fragment.node(1)->tag() == "div"_s && stream_fragment.node(1)->parent() == 0);
+    return error_type();
+}
+
+//  parse time, retained bytes and peak heap bytes of both parse paths on a 150K-element document
+error_type icy::bench_html_parse() noexcept
+{
+    string text;
+    ICY_ERROR(html_test_document(200, 80, text));
+    for (auto pass = 0u; pass < 2; ++pass)
+    {
+        for (auto stream = 0u; stream < 2; ++stream)
+        {
+            auto time = duration_type();
+            auto nodes = 0_z;
+            auto bytes = 0_z;
+            auto peak = 0_z;
+            ICY_ERROR(html_test_parse(text.bytes(), stream != 0, time, nodes, bytes, peak));
+            const auto name = stream ? "html initialize_stream"_s : "html initialize"_s;
+            ICY_ERROR(test_report_bytes(name, text.bytes().size(), time));
+            string str;
+            ICY_ERROR(to_string("%1: %2 nodes, %3 KB of html, %4 KB kept, %5 KB peak\n"_s, str, name, uint64_t(nodes),
+                uint64_t(text.bytes().size() / 1_kb), uint64_t(bytes / 1_kb), uint64_t(peak / 1_kb)));
+            ICY_ERROR(test_print(str));
+        }
+    }
+    return error_type();
+}
+
+//  "css_system::prepare" (atom interning and sibling counts) on a 150K-element document
+error_type icy::bench_css_prepare() noexcept
+{
+    html_test_input input;
+    ICY_ERROR(html_test_input_make(200, 80, input));
+
+    auto elements = 0_z;
+    for (auto k = 0_z; k < input.doc.size(); ++k)
+    {
+        if (input.doc.node(k)->type() == html_type::node)
+            ++elements;
+    }
+    string str;
+    ICY_ERROR(to_string("css prepare: %1 nodes (%2 elements), %3 KB of html\n"_s, str,
+        uint64_t(input.doc.size()), uint64_t(elements), uint64_t(input.text.bytes().size() / 1_kb)));
+    ICY_ERROR(test_print(str));
+
+    //  every pass drops the document atoms and interns them again
+    for (auto pass = 0u; pass < 3; ++pass)
+    {
+        const auto beg = clock_type::now();
+        ICY_ERROR(input.system.prepare(input.doc));
+        ICY_ERROR(test_report("css prepare"_s, input.doc.size(), clock_type::now() - beg));
+    }
+    return error_type();
+}
+
+//  "css_system::cascade" against "apply" node by node, on 1, 2, 4 ... workers up to one per core
+error_type icy::bench_css_cascade() noexcept
+{
+    html_test_input input;
+    ICY_ERROR(html_test_input_make(200, 80, input));
+
+    array<color> colors;
+    ICY_ERROR(colors.resize(input.doc.size()));
+    auto elements = 0_z;
+    const auto serial_beg = clock_type::now();
+    ICY_ERROR(input.system.prepare(input.doc));
+    for (auto k = 0u; k < input.doc.size(); ++k)
+    {
+        //  document order has every parent before its children
+        if (input.doc.node(k)->type() != html_type::node)
+            continue;
+        ICY_ERROR(input.system.apply(input.doc, k));
+        ++elements;
+    }
+    const auto serial = clock_type::now() - serial_beg;
+    for (auto k = 0_z; k < input.doc.size(); ++k)
+        colors[k] = input.doc.node(k)->color();
+    ICY_ERROR(test_report("css apply, serial"_s, elements, serial));
+
+    const auto seconds = [](const duration_type time) { return std::chrono::duration<double>(time).count(); };
+    const auto cores = std::max(thread::cores(), 1_z);
+    auto single = duration_type();
+    for (auto threads = 1_z; ; threads = std::min(2 * threads, cores))
+    {
+        html_document_css doc;
+        ICY_ERROR(doc.initialize(input.text.bytes()));
+        const auto beg = clock_type::now();
+        ICY_ERROR(input.system.cascade(doc, threads));
+        const auto time = clock_type::now() - beg;
+        if (threads == 1)
+            single = time;
+
+        auto mismatch = 0_z;
+        for (auto k = 0_z; k < doc.size(); ++k)
+        {
+            if (doc.node(k)->type() == html_type::node && doc.node(k)->color() != colors[k])
+                ++mismatch;
+        }
+        string str;
+        ICY_ERROR(to_string("css cascade, %1 threads"_s, str, uint64_t(threads)));
+        ICY_ERROR(test_report(str, elements, time));
+        ICY_ERROR(to_string("css cascade, %1 threads: speedup %2 over serial, %3 over 1 thread, %4 mismatched styles\n"_s, str,
+            uint64_t(threads), seconds(serial) / seconds(time), seconds(single) / seconds(time), uint64_t(mismatch)));
+        ICY_ERROR(test_print(str));
+        if (threads == cores)
+            break;
+    }
+    return error_type();
+}
@@ -0,0 +1,477 @@
+#include "engine_test.hpp"
+#include <icy_engine/core/icy_array.hpp>
+#include <icy_engine/core/icy_color.hpp>
+#include <icy_engine/core/icy_json.hpp>
+#include <icy_engine/core/icy_map.hpp>
+#include <icy_engine/core/icy_matrix.hpp>
+#include <icy_engine/core/icy_thread.hpp>
+#include <icy_engine/utility/icy_lua.hpp>
+
+using namespace icy;
+
+ICY_STATIC_NAMESPACE_BEG
+//  a small script with no library calls ("%1" makes each variant a distinct chunk)
+static const auto lua_test_script = "local t = {} for i = 1, 20 do t[i] = i * %1 end "
+    "local s = 0 for i = 1, #t do s = s + t[i] end "
+    "local function f(a, b) if a > b then return a - b else return b - a end end "
+    "local x = { size = s, list = { 1, 2, 3 } } for k = 1, 4 do x.size = f(x.size, k * 3) end "
+    "return x.size";
+
+//  "pairs" over a view: the number of pairs and their keys, space separated
+static const auto lua_test_pairs = "local v = ... local base = _G.base local n, keys = 0, '' "
+    "for k in base.pairs(v) do n = n + 1 keys = keys .. base.tostring(k) .. ' ' end return n, keys";
+
+//  a standalone system with the base library as "_G.base"
+static error_type lua_test_system(shared_ptr<lua_system>& system) noexcept
+{
+    ICY_ERROR(create_lua_system(system));
+    lua_variable globals;
+    lua_variable base;
+    ICY_ERROR(system->global(globals));
+    ICY_ERROR(system->make_library(base, lua_default_library::base));
+    return globals.insert("base"_s, base);
+}
+//  runs "source" with one argument
+static error_type lua_test_exec(const lua_system& system, const string_view source, const lua_variable& input, array<lua_variable>& output) noexcept
+{
+    lua_variable func;
+    ICY_ERROR(system.parse(func, source));
+    return func(const_array_view<lua_variable>(&input, 1), output);
+}
+static bool lua_test_keys(const array<lua_variable>& output, const size_t count, const string_view keys) noexcept
+{
+    return output.size() == 2 && output[0].as_number() == count && output[1].as_string() == keys;
+}
+static error_type lua_test_run(lua_pool& pool, const string_view script) noexcept
+{
+    shared_ptr<lua_system> system;
+    ICY_ERROR(pool.checkout(system));
+    {
+        lua_variable func;
+        ICY_ERROR(system->parse(func, script));
+        array<lua_variable> output;
+        ICY_ERROR(func({}, output));
+        if (output.size() != 1 || output[0].type() != lua_type::number)
+            return make_unexpected_error();
+    }
+    return pool.checkin(std::move(system));
+}
+class lua_test_thread : public thread
+{
+public:
+    error_type run() noexcept override
+    {
+        for (auto k = offset; k < count; k += step)
+            ICY_ERROR(lua_test_run(*pool, scripts[k % scripts.size()]));
+        return error_type();
+    }
+public:
+    lua_pool* pool = nullptr;
+    const_array_view<string> scripts;
+    size_t count = 0;
+    size_t offset = 0;
+    size_t step = 1;
+};
+ICY_STATIC_NAMESPACE_END
+
+error_type icy::test_lua_pool() noexcept
+{
+    const lua_default_library libraries[] = { lua_default_library::base, lua_default_library::string };
+    shared_ptr<lua_pool> pool;
+    ICY_ERROR(create_lua_pool(pool, libraries, 1));
+    shared_ptr<lua_system> system;
+    ICY_ERROR(pool->checkout(system));
+
+    //  the second parse of the same source loads the stored chunk
+    {
+        const auto before = system->stats();
+        lua_variable func;
+        ICY_ERROR(system->parse(func, "return 40 + 2"_s));
+        ICY_ERROR(system->parse(func, "return 40 + 2"_s));
+        const auto after = system->stats();
+        ICY_TEST(after.cache_misses == before.cache_misses + 1);
+        ICY_TEST(after.cache_hits == before.cache_hits + 1);
+
+        array<lua_variable> output;
+        ICY_ERROR(func({}, output));
+        ICY_TEST(output.size() == 1 && output[0].as_number() == 42);
+    }
+
+    //  16 shards of 256 chunks: 8192 distinct chunks evict the least recently used ones, "return 0" first
+    {
+        const auto before = system->stats();
+        string str;
+        for (auto k = 0u; k < 8192; ++k)
+        {
+            ICY_ERROR(to_string("return %1"_s, str, k));
+            lua_variable func;
+            ICY_ERROR(system->parse(func, str));
+        }
+        const auto after = system->stats();
+        ICY_TEST(after.cache_evictions > before.cache_evictions);
+        ICY_TEST(after.cache_chunks <= 16 * 256);
+
+        lua_variable func;
+        ICY_ERROR(system->parse(func, "return 0"_s));
+        ICY_TEST(system->stats().cache_misses == after.cache_misses + 1);
+    }
+
+    //  small blocks freed by the collector are handed out again: the arena stops taking pages
+    {
+        lua_variable func;
+        ICY_ERROR(system->parse(func, "local t = {} for i = 1, 20000 do t[i % 64 + 1] = { i } end"_s));
+        ICY_ERROR(func());
+        const auto first = system->stats();
+        for (auto k = 0u; k < 20; ++k)
+            ICY_ERROR(func());
+        const auto after = system->stats();
+        ICY_TEST(after.arena_reused > first.arena_reused);
+        ICY_TEST(after.arena_pages <= 2 * first.arena_pages);
+    }
+
+    //  script changes to the global table and to a library table are undone by "checkin"
+    {
+        lua_variable globals;
+        lua_variable library;
+        ICY_ERROR(system->global(globals));
+        ICY_ERROR(system->make_library(library, lua_default_library::string));
+        ICY_ERROR(globals.insert("string"_s, library));
+
+        lua_variable func;
+        ICY_ERROR(system->parse(func, "_G.leak = 1 _G.string.leak = 2 _G.string.format = nil"_s));
+        ICY_ERROR(func());
+        lua_variable value;
+        ICY_ERROR(globals.find("leak"_s, value));
+        ICY_TEST(value.as_number() == 1);
+    }
+    ICY_ERROR(pool->checkin(std::move(system)));
+    ICY_ERROR(pool->checkout(system));
+    {
+        lua_variable globals;
+        lua_variable library;
+        ICY_ERROR(system->global(globals));
+        ICY_ERROR(system->make_library(library, lua_default_library::string));
+
+        lua_variable leak;
+        lua_variable string_lib;
+        lua_variable string_leak;
+        lua_variable string_format;
+        ICY_ERROR(globals.find("leak"_s, leak));
+        ICY_ERROR(globals.find("string"_s, string_lib));
+        ICY_ERROR(library.find("leak"_s, string_leak));
+        ICY_ERROR(library.find("format"_s, string_format));
+        ICY_TEST(leak.type() == lua_type::none);
+        ICY_TEST(string_lib.type() == lua_type::none);
+        ICY_TEST(string_leak.type() == lua_type::none);
+        ICY_TEST(string_format.type() == lua_type::function);
+    }
+    return pool->checkin(std::move(system));
+}
+
+//  scripts/s through a pool (checkout, parse from the chunk cache, run, checkin) on one thread and one
+//  per core, against a new system per script (new state, libraries opened, chunk compiled every time)
+error_type icy::bench_lua_pool() noexcept
+{
+    array<string> scripts;
+    for (auto k = 0u; k < 8; ++k)
+    {
+        string str;
+        ICY_ERROR(to_string(string_view(lua_test_script, strlen(lua_test_script), string_view::constexpr_tag()), str, k + 1));
+        ICY_ERROR(scripts.push_back(std::move(str)));
+    }
+    const lua_default_library libraries[] = { lua_default_library::base, lua_default_library::math,
+        lua_default_library::string, lua_default_library::table };
+
+    {
+        const auto count = 10'000_z;
+        const auto beg = clock_type::now();
+        for (auto k = 0_z; k < count; ++k)
+        {
+            shared_ptr<lua_system> system;
+            ICY_ERROR(create_lua_system(system));
+            for (auto&& lib : libraries)
+            {
+                lua_variable var;
+                ICY_ERROR(system->make_library(var, lib));
+            }
+            lua_variable func;
+            ICY_ERROR(system->parse(func, scripts[k % scripts.size()]));
+            ICY_ERROR(func());
+        }
+        ICY_ERROR(test_report("lua new system per script"_s, count, clock_type::now() - beg));
+    }
+
+    const auto cores = std::max(thread::cores(), 1_z);
+    const size_t thread_counts[] = { 1, cores };
+    for (auto&& thread_count : thread_counts)
+    {
+        shared_ptr<lua_pool> pool;
+        ICY_ERROR(create_lua_pool(pool, libraries, thread_count));
+
+        const auto count = 200'000_z;
+        array<shared_ptr<lua_test_thread>> threads;
+        for (auto k = 0_z; k < thread_count; ++k)
+        {
+            shared_ptr<lua_test_thread> new_thread;
+            ICY_ERROR(make_shared(new_thread));
+            new_thread->pool = pool.get();
+            new_thread->scripts = scripts;
+            new_thread->count = count;
+            new_thread->offset = k;
+            new_thread->step = thread_count;
+            ICY_ERROR(threads.push_back(std::move(new_thread)));
+        }
+        const auto beg = clock_type::now();
+        for (auto&& thread : threads)
+            ICY_ERROR(thread->launch());
+        for (auto&& thread : threads)
+        {
+            ICY_ERROR(thread->wait());
+            ICY_ERROR(thread->error());
+        }
+        const auto time = clock_type::now() - beg;
+
+        string str;
+        ICY_ERROR(to_string("lua pool, %1 threads"_s, str, uint64_t(thread_count)));
+        ICY_ERROR(test_report(str, count, time));
+        ICY_ERROR(to_string("lua pool, %1 threads: %2 scripts/s\n"_s, str, uint64_t(thread_count),
+            uint64_t(count / std::max(std::chrono::duration<double>(time).count(), 1e-9))));
+        ICY_ERROR(test_print(str));
+    }
+    return error_type();
+}
+
+error_type icy::test_lua_view() noexcept
+{
+    shared_ptr<lua_system> system;
+    ICY_ERROR(lua_test_system(system));
+    array<lua_variable> output;
+    const auto script_pairs = string_view(lua_test_pairs, strlen(lua_test_pairs), string_view::constexpr_tag());
+
+    //  bytes: 1..n from C++ and scripts, nil outside, "sub" range checks
+    const uint8_t bytes[] = { 1, 2, 3, 4, 5 };
+    lua_variable view;
+    ICY_ERROR(system->make_view(view, const_array_view<uint8_t>(bytes)));
+    {
+        lua_variable lo, first, last, hi;
+        ICY_ERROR(view.find(0.0, lo));
+        ICY_ERROR(view.find(1.0, first));
+        ICY_ERROR(view.find(5.0, last));
+        ICY_ERROR(view.find(6.0, hi));
+        ICY_TEST(lo.type() == lua_type::none && hi.type() == lua_type::none);
+        ICY_TEST(first.as_number() == 1 && last.as_number() == 5);
+    }
+    ICY_ERROR(lua_test_exec(*system, "local v = ... return #v, v[0], v[6], v[2], v[1.5]"_s, view, output));
+    ICY_TEST(output.size() == 5 && output[0].as_number() == 5 && output[3].as_number() == 2);
+    ICY_TEST(output.size() == 5 && output[1].type() == lua_type::none && output[2].type() == lua_type::none && output[4].type() == lua_type::none);
+    ICY_ERROR(lua_test_exec(*system, "local v = ... return v:sub(2, 4), v:sub(6), v:sub(3, 2), #v:sub()"_s, view, output));
+    ICY_TEST(output.size() == 4 && output[0].as_string() == "\x02\x03\x04"_s);
+    ICY_TEST(output.size() == 4 && output[1].as_string().empty() && output[2].as_string().empty() && output[3].as_number() == 5);
+    ICY_TEST(lua_test_exec(*system, "local v = ... return v:sub(0)"_s, view, output));
+    ICY_TEST(lua_test_exec(*system, "local v = ... return v:sub(7)"_s, view, output));
+    ICY_TEST(lua_test_exec(*system, "local v = ... return v:sub(2, 6)"_s, view, output));
+    ICY_TEST(lua_test_exec(*system, "local v = ... return v:sub(3, 1)"_s, view, output));
+    ICY_TEST(lua_test_exec(*system, "local v = ... return v:sub('x')"_s, view, output));
+    ICY_ERROR(lua_test_exec(*system, script_pairs, view, output));
+    ICY_TEST(lua_test_keys(output, 5, "1 2 3 4 5 "_s));
+
+    //  "next" from C++ walks the same pairs and resumes from any key
+    {
+        lua_variable key;
+        lua_variable val;
+        auto count = 0_z;
+        auto sum = 0.0;
+        while (true)
+        {
+            ICY_ERROR(view.next(key, val));
+            if (key.type() == lua_type::none)
+                break;
+            ++count;
+            sum += val.as_number();
+        }
+        ICY_TEST(count == 5 && sum == 15);
+
+        key = 3.0;
+        ICY_ERROR(view.next(key, val));
+        ICY_TEST(key.as_number() == 4 && val.as_number() == 4);
+        key = 5.0;
+        ICY_ERROR(view.next(key, val));
+        ICY_TEST(key.type() == lua_type::none && val.type() == lua_type::none);
+        key = 9.0;
+        ICY_TEST(view.next(key, val));
+    }
+    ICY_TEST(view.insert(1.0, 2.0) == make_stdlib_error(std::errc::operation_not_permitted));
+    {
+        lua_variable value;
+        ICY_ERROR(view.find(1.0, value));
+        ICY_TEST(value.as_number() == 1);
+    }
+
+    //  image: 2 rows of 3, "get(x, y)" is 1-based column and row
+    color pixels[2][3];
+    for (auto row = 0u; row < 2; ++row)
+    {
+        for (auto col = 0u; col < 3; ++col)
+            pixels[row][col] = color::from_rgba(uint8_t(10 * row + col), 1, 2, 3);
+    }
+    lua_variable image;
+    ICY_ERROR(system->make_view(image, const_matrix_view<color>(pixels)));
+    ICY_ERROR(lua_test_exec(*system, "local v = ... local r, g, b, a = v:get(3, 2) return v.width, v.height, #v, r, g, b, a, v[7]"_s, image, output));
+    ICY_TEST(output.size() == 8 && output[0].as_number() == 3 && output[1].as_number() == 2 && output[2].as_number() == 6);
+    ICY_TEST(output.size() == 8 && output[3].as_number() == 12 && output[4].as_number() == 1 && output[5].as_number() == 2 && output[6].as_number() == 3);
+    ICY_TEST(output.size() == 8 && output[7].type() == lua_type::none);
+    {
+        lua_variable value;
+        ICY_ERROR(image.find(4.0, value));
+        ICY_TEST(value.as_number() == pixels[1][0].bgra);
+    }
+    ICY_TEST(lua_test_exec(*system, "local v = ... return v:get(0, 1)"_s, image, output));
+    ICY_TEST(lua_test_exec(*system, "local v = ... return v:get(4, 1)"_s, image, output));
+    ICY_TEST(lua_test_exec(*system, "local v = ... return v:get(1, 3)"_s, image, output));
+    ICY_TEST(lua_test_exec(*system, "local v = ... return v:get(1)"_s, image, output));
+    ICY_TEST(lua_test_exec(*system, "local v = ... return v.sub(v, 1, 1)"_s, image, output));
+    ICY_ERROR(lua_test_exec(*system, script_pairs, image, output));
+    ICY_TEST(lua_test_keys(output, 6, "1 2 3 4 5 6 "_s));
+    ICY_TEST(image.insert("width"_s, 1.0) == make_stdlib_error(std::errc::operation_not_permitted));
+
+    //  json: an array, an object (keys in sorted order) and nested views
+    json json_array(json_type::array);
+    ICY_ERROR(json_array.push_back(10));
+    ICY_ERROR(json_array.push_back(20));
+    ICY_ERROR(json_array.push_back(30));
+    lua_variable array_view;
+    ICY_ERROR(system->make_view(array_view, json_array));
+    ICY_ERROR(lua_test_exec(*system, script_pairs, array_view, output));
+    ICY_TEST(lua_test_keys(output, 3, "1 2 3 "_s));
+    ICY_ERROR(lua_test_exec(*system, "local v = ... return v[0], v[3], v[4], v.x"_s, array_view, output));
+    ICY_TEST(output.size() == 4 && output[0].type() == lua_type::none && output[1].as_number() == 30);
+    ICY_TEST(output.size() == 4 && output[2].type() == lua_type::none && output[3].type() == lua_type::none);
+
+    json json_object(json_type::object);
+    json json_nested(json_type::array);
+    ICY_ERROR(json_nested.push_back(1));
+    ICY_ERROR(json_nested.push_back(2));
+    ICY_ERROR(json_object.insert("c"_s, std::move(json_nested)));
+    ICY_ERROR(json_object.insert("a"_s, 1));
+    ICY_ERROR(json_object.insert("b"_s, "text"_s));
+    lua_variable object_view;
+    ICY_ERROR(system->make_view(object_view, json_object));
+    ICY_ERROR(lua_test_exec(*system, script_pairs, object_view, output));
+    ICY_TEST(lua_test_keys(output, 3, "a b c "_s));
+    ICY_ERROR(lua_test_exec(*system, "local v = ... return v.a, v.b, #v.c, v.c[2], v[1], v.d"_s, object_view, output));
+    ICY_TEST(output.size() == 6 && output[0].as_number() == 1 && output[1].as_string() == "text"_s);
+    ICY_TEST(output.size() == 6 && output[2].as_number() == 2 && output[3].as_number() == 2);
+    ICY_TEST(output.size() == 6 && output[4].type() == lua_type::none && output[5].type() == lua_type::none);
+    {
+        lua_variable key = "a"_s;
+        lua_variable val;
+        ICY_ERROR(object_view.next(key, val));
+        ICY_TEST(key.as_string() == "b"_s && val.as_string() == "text"_s);
+        ICY_ERROR(object_view.next(key, val));
+        ICY_TEST(key.as_string() == "c"_s && val.type() == lua_type::table);
+        ICY_ERROR(object_view.next(key, val));
+        ICY_TEST(key.type() == lua_type::none);
+        key = "x"_s;
+        ICY_TEST(object_view.next(key, val));
+    }
+
+    //  map: values are variables, keys in sorted order
+    map<string, lua_variable> values;
+    {
+        string key_y;
+        string key_x;
+        ICY_ERROR(copy("y"_s, key_y));
+        ICY_ERROR(copy("x"_s, key_x));
+        ICY_ERROR(values.insert(std::move(key_y), lua_variable(2.0)));
+        ICY_ERROR(values.insert(std::move(key_x), lua_variable(1.0)));
+    }
+    lua_variable map_view;
+    ICY_ERROR(system->make_view(map_view, values));
+    ICY_ERROR(lua_test_exec(*system, script_pairs, map_view, output));
+    ICY_TEST(lua_test_keys(output, 2, "x y "_s));
+    ICY_ERROR(lua_test_exec(*system, "local v = ... return #v, v.x, v.y, v.z, v[1]"_s, map_view, output));
+    ICY_TEST(output.size() == 5 && output[0].as_number() == 2 && output[1].as_number() == 1 && output[2].as_number() == 2);
+    ICY_TEST(output.size() == 5 && output[3].type() == lua_type::none && output[4].type() == lua_type::none);
+    {
+        lua_variable key = "x"_s;
+        lua_variable val;
+        ICY_ERROR(map_view.next(key, val));
+        ICY_TEST(key.as_string() == "y"_s && val.as_number() == 2);
+    }
+    ICY_TEST(map_view.insert("z"_s, 3.0) == make_stdlib_error(std::errc::operation_not_permitted));
+    return error_type();
+}
+
+//  reads over a 100 MB byte view: creating the view against copying the bytes into Lua,
+//  indexed reads from a script and from C++, and "sub" in 64 KB pieces
+error_type icy::bench_lua_view() noexcept
+{
+    const auto size = 100_mb;
+    array<uint8_t> bytes;
+    ICY_ERROR(bytes.resize(size));
+    for (auto k = 0_z; k < size; ++k)
+        bytes[k] = uint8_t(k * 31);
+
+    shared_ptr<lua_system> system;
+    ICY_ERROR(lua_test_system(system));
+
+    lua_variable view;
+    {
+        const auto beg = clock_type::now();
+        ICY_ERROR(system->make_view(view, const_array_view<uint8_t>(bytes)));
+        ICY_ERROR(test_report_bytes("lua make_view"_s, size, clock_type::now() - beg));
+    }
+    {
+        const auto beg = clock_type::now();
+        lua_variable binary;
+        ICY_ERROR(system->make_binary(binary, const_array_view<uint8_t>(bytes)));
+        ICY_ERROR(test_report_bytes("lua make_binary (copy)"_s, size, clock_type::now() - beg));
+    }
+
+    //  every 64th byte
+    const auto step = 64_z;
+    auto expected = 0.0;
+    for (auto k = 0_z; k < size; k += step)
+        expected += bytes[k];
+    {
+        lua_variable func;
+        ICY_ERROR(system->parse(func, "local v, step = ... local s = 0 for i = 1, #v, step do s = s + v[i] end return s"_s));
+        lua_variable input[] = { lua_variable(), lua_variable(double(step)) };
+        ICY_ERROR(system->copy(view, input[0]));
+        array<lua_variable> output;
+        const auto beg = clock_type::now();
+        ICY_ERROR(func(input, output));
+        const auto time = clock_type::now() - beg;
+        if (output.size() != 1 || output[0].as_number() != expected)
+            return make_unexpected_error();
+        ICY_ERROR(test_report("lua view index, script"_s, size / step, time));
+    }
+    {
+        const auto count = size / step / 16;
+        auto sum = 0.0;
+        const auto beg = clock_type::now();
+        for (auto k = 0_z; k < count; ++k)
+        {
+            lua_variable value;
+            ICY_ERROR(view.find(double(1 + k * step), value));
+            sum += value.as_number();
+        }
+        const auto time = clock_type::now() - beg;
+        if (sum == 0)
+            return make_unexpected_error();
+        ICY_ERROR(test_report("lua view index, C++ find"_s, count, time));
+    }
+    {
+        //  100 MB is a whole number of 64 KB pieces
+        lua_variable func;
+        ICY_ERROR(system->parse(func, "local v = ... local n = 0 for i = 1, #v, 65536 do n = n + #v:sub(i, i + 65535) end return n"_s));
+        array<lua_variable> output;
+        const auto beg = clock_type::now();
+        ICY_ERROR(func(const_array_view<lua_variable>(&view, 1), output));
+        const auto time = clock_type::now() - beg;
+        if (output.size() != 1 || output[0].as_number() != size)
+            return make_unexpected_error();
+        ICY_ERROR(test_report_bytes("lua view sub, 64 KB pieces"_s, size, time));
+    }
+    return error_type();
+}
@@ -0,0 +1,310 @@
+#include "engine_test.hpp"
+#include <icy_engine/core/icy_array.hpp>
+#include <icy_engine/core/icy_pixel.hpp>
+
+using namespace icy;
+
+ICY_STATIC_NAMESPACE_BEG
+static uint64_t next_random(uint64_t& state) noexcept
+{
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+//  plain per-pixel reference: exact rounding written as integer division
+static uint8_t pixel_test_narrow(const uint16_t value) noexcept
+{
+    return uint8_t((2 * uint32_t(value) + 257) / 514);
+}
+static uint8_t pixel_test_clamp(const int32_t value) noexcept
+{
+    return uint8_t(value < 0 ? 0 : value > 0xFF ? 0xFF : value);
+}
+static void pixel_test_reference(const pixel_format src_format, const uint8_t* const src,
+    const pixel_format dst_format, uint8_t* const dst, const size_t count) noexcept
+{
+    for (auto k = 0_z; k < count; ++k)
+    {
+        uint8_t rgba[4] = { 0, 0, 0, 0xFF };
+        const auto pixel = src + k * pixel_size(src_format);
+        switch (src_format)
+        {
+        case pixel_format::rgb8:
+        case pixel_format::rgba8:
+            memcpy(rgba, pixel, pixel_size(src_format));
+            break;
+        case pixel_format::bgra8:
+            rgba[0] = pixel[2];
+            rgba[1] = pixel[1];
+            rgba[2] = pixel[0];
+            rgba[3] = pixel[3];
+            break;
+        case pixel_format::rgb16:
+        case pixel_format::rgba16:
+            for (auto n = 0_z; n < pixel_size(src_format) / 2; ++n)
+            {
+                uint16_t sample = 0;
+                memcpy(&sample, pixel + 2 * n, sizeof(sample));
+                rgba[n] = pixel_test_narrow(sample);
+            }
+            break;
+        case pixel_format::ycbcr8:
+        {
+            //  JFIF in 2.14 fixed point, rounded to nearest
+            const auto y = int32_t(pixel[0]) * 16384 + 8192;
+            const auto cb = int32_t(pixel[1]) - 128;
+            const auto cr = int32_t(pixel[2]) - 128;
+            rgba[0] = pixel_test_clamp((y + 22970 * cr) >> 14);
+            rgba[1] = pixel_test_clamp((y - 5638 * cb - 11700 * cr) >> 14);
+            rgba[2] = pixel_test_clamp((y + 29032 * cb) >> 14);
+            break;
+        }
+        default:
+            break;
+        }
+        const auto out = dst + k * pixel_size(dst_format);
+        switch (dst_format)
+        {
+        case pixel_format::rgb8:
+            memcpy(out, rgba, 3);
+            break;
+        case pixel_format::rgba8:
+            memcpy(out, rgba, 4);
+            break;
+        case pixel_format::bgra8:
+            out[0] = rgba[2];
+            out[1] = rgba[1];
+            out[2] = rgba[0];
+            out[3] = rgba[3];
+            break;
+        default:
+            break;
+        }
+    }
+}
+static void pixel_test_premultiply(color* const data, const size_t count) noexcept
+{
+    for (auto k = 0_z; k < count; ++k)
+    {
+        const auto alpha = uint32_t(data[k].a);
+        data[k].b = uint8_t((2 * data[k].b * alpha + 255) / 510);
+        data[k].g = uint8_t((2 * data[k].g * alpha + 255) / 510);
+        data[k].r = uint8_t((2 * data[k].r * alpha + 255) / 510);
+    }
+}
+struct pixel_test_pair
+{
+    const char* name;
+    pixel_format src;
+    pixel_format dst;
+};
+static const pixel_test_pair pixel_test_pairs[] =
+{
+    { "rgb8 -> bgra8", pixel_format::rgb8, pixel_format::bgra8 },
+    { "rgba8 -> bgra8", pixel_format::rgba8, pixel_format::bgra8 },
+    { "bgra8 -> bgra8", pixel_format::bgra8, pixel_format::bgra8 },
+    { "rgb16 -> bgra8", pixel_format::rgb16, pixel_format::bgra8 },
+    { "rgba16 -> bgra8", pixel_format::rgba16, pixel_format::bgra8 },
+    { "ycbcr8 -> bgra8", pixel_format::ycbcr8, pixel_format::bgra8 },
+    { "bgra8 -> rgb8", pixel_format::bgra8, pixel_format::rgb8 },
+    { "bgra8 -> rgba8", pixel_format::bgra8, pixel_format::rgba8 },
+};
+static const auto pixel_test_guard = 64_z;
+static const auto pixel_test_fill = uint8_t(0xCD);
+ICY_STATIC_NAMESPACE_END
+
+error_type icy::test_pixel() noexcept
+{
+    auto state = 0x9E3779B97F4A7C15ull;
+    array<uint8_t> src;
+    array<uint8_t> dst;
+    array<uint8_t> ref;
+
+    //  every count up to a few SIMD steps (all tails), misaligned source and destination,
+    //  a chunk-crossing count for 16-bit input; nothing is written past "count" pixels
+    for (auto&& pair : pixel_test_pairs)
+    {
+        const auto src_size = pixel_size(pair.src);
+        const auto dst_size = pixel_size(pair.dst);
+        //  offsets keep "uint16_t" and "color" pointers naturally aligned but move SIMD loads and stores off 16 bytes
+        const auto src_align = pair.src == pixel_format::bgra8 ? 4_z : src_size == 6 || src_size == 8 ? 2_z : 1_z;
+        const auto dst_align = pair.dst == pixel_format::bgra8 ? 4_z : 1_z;
+        for (auto&& count : { 0_z, 1_z, 2_z, 3_z, 4_z, 5_z, 7_z, 8_z, 9_z, 10_z, 11_z, 15_z, 16_z, 17_z, 18_z,
+            31_z, 32_z, 33_z, 63_z, 64_z, 65_z, 255_z, 256_z, 257_z, 1000_z, 1027_z })
+        {
+            for (auto offset = 0_z; offset < 4; ++offset)
+            {
+                const auto src_offset = offset * src_align;
+                const auto dst_offset = offset * dst_align;
+                ICY_ERROR(src.resize(src_offset + count * src_size + pixel_test_guard));
+                for (auto&& byte : src)
+                    byte = uint8_t(next_random(state));
+
+                ICY_ERROR(dst.resize(dst_offset + count * dst_size + pixel_test_guard));
+                ICY_ERROR(ref.resize(dst.size()));
+                memset(dst.data(), pixel_test_fill, dst.size());
+                memset(ref.data(), pixel_test_fill, ref.size());
+
+                ICY_ERROR(pixel_convert(pair.src, src.data() + src_offset, pair.dst, dst.data() + dst_offset, count));
+                pixel_test_reference(pair.src, src.data() + src_offset, pair.dst, ref.data() + dst_offset, count);
+                if (memcmp(dst.data(), ref.data(), dst.size()) != 0)
+                {
+                    string str;
+                    ICY_ERROR(to_string("pixel %1, count %2, offset %3: mismatch"_s, str,
+                        string_view(pair.name, strlen(pair.name), string_view::constexpr_tag()), uint64_t(count), uint64_t(offset)));
+                    ICY_ERROR(test_print(str));
+                    ICY_TEST(false);
+                }
+            }
+        }
+    }
+
+    //  narrowing: every 16-bit sample value
+    {
+        array<uint16_t> samples;
+        ICY_ERROR(samples.resize(4 * 16384));
+        for (auto k = 0_z; k < samples.size(); ++k)
+            samples[k] = uint16_t(k);
+        array<color> colors;
+        ICY_ERROR(colors.resize(16384));
+        ICY_ERROR(pixel_convert(pixel_format::rgba16, samples.data(), pixel_format::bgra8, colors.data(), colors.size()));
+        auto valid = true;
+        for (auto k = 0_z; k < colors.size(); ++k)
+        {
+            const auto& pixel = colors[k];
+            valid &= pixel.r == pixel_test_narrow(uint16_t(4 * k + 0)) && pixel.g == pixel_test_narrow(uint16_t(4 * k + 1))
+                && pixel.b == pixel_test_narrow(uint16_t(4 * k + 2)) && pixel.a == pixel_test_narrow(uint16_t(4 * k + 3));
+        }
+        ICY_TEST(valid);
+    }
+    //  YCbCr: all Cb/Cr pairs (clamping on every side) for Y at both ends, mid-range and the video range limits
+    {
+        array<uint8_t> ycbcr;
+        for (auto&& y : { 0, 1, 16, 127, 128, 235, 254, 255 })
+        {
+            for (auto cb = 0; cb < 256; ++cb)
+            {
+                for (auto cr = 0; cr < 256; ++cr)
+                {
+                    const uint8_t pixel[] = { uint8_t(y), uint8_t(cb), uint8_t(cr) };
+                    ICY_ERROR(ycbcr.append(pixel));
+                }
+            }
+        }
+        const auto count = ycbcr.size() / 3;
+        ICY_ERROR(dst.resize(count * sizeof(color)));
+        ICY_ERROR(ref.resize(count * sizeof(color)));
+        ICY_ERROR(pixel_convert(pixel_format::ycbcr8, ycbcr.data(), pixel_format::bgra8, dst.data(), count));
+        pixel_test_reference(pixel_format::ycbcr8, ycbcr.data(), pixel_format::bgra8, ref.data(), count);
+        ICY_TEST(memcmp(dst.data(), ref.data(), dst.size()) == 0);
+    }
+    //  in place: rgba8 <-> bgra8 with src == dst
+    for (auto&& count : { 1_z, 7_z, 8_z, 13_z, 100_z })
+    {
+        ICY_ERROR(src.resize(count * 4));
+        for (auto&& byte : src)
+            byte = uint8_t(next_random(state));
+        ICY_ERROR(ref.resize(src.size()));
+        pixel_test_reference(pixel_format::rgba8, src.data(), pixel_format::bgra8, ref.data(), count);
+        ICY_ERROR(pixel_convert(pixel_format::rgba8, src.data(), pixel_format::bgra8, src.data(), count));
+        ICY_TEST(memcmp(src.data(), ref.data(), src.size()) == 0);
+    }
+    //  premultiply: every (color, alpha) pair, and every tail length
+    {
+        array<color> colors;
+        array<color> expect;
+        ICY_ERROR(colors.resize(256 * 256));
+        for (auto k = 0_z; k < colors.size(); ++k)
+            colors[k] = color::from_bgra(uint8_t(k), uint8_t(k ^ 0x55), uint8_t(~k), uint8_t(k >> 8));
+        ICY_ERROR(copy(colors, expect));
+        pixel_premultiply(colors.data(), colors.size());
+        pixel_test_premultiply(expect.data(), expect.size());
+        ICY_TEST(memcmp(colors.data(), expect.data(), colors.size() * sizeof(color)) == 0);
+
+        for (auto count = 0_z; count <= 19; ++count)
+        {
+            ICY_ERROR(colors.resize(count + 4));
+            for (auto&& pixel : colors)
+                pixel.bgra = uint32_t(next_random(state));
+            ICY_ERROR(copy(colors, expect));
+            pixel_premultiply(colors.data(), count);
+            pixel_test_premultiply(expect.data(), count);
+            ICY_TEST(memcmp(colors.data(), expect.data(), colors.size() * sizeof(color)) == 0);
+        }
+    }
+
+    //  unsupported pairs and the matrix overload
+    {
+        uint8_t bytes[16] = {};
+        ICY_TEST(pixel_convert(pixel_format::rgb8, bytes, pixel_format::rgba8, bytes + 8, 1) == make_stdlib_error(std::errc::invalid_argument));
+        ICY_TEST(pixel_convert(pixel_format::rgb8, nullptr, pixel_format::bgra8, bytes, 1) == make_stdlib_error(std::errc::invalid_argument));
+        ICY_TEST(!pixel_convert(pixel_format::rgb8, nullptr, pixel_format::bgra8, nullptr, 0));
+
+        const auto rows = 5_z;
+        const auto cols = 13_z;
+        const auto pitch = cols * 3 + 7;
+        ICY_ERROR(src.resize(rows * pitch));
+        for (auto&& byte : src)
+            byte = uint8_t(next_random(state));
+        matrix<color> image(rows, cols);
+        ICY_TEST(image.size() == rows * cols);
+        ICY_ERROR(pixel_convert(pixel_format::rgb8, src.data(), pitch, image));
+        ICY_ERROR(ref.resize(cols * sizeof(color)));
+        for (auto row = 0_z; row < rows; ++row)
+        {
+            pixel_test_reference(pixel_format::rgb8, src.data() + row * pitch, pixel_format::bgra8, ref.data(), cols);
+            ICY_TEST(memcmp(image.data() + row * cols, ref.data(), ref.size()) == 0);
+        }
+    }
+    return error_type();
+}
+
+//  Mpix/s for a 1920x1080 image: pixel_convert (SSE2 / AVX2, as compiled) against the per-pixel reference
+error_type icy::bench_pixel() noexcept
+{
+    const auto count = 1920_z * 1080;
+    const auto repeat = 20_z;
+    array<uint8_t> src;
+    array<uint8_t> dst;
+    ICY_ERROR(src.resize(count * 8));
+    ICY_ERROR(dst.resize(count * 4));
+    auto state = 0x2545F4914F6CDD1Dull;
+    for (auto&& byte : src)
+        byte = uint8_t(next_random(state));
+
+    for (auto&& pair : pixel_test_pairs)
+    {
+        const auto name = string_view(pair.name, strlen(pair.name), string_view::constexpr_tag());
+        auto beg = clock_type::now();
+        for (auto k = 0_z; k < repeat; ++k)
+            ICY_ERROR(pixel_convert(pair.src, src.data(), pair.dst, dst.data(), count));
+        auto time = clock_type::now() - beg;
+
+        string str;
+        ICY_ERROR(to_string("pixel_convert %1, 1080p, %2 Mpix/s"_s, str, name,
+            double(count * repeat) / 1e6 / std::chrono::duration<double>(time).count()));
+        ICY_ERROR(test_report(str, count * repeat, time));
+
+        beg = clock_type::now();
+        for (auto k = 0_z; k < repeat; ++k)
+            pixel_test_reference(pair.src, src.data(), pair.dst, dst.data(), count);
+        time = clock_type::now() - beg;
+
+        ICY_ERROR(to_string("reference %1, 1080p, %2 Mpix/s"_s, str, name,
+            double(count * repeat) / 1e6 / std::chrono::duration<double>(time).count()));
+        ICY_ERROR(test_report(str, count * repeat, time));
+    }
+    {
+        const auto colors = reinterpret_cast<color*>(dst.data());
+        const auto beg = clock_type::now();
+        for (auto k = 0_z; k < repeat; ++k)
+            pixel_premultiply(colors, count);
+        const auto time = clock_type::now() - beg;
+        string str;
+        ICY_ERROR(to_string("pixel_premultiply, 1080p, %1 Mpix/s"_s, str,
+            double(count * repeat) / 1e6 / std::chrono::duration<double>(time).count()));
+        ICY_ERROR(test_report(str, count * repeat, time));
+    }
+    return error_type();
+}
@@ -0,0 +1,597 @@
+#include "engine_test.hpp"
+#include <icy_engine/core/icy_array.hpp>
+#include <icy_engine/core/icy_thread_pool.hpp>
+
+using namespace icy;
+
+ICY_STATIC_NAMESPACE_BEG
+//  item "k" of producer "p" is "p << 32 | k"
+class pool_test_producer : public thread
+{
+public:
+    error_type run() noexcept override
+    {
+        for (auto k = 0_z; k < count; )
+        {
+            if (queue->push(uint64_t(index) << 32 | k))
+                ++k;
+            else
+                ++full;
+        }
+        return error_type();
+    }
+public:
+    mpmc_queue<uint64_t>* queue = nullptr;
+    uint32_t index = 0;
+    size_t count = 0;
+    size_t full = 0;
+};
+class pool_test_consumer : public thread
+{
+public:
+    error_type run() noexcept override
+    {
+        while (consumed->load(std::memory_order_acquire) < total)
+        {
+            auto value = 0ull;
+            if (queue->pop(value))
+            {
+                ICY_ERROR(items.push_back(value));
+                consumed->fetch_add(1, std::memory_order_acq_rel);
+            }
+            else
+            {
+                sleep(clock_type::duration());
+            }
+        }
+        return error_type();
+    }
+public:
+    mpmc_queue<uint64_t>* queue = nullptr;
+    std::atomic<size_t>* consumed = nullptr;
+    size_t total = 0;
+    array<uint64_t> items;
+};
+
+//  holds one worker until "open": with one per worker, the pool runs nothing else
+struct pool_test_block
+{
+    const thread_pool* pool = nullptr;
+    std::atomic<uint32_t>* started = nullptr;
+    std::atomic<uint32_t> worker = thread_pool::any_thread;
+    std::atomic<bool> open = false;
+};
+//  order in which tasks ran, and on which worker
+struct pool_test_log
+{
+    const thread_pool* pool = nullptr;
+    std::atomic<uint32_t> count = 0;
+    uint32_t values[64] = {};
+    uint32_t workers[64] = {};
+};
+struct pool_test_item
+{
+    pool_test_log* log = nullptr;
+    uint32_t value = 0;
+};
+struct pool_test_fail
+{
+    std::atomic<uint32_t>* done = nullptr;
+    std::errc code = std::errc(0);
+};
+static error_type pool_test_block_func(void* user) noexcept
+{
+    const auto block = static_cast<pool_test_block*>(user);
+    block->worker.store(block->pool->this_index(), std::memory_order_release);
+    block->started->fetch_add(1, std::memory_order_acq_rel);
+    while (!block->open.load(std::memory_order_acquire))
+        sleep(clock_type::duration());
+    return error_type();
+}
+static error_type pool_test_item_func(void* user) noexcept
+{
+    const auto item = static_cast<pool_test_item*>(user);
+    const auto log = item->log;
+    const auto index = log->count.load(std::memory_order_acquire);
+    log->values[index] = item->value;
+    log->workers[index] = log->pool->this_index();
+    log->count.store(index + 1, std::memory_order_release);
+    return error_type();
+}
+static error_type pool_test_count_func(void* user) noexcept
+{
+    static_cast<std::atomic<uint32_t>*>(user)->fetch_add(1, std::memory_order_acq_rel);
+    return error_type();
+}
+static error_type pool_test_fail_func(void* user) noexcept
+{
+    const auto fail = static_cast<pool_test_fail*>(user);
+    fail->done->fetch_add(1, std::memory_order_acq_rel);
+    return make_stdlib_error(fail->code);
+}
+//  blocks every worker of "pool" ("blocks" has one entry per worker)
+static error_type pool_test_block_all(thread_pool& pool, pool_test_block* blocks, std::atomic<uint32_t>& started) noexcept
+{
+    for (auto k = 0_z; k < pool.size(); ++k)
+    {
+        blocks[k].pool = &pool;
+        blocks[k].started = &started;
+        ICY_ERROR(pool.post({ &pool_test_block_func, &blocks[k] }));
+    }
+    while (started.load(std::memory_order_acquire) < pool.size())
+        sleep(std::chrono::milliseconds(1));
+    return error_type();
+}
+static void pool_test_open(pool_test_block* blocks, const size_t count, const uint32_t worker) noexcept
+{
+    for (auto k = 0_z; k < count; ++k)
+    {
+        if (worker == thread_pool::any_thread || blocks[k].worker.load(std::memory_order_acquire) == worker)
+            blocks[k].open.store(true, std::memory_order_release);
+    }
+}
+static void pool_test_wait(const std::atomic<uint32_t>& count, const uint32_t value) noexcept
+{
+    while (count.load(std::memory_order_acquire) < value)
+        sleep(std::chrono::milliseconds(1));
+}
+
+struct pool_test_stats
+{
+    std::atomic<uint32_t> count = 0;
+    std::atomic<int64_t> latency = 0;   //  sum of post-to-handle times, ns
+};
+static void pool_test_handle(pool_test_stats& stats, event& event) noexcept
+{
+    const auto time = clock_type::now() - event->time;
+    stats.latency.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(time).count(), std::memory_order_relaxed);
+    stats.count.fetch_add(1, std::memory_order_acq_rel);
+}
+class pool_test_system : public pool_event_system
+{
+public:
+    using pool_event_system::shutdown;
+    ~pool_test_system() noexcept override
+    {
+        shutdown();
+    }
+    error_type initialize(shared_ptr<thread_pool> pool, const uint32_t affinity = thread_pool::any_thread) noexcept
+    {
+        return pool_event_system::initialize(std::move(pool), 0, thread_pool_priority::normal, affinity);
+    }
+    error_type handle(event& event) noexcept override
+    {
+        pool_test_handle(stats, event);
+        if (event->data<uint32_t>() == stop)
+            shutdown();
+        return error_type();
+    }
+public:
+    pool_test_stats stats;
+    uint32_t stop = UINT32_MAX;
+};
+//  the dedicated-thread model: one "event_thread" per system, woken by "signal"
+class pool_test_dedicated : public event_system
+{
+public:
+    error_type initialize() noexcept
+    {
+        return m_sync.initialize();
+    }
+    error_type exec() noexcept override
+    {
+        while (*this)
+        {
+            while (auto event = pop())
+                pool_test_handle(stats, event);
+            ICY_ERROR(m_sync.wait());
+        }
+        return error_type();
+    }
+    error_type signal(const event_data* event) noexcept override
+    {
+        return m_sync.wake();
+    }
+public:
+    pool_test_stats stats;
+private:
+    sync_handle m_sync;
+};
+struct pool_test_shutdown
+{
+    pool_test_system* system = nullptr;
+    std::atomic<uint32_t> done = 0;
+};
+//  posts to "system" (its drain is queued behind this task on a one-thread pool) and shuts it down
+static error_type pool_test_shutdown_func(void* user) noexcept
+{
+    const auto data = static_cast<pool_test_shutdown*>(user);
+    ICY_ERROR(data->system->post(nullptr, event_type::user, 0u));
+    data->system->shutdown();
+    data->done.fetch_add(1, std::memory_order_acq_rel);
+    return error_type();
+}
+
+//  "systems" systems get "count" events each, round robin, from the calling thread
+template<typename T>
+static error_type pool_test_post(array<shared_ptr<T>>& systems, const size_t count) noexcept
+{
+    for (auto k = 0_z; k < count; ++k)
+    {
+        for (auto&& system : systems)
+            ICY_ERROR(system->post(nullptr, event_type::user, uint32_t(k)));
+    }
+    for (auto&& system : systems)
+        pool_test_wait(system->stats.count, uint32_t(count));
+    return error_type();
+}
+//  one event at a time: the handler is idle (asleep) when the event arrives
+template<typename T>
+static error_type pool_test_ping(T& system, const size_t count, duration_type& latency) noexcept
+{
+    const auto base = system.stats.latency.load();
+    for (auto k = 0_z; k < count; ++k)
+    {
+        const auto expected = system.stats.count.load() + 1;
+        ICY_ERROR(system.post(nullptr, event_type::user, uint32_t(k)));
+        while (system.stats.count.load(std::memory_order_acquire) < expected)
+            sleep(clock_type::duration());
+        sleep(std::chrono::milliseconds(1));
+    }
+    latency = std::chrono::nanoseconds(system.stats.latency.load() - base);
+    return error_type();
+}
+ICY_STATIC_NAMESPACE_END
+
+error_type icy::test_mpmc_queue() noexcept
+{
+    //  empty and full, single thread
+    {
+        mpmc_queue<uint64_t> queue;
+        ICY_ERROR(queue.initialize(100));
+        ICY_TEST(queue.capacity() == 128 && queue.empty());
+
+        auto value = 0ull;
+        ICY_TEST(!queue.pop(value));
+        for (auto k = 0u; k < 128; ++k)
+            ICY_TEST(queue.push(uint64_t(k)));
+        ICY_TEST(!queue.push(128ull));
+        ICY_TEST(queue.size() == 128);
+
+        //  one pop frees one cell: the next push wraps around into it
+        ICY_TEST(queue.pop(value) && value == 0);
+        ICY_TEST(queue.push(128ull));
+        ICY_TEST(!queue.push(129ull));
+        for (auto k = 1u; k <= 128; ++k)
+            ICY_TEST(queue.pop(value) && value == k);
+        ICY_TEST(!queue.pop(value) && queue.empty());
+
+        ICY_TEST(queue.push(7ull));
+        queue.clear();
+        ICY_TEST(!queue.pop(value) && queue.empty());
+    }
+
+    //  4 producers, 4 consumers, a small ring so that both "full" and "empty" are hit all the time:
+    //  every item comes out exactly once, and one consumer sees one producer's items in push order
+    const auto producer_count = 4u;
+    const auto consumer_count = 4u;
+    const auto count = 100_z * 1000;
+    const auto total = producer_count * count;
+
+    mpmc_queue<uint64_t> queue;
+    ICY_ERROR(queue.initialize(64));
+    std::atomic<size_t> consumed = 0;
+
+    array<shared_ptr<pool_test_producer>> producers;
+    array<shared_ptr<pool_test_consumer>> consumers;
+    for (auto k = 0u; k < producer_count; ++k)
+    {
+        shared_ptr<pool_test_producer> new_thread;
+        ICY_ERROR(make_shared(new_thread));
+        new_thread->queue = &queue;
+        new_thread->index = k;
+        new_thread->count = count;
+        ICY_ERROR(producers.push_back(std::move(new_thread)));
+    }
+    for (auto k = 0u; k < consumer_count; ++k)
+    {
+        shared_ptr<pool_test_consumer> new_thread;
+        ICY_ERROR(make_shared(new_thread));
+        new_thread->queue = &queue;
+        new_thread->consumed = &consumed;
+        new_thread->total = total;
+        ICY_ERROR(new_thread->items.reserve(total));
+        ICY_ERROR(consumers.push_back(std::move(new_thread)));
+    }
+    for (auto&& thread : consumers)
+        ICY_ERROR(thread->launch());
+    for (auto&& thread : producers)
+        ICY_ERROR(thread->launch());
+    for (auto&& thread : producers)
+    {
+        ICY_ERROR(thread->wait());
+        ICY_TEST(!thread->error());
+    }
+    for (auto&& thread : consumers)
+    {
+        ICY_ERROR(thread->wait());
+        ICY_TEST(!thread->error());
+    }
+
+    array<uint8_t> seen;
+    ICY_ERROR(seen.resize(total));
+    auto bad = 0_z;
+    auto unordered = 0_z;
+    for (auto&& thread : consumers)
+    {
+        uint64_t last[producer_count] = {};
+        for (auto&& item : thread->items)
+        {
+            const auto producer = uint32_t(item >> 32);
+            const auto index = size_t(item & 0xFFFFFFFF);
+            if (producer >= producer_count || index >= count)
+            {
+                ++bad;
+                continue;
+            }
+            if (last[producer] && index + 1 <= last[producer])
+                ++unordered;
+            last[producer] = index + 1;
+            ++seen[producer * count + index];
+        }
+    }
+    auto once = 0_z;
+    for (auto&& value : seen)
+        once += value == 1;
+    ICY_TEST(bad == 0);
+    ICY_TEST(unordered == 0);
+    ICY_TEST(once == total);
+    ICY_TEST(queue.empty());
+    return error_type();
+}
+
+error_type icy::test_thread_pool() noexcept
+{
+    //  priorities: one worker, held while tasks of every priority are queued
+    {
+        thread_pool_options options;
+        options.threads = 1;
+        options.capacity = 16;
+        shared_ptr<thread_pool> pool;
+        ICY_ERROR(create_thread_pool(pool, options));
+        ICY_TEST(pool->size() == 1 && pool->this_index() == thread_pool::any_thread);
+
+        std::atomic<uint32_t> started = 0;
+        pool_test_block blocks[1];
+        ICY_ERROR(pool_test_block_all(*pool, blocks, started));
+        ICY_TEST(blocks[0].worker.load() == 0);
+
+        pool_test_log log;
+        log.pool = pool.get();
+        pool_test_item items[12];
+        const thread_pool_priority priorities[] = { thread_pool_priority::low, thread_pool_priority::normal, thread_pool_priority::high };
+        for (auto k = 0u; k < _countof(items); ++k)
+        {
+            items[k].log = &log;
+            items[k].value = k;
+            ICY_ERROR(pool->post({ &pool_test_item_func, &items[k] }, priorities[k % 3]));
+        }
+
+        //  4 of 16 low priority slots are taken
+        std::atomic<uint32_t> fillers = 0;
+        auto posted = 0u;
+        error_type error;
+        while (!error)
+        {
+            error = pool->post({ &pool_test_count_func, &fillers }, thread_pool_priority::low);
+            posted += !error;
+        }
+        ICY_TEST(error == make_stdlib_error(std::errc::no_buffer_space));
+        ICY_TEST(posted == 12);
+        ICY_TEST(pool->post({}) == make_stdlib_error(std::errc::invalid_argument));
+        ICY_TEST(pool->post({ &pool_test_count_func, &fillers }, thread_pool_priority::_total) == make_stdlib_error(std::errc::invalid_argument));
+
+        pool_test_open(blocks, _countof(blocks), thread_pool::any_thread);
+        pool_test_wait(log.count, uint32_t(_countof(items)));
+        pool_test_wait(fillers, posted);
+
+        //  high, then normal, then low; FIFO within one priority
+        const uint32_t expected[] = { 2, 5, 8, 11, 1, 4, 7, 10, 0, 3, 6, 9 };
+        for (auto k = 0u; k < _countof(expected); ++k)
+            ICY_TEST(log.values[k] == expected[k] && log.workers[k] == 0);
+
+        //  error(): the first error a task returns, later ones are dropped
+        ICY_TEST(!pool->error());
+        std::atomic<uint32_t> done = 0;
+        pool_test_fail fail[2];
+        fail[0].done = &done;
+        fail[0].code = std::errc::timed_out;
+        fail[1].done = &done;
+        fail[1].code = std::errc::io_error;
+        ICY_ERROR(pool->post({ &pool_test_fail_func, &fail[0] }));
+        ICY_ERROR(pool->post({ &pool_test_fail_func, &fail[1] }));
+        //  one worker: this runs after both errors have been recorded
+        ICY_ERROR(pool->post({ &pool_test_count_func, &done }));
+        pool_test_wait(done, 3);
+        ICY_TEST(pool->error() == make_stdlib_error(std::errc::timed_out));
+    }
+
+    //  affinity: with every other worker held, the target worker runs its tasks itself;
+    //  with the target held, the others steal them (affinity is a hint)
+    {
+        thread_pool_options options;
+        options.threads = 4;
+        options.capacity = 16;
+        shared_ptr<thread_pool> pool;
+        ICY_ERROR(create_thread_pool(pool, options));
+
+        std::atomic<uint32_t> started = 0;
+        pool_test_block blocks[4];
+        ICY_ERROR(pool_test_block_all(*pool, blocks, started));
+        auto workers = 0u;
+        for (auto&& block : blocks)
+        {
+            const auto worker = block.worker.load();
+            ICY_TEST(worker < options.threads);
+            if (worker < options.threads)
+                workers |= 1u << worker;
+        }
+        ICY_TEST(workers == 0x0F);
+
+        pool_test_log log;
+        log.pool = pool.get();
+        pool_test_item items[16];
+        for (auto k = 0u; k < 8; ++k)
+        {
+            items[k].log = &log;
+            items[k].value = k;
+            //  6 % 4: the index wraps around
+            ICY_ERROR(pool->post({ &pool_test_item_func, &items[k] }, thread_pool_priority::normal, k % 2 ? 6 : 2));
+        }
+        pool_test_open(blocks, _countof(blocks), 2);
+        pool_test_wait(log.count, 8);
+        for (auto k = 0u; k < 8; ++k)
+            ICY_TEST(log.values[k] == k && log.workers[k] == 2);
+
+        for (auto k = 8u; k < 16; ++k)
+        {
+            items[k].log = &log;
+            items[k].value = k;
+            ICY_ERROR(pool->post({ &pool_test_item_func, &items[k] }, thread_pool_priority::normal, 0));
+        }
+        pool_test_wait(log.count, 16);
+        for (auto k = 8u; k < 16; ++k)
+            ICY_TEST(log.workers[k] == 2);
+
+        pool_test_open(blocks, _countof(blocks), thread_pool::any_thread);
+        ICY_TEST(!pool->error());
+    }
+
+    //  "pool_event_system::shutdown" on a one-thread pool: from its own "handle",
+    //  and from a task the pending drain is queued behind
+    {
+        thread_pool_options options;
+        options.threads = 1;
+        shared_ptr<thread_pool> pool;
+        ICY_ERROR(create_thread_pool(pool, options));
+
+        shared_ptr<pool_test_system> system;
+        ICY_ERROR(make_shared(system));
+        ICY_ERROR(system->initialize(pool));
+        system->stop = 4;
+        for (auto k = 0u; k < 10; ++k)
+            ICY_ERROR(system->post(nullptr, event_type::user, uint32_t(k)));
+        pool_test_wait(system->stats.count, 5);
+
+        //  the worker is free again and nothing else is handled
+        std::atomic<uint32_t> done = 0;
+        ICY_ERROR(pool->post({ &pool_test_count_func, &done }));
+        pool_test_wait(done, 1);
+        ICY_TEST(system->stats.count.load() == 5);
+        system = nullptr;
+
+        ICY_ERROR(make_shared(system));
+        ICY_ERROR(system->initialize(pool));
+        pool_test_shutdown data;
+        data.system = system.get();
+        ICY_ERROR(pool->post({ &pool_test_shutdown_func, &data }));
+        pool_test_wait(data.done, 1);
+        ICY_TEST(system->stats.count.load() == 1);
+        system = nullptr;
+        ICY_TEST(!pool->error());
+    }
+    return error_type();
+}
+
+//  16 systems (about what the engine runs) on their own event threads vs on a pool with one worker per core:
+//  throughput with every system busy, and post-to-handle latency when the handler is idle
+error_type icy::bench_thread_pool() noexcept
+{
+    const auto system_count = 16_z;
+    const auto count = 20_z * 1000;
+    const auto pings = 1000_z;
+
+    //  raw task throughput: one producer, one worker per core
+    {
+        shared_ptr<thread_pool> pool;
+        ICY_ERROR(create_thread_pool(pool));
+        std::atomic<uint32_t> done = 0;
+        const auto tasks = 1000u * 1000;
+        const auto beg = clock_type::now();
+        for (auto k = 0u; k < tasks; )
+        {
+            const auto error = pool->post({ &pool_test_count_func, &done });
+            if (error == make_stdlib_error(std::errc::no_buffer_space))
+                sleep(clock_type::duration());
+            else if (error)
+                return error;
+            else
+                ++k;
+        }
+        pool_test_wait(done, tasks);
+        string name;
+        ICY_ERROR(to_string("thread pool tasks, %1 workers"_s, name, uint64_t(pool->size())));
+        ICY_ERROR(test_report(name, tasks, clock_type::now() - beg));
+    }
+
+    //  dedicated threads
+    {
+        array<shared_ptr<pool_test_dedicated>> systems;
+        array<shared_ptr<event_thread>> threads;
+        ICY_SCOPE_EXIT
+        {
+            for (auto&& system : systems)
+                system->post_quit_event();
+            for (auto&& thread : threads)
+                thread->wait();
+        };
+        for (auto k = 0_z; k < system_count; ++k)
+        {
+            shared_ptr<pool_test_dedicated> system;
+            ICY_ERROR(make_shared(system));
+            ICY_ERROR(system->initialize());
+            shared_ptr<event_thread> thread;
+            ICY_ERROR(make_shared(thread));
+            thread->system = system.get();
+            ICY_ERROR(systems.push_back(std::move(system)));
+            ICY_ERROR(thread->launch());
+            ICY_ERROR(threads.push_back(std::move(thread)));
+        }
+
+        const auto beg = clock_type::now();
+        ICY_ERROR(pool_test_post(systems, count));
+        string name;
+        ICY_ERROR(to_string("events, %1 dedicated threads"_s, name, uint64_t(system_count)));
+        ICY_ERROR(test_report(name, system_count * count, clock_type::now() - beg));
+
+        duration_type latency;
+        ICY_ERROR(pool_test_ping(*systems[0], pings, latency));
+        ICY_ERROR(test_report("event latency, dedicated thread"_s, pings, latency));
+    }
+
+    //  pool
+    {
+        shared_ptr<thread_pool> pool;
+        ICY_ERROR(create_thread_pool(pool));
+        array<shared_ptr<pool_test_system>> systems;
+        for (auto k = 0_z; k < system_count; ++k)
+        {
+            shared_ptr<pool_test_system> system;
+            ICY_ERROR(make_shared(system));
+            ICY_ERROR(system->initialize(pool));
+            ICY_ERROR(systems.push_back(std::move(system)));
+        }
+
+        const auto beg = clock_type::now();
+        ICY_ERROR(pool_test_post(systems, count));
+        string name;
+        ICY_ERROR(to_string("events, %1 systems on %2 pool workers"_s, name, uint64_t(system_count), uint64_t(pool->size())));
+        ICY_ERROR(test_report(name, system_count * count, clock_type::now() - beg));
+
+        duration_type latency;
+        ICY_ERROR(pool_test_ping(*systems[0], pings, latency));
+        ICY_ERROR(test_report("event latency, pool"_s, pings, latency));
+        ICY_ERROR(pool->error());
+    }
+    return error_type();
+}
@@ -0,0 +1,330 @@
+#include "engine_test.hpp"
+#include <icy_engine/core/icy_array.hpp>
+#include <icy_engine/core/icy_thread.hpp>
+#include <icy_engine/graphics/icy_render_raster.hpp>
+
+using namespace icy;
+
+ICY_STATIC_NAMESPACE_BEG
+static uint64_t next_random(uint64_t& state) noexcept
+{
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+//  a quad in pixel coordinates (two triangles sharing the top-left to bottom-right diagonal)
+struct raster_test_quad
+{
+    float x0 = 0;
+    float y0 = 0;
+    float x1 = 0;
+    float y1 = 0;
+    color col;
+    render_vec2 uv0 = render_vec2(0, 0);
+    render_vec2 uv1 = render_vec2(0, 0);
+    guid tex;
+    render_vec4 clip = render_vec4(0, 0, 1e6F, 1e6F);
+};
+static void raster_test_frame(render_gui_frame& frame, const uint32_t width, const uint32_t height) noexcept
+{
+    frame.data.clear();
+    frame.viewport = render_vec4(0, 0, float(width), float(height));
+}
+//  one command per quad; pixel -> NDC is exact for power-of-two viewports
+static error_type raster_test_append(render_gui_frame& frame, const raster_test_quad& quad) noexcept
+{
+    if (frame.data.empty())
+        ICY_ERROR(frame.data.push_back(render_gui_list()));
+    auto& list = frame.data.back();
+    const auto sx = 2 / frame.viewport.vec[2];
+    const auto sy = 2 / frame.viewport.vec[3];
+
+    render_gui_cmd cmd;
+    cmd.clip = quad.clip;
+    cmd.tex = quad.tex;
+    cmd.vtx = uint32_t(list.vtx.size());
+    cmd.idx = uint32_t(list.idx.size());
+    cmd.size = 6;
+
+    const float xs[] = { quad.x0, quad.x1, quad.x1, quad.x0 };
+    const float ys[] = { quad.y0, quad.y0, quad.y1, quad.y1 };
+    const float us[] = { quad.uv0.u, quad.uv1.u, quad.uv1.u, quad.uv0.u };
+    const float vs[] = { quad.uv0.v, quad.uv0.v, quad.uv1.v, quad.uv1.v };
+    for (auto k = 0u; k < 4; ++k)
+    {
+        render_gui_vtx vtx;
+        vtx.pos = render_vec2(xs[k] * sx - 1, 1 - ys[k] * sy);
+        vtx.tex = render_vec2(us[k], vs[k]);
+        vtx.col = quad.col;
+        ICY_ERROR(list.vtx.push_back(vtx));
+    }
+    const uint32_t idx[] = { 0, 1, 2, 0, 2, 3 };
+    ICY_ERROR(list.idx.append(idx));
+    ICY_ERROR(list.cmd.push_back(cmd));
+    return error_type();
+}
+//  every pixel of "image": "inside" within [x0, x1) x [y0, y1), "outside" elsewhere
+static bool raster_test_rect(const matrix<color>& image, const uint32_t x0, const uint32_t y0, const uint32_t x1, const uint32_t y1,
+    const color inside, const color outside) noexcept
+{
+    for (auto y = 0u; y < image.rows(); ++y)
+    {
+        for (auto x = 0u; x < image.cols(); ++x)
+        {
+            const auto expect = x >= x0 && x < x1 && y >= y0 && y < y1 ? inside : outside;
+            if (image.at(y, x) != expect)
+                return false;
+        }
+    }
+    return true;
+}
+//  a GUI-like frame: background, panels, and text made of small textured quads sampling an atlas
+static error_type raster_test_scene(const uint32_t width, const uint32_t height, const guid& atlas, render_gui_frame& frame) noexcept
+{
+    raster_test_frame(frame, width, height);
+    auto state = 0x9E3779B97F4A7C15ull;
+
+    raster_test_quad background;
+    background.x1 = float(width);
+    background.y1 = float(height);
+    background.col = color::from_rgba(32, 32, 40);
+    ICY_ERROR(raster_test_append(frame, background));
+
+    for (auto k = 0u; k < 100; ++k)
+    {
+        raster_test_quad panel;
+        panel.x0 = float(next_random(state) % width);
+        panel.y0 = float(next_random(state) % height);
+        panel.x1 = panel.x0 + 200 + float(next_random(state) % 200);
+        panel.y1 = panel.y0 + 100 + float(next_random(state) % 200);
+        panel.col = color::from_rgba(uint8_t(next_random(state)), uint8_t(next_random(state)), uint8_t(next_random(state)), 220);
+        ICY_ERROR(raster_test_append(frame, panel));
+    }
+    //  one glyph per 8x16 cell on every other text line
+    for (auto y = 0u; y + 16 <= height; y += 32)
+    {
+        for (auto x = 0u; x + 8 <= width; x += 8)
+        {
+            raster_test_quad glyph;
+            glyph.x0 = float(x);
+            glyph.y0 = float(y);
+            glyph.x1 = float(x + 7);
+            glyph.y1 = float(y + 14);
+            glyph.col = color::from_rgba(230, 230, 230);
+            const auto cell = uint32_t(next_random(state) % 256);
+            glyph.uv0 = render_vec2(float(cell % 16) / 16, float(cell / 16) / 16);
+            glyph.uv1 = render_vec2(glyph.uv0.u + 7.0F / 256, glyph.uv0.v + 14.0F / 256);
+            glyph.tex = atlas;
+            ICY_ERROR(raster_test_append(frame, glyph));
+        }
+    }
+    return error_type();
+}
+static error_type raster_test_atlas(matrix<color>& atlas) noexcept
+{
+    atlas = matrix<color>(256, 256);
+    if (atlas.size() != 256 * 256)
+        return make_stdlib_error(std::errc::not_enough_memory);
+    auto state = 0x2545F4914F6CDD1Dull;
+    for (auto k = 0_z; k < atlas.size(); ++k)
+        atlas.data()[k] = color::from_rgba(255, 255, 255, uint8_t(next_random(state) & 1 ? 255 : 0));
+    return error_type();
+}
+ICY_STATIC_NAMESPACE_END
+
+error_type icy::test_render_raster() noexcept
+{
+    render_gui_raster raster;
+    ICY_ERROR(raster.initialize(1));
+    render_gui_frame frame;
+    matrix<color> image;
+    const auto width = 256u;
+    const auto height = 128u;
+    const auto none = color();
+    const auto red = color::from_rgba(255, 0, 0);
+
+    //  an empty frame is the clear color
+    raster_test_frame(frame, width, height);
+    ICY_ERROR(raster.render(frame, image, color::from_rgba(1, 2, 3, 4)));
+    ICY_TEST(image.rows() == height && image.cols() == width);
+    ICY_TEST(raster_test_rect(image, 0, 0, 0, 0, none, color::from_rgba(1, 2, 3, 4)));
+
+    //  integer edges: exactly the covered pixels, also across tile borders
+    {
+        raster_test_quad quad;
+        quad.x0 = 10;
+        quad.y0 = 5;
+        quad.x1 = 20;
+        quad.y1 = 9;
+        quad.col = red;
+        raster_test_frame(frame, width, height);
+        ICY_ERROR(raster_test_append(frame, quad));
+        ICY_ERROR(raster.render(frame, image));
+        ICY_TEST(raster_test_rect(image, 10, 5, 20, 9, red, none));
+
+        quad.x0 = 60;
+        quad.y0 = 60;
+        quad.x1 = 130;
+        quad.y1 = 70;
+        raster_test_frame(frame, width, height);
+        ICY_ERROR(raster_test_append(frame, quad));
+        ICY_ERROR(raster.render(frame, image));
+        ICY_TEST(raster_test_rect(image, 60, 60, 130, 70, red, none));
+    }
+    //  edges through pixel centers: top and left are in, bottom and right are out (top-left rule);
+    //  at 50% alpha a pixel on the shared diagonal drawn twice would show up as 192
+    {
+        raster_test_quad quad;
+        quad.x0 = 10.5F;
+        quad.y0 = 5.5F;
+        quad.x1 = 20.5F;
+        quad.y1 = 9.5F;
+        quad.col = color::from_rgba(255, 0, 0, 128);
+        raster_test_frame(frame, width, height);
+        ICY_ERROR(raster_test_append(frame, quad));
+        ICY_ERROR(raster.render(frame, image));
+        ICY_TEST(raster_test_rect(image, 10, 5, 20, 9, color::from_rgba(128, 0, 0, 128), none));
+
+        //  the same over an opaque clear color: (255 * 128 + 255 * 127 + 127) / 255 = 255 alpha
+        ICY_ERROR(raster.render(frame, image, color::from_rgba(0, 0, 255)));
+        ICY_TEST(raster_test_rect(image, 10, 5, 20, 9, color::from_rgba(128, 0, 127, 255), color::from_rgba(0, 0, 255)));
+    }
+    //  the clip rectangle cuts a full-screen quad
+    {
+        raster_test_quad quad;
+        quad.x1 = float(width);
+        quad.y1 = float(height);
+        quad.col = red;
+        quad.clip = render_vec4(32, 16, 100, 50);
+        raster_test_frame(frame, width, height);
+        ICY_ERROR(raster_test_append(frame, quad));
+        ICY_ERROR(raster.render(frame, image));
+        ICY_TEST(raster_test_rect(image, 32, 16, 100, 50, red, none));
+    }
+    //  a 2x2 texture on a 2x2 quad: pixel centers hit texel centers, bilinear sampling returns the texels
+    {
+        const auto tex = guid::create();
+        matrix<color> texture(2, 2);
+        ICY_TEST(texture.size() == 4);
+        texture.at(0, 0) = color::from_rgba(10, 20, 30);
+        texture.at(0, 1) = color::from_rgba(40, 50, 60);
+        texture.at(1, 0) = color::from_rgba(70, 80, 90);
+        texture.at(1, 1) = color::from_rgba(100, 110, 120);
+        ICY_ERROR(raster.texture(tex, texture));
+
+        raster_test_quad quad;
+        quad.x0 = 100;
+        quad.y0 = 50;
+        quad.x1 = 102;
+        quad.y1 = 52;
+        quad.col = color::from_rgba(255, 255, 255);
+        quad.uv1 = render_vec2(1, 1);
+        quad.tex = tex;
+        raster_test_frame(frame, width, height);
+        ICY_ERROR(raster_test_append(frame, quad));
+        ICY_ERROR(raster.render(frame, image));
+        ICY_TEST(image.at(50, 100) == texture.at(0, 0) && image.at(50, 101) == texture.at(0, 1));
+        ICY_TEST(image.at(51, 100) == texture.at(1, 0) && image.at(51, 101) == texture.at(1, 1));
+        ICY_TEST(image.at(49, 100) == none && image.at(50, 102) == none);
+
+        //  vertex color modulates the texel: 128 * 100 / 255 = 50.2
+        quad.col = color::from_rgba(128, 255, 255);
+        raster_test_frame(frame, width, height);
+        ICY_ERROR(raster_test_append(frame, quad));
+        ICY_ERROR(raster.render(frame, image));
+        ICY_TEST(image.at(51, 101) == color::from_rgba(50, 110, 120));
+
+        //  an unknown (or erased) texture skips the command
+        raster.erase(tex);
+        ICY_ERROR(raster.render(frame, image));
+        ICY_TEST(raster_test_rect(image, 0, 0, 0, 0, none, none));
+    }
+    //  later commands draw over earlier ones in submission order
+    {
+        raster_test_quad quad;
+        quad.x0 = 0;
+        quad.y0 = 0;
+        quad.x1 = 64;
+        quad.y1 = 64;
+        quad.col = red;
+        raster_test_frame(frame, width, height);
+        ICY_ERROR(raster_test_append(frame, quad));
+        quad.x0 = 32;
+        quad.y0 = 32;
+        quad.x1 = 96;
+        quad.y1 = 96;
+        quad.col = color::from_rgba(0, 255, 0);
+        ICY_ERROR(raster_test_append(frame, quad));
+        ICY_ERROR(raster.render(frame, image));
+        ICY_TEST(image.at(10, 10) == red && image.at(40, 40) == color::from_rgba(0, 255, 0) && image.at(80, 80) == color::from_rgba(0, 255, 0));
+    }
+
+    //  output doesn't depend on the thread count (random overlapping, translucent, textured triangles)
+    {
+        matrix<color> atlas;
+        ICY_ERROR(raster_test_atlas(atlas));
+        const auto atlas_index = guid::create();
+        render_gui_raster threaded;
+        ICY_ERROR(threaded.initialize(4));
+        ICY_ERROR(raster.texture(atlas_index, atlas));
+        ICY_ERROR(threaded.texture(atlas_index, atlas));
+
+        ICY_ERROR(raster_test_scene(1024, 512, atlas_index, frame));
+        matrix<color> single;
+        matrix<color> multi;
+        ICY_ERROR(raster.render(frame, single));
+        ICY_ERROR(threaded.render(frame, multi));
+        ICY_TEST(single.size() == multi.size() && memcmp(single.data(), multi.data(), single.size() * sizeof(color)) == 0);
+
+        //  repeated renders with the same raster are stable
+        ICY_ERROR(threaded.render(frame, multi));
+        ICY_TEST(memcmp(single.data(), multi.data(), single.size() * sizeof(color)) == 0);
+    }
+    return error_type();
+}
+
+//  frames/sec for a GUI-like frame (background, 100 panels, a glyph on every other text line)
+error_type icy::bench_render_raster() noexcept
+{
+    matrix<color> atlas;
+    ICY_ERROR(raster_test_atlas(atlas));
+    const auto atlas_index = guid::create();
+
+    struct size_type
+    {
+        const char* name;
+        uint32_t width;
+        uint32_t height;
+    };
+    const size_type sizes[] = { { "1080p", 1920, 1080 }, { "4K", 3840, 2160 } };
+    for (auto&& size : sizes)
+    {
+        render_gui_frame frame;
+        ICY_ERROR(raster_test_scene(size.width, size.height, atlas_index, frame));
+        const auto triangles = frame.data.back().idx.size() / 3;
+
+        for (auto&& threads : { 1_z, 0_z })
+        {
+            render_gui_raster raster;
+            ICY_ERROR(raster.initialize(threads));
+            ICY_ERROR(raster.texture(atlas_index, atlas));
+            matrix<color> image;
+            ICY_ERROR(raster.render(frame, image));
+
+            const auto frames = 20_z;
+            const auto beg = clock_type::now();
+            for (auto k = 0_z; k < frames; ++k)
+                ICY_ERROR(raster.render(frame, image));
+            const auto time = clock_type::now() - beg;
+
+            const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(time).count();
+            string name;
+            ICY_ERROR(to_string("raster %1, %2 triangles, %3 threads: %4 fps"_s, name,
+                string_view(size.name, strlen(size.name), string_view::constexpr_tag()), uint64_t(triangles),
+                uint64_t(threads ? threads : thread::cores()), ns ? uint64_t(1e9 * frames / double(ns)) : 0));
+            ICY_ERROR(test_report(name, frames, time));
+        }
+    }
+    return error_type();
+}
@@ -0,0 +1,215 @@
+#include "engine_test.hpp"
+#include <icy_engine/graphics/icy_render_animation.hpp>
+
+using namespace icy;
+
+ICY_STATIC_NAMESPACE_BEG
+//  "count" nodes, 4 children per node (breadth-first guid order, so map inserts append)
+static error_type make_nodes(const size_t count, map<guid, render_node>& nodes) noexcept
+{
+    array<guid> keys;
+    ICY_ERROR(keys.resize(count));
+    for (auto&& key : keys)
+        key = guid::create();
+    std::sort(keys.begin(), keys.end());
+
+    nodes.clear();
+    ICY_ERROR(nodes.reserve(count));
+    for (auto k = 0_z; k < count; ++k)
+    {
+        render_node node;
+        if (k)
+            node.parent = keys[(k - 1) / 4];
+        node.transform.world = render_vec3(float(k % 7), 1, 0);
+        node.transform.angle = render_vec4(0, 0.38268343F, 0, 0.92387953F);
+        ICY_ERROR(nodes.insert(keys[k], std::move(node)));
+    }
+    return error_type();
+}
+//  "count" channels with "keys" keys per track, one key per frame
+static error_type make_animation(const size_t count, const size_t keys, render_animation& animation) noexcept
+{
+    array<guid> nodes;
+    ICY_ERROR(nodes.resize(count));
+    for (auto&& node : nodes)
+        node = guid::create();
+    std::sort(nodes.begin(), nodes.end());
+
+    animation.frames = double(keys - 1);
+    animation.fps = 30;
+    animation.nodes.clear();
+    ICY_ERROR(animation.nodes.reserve(count));
+    for (auto&& node : nodes)
+    {
+        render_animation_node channel;
+        channel.suffix = render_animation_type::repeat;
+        for (auto k = 0_z; k < keys; ++k)
+        {
+            const auto half = float(k) * 0.05F;
+            render_animation_node::step3 world;
+            world.time = double(k);
+            world.value = render_vec3(float(k), 0, 1);
+            render_animation_node::step4 angle;
+            angle.time = double(k);
+            angle.value = render_vec4(0, sinf(half), 0, cosf(half));
+            ICY_ERROR(channel.world.push_back(world));
+            ICY_ERROR(channel.angle.push_back(angle));
+        }
+        ICY_ERROR(animation.nodes.insert(node, std::move(channel)));
+    }
+    return error_type();
+}
+ICY_STATIC_NAMESPACE_END
+
+error_type icy::test_render_animation() noexcept
+{
+    const auto node = guid::create();
+    render_animation animation;
+    animation.frames = 10;
+    animation.fps = 10;
+    {
+        //  rotation only, repeated after the end
+        render_animation_node channel;
+        channel.suffix = render_animation_type::repeat;
+        const float values[] = { 0, 1 };
+        for (auto&& value : values)
+        {
+            render_animation_node::step4 angle;
+            angle.time = value * animation.frames;
+            angle.value = render_vec4(0, value, 0, 1 - value);
+            ICY_ERROR(channel.angle.push_back(angle));
+        }
+        ICY_ERROR(animation.nodes.insert(node, std::move(channel)));
+    }
+    render_animation_clip clip;
+    ICY_ERROR(clip.initialize(animation));
+
+    map<guid, render_node> nodes;
+    {
+        render_node bind;
+        bind.transform.world = render_vec3(1, 2, 3);
+        bind.transform.scale = render_vec3(2, 2, 2);
+        ICY_ERROR(nodes.insert(node, std::move(bind)));
+    }
+    render_transform_buffer buffer;
+    ICY_ERROR(buffer.initialize(nodes));
+
+    render_animation_state state;
+    ICY_ERROR(state.initialize(clip));
+    ICY_ERROR(state.bind(clip, buffer));
+
+    //  the last key is held at the end of the range instead of wrapping to the first one
+    clip.sample(clip.duration(), state);
+    state.apply(buffer);
+    auto transform = buffer.transform(0);
+    ICY_TEST(transform.world.x == 1 && transform.world.y == 2 && transform.world.z == 3);
+    ICY_TEST(transform.scale.x == 2 && transform.scale.y == 2 && transform.scale.z == 2);
+    ICY_TEST(fabsf(transform.angle.y - 1) < 1e-5F && fabsf(transform.angle.w) < 1e-5F);
+
+    //  past the end the suffix applies: 1.25 * duration repeats as 0.25 * duration
+    clip.sample(clip.duration() * 1.25, state);
+    state.apply(buffer);
+    transform = buffer.transform(0);
+    ICY_TEST(transform.world.x == 1 && transform.scale.x == 2);
+    ICY_TEST(fabsf(transform.angle.y / transform.angle.w - 1.0F / 3) < 1e-5F);
+    return error_type();
+}
+
+error_type icy::bench_render_transform() noexcept
+{
+    const size_t sizes[] = { 10'000, 100'000, 1'000'000 };
+    for (auto&& size : sizes)
+    {
+        map<guid, render_node> nodes;
+        ICY_ERROR(make_nodes(size, nodes));
+
+        string str;
+        render_transform_buffer buffer;
+        auto beg = clock_type::now();
+        ICY_ERROR(buffer.initialize(nodes));
+        ICY_ERROR(to_string("transform initialize (%1)"_s, str, uint64_t(size)));
+        ICY_ERROR(test_report(str, size, clock_type::now() - beg));
+
+        const auto frames = 10_z;
+        auto transform = buffer.transform(0);
+
+        //  animated skeleton: every node is assigned every frame
+        beg = clock_type::now();
+        for (auto n = 0_z; n < frames; ++n)
+        {
+            for (auto k = 0u; k < size; ++k)
+                buffer.assign(k, transform);
+            buffer.update();
+        }
+        ICY_ERROR(to_string("transform update, all dirty (%1)"_s, str, uint64_t(size)));
+        ICY_ERROR(test_report(str, size * frames, clock_type::now() - beg));
+
+        //  sparse edits: 1% of the nodes (mostly leaves) move per frame
+        beg = clock_type::now();
+        for (auto n = 0_z; n < frames; ++n)
+        {
+            transform.world.x += 1;
+            for (auto k = n; k < size; k += 100)
+                buffer.assign(uint32_t(size - 1 - k), transform);
+            buffer.update();
+        }
+        ICY_ERROR(to_string("transform update, 1%% dirty (%1)"_s, str, uint64_t(size)));
+        ICY_ERROR(test_report(str, size * frames, clock_type::now() - beg));
+
+        //  scalar reference: compose and multiply one node at a time
+        const auto parent = buffer.parent();
+        array<render_matrix> world;
+        ICY_ERROR(world.resize(size));
+        beg = clock_type::now();
+        for (auto n = 0_z; n < frames; ++n)
+        {
+            for (auto k = 0_z; k < size; ++k)
+            {
+                const auto local = to_matrix(buffer.transform(uint32_t(k)));
+                world[k] = parent[k] == render_transform_buffer::invalid_index ? local : local * world[parent[k]];
+            }
+        }
+        ICY_ERROR(to_string("transform update, scalar (%1)"_s, str, uint64_t(size)));
+        ICY_ERROR(test_report(str, size * frames, clock_type::now() - beg));
+    }
+    return error_type();
+}
+error_type icy::bench_render_animation() noexcept
+{
+    const size_t sizes[] = { 64, 1024, 16 * 1024 };
+    const struct
+    {
+        const char* name;
+        uint32_t flags;
+        render_animation_blend blend;
+    } modes[] =
+    {
+        { "nlerp", render_animation_flag_none, render_animation_blend::nlerp },
+        { "slerp", render_animation_flag_none, render_animation_blend::slerp },
+        { "nlerp, snorm16", render_animation_flag_quantize, render_animation_blend::nlerp },
+    };
+    for (auto&& size : sizes)
+    {
+        render_animation animation;
+        ICY_ERROR(make_animation(size, 120, animation));
+        for (auto&& mode : modes)
+        {
+            render_animation_clip clip;
+            ICY_ERROR(clip.initialize(animation, mode.flags));
+            render_animation_state state;
+            ICY_ERROR(state.initialize(clip));
+
+            //  about 8M channel samples per run, forward playback at 60 fps over two loops
+            const auto frames = std::max(8_z * 1024 * 1024 / size, 1_z);
+            const auto beg = clock_type::now();
+            for (auto k = 0_z; k < frames; ++k)
+                clip.sample(double(k % 480) / 60, state, mode.blend);
+
+            string str;
+            ICY_ERROR(to_string("animation sample, %1 (%2 channels)"_s, str,
+                string_view(mode.name, strlen(mode.name), string_view::constexpr_tag()), uint64_t(size)));
+            ICY_ERROR(test_report(str, frames * size, clock_type::now() - beg));
+        }
+    }
+    return error_type();
+}
@@ -0,0 +1,250 @@
+#include "engine_test.hpp"
+#include <icy_engine/core/icy_array.hpp>
+#include <icy_engine/graphics/icy_render_stream.hpp>
+
+using namespace icy;
+
+ICY_STATIC_NAMESPACE_BEG
+static uint64_t next_random(uint64_t& state) noexcept
+{
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+static error_type stream_test_list(uint64_t& state, const guid& tex, render_gui_list& list) noexcept
+{
+    const auto vtx_count = 4 + uint32_t(next_random(state) % 60);
+    const auto idx_count = 3 * (1 + uint32_t(next_random(state) % 40));
+    ICY_ERROR(list.vtx.resize(vtx_count));
+    ICY_ERROR(list.idx.resize(idx_count));
+    for (auto&& vtx : list.vtx)
+    {
+        vtx.pos = render_vec2(float(next_random(state) % 2000) / 1000 - 1, float(next_random(state) % 2000) / 1000 - 1);
+        vtx.tex = render_vec2(float(next_random(state) % 256) / 256, float(next_random(state) % 256) / 256);
+        vtx.col.bgra = uint32_t(next_random(state));
+    }
+    for (auto&& idx : list.idx)
+        idx = uint32_t(next_random(state) % vtx_count);
+
+    for (auto offset = 0u; offset < idx_count; )
+    {
+        render_gui_cmd cmd;
+        cmd.clip = render_vec4(0, 0, float(next_random(state) % 1024), float(next_random(state) % 1024));
+        cmd.tex = next_random(state) & 1 ? tex : guid();
+        cmd.idx = offset;
+        cmd.size = std::min(3 * (1 + uint32_t(next_random(state) % 8)), idx_count - offset);
+        offset += cmd.size;
+        ICY_ERROR(list.cmd.push_back(cmd));
+    }
+    return error_type();
+}
+//  "lists" random lists, the first "reuse" copied from "prev" (sent as cached references)
+static error_type stream_test_frame(uint64_t& state, const guid& tex, const render_gui_frame* prev, const size_t reuse,
+    const size_t lists, render_gui_frame& frame) noexcept
+{
+    frame.viewport = render_vec4(0, 0, 1024, 768);
+    frame.vbuffer = uint32_t(next_random(state) % 1000);
+    frame.ibuffer = uint32_t(next_random(state) % 1000);
+    ICY_ERROR(frame.data.resize(lists));
+    for (auto k = 0_z; k < lists; ++k)
+    {
+        if (prev && k < reuse && k < prev->data.size())
+        {
+            ICY_ERROR(copy(prev->data[k], frame.data[k]));
+        }
+        else
+        {
+            ICY_ERROR(stream_test_list(state, tex, frame.data[k]));
+        }
+    }
+    return error_type();
+}
+static bool stream_test_equal(const render_gui_frame& lhs, const render_gui_frame& rhs) noexcept
+{
+    if (memcmp(lhs.viewport.vec, rhs.viewport.vec, sizeof(lhs.viewport.vec)) != 0
+        || lhs.vbuffer != rhs.vbuffer || lhs.ibuffer != rhs.ibuffer || lhs.data.size() != rhs.data.size())
+        return false;
+    for (auto k = 0_z; k < lhs.data.size(); ++k)
+    {
+        const auto& a = lhs.data[k];
+        const auto& b = rhs.data[k];
+        if (a.idx.size() != b.idx.size() || a.vtx.size() != b.vtx.size() || a.cmd.size() != b.cmd.size())
+            return false;
+        if (memcmp(a.idx.data(), b.idx.data(), a.idx.size() * sizeof(a.idx[0])) != 0
+            || memcmp(a.vtx.data(), b.vtx.data(), a.vtx.size() * sizeof(a.vtx[0])) != 0
+            || memcmp(a.cmd.data(), b.cmd.data(), a.cmd.size() * sizeof(a.cmd[0])) != 0)
+            return false;
+    }
+    return true;
+}
+static bool stream_test_equal(const const_array_view<render_gui_frame> lhs, const const_array_view<render_gui_frame> rhs) noexcept
+{
+    if (lhs.size() != rhs.size())
+        return false;
+    for (auto k = 0_z; k < lhs.size(); ++k)
+    {
+        if (!stream_test_equal(lhs[k], rhs[k]))
+            return false;
+    }
+    return true;
+}
+//  three messages: a full frame with a texture, a frame mostly cached from the first,
+//  and a self-contained frame after "reset"; "offsets" are the message boundaries
+struct stream_test_input
+{
+    guid tex;
+    matrix<color> image;
+    array<render_gui_frame> frames;
+    array<uint8_t> bytes;
+    size_t offsets[4] = {};
+};
+static error_type stream_test_input_make(stream_test_input& input) noexcept
+{
+    auto state = 0x9E3779B97F4A7C15ull;
+    input.tex = guid::create();
+    input.image = matrix<color>(8, 16);
+    if (input.image.size() != 8 * 16)
+        return make_stdlib_error(std::errc::not_enough_memory);
+    for (auto k = 0_z; k < input.image.size(); ++k)
+        input.image.data()[k].bgra = uint32_t(next_random(state));
+
+    ICY_ERROR(input.frames.resize(3));
+    ICY_ERROR(stream_test_frame(state, input.tex, nullptr, 0, 4, input.frames[0]));
+    ICY_ERROR(stream_test_frame(state, input.tex, &input.frames[0], 3, 5, input.frames[1]));
+    ICY_ERROR(stream_test_frame(state, input.tex, &input.frames[1], 5, 5, input.frames[2]));
+
+    render_gui_encoder encoder;
+    ICY_ERROR(encoder.texture(input.tex, input.image));
+    for (auto k = 0_z; k < 3; ++k)
+    {
+        if (k == 2)
+            encoder.reset();
+        ICY_ERROR(encoder.encode(input.frames[k], input.bytes));
+        input.offsets[k + 1] = input.bytes.size();
+    }
+    return error_type();
+}
+static const_array_view<uint8_t> stream_test_range(const stream_test_input& input, const size_t beg, const size_t end) noexcept
+{
+    return const_array_view<uint8_t>(input.bytes.data() + beg, end - beg);
+}
+ICY_STATIC_NAMESPACE_END
+
+error_type icy::test_render_stream() noexcept
+{
+    stream_test_input input;
+    ICY_ERROR(stream_test_input_make(input));
+    const auto size = input.bytes.size();
+    const auto invalid = make_stdlib_error(std::errc::illegal_byte_sequence);
+
+    //  round trip: frames, textures and stats
+    {
+        render_gui_decoder decoder;
+        array<render_gui_frame> frames;
+        array<guid> textures;
+        ICY_ERROR(decoder.decode(input.bytes, frames, &textures));
+        ICY_TEST(stream_test_equal(frames, input.frames));
+        //  the texture is sent once, then again after "reset"
+        ICY_TEST(textures.size() == 2 && textures[0] == input.tex && textures[1] == input.tex);
+        const auto image = decoder.texture(input.tex);
+        ICY_TEST(image && image->rows() == input.image.rows() && image->cols() == input.image.cols()
+            && memcmp(image->data(), input.image.data(), input.image.size() * sizeof(color)) == 0);
+        ICY_TEST(decoder.stats().frames == 3 && decoder.stats().cached == 3 && decoder.stats().rejected == 0);
+        ICY_TEST(decoder.stats().bytes == size);
+    }
+    //  two pieces split at every byte offset, then one byte at a time
+    for (auto split = 0_z; split <= size; ++split)
+    {
+        render_gui_decoder decoder;
+        array<render_gui_frame> frames;
+        ICY_ERROR(decoder.decode(stream_test_range(input, 0, split), frames));
+        ICY_ERROR(decoder.decode(stream_test_range(input, split, size), frames));
+        ICY_TEST(stream_test_equal(frames, input.frames));
+    }
+    {
+        render_gui_decoder decoder;
+        array<render_gui_frame> frames;
+        for (auto k = 0_z; k < size; ++k)
+        {
+            ICY_ERROR(decoder.decode(stream_test_range(input, k, k + 1), frames));
+            ICY_TEST(frames.size() == (k + 1 >= input.offsets[3] ? 3 : k + 1 >= input.offsets[2] ? 2 : k + 1 >= input.offsets[1] ? 1 : 0));
+        }
+        ICY_TEST(stream_test_equal(frames, input.frames));
+    }
+
+    //  a bad magic in the second message: it is skipped, the third (after "reset") still decodes,
+    //  also when the bad message arrives split in two
+    {
+        array<uint8_t> bytes;
+        ICY_ERROR(copy(input.bytes, bytes));
+        bytes[input.offsets[1] + sizeof(uint32_t)] ^= 0xFF;
+        for (auto&& split : { size, input.offsets[1] + 10, input.offsets[2] - 1 })
+        {
+            render_gui_decoder decoder;
+            array<render_gui_frame> frames;
+            auto error = decoder.decode(const_array_view<uint8_t>(bytes.data(), split), frames);
+            if (!error)
+                error = decoder.decode(const_array_view<uint8_t>(bytes.data() + split, size - split), frames);
+            ICY_TEST(error == invalid);
+            ICY_TEST(frames.size() == 2 && stream_test_equal(frames[0], input.frames[0]) && stream_test_equal(frames[1], input.frames[2]));
+            ICY_TEST(decoder.stats().rejected == 1 && decoder.stats().frames == 2);
+        }
+    }
+    //  cached lists the decoder never saw: out of sync until the encoder resets
+    {
+        render_gui_decoder decoder;
+        array<render_gui_frame> frames;
+        const auto error = decoder.decode(stream_test_range(input, input.offsets[1], size), frames);
+        ICY_TEST(error == make_stdlib_error(std::errc::invalid_argument));
+        ICY_TEST(frames.size() == 1 && stream_test_equal(frames[0], input.frames[2]));
+    }
+    //  a message with trailing bytes inside its size prefix is rejected, the next one is kept
+    {
+        array<uint8_t> bytes;
+        ICY_ERROR(bytes.append(stream_test_range(input, 0, input.offsets[1])));
+        ICY_ERROR(bytes.push_back(0));
+        const auto body = uint32_t(input.offsets[1] - sizeof(uint32_t) + 1);
+        memcpy(bytes.data(), &body, sizeof(body));
+        ICY_ERROR(bytes.append(stream_test_range(input, input.offsets[2], size)));
+
+        render_gui_decoder decoder;
+        array<render_gui_frame> frames;
+        ICY_TEST(decoder.decode(bytes, frames) == invalid);
+        ICY_TEST(frames.size() == 1 && stream_test_equal(frames[0], input.frames[2]));
+    }
+    //  a size prefix over the limit loses framing: the rest of the input is dropped
+    {
+        array<uint8_t> bytes;
+        ICY_ERROR(copy(input.bytes, bytes));
+        const auto body = uint32_t(UINT32_MAX);
+        memcpy(bytes.data() + input.offsets[1], &body, sizeof(body));
+
+        render_gui_decoder decoder;
+        array<render_gui_frame> frames;
+        ICY_TEST(decoder.decode(bytes, frames) == invalid);
+        ICY_TEST(frames.size() == 1 && stream_test_equal(frames[0], input.frames[0]));
+    }
+    //  random corruption inside the second message never breaks framing:
+    //  the first and last frames always come through
+    {
+        auto state = 0x2545F4914F6CDD1Dull;
+        array<uint8_t> bytes;
+        for (auto k = 0u; k < 2000; ++k)
+        {
+            ICY_ERROR(copy(input.bytes, bytes));
+            const auto beg = input.offsets[1] + sizeof(uint32_t);
+            const auto len = input.offsets[2] - beg;
+            for (auto n = 1 + next_random(state) % 4; n; --n)
+                bytes[beg + next_random(state) % len] ^= uint8_t(1 + next_random(state) % 255);
+
+            render_gui_decoder decoder;
+            array<render_gui_frame> frames;
+            const auto error = decoder.decode(bytes, frames);
+            ICY_TEST(frames.size() == 3 || (frames.size() == 2 && error));
+            if (frames.size() >= 2)
+                ICY_TEST(stream_test_equal(frames[0], input.frames[0]) && stream_test_equal(frames.back(), input.frames[2]));
+        }
+    }
+    return error_type();
+}
@@ -0,0 +1,308 @@
+#include "engine_test.hpp"
+#include <cfloat>
+#include <clocale>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+using namespace icy;
+
+ICY_STATIC_NAMESPACE_BEG
+static uint64_t next_random(uint64_t& state) noexcept
+{
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+ICY_STATIC_NAMESPACE_END
+
+error_type icy::test_string_convert() noexcept
+{
+    auto state = 0x9E3779B97F4A7C15ull;
+    string str;
+
+    //  integers: extremes and random values survive to_string -> to_value
+    const int64_t signed_values[] = { 0, 1, -1, 9, 10, 99999999, 100000000, INT64_MAX, INT64_MIN };
+    for (auto&& value : signed_values)
+    {
+        ICY_ERROR(to_string(value, str));
+        auto parsed = int64_t(0);
+        ICY_TEST(!to_value(str, parsed) && parsed == value);
+    }
+    for (auto k = 0u; k < 10000; ++k)
+    {
+        const auto value = next_random(state) >> (k % 64);
+        ICY_ERROR(to_string(value, str));
+        auto parsed = uint64_t(0);
+        ICY_TEST(!to_value(str, parsed) && parsed == value);
+        ICY_ERROR(to_string(-int64_t(value >> 1), str));
+        auto parsed_signed = int64_t(0);
+        ICY_TEST(!to_value(str, parsed_signed) && parsed_signed == -int64_t(value >> 1));
+    }
+    {
+        const auto out_of_range = make_stdlib_error(std::errc::result_out_of_range);
+        auto parsed = int64_t(0);
+        auto parsed_unsigned = uint64_t(0);
+        ICY_TEST(to_value("9223372036854775808"_s, parsed) == out_of_range);
+        ICY_TEST(to_value("-9223372036854775809"_s, parsed) == out_of_range);
+        ICY_TEST(to_value("18446744073709551616"_s, parsed_unsigned) == out_of_range);
+        ICY_TEST(!to_value("18446744073709551615"_s, parsed_unsigned) && parsed_unsigned == UINT64_MAX);
+        ICY_TEST(!to_value("  -0x1F;"_s, parsed) && parsed == -31);
+        ICY_TEST(!to_value("0042"_s, parsed) && parsed == 42);
+        ICY_TEST(to_value(""_s, parsed) && to_value("-"_s, parsed) && to_value("x1"_s, parsed));
+    }
+
+    //  doubles: 15 significant digits (DBL_DIG) survive string -> double -> string exactly,
+    //  and the parsed value matches the C library
+    for (auto k = 0u; k < 10000; ++k)
+    {
+        auto bits = next_random(state);
+        auto value = 0.0;
+        memcpy(&value, &bits, sizeof(value));
+        if (std::fpclassify(value) != FP_NORMAL)  //  subnormals keep fewer than 15 digits
+            continue;
+
+        char buffer[64];
+        const auto length = snprintf(buffer, sizeof(buffer), "%.14e", value);
+        const auto input = string_view(buffer, size_t(length), string_view::constexpr_tag());
+        auto parsed = 0.0;
+        ICY_TEST(!to_value(input, parsed) && parsed == strtod(buffer, nullptr));
+        ICY_ERROR(to_string(parsed, float_type_exp, 14, str));
+        ICY_TEST(str == input);
+    }
+    {
+        //  short decimals (fast path) and long mantissas / large exponents (strtod path)
+        const char* const inputs[] = { "0", "-0.5", "3.14159", "55.755831", "37.617673", "1e22", "1e-22", "123456789012345678",
+            "0.1000000000000000055511151231257827", "2.2250738585072014e-308", "1.7976931348623157e308", "4.9e-324", " +7.25e+3x" };
+        for (auto&& input : inputs)
+        {
+            auto parsed = 0.0;
+            ICY_TEST(!to_value(string_view(input, strlen(input), string_view::constexpr_tag()), parsed) && parsed == strtod(input, nullptr));
+        }
+        auto parsed = 0.0;
+        ICY_TEST(to_value(""_s, parsed) && to_value("."_s, parsed) && to_value("e5"_s, parsed));
+    }
+    //  parsing (including the strtod path) and printing ignore the process locale
+    if (setlocale(LC_NUMERIC, "de-DE") || setlocale(LC_NUMERIC, "de_DE.UTF-8"))
+    {
+        auto parsed = 0.0;
+        const auto parse_error = to_value("0.1000000000000000055511151231257827"_s, parsed);
+        string fixed;
+        string exp;
+        string format;
+        auto print_error = to_string(-1234.5, float_type_fixed, 3, fixed);
+        if (!print_error)
+            print_error = to_string(6.02214076e23, float_type_exp, 8, exp);
+        if (!print_error)
+            print_error = to_string("%1;%2"_s, format, 0.25, 1e-3F);
+        setlocale(LC_NUMERIC, "C");
+        ICY_TEST(!parse_error && parsed == 0.1);
+        ICY_TEST(!print_error);
+        ICY_TEST(fixed == "-1234.500"_s);
+        ICY_TEST(exp == "6.02214076e+23"_s);
+        ICY_TEST(format == "0.250000;0.001000"_s);
+    }
+    {
+        auto parsed = 0.0F;
+        ICY_TEST(!to_value("1.25e-3"_s, parsed) && parsed == 1.25e-3F);
+    }
+
+    //  guids
+    for (auto k = 0u; k < 1000; ++k)
+    {
+        const auto value = guid::create();
+        ICY_ERROR(to_string(value, str));
+        auto parsed = guid();
+        ICY_TEST(!to_value(str, parsed) && parsed == value);
+    }
+    {
+        auto parsed = guid();
+        ICY_TEST(!to_value("0123ABCD-4567-89ab-CDEF-0123456789AB"_s, parsed));
+        ICY_ERROR(to_string(parsed, str));
+        ICY_TEST(str == "0123ABCD-4567-89AB-CDEF-0123456789AB"_s);
+        ICY_TEST(to_value("0123ABCD-4567-89AB-CDEF-0123456789A"_s, parsed));
+        ICY_TEST(to_value("0123ABCD 4567-89AB-CDEF-0123456789AB"_s, parsed));
+        ICY_TEST(to_value("0123ABCD-4567-89AB-CDEF-0123456789AG"_s, parsed));
+    }
+    return error_type();
+}
+
+error_type icy::test_string_format() noexcept
+{
+    const auto invalid = make_stdlib_error(std::errc::invalid_argument);
+    string str;
+
+    //  escapes, repeated and out-of-order indices, multi-digit indices
+    ICY_ERROR(to_string("100%% of %1, %2 and %1 again"_s, str, "a"_s, int32_t(-7)));
+    ICY_TEST(str == "100% of a, -7 and a again"_s);
+    ICY_ERROR(to_string("%2%1%%%%"_s, str, uint8_t(1), uint16_t(2)));
+    ICY_TEST(str == "21%%"_s);
+    ICY_ERROR(to_string("%10|%1"_s, str, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10));
+    ICY_TEST(str == "10|1"_s);
+    ICY_ERROR(to_string("%1x"_s, str, 5));
+    ICY_TEST(str == "5x"_s);
+
+    //  integer extremes
+    ICY_ERROR(to_string("%1 %2 %3 %4"_s, str, int64_t(INT64_MIN), uint64_t(UINT64_MAX), int8_t(-128), uint8_t(255)));
+    ICY_TEST(str == "-9223372036854775808 18446744073709551615 -128 255"_s);
+
+    //  non-ASCII literals pass through byte for byte ("%" never occurs inside a UTF-8 sequence)
+    ICY_ERROR(to_string("\xD0\x9F\xD1\x80\xD0\xB8 %1 \xE6\x97\xA5%%\xE6\x9C\xAC"_s, str, "\xC3\xA9"_s));
+    ICY_TEST(str == "\xD0\x9F\xD1\x80\xD0\xB8 \xC3\xA9 \xE6\x97\xA5%\xE6\x9C\xAC"_s);
+
+    //  malformed formats fail before anything is written
+    const string_view malformed[] = { "%"_s, "abc%"_s, "%0"_s, "%00"_s, "%2"_s, "%x"_s, "%%%"_s, "%1%"_s };
+    for (auto&& format : malformed)
+    {
+        ICY_ERROR(copy("keep"_s, str));
+        ICY_TEST(str.appendf(format, 1) == invalid && str == "keep"_s);
+    }
+
+    //  floats and guids are written directly and match to_string / printf in the "C" locale
+    auto state = 0x2545F4914F6CDD1Dull;
+    for (auto k = 0u; k < 10000; ++k)
+    {
+        auto bits = next_random(state);
+        auto value = 0.0;
+        memcpy(&value, &bits, sizeof(value));
+        if (!std::isfinite(value))
+            continue;
+        const auto precision = size_t(k % (DBL_DIG + 1));
+        for (auto type : { float_type_fixed, float_type_exp })
+        {
+            char expect[512];
+            const auto expect_length = snprintf(expect, sizeof(expect),
+                type == float_type_exp ? "%.*e" : "%.*f", int(precision), value);
+            char buffer[detail::double_chars_max];
+            const auto length = detail::double_to_chars(value, type, precision, buffer);
+            ICY_TEST(length == size_t(expect_length) && memcmp(buffer, expect, length) == 0);
+        }
+    }
+    const double reals[] = { 0.0, -0.0, 0.5, 1.5, 2.5, -2.5, 0.125, 1e-7, 999999.9999996, 1e300, 5e-324, DBL_MAX };
+    for (auto&& value : reals)
+    {
+        char expect[512];
+        const auto expect_length = snprintf(expect, sizeof(expect), "%.*f", FLT_DIG, value);
+        ICY_ERROR(to_string("%1"_s, str, value));
+        ICY_TEST(str == string_view(expect, size_t(expect_length), string_view::constexpr_tag()));
+        for (auto precision = 0u; precision <= DBL_DIG; ++precision)
+        {
+            char buffer[detail::double_chars_max];
+            auto length = snprintf(expect, sizeof(expect), "%.*e", int(precision), value);
+            ICY_TEST(detail::double_to_chars(value, float_type_exp, precision, buffer) == size_t(length) &&
+                memcmp(buffer, expect, size_t(length)) == 0);
+            length = snprintf(expect, sizeof(expect), "%.*f", int(precision), value);
+            ICY_TEST(detail::double_to_chars(value, float_type_fixed, precision, buffer) == size_t(length) &&
+                memcmp(buffer, expect, size_t(length)) == 0);
+        }
+    }
+    ICY_ERROR(to_string("%1"_s, str, 0.1F));
+    ICY_TEST(str == "0.100000"_s);
+    ICY_TEST(str.appendf("%1"_s, std::numeric_limits<double>::quiet_NaN()) == invalid);
+    ICY_TEST(str.appendf("%1"_s, std::numeric_limits<double>::infinity()) == invalid);
+    {
+        const auto value = guid::create();
+        string expect;
+        ICY_ERROR(to_string(value, expect));
+        ICY_ERROR(to_string("{%1}"_s, str, value));
+        ICY_TEST(str.bytes().size() == expect.bytes().size() + 2 &&
+            memcmp(str.bytes().data() + 1, expect.bytes().data(), expect.bytes().size()) == 0);
+    }
+
+    //  compiled tables produce the same output as the runtime parser
+    {
+        static constexpr auto format = make_format("[%1] %2: 100%% %3 %1 \xE6\x97\xA5");
+        ICY_TEST(format.valid && format.args == 3);
+        string expect;
+        ICY_ERROR(to_string("[%1] %2: 100%% %3 %1 \xE6\x97\xA5"_s, expect, INT64_MIN, "name"_s, 0.25));
+        ICY_ERROR(to_string(format, str, INT64_MIN, "name"_s, 0.25));
+        ICY_TEST(str == expect);
+        ICY_TEST(str.appendf(format, 1, 2) == invalid);
+
+        static constexpr auto empty = make_format("");
+        ICY_ERROR(to_string(empty, str));
+        ICY_TEST(empty.valid && empty.count == 0 && str.bytes().empty());
+    }
+    //  outside a constant expression an invalid literal yields an invalid table
+    {
+        const auto trailing = make_format("abc%");
+        const auto zero = make_format("%0");
+        ICY_TEST(!trailing.valid && !zero.valid);
+        ICY_TEST(str.appendf(trailing) == invalid && str.appendf(zero, 1) == invalid);
+    }
+    return error_type();
+}
+
+error_type icy::bench_string_appendf() noexcept
+{
+    const auto count = 1'000'000_z;
+    const auto name = "render_transform"_s;
+    string str;
+    string tmp;
+    ICY_ERROR(str.reserve(256));
+
+    //  integers and string arguments take the direct path
+    auto beg = clock_type::now();
+    for (auto k = 0_z; k < count; ++k)
+    {
+        str.clear();
+        ICY_ERROR(str.appendf("[%1] %2: %3 of %4 (%5)"_s, uint64_t(k), name, int32_t(k) - 500, uint32_t(count), name));
+    }
+    ICY_ERROR(test_report("appendf, integers and strings"_s, count, clock_type::now() - beg));
+
+    //  the same format compiled into a segment table
+    static constexpr auto format = make_format("[%1] %2: %3 of %4 (%5)");
+    beg = clock_type::now();
+    for (auto k = 0_z; k < count; ++k)
+    {
+        str.clear();
+        ICY_ERROR(str.appendf(format, uint64_t(k), name, int32_t(k) - 500, uint32_t(count), name));
+    }
+    ICY_ERROR(test_report("appendf, compiled format"_s, count, clock_type::now() - beg));
+
+    //  reference: the same output with one to_string per argument
+    beg = clock_type::now();
+    for (auto k = 0_z; k < count; ++k)
+    {
+        str.clear();
+        ICY_ERROR(str.append("["_s));
+        ICY_ERROR(to_string(uint64_t(k), tmp));
+        ICY_ERROR(str.append(tmp));
+        ICY_ERROR(str.append("] "_s));
+        ICY_ERROR(str.append(name));
+        ICY_ERROR(str.append(": "_s));
+        ICY_ERROR(to_string(int64_t(k) - 500, tmp));
+        ICY_ERROR(str.append(tmp));
+        ICY_ERROR(str.append(" of "_s));
+        ICY_ERROR(to_string(uint64_t(count), tmp));
+        ICY_ERROR(str.append(tmp));
+        ICY_ERROR(str.append(" ("_s));
+        ICY_ERROR(str.append(name));
+        ICY_ERROR(str.append(")"_s));
+    }
+    ICY_ERROR(test_report("to_string + append"_s, count, clock_type::now() - beg));
+
+    beg = clock_type::now();
+    for (auto k = 0_z; k < count; ++k)
+    {
+        char buffer[256];
+        const auto length = snprintf(buffer, sizeof(buffer), "[%llu] %s: %d of %u (%s)", static_cast<unsigned long long>(k),
+            "render_transform", int(k) - 500, unsigned(count), "render_transform");
+        str.clear();
+        ICY_ERROR(str.append(string_view(buffer, size_t(length), string_view::constexpr_tag())));
+    }
+    ICY_ERROR(test_report("snprintf + append"_s, count, clock_type::now() - beg));
+
+    //  doubles are printed in place as well
+    beg = clock_type::now();
+    for (auto k = 0_z; k < count; ++k)
+    {
+        str.clear();
+        ICY_ERROR(str.appendf("%1 = %2"_s, name, double(k) / 8));
+    }
+    ICY_ERROR(test_report("appendf, double"_s, count, clock_type::now() - beg));
+    return error_type();
+}
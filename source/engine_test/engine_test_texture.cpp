@@ -0,0 +1,413 @@
+#include "engine_test.hpp"
+#include <icy_engine/core/icy_array.hpp>
+#include <icy_engine/graphics/icy_render_texture.hpp>
+#include <cmath>
+
+using namespace icy;
+
+ICY_STATIC_NAMESPACE_BEG
+static uint64_t next_random(uint64_t& state) noexcept
+{
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+//  smooth gradients, a hard-edged disc, a checker band and mild noise; alpha ramps across the image
+static error_type texture_test_image(const size_t cols, const size_t rows, matrix<color>& image) noexcept
+{
+    image = matrix<color>(rows, cols);
+    if (image.size() != rows * cols)
+        return make_stdlib_error(std::errc::not_enough_memory);
+    auto state = 0x9E3779B97F4A7C15ull;
+    for (auto y = 0_z; y < rows; ++y)
+    {
+        for (auto x = 0_z; x < cols; ++x)
+        {
+            const auto fx = double(x) / cols;
+            const auto fy = double(y) / rows;
+            auto r = 128 + 100 * std::sin(x * 0.05) * std::cos(y * 0.03);
+            auto g = 255 * fx;
+            auto b = 255 * fy;
+            const auto dx = fx - 0.6;
+            const auto dy = fy - 0.4;
+            if (dx * dx + dy * dy < 0.04)
+            {
+                r = 240;
+                g = 200;
+                b = 40;
+            }
+            if (fy > 0.8 && fy < 0.85 && ((x / 8 + y / 8) & 1))
+                r = g = b = 20;
+            const auto noise = int(next_random(state) % 9) - 4;
+            const auto clamp = [noise](const double value)
+            {
+                return uint8_t(std::min(std::max(int(value) + noise, 0), 255));
+            };
+            image.at(y, x) = color::from_rgba(clamp(r), clamp(g), clamp(b), uint8_t(255 * (1 - (fx + fy) / 2)));
+        }
+    }
+    return error_type();
+}
+
+//  reference decoders written from the format description (D3D10 block layouts)
+static void texture_test_565(const uint16_t value, int32_t (&rgb)[3]) noexcept
+{
+    const auto r = (value >> 11) & 0x1F;
+    const auto g = (value >> 5) & 0x3F;
+    const auto b = value & 0x1F;
+    rgb[0] = (r << 3) | (r >> 2);
+    rgb[1] = (g << 2) | (g >> 4);
+    rgb[2] = (b << 3) | (b >> 2);
+}
+//  "four": BC3 color blocks always use the 4-color palette
+static void texture_test_bc1(const uint8_t* const input, const bool four, color (&block)[16]) noexcept
+{
+    uint16_t c0 = 0;
+    uint16_t c1 = 0;
+    uint32_t bits = 0;
+    memcpy(&c0, input + 0, sizeof(c0));
+    memcpy(&c1, input + 2, sizeof(c1));
+    memcpy(&bits, input + 4, sizeof(bits));
+    int32_t palette[4][3];
+    texture_test_565(c0, palette[0]);
+    texture_test_565(c1, palette[1]);
+    uint8_t alpha[4] = { 255, 255, 255, 255 };
+    for (auto c = 0u; c < 3; ++c)
+    {
+        if (four || c0 > c1)
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c] + 1) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c] + 1) / 3;
+        }
+        else
+        {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        }
+    }
+    if (!four && c0 <= c1)
+        alpha[3] = 0;
+    for (auto k = 0u; k < 16; ++k)
+    {
+        const auto index = (bits >> (2 * k)) & 3;
+        const auto& value = palette[index];
+        block[k] = color::from_rgba(uint8_t(value[0]), uint8_t(value[1]), uint8_t(value[2]), alpha[index]);
+    }
+}
+static void texture_test_bc3(const uint8_t* const input, color (&block)[16]) noexcept
+{
+    texture_test_bc1(input + 8, true, block);
+    const uint32_t a0 = input[0];
+    const uint32_t a1 = input[1];
+    uint32_t palette[8] = { a0, a1 };
+    if (a0 > a1)
+    {
+        for (auto k = 1u; k < 7; ++k)
+            palette[k + 1] = ((7 - k) * a0 + k * a1 + 3) / 7;
+    }
+    else
+    {
+        for (auto k = 1u; k < 5; ++k)
+            palette[k + 1] = ((5 - k) * a0 + k * a1 + 2) / 5;
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+    uint64_t bits = 0;
+    memcpy(&bits, input + 2, 6);
+    for (auto k = 0u; k < 16; ++k)
+        block[k].a = uint8_t(palette[(bits >> (3 * k)) & 7]);
+}
+//  mode 6 only: returns false for any other mode
+static bool texture_test_bc7(const uint8_t* const input, color (&block)[16]) noexcept
+{
+    auto offset = 0u;
+    const auto read = [input, &offset](const uint32_t count)
+    {
+        auto value = 0u;
+        for (auto k = 0u; k < count; ++k, ++offset)
+            value |= uint32_t((input[offset >> 3] >> (offset & 7)) & 1) << k;
+        return value;
+    };
+    auto mode = 0u;
+    while (mode < 8 && !read(1))
+        ++mode;
+    if (mode != 6)
+        return false;
+
+    uint32_t e0[4];
+    uint32_t e1[4];
+    for (auto c = 0u; c < 4; ++c)
+    {
+        e0[c] = read(7) << 1;
+        e1[c] = read(7) << 1;
+    }
+    const auto p0 = read(1);
+    const auto p1 = read(1);
+    static const uint32_t weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+    for (auto k = 0u; k < 16; ++k)
+    {
+        const auto index = read(k ? 4 : 3);
+        uint8_t value[4];
+        for (auto c = 0u; c < 4; ++c)
+            value[c] = uint8_t(((64 - weights[index]) * (e0[c] | p0) + weights[index] * (e1[c] | p1) + 32) >> 6);
+        block[k] = color::from_rgba(value[0], value[1], value[2], value[3]);
+    }
+    return true;
+}
+//  one level back to pixels; false on a block the reference decoder rejects
+static bool texture_test_decode(const render_texture_compress compress, const uint8_t* const bytes, matrix<color>& image) noexcept
+{
+    const auto block_size = compress == render_texture_compress::dds1 ? 8_z : 16_z;
+    const auto blocks_x = (image.cols() + 3) / 4;
+    for (auto block_y = 0_z; block_y < (image.rows() + 3) / 4; ++block_y)
+    {
+        for (auto block_x = 0_z; block_x < blocks_x; ++block_x)
+        {
+            const auto input = bytes + (block_y * blocks_x + block_x) * block_size;
+            color block[16];
+            switch (compress)
+            {
+            case render_texture_compress::dds1:
+                texture_test_bc1(input, false, block);
+                break;
+            case render_texture_compress::dds5:
+                texture_test_bc3(input, block);
+                break;
+            case render_texture_compress::bc7:
+                if (!texture_test_bc7(input, block))
+                    return false;
+                break;
+            default:
+                return false;
+            }
+            for (auto k = 0_z; k < 16; ++k)
+            {
+                const auto row = block_y * 4 + k / 4;
+                const auto col = block_x * 4 + k % 4;
+                if (row < image.rows() && col < image.cols())
+                    image.at(row, col) = block[k];
+            }
+        }
+    }
+    return true;
+}
+//  peak signal to noise ratio in dB over RGB ("alpha" = false) or alpha only
+static double texture_test_psnr(const matrix<color>& lhs, const matrix<color>& rhs, const bool alpha) noexcept
+{
+    auto sum = 0.0;
+    for (auto row = 0_z; row < lhs.rows(); ++row)
+    {
+        for (auto col = 0_z; col < lhs.cols(); ++col)
+        {
+            const auto a = lhs.at(row, col);
+            const auto b = rhs.at(row, col);
+            if (alpha)
+            {
+                sum += double(a.a - b.a) * (a.a - b.a);
+            }
+            else
+            {
+                sum += double(a.r - b.r) * (a.r - b.r) + double(a.g - b.g) * (a.g - b.g) + double(a.b - b.b) * (a.b - b.b);
+            }
+        }
+    }
+    const auto mse = sum / (double(lhs.size()) * (alpha ? 1 : 3));
+    return mse > 0 ? 10 * std::log10(255.0 * 255.0 / mse) : 99.0;
+}
+static uint32_t texture_test_max_error(const color lhs, const color rhs) noexcept
+{
+    const auto delta = [](const uint8_t a, const uint8_t b) { return uint32_t(a > b ? a - b : b - a); };
+    return std::max(std::max(delta(lhs.r, rhs.r), delta(lhs.g, rhs.g)), std::max(delta(lhs.b, rhs.b), delta(lhs.a, rhs.a)));
+}
+static error_type texture_test_roundtrip(render_texture_encoder& encoder, const matrix<color>& image,
+    const render_texture_compress compress, matrix<color>& decoded, bool& valid) noexcept
+{
+    array<uint8_t> bytes;
+    ICY_ERROR(bytes.resize(render_texture_level_size(compress, uint32_t(image.cols()), uint32_t(image.rows()))));
+    ICY_ERROR(encoder.encode(image, compress, bytes.data()));
+    decoded = matrix<color>(image.rows(), image.cols());
+    if (decoded.size() != image.size())
+        return make_stdlib_error(std::errc::not_enough_memory);
+    valid = texture_test_decode(compress, bytes.data(), decoded);
+    return error_type();
+}
+static const char* texture_test_name(const render_texture_compress compress) noexcept
+{
+    switch (compress)
+    {
+    case render_texture_compress::dds1:
+        return "BC1";
+    case render_texture_compress::dds5:
+        return "BC3";
+    case render_texture_compress::bc7:
+        return "BC7";
+    default:
+        return "none";
+    }
+}
+ICY_STATIC_NAMESPACE_END
+
+error_type icy::test_render_texture() noexcept
+{
+    render_texture_encoder encoder;
+    ICY_ERROR(encoder.initialize(1));
+    const render_texture_compress formats[] = { render_texture_compress::dds1, render_texture_compress::dds5, render_texture_compress::bc7 };
+
+    //  a solid block: BC1 / BC3 color within 565 rounding, BC3 alpha exact, BC7 within one step
+    {
+        auto state = 0x2545F4914F6CDD1Dull;
+        for (auto k = 0u; k < 256; ++k)
+        {
+            const auto value = color::from_bgra(uint32_t(next_random(state)));
+            matrix<color> image(4, 4);
+            ICY_TEST(image.size() == 16);
+            for (auto n = 0_z; n < 16; ++n)
+                image.data()[n] = value;
+            for (auto&& compress : formats)
+            {
+                matrix<color> decoded;
+                auto valid = false;
+                ICY_ERROR(texture_test_roundtrip(encoder, image, compress, decoded, valid));
+                ICY_TEST(valid);
+                auto color_error = 0u;
+                for (auto n = 0_z; n < 16; ++n)
+                {
+                    auto pixel = decoded.data()[n];
+                    if (compress != render_texture_compress::bc7)
+                    {
+                        ICY_TEST(compress == render_texture_compress::dds1 ? pixel.a == 255 : pixel.a == value.a);
+                        pixel.a = value.a;
+                    }
+                    color_error = std::max(color_error, texture_test_max_error(pixel, value));
+                }
+                ICY_TEST(color_error <= (compress == render_texture_compress::bc7 ? 1u : 4u));
+            }
+        }
+    }
+    //  a two-color block: BC3 alpha and BC7 reproduce both values exactly
+    {
+        matrix<color> image(4, 4);
+        ICY_TEST(image.size() == 16);
+        for (auto n = 0_z; n < 16; ++n)
+            image.data()[n] = n & 1 ? color::from_rgba(0, 0, 0, 0) : color::from_rgba(254, 254, 254, 254);
+        for (auto&& compress : { render_texture_compress::dds5, render_texture_compress::bc7 })
+        {
+            matrix<color> decoded;
+            auto valid = false;
+            ICY_ERROR(texture_test_roundtrip(encoder, image, compress, decoded, valid));
+            ICY_TEST(valid);
+            for (auto n = 0_z; n < 16; ++n)
+            {
+                ICY_TEST(decoded.data()[n].a == image.data()[n].a);
+                if (compress == render_texture_compress::bc7)
+                    ICY_TEST(decoded.data()[n] == image.data()[n]);
+            }
+        }
+    }
+
+    //  the generated image, including partial edge blocks: quality floors, BC7 beats BC1
+    for (auto&& size : { window_size(256, 256), window_size(70, 37) })
+    {
+        matrix<color> image;
+        ICY_ERROR(texture_test_image(size.x, size.y, image));
+        double psnr_rgb[3] = {};
+        for (auto k = 0_z; k < 3; ++k)
+        {
+            matrix<color> decoded;
+            auto valid = false;
+            ICY_ERROR(texture_test_roundtrip(encoder, image, formats[k], decoded, valid));
+            ICY_TEST(valid);
+            psnr_rgb[k] = texture_test_psnr(image, decoded, false);
+            if (formats[k] != render_texture_compress::dds1)
+                ICY_TEST(texture_test_psnr(image, decoded, true) >= 38);
+        }
+        ICY_TEST(psnr_rgb[0] >= 34 && psnr_rgb[1] >= 34 && psnr_rgb[2] >= 35);
+        ICY_TEST(psnr_rgb[1] == psnr_rgb[0]);   //  same color encoder
+        ICY_TEST(psnr_rgb[2] > psnr_rgb[0]);
+    }
+
+    //  worker threads produce the same bytes as the calling thread alone; the mip chain is back to back
+    {
+        matrix<color> image;
+        ICY_ERROR(texture_test_image(300, 200, image));
+        render_texture_encoder threaded;
+        ICY_ERROR(threaded.initialize(4));
+        for (auto&& compress : formats)
+        {
+            render_texture_options options;
+            options.compress = compress;
+            render_texture single;
+            render_texture multi;
+            ICY_ERROR(encoder.encode(image, options, single));
+            ICY_ERROR(threaded.encode(image, options, multi));
+            ICY_TEST(single.bytes.size() == multi.bytes.size() && memcmp(single.bytes.data(), multi.bytes.data(), single.bytes.size()) == 0);
+            ICY_TEST(single.levels == 9 && single.size.x == 300 && single.size.y == 200);
+
+            auto width = 300u;
+            auto height = 200u;
+            auto offset = 0_z;
+            for (auto level = 0u; level < single.levels; ++level)
+            {
+                matrix<color> decoded(height, width);
+                ICY_TEST(decoded.size() == size_t(width) * height);
+                ICY_TEST(texture_test_decode(compress, single.bytes.data() + offset, decoded));
+                offset += render_texture_level_size(compress, width, height);
+                width = std::max(width / 2, 1u);
+                height = std::max(height / 2, 1u);
+            }
+            ICY_TEST(offset == single.bytes.size());
+        }
+    }
+    return error_type();
+}
+
+//  Mpix/s and quality per format on a 2048x2048 generated image, one thread and all cores
+error_type icy::bench_render_texture() noexcept
+{
+    matrix<color> image;
+    ICY_ERROR(texture_test_image(2048, 2048, image));
+    const auto pixels = image.size();
+
+    for (auto&& compress : { render_texture_compress::dds1, render_texture_compress::dds5, render_texture_compress::bc7 })
+    {
+        const auto format = texture_test_name(compress);
+        array<uint8_t> bytes;
+        ICY_ERROR(bytes.resize(render_texture_level_size(compress, uint32_t(image.cols()), uint32_t(image.rows()))));
+        for (auto&& threads : { 1_z, 0_z })
+        {
+            render_texture_encoder encoder;
+            ICY_ERROR(encoder.initialize(threads));
+            const auto beg = clock_type::now();
+            ICY_ERROR(encoder.encode(image, compress, bytes.data()));
+            const auto time = clock_type::now() - beg;
+
+            string str;
+            ICY_ERROR(to_string("texture %1, 2048x2048, %2 threads: %3 Mpix/s"_s, str,
+                string_view(format, strlen(format), string_view::constexpr_tag()), uint64_t(threads ? threads : thread::cores()),
+                double(pixels) / 1e6 / std::chrono::duration<double>(time).count()));
+            ICY_ERROR(test_report(str, pixels, time));
+        }
+
+        matrix<color> decoded(image.rows(), image.cols());
+        ICY_TEST(decoded.size() == pixels && texture_test_decode(compress, bytes.data(), decoded));
+        string str;
+        ICY_ERROR(to_string("texture %1: PSNR rgb %2 dB, alpha %3 dB"_s, str,
+            string_view(format, strlen(format), string_view::constexpr_tag()),
+            texture_test_psnr(image, decoded, false), texture_test_psnr(image, decoded, true)));
+        ICY_ERROR(test_print(str));
+    }
+
+    //  mip chain filtering alone
+    for (auto&& filter : { render_texture_filter::box, render_texture_filter::kaiser })
+    {
+        render_texture_options options;
+        options.filter = filter;
+        array<matrix<color>> mips;
+        const auto beg = clock_type::now();
+        ICY_ERROR(render_texture_mips(image, options, mips));
+        const auto time = clock_type::now() - beg;
+        ICY_ERROR(test_report(filter == render_texture_filter::box ? "texture mips, box, 2048x2048"_s : "texture mips, kaiser, 2048x2048"_s, pixels, time));
+    }
+    return error_type();
+}
@@ -147,7 +147,7 @@ error_type main_func()
     ICY_ERROR(create_gui_system(gui_system, adapter));
     ICY_ERROR(gui_system->thread().launch());
     ICY_ERROR(gui_system->thread().rename("GUI Thread"_s));
-    
+
     array<char> bytes;
     {
         icy::file f1;
@@ -168,7 +168,9 @@ error_type main_func()
     ICY_ERROR(model->insert(gui_node(), 1, 0, root1));
 
     size_t index = 0;
+    ICY_ERROR(model->begin());
     ICY_ERROR(append_nodes(*model, root1, ""_s, 0, index));
+    ICY_ERROR(model->commit());
 
     gui_node tab_0;
     gui_node tab_1;
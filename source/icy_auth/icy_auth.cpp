@@ -413,6 +413,7 @@ struct internal_message
     string address;
     auth_clock::duration timeout = {};
     crypto_msg<auth_client_ticket_server> encrypted_server_ticket;
+    promise<auth_event> result;     //  empty: broadcast the result
 };
 class auth_system_data : public auth_system
 {
@@ -437,6 +438,8 @@ private:
     error_type connect(const string_view hostname, const duration_type timeout) noexcept override;
     error_type client_create(const guid guid, const uint64_t username, const crypto_key& password) noexcept override;
     error_type client_ticket(const guid guid, const uint64_t username, const crypto_key& password) noexcept override;
+    error_type client_ticket(const guid guid, const uint64_t username, const crypto_key& password, future<auth_event>& future) noexcept override;
+    error_type client_ticket(const guid guid, const uint64_t username, const crypto_key& password, promise<auth_event>&& result) noexcept;
     error_type client_connect(const guid guid, const uint64_t username, const crypto_key& password, const uint64_t module, const crypto_msg<auth_client_ticket_server>& encrypted_server_ticket) noexcept override;
     error_type module_create(const guid guid, const uint64_t module) noexcept override;
     error_type module_update(const guid guid, const uint64_t module, const string_view address, const auth_clock::duration timeout, const crypto_key& password) noexcept override;
@@ -467,10 +470,25 @@ error_type auth_system_data::exec() noexcept
     shared_ptr<network_system_http_client> network;
 
 
-    using pair_type = std::pair<auth_request, crypto_key>;
-    icy::mpsc_queue<pair_type> requests_queue;
-    pair_type current_request;
-    
+    struct request_type
+    {
+        auth_request request;
+        crypto_key password;
+        promise<auth_event> result;
+    };
+    icy::mpsc_queue<request_type> requests_queue;
+    request_type current_request;
+
+    //  to the caller's future if it passed one, else broadcast
+    const auto complete = [&](auth_event&& new_event)
+    {
+        if (current_request.result)
+        {
+            current_request.result.set_value(std::move(new_event));
+            return error_type();
+        }
+        return event::post(this, auth_event_type, std::move(new_event));
+    };
     const auto func = [&]
     {
         if (network)
@@ -481,7 +499,7 @@ error_type auth_system_data::exec() noexcept
         hrequest.content = http_content_type::application_json;
 
         icy::json json;
-        ICY_ERROR(current_request.first.to_json(json));
+        ICY_ERROR(current_request.request.to_json(json));
         string str;
         ICY_ERROR(to_string(json, str));
         ICY_ERROR(hrequest.body.assign(str.ubytes()));
@@ -493,10 +511,10 @@ error_type auth_system_data::exec() noexcept
         if (!network)
         {
             auth_event new_event;
-            new_event.type = current_request.first.type;
-            new_event.guid = current_request.first.guid;
+            new_event.type = current_request.request.type;
+            new_event.guid = current_request.request.guid;
             new_event.error = make_stdlib_error(std::errc::host_unreachable);
-            ICY_ERROR(event::post(this, auth_event_type, std::move(new_event)));
+            ICY_ERROR(complete(std::move(new_event)));
             return error_type();
         }
         ICY_ERROR(network->thread().launch());
@@ -566,11 +584,15 @@ error_type auth_system_data::exec() noexcept
                     break;
                 }
                 }
-                ICY_ERROR(requests_queue.push(std::make_pair(std::move(new_request), event_data.password)));
+                request_type next_request;
+                next_request.request = std::move(new_request);
+                next_request.password = event_data.password;
+                next_request.result = std::move(event_data.result);
+                ICY_ERROR(requests_queue.push(std::move(next_request)));
                 if (network)
                     continue;
 
-                if (!current_request.first.guid)
+                if (!current_request.request.guid)
                 {
                     if (requests_queue.pop(current_request))
                         ICY_ERROR(func());
@@ -583,11 +605,11 @@ error_type auth_system_data::exec() noexcept
                 network = nullptr;
                 const auto& event_data = event->data<network_event>();
                 auth_event new_event;
-                new_event.type = current_request.first.type;
-                new_event.guid = current_request.first.guid;
+                new_event.type = current_request.request.type;
+                new_event.guid = current_request.request.guid;
                 new_event.error = event_data.error;
-                ICY_ERROR(event::post(this, auth_event_type, std::move(new_event)));
-                current_request = pair_type();
+                ICY_ERROR(complete(std::move(new_event)));
+                current_request = request_type();
             }
             else if (event->type == event_type::network_recv)
             {
@@ -595,9 +617,9 @@ error_type auth_system_data::exec() noexcept
                     continue;
                 network = nullptr;
                 const auto& event_data = event->data<network_event>();
-                if (current_request.first.guid)
+                if (current_request.request.guid)
                 {
-                    const auto& request = current_request.first;
+                    const auto& request = current_request.request;
                     auth_event new_event;
                     new_event.type = request.type;
                     new_event.guid = request.guid;
@@ -638,7 +660,7 @@ error_type auth_system_data::exec() noexcept
                             if (!new_event.error) new_event.error = data.from_json(response.message);
                             if (!new_event.error)
                             {
-                                if (const auto error = data.encrypted_client_ticket.decode(current_request.second, new_event.client_ticket))
+                                if (const auto error = data.encrypted_client_ticket.decode(current_request.password, new_event.client_ticket))
                                     new_event.error = make_auth_error(auth_error_code::client_invalid_password);
                                 else
                                     new_event.encrypted_server_ticket = data.encrypted_server_ticket;
@@ -651,7 +673,7 @@ error_type auth_system_data::exec() noexcept
                             if (!new_event.error) new_event.error = data.from_json(response.message);
                             if (!new_event.error)
                             {
-                                if (const auto error = data.encrypted_client_connect.decode(current_request.second, new_event.client_connect))
+                                if (const auto error = data.encrypted_client_connect.decode(current_request.password, new_event.client_connect))
                                     new_event.error = make_auth_error(auth_error_code::client_invalid_password);
                                 else
                                     new_event.encrypted_module_connect = data.encrypted_module_connect;
@@ -669,8 +691,8 @@ error_type auth_system_data::exec() noexcept
                     {
                         new_event.error = make_unexpected_error();
                     }
-                    ICY_ERROR(event::post(this, auth_event_type, std::move(new_event)));
-                    current_request = pair_type();
+                    ICY_ERROR(complete(std::move(new_event)));
+                    current_request = request_type();
                 }
                 else
                 {
@@ -718,6 +740,16 @@ error_type auth_system_data::client_create(const guid guid, const uint64_t usern
     return event_system::post(nullptr, event_type::system_internal, std::move(msg));
 }
 error_type auth_system_data::client_ticket(const guid guid, const uint64_t username, const crypto_key& password) noexcept
+{
+    return client_ticket(guid, username, password, promise<auth_event>());
+}
+error_type auth_system_data::client_ticket(const guid guid, const uint64_t username, const crypto_key& password, future<auth_event>& future) noexcept
+{
+    promise<auth_event> result;
+    ICY_ERROR(result.initialize(future));
+    return client_ticket(guid, username, password, std::move(result));
+}
+error_type auth_system_data::client_ticket(const guid guid, const uint64_t username, const crypto_key& password, promise<auth_event>&& result) noexcept
 {
     if (!guid || !username)
         return make_stdlib_error(std::errc::invalid_argument);
@@ -726,6 +758,7 @@ error_type auth_system_data::client_ticket(const guid guid, const uint64_t usern
     msg.type = auth_request_type::client_ticket;
     msg.username = username;
     msg.password = password;
+    msg.result = std::move(result);
     return event_system::post(nullptr, event_type::system_internal, std::move(msg));
 }
 error_type auth_system_data::client_connect(const guid guid, const uint64_t username, const crypto_key& password, const uint64_t module, const crypto_msg<auth_client_ticket_server>& encrypted_server_ticket) noexcept
@@ -0,0 +1,213 @@
+#pragma once
+
+#include <icy_engine/core/icy_array.hpp>
+#include <icy_engine/core/icy_atomic.hpp>
+#include <icy_engine/core/icy_hash.hpp>
+#include <icy_engine/core/icy_smart_pointer.hpp>
+#include <icy_auth/icy_auth.hpp>
+
+using icy::operator""_s;
+using icy::operator""_z;
+
+//  sharded fixed-size cache of read-mostly records in front of LMDB.
+//  A key hashes to one shard and a window of "probe" slots inside it; a full window
+//  evicts the entry closest to expiry. Lookups and inserts never allocate.
+//  Generations are kept per home slot, so "erase" only drops concurrent inserts of keys sharing it.
+template<typename T>
+class auth_cache
+{
+public:
+    enum : size_t
+    {
+        shard_count = 16,
+        probe = 8,
+    };
+public:
+    icy::error_type initialize(const size_t capacity) noexcept;
+    //  snapshot before reading the database: "insert" drops the record if "erase" (of this key) or "clear" ran since
+    uint64_t generation(const uint64_t key) const noexcept;
+    bool find(const uint64_t key, T& value, const icy::auth_clock::time_point now) noexcept;
+    void insert(const uint64_t key, const T& value, const icy::auth_clock::time_point expire, const uint64_t generation) noexcept;
+    void erase(const uint64_t key) noexcept;
+    void clear() noexcept;
+    icy::error_type status(icy::string& msg) const noexcept;
+private:
+    struct entry_type
+    {
+        entry_type() noexcept
+        {
+
+        }
+        uint64_t key = 0;
+        icy::auth_clock::time_point expire;
+        T value;
+        bool used = false;
+    };
+    struct shard_type
+    {
+        mutable icy::mutex lock;
+        icy::array<entry_type> entries;
+        icy::array<uint64_t> generations;   //  by home slot
+        size_t size = 0;
+    };
+private:
+    shard_type& shard(const uint64_t hash) noexcept
+    {
+        return *m_shards[size_t(hash >> 60) % shard_count];
+    }
+    const shard_type& shard(const uint64_t hash) const noexcept
+    {
+        return *m_shards[size_t(hash >> 60) % shard_count];
+    }
+private:
+    icy::array<icy::unique_ptr<shard_type>> m_shards;
+    size_t m_mask = 0;  //  per-shard slot count - 1
+    std::atomic<uint64_t> m_hits = 0;
+    std::atomic<uint64_t> m_misses = 0;
+    std::atomic<uint64_t> m_evictions = 0;
+};
+
+template<typename T>
+inline icy::error_type auth_cache<T>::initialize(const size_t capacity) noexcept
+{
+    auto slots = size_t(probe);
+    while (slots * shard_count < capacity)
+        slots *= 2;
+
+    m_shards.clear();
+    ICY_ERROR(m_shards.reserve(shard_count));
+    for (auto k = 0_z; k < shard_count; ++k)
+    {
+        auto shard = icy::make_unique<shard_type>();
+        if (!shard)
+            return icy::make_stdlib_error(std::errc::not_enough_memory);
+        ICY_ERROR(shard->lock.initialize());
+        ICY_ERROR(shard->entries.resize(slots));
+        ICY_ERROR(shard->generations.resize(slots));
+        ICY_ERROR(m_shards.push_back(std::move(shard)));
+    }
+    m_mask = slots - 1;
+    return icy::error_type();
+}
+template<typename T>
+inline uint64_t auth_cache<T>::generation(const uint64_t key) const noexcept
+{
+    if (m_shards.empty())
+        return 0;
+
+    const auto hash = icy::hash_mix(key);
+    const auto& shard = this->shard(hash);
+    ICY_LOCK_GUARD(shard.lock);
+    return shard.generations[hash & m_mask];
+}
+template<typename T>
+inline bool auth_cache<T>::find(const uint64_t key, T& value, const icy::auth_clock::time_point now) noexcept
+{
+    if (m_shards.empty())
+        return false;
+
+    const auto hash = icy::hash_mix(key);
+    auto& shard = this->shard(hash);
+    ICY_LOCK_GUARD(shard.lock);
+    for (auto k = 0_z; k < probe; ++k)
+    {
+        auto& entry = shard.entries[(hash + k) & m_mask];
+        if (!entry.used || entry.key != key)
+            continue;
+
+        if (entry.expire > now)
+        {
+            value = entry.value;
+            m_hits.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+        entry.used = false;
+        shard.size -= 1;
+        break;
+    }
+    m_misses.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+template<typename T>
+inline void auth_cache<T>::insert(const uint64_t key, const T& value, const icy::auth_clock::time_point expire, const uint64_t generation) noexcept
+{
+    if (m_shards.empty())
+        return;
+
+    const auto hash = icy::hash_mix(key);
+    auto& shard = this->shard(hash);
+    ICY_LOCK_GUARD(shard.lock);
+    if (generation != shard.generations[hash & m_mask])
+        return;
+
+    entry_type* slot = nullptr;
+    for (auto k = 0_z; k < probe; ++k)
+    {
+        auto& entry = shard.entries[(hash + k) & m_mask];
+        if (entry.used && entry.key == key)
+        {
+            slot = &entry;
+            break;
+        }
+        if (!slot || (slot->used && (!entry.used || entry.expire < slot->expire)))
+            slot = &entry;
+    }
+    if (!slot->used)
+        shard.size += 1;
+    else if (slot->key != key)
+        m_evictions.fetch_add(1, std::memory_order_relaxed);
+
+    slot->key = key;
+    slot->expire = expire;
+    slot->value = value;
+    slot->used = true;
+}
+template<typename T>
+inline void auth_cache<T>::erase(const uint64_t key) noexcept
+{
+    if (m_shards.empty())
+        return;
+
+    const auto hash = icy::hash_mix(key);
+    auto& shard = this->shard(hash);
+    ICY_LOCK_GUARD(shard.lock);
+    shard.generations[hash & m_mask] += 1;
+    for (auto k = 0_z; k < probe; ++k)
+    {
+        auto& entry = shard.entries[(hash + k) & m_mask];
+        if (entry.used && entry.key == key)
+        {
+            entry.used = false;
+            shard.size -= 1;
+        }
+    }
+}
+template<typename T>
+inline void auth_cache<T>::clear() noexcept
+{
+    for (auto&& shard : m_shards)
+    {
+        ICY_LOCK_GUARD(shard->lock);
+        for (auto&& generation : shard->generations)
+            generation += 1;
+        for (auto&& entry : shard->entries)
+            entry.used = false;
+        shard->size = 0;
+    }
+}
+template<typename T>
+inline icy::error_type auth_cache<T>::status(icy::string& msg) const noexcept
+{
+    auto size = 0_z;
+    for (auto&& shard : m_shards)
+    {
+        ICY_LOCK_GUARD(shard->lock);
+        size += shard->size;
+    }
+    const auto hits = m_hits.load(std::memory_order_relaxed);
+    const auto misses = m_misses.load(std::memory_order_relaxed);
+    const auto rate = hits + misses ? 100.0 * double(hits) / double(hits + misses) : 0.0;
+    ICY_ERROR(msg.appendf("entries %1 / %2, hits %3, misses %4, hit rate %5 pct, evictions %6"_s,
+        size, m_shards.size() * (m_mask + 1), hits, misses, rate, m_evictions.load(std::memory_order_relaxed)));
+    return icy::error_type();
+}
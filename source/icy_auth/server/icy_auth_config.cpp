@@ -12,6 +12,8 @@ error_type auth_config_dbase::from_json(const json& input) noexcept
     auto timeout_sec = 0u;    
     ICY_ERROR(input.get(key::timeout, timeout_sec));
     timeout = std::chrono::seconds(timeout_sec);
+    input.get(key::cache, cache);
+    if (!cache) cache = std::min(clients, 0x10000_z);
     return error_type();
 }
 error_type auth_config_dbase::to_json(json& output) const noexcept
@@ -22,6 +24,7 @@ error_type auth_config_dbase::to_json(json& output) const noexcept
     ICY_ERROR(output.insert(key::clients, json_type_integer(clients)));
     ICY_ERROR(output.insert(key::modules, json_type_integer(modules)));
     ICY_ERROR(output.insert(key::timeout, std::chrono::duration_cast<std::chrono::seconds>(timeout).count()));
+    ICY_ERROR(output.insert(key::cache, json_type_integer(cache)));
     return error_type();
 }
 error_type auth_config_dbase::copy(const auth_config_dbase& src, auth_config_dbase& dst) noexcept
@@ -31,6 +34,7 @@ error_type auth_config_dbase::copy(const auth_config_dbase& src, auth_config_dba
     dst.timeout = src.timeout;
     dst.clients = src.clients;
     dst.modules = src.modules;
+    dst.cache = src.cache;
     return error_type();
 }
 
@@ -127,6 +131,9 @@ error_type auth_config::from_json(const json& input) noexcept
     input.get(key::gheap_size, gheap_size);
     if (!gheap_size) gheap_size = default_values::gheap_size;
 
+    input.get(key::workers, workers);
+    if (!workers) workers = std::max(thread::cores(), 2_z) - 1;
+
     return error_type();
 }
 error_type auth_config::to_json(json& output) const noexcept
@@ -145,11 +152,13 @@ error_type auth_config::to_json(json& output) const noexcept
     ICY_ERROR(output.insert(key::module, std::move(json_module)));
     ICY_ERROR(output.insert(key::admin, std::move(json_admin)));
     ICY_ERROR(output.insert(key::gheap_size, gheap_size));
+    ICY_ERROR(output.insert(key::workers, workers));
     return error_type();
 }
 error_type auth_config::copy(const auth_config& src, auth_config& dst) noexcept
 {
     dst.gheap_size = src.gheap_size;
+    dst.workers = src.workers;
     ICY_ERROR(auth_config_dbase::copy(src.dbase, dst.dbase));
     ICY_ERROR(auth_config_network::copy(src.client, dst.client));
     ICY_ERROR(auth_config_network::copy(src.module, dst.module));
@@ -38,6 +38,7 @@ public:
         static constexpr icy::string_view timeout = "timeout"_s;
         static constexpr icy::string_view clients = "clients"_s;
         static constexpr icy::string_view modules = "modules"_s;
+        static constexpr icy::string_view cache = "cache"_s;    //  integer (records per cache, 0 = min(clients, 64k))
     };
 public:
     icy::error_type from_json(const icy::json& input) noexcept;
@@ -49,6 +50,7 @@ public:
     icy::auth_clock::duration timeout = {};
     size_t clients = 0;
     size_t modules = 0;
+    size_t cache = 0;
 };
 
 class auth_config
@@ -66,6 +68,7 @@ public:
         static constexpr icy::string_view client = "client"_s;
         static constexpr icy::string_view module = "module"_s;
         static constexpr icy::string_view admin = "admin"_s;
+        static constexpr icy::string_view workers = "workers"_s;   //  integer (reader threads, 0 = cores - 1)
     };
 public:
     icy::error_type from_json(const icy::json& input) noexcept;
@@ -73,6 +76,7 @@ public:
     static icy::error_type copy(const auth_config& src, auth_config& dst) noexcept;
 public:
     size_t gheap_size = 0;
+    size_t workers = 0;
     auth_config_dbase dbase;
     auth_config_network client;
     auth_config_network module;
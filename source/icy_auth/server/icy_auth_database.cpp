@@ -18,6 +18,17 @@ static error_type save_date_time(char (&str)[auth_date_length]) noexcept
     strftime(str, _countof(str), "%F %T", &time);
     return error_type();
 }
+static uint64_t auth_session_version(const auth_client_data& client, const auth_module_data& module) noexcept
+{
+    hasher hash;
+    hash.append(client.password.data(), client.password.size());
+    hash.append(&client.guid, sizeof(client.guid));
+    hash.append(module.password.data(), module.password.size());
+    hash.append(&module.guid, sizeof(module.guid));
+    hash.append(module.addr, sizeof(module.addr));
+    hash.append(&module.timeout, sizeof(module.timeout));
+    return hash.finish64();
+}
 
 error_type auth_database::initialize(const auth_config_dbase& config) noexcept
 {
@@ -38,8 +49,42 @@ error_type auth_database::initialize(const auth_config_dbase& config) noexcept
     m_max_clients = config.clients;
     m_max_modules = config.modules;
     m_timeout = config.timeout;
+
+    ICY_ERROR(m_cache_usr.initialize(config.cache));
+    ICY_ERROR(m_cache_mod.initialize(std::min(config.cache, config.modules)));
+    ICY_ERROR(m_cache_ses.initialize(config.cache));
     return {};
 }
+error_type auth_database::find(const uint64_t key, auth_client_data& value) noexcept
+{
+    if (m_cache_usr.find(key, value, auth_clock::now()))
+        return error_type();
+
+    const auto generation = m_cache_usr.generation(key);
+    database_txn_read txn;
+    database_cursor_read cur;
+    ICY_ERROR(txn.initialize(m_data));
+    ICY_ERROR(cur.initialize(txn, m_dbi_usr));
+    auto tmp = key;
+    ICY_ERROR(cur.get_type_by_type(tmp, value, database_oper_read::none));
+    m_cache_usr.insert(key, value, auth_clock::now() + m_timeout, generation);
+    return error_type();
+}
+error_type auth_database::find(const uint64_t key, auth_module_data& value) noexcept
+{
+    if (m_cache_mod.find(key, value, auth_clock::now()))
+        return error_type();
+
+    const auto generation = m_cache_mod.generation(key);
+    database_txn_read txn;
+    database_cursor_read cur;
+    ICY_ERROR(txn.initialize(m_data));
+    ICY_ERROR(cur.initialize(txn, m_dbi_mod));
+    auto tmp = key;
+    ICY_ERROR(cur.get_type_by_type(tmp, value, database_oper_read::none));
+    m_cache_mod.insert(key, value, auth_clock::now() + std::chrono::milliseconds(value.timeout), generation);
+    return error_type();
+}
 error_type auth_database::query(const auth_query_flag flags, auth_query_callback& callback) const noexcept
 {
     database_txn_read txn;
@@ -226,18 +271,13 @@ error_type auth_database::exec(const auth_request& request, const auth_request_m
         }
     }
     ICY_ERROR(txn.commit());
+    m_cache_usr.erase(key);
     return error_type();
 }
 error_type auth_database::exec(const auth_request& request, const auth_request_msg_client_ticket& input, auth_response_msg_client_ticket& output) noexcept
 {
-    database_txn_read txn;
-    database_cursor_read cur;
-    ICY_ERROR(txn.initialize(m_data));
-    ICY_ERROR(cur.initialize(txn, m_dbi_usr));
-
-    auto key = request.username;
     auth_client_data val;
-    if (const auto error = cur.get_type_by_type(key, val, database_oper_read::none))
+    if (const auto error = find(request.username, val))
     {
         if (error == database_error_not_found)
             return make_auth_error(auth_error_code::client_not_found);
@@ -269,30 +309,45 @@ error_type auth_database::exec(const auth_request& request, const auth_request_m
     if (now > ticket.expire)
         return make_auth_error(auth_error_code::client_expired_ticket);
 
-    const auto session = crypto_key(crypto_random);
-
-    database_txn_read txn;
-    database_cursor_read cur_client;
-    database_cursor_read cur_module;
-    ICY_ERROR(txn.initialize(m_data));
-    ICY_ERROR(cur_client.initialize(txn, m_dbi_usr));
-    ICY_ERROR(cur_module.initialize(txn, m_dbi_mod));
-
     auth_module_data module;
     auth_client_data client;
-    auto key_module = input.module;
-    auto key_client = request.username;
+    if (const auto error = find(input.module, module))
+    {
+        if (error == database_error_not_found)
+            return make_auth_error(auth_error_code::client_invalid_module);
+        ICY_ERROR(error);
+    }
+    if (const auto error = find(request.username, client))
+    {
+        if (error == database_error_not_found)
+            return make_auth_error(auth_error_code::client_not_found);
+        ICY_ERROR(error);
+    }
 
-    if (const auto error = cur_module.get_type_by_type(key_module, module, database_oper_read::none))
-        return make_auth_error(auth_error_code::client_invalid_module);
-    if (const auto error = cur_client.get_type_by_type(key_client, client, database_oper_read::none))
-        return make_auth_error(auth_error_code::client_not_found);
+    //  a repeated connect to the same module reuses the live session; the key includes the
+    //  records' version, so a module update or a recreated client never gets an old session
+    const auto version = auth_session_version(client, module);
+    const auto session_key = hash_value(request.username, input.module, version);
+    auth_session_data session;
+    if (m_cache_ses.find(session_key, session, now)
+        && session.username == request.username && session.module == input.module && session.version == version)
+        ;
+    else
+    {
+        const auto timeout = std::chrono::milliseconds(module.timeout);
+        session.username = request.username;
+        session.module = input.module;
+        session.version = version;
+        session.session = crypto_random;
+        session.expire = now + timeout;
+        m_cache_ses.insert(session_key, session, now + timeout / 2, m_cache_ses.generation(session_key));
+    }
 
     auth_client_connect_client connect_client;
     auth_client_connect_module connect_module;
     memcpy(connect_client.address, module.addr, auth_addr_length);
-    connect_client.expire = connect_module.expire = now + std::chrono::milliseconds(module.timeout);
-    connect_client.session = connect_module.session = session;
+    connect_client.expire = connect_module.expire = session.expire;
+    connect_client.session = connect_module.session = session.session;
     connect_module.userguid = client.guid;
     output.encrypted_client_connect = crypto_msg<auth_client_connect_client>(client.password, connect_client);
     output.encrypted_module_connect = crypto_msg<auth_client_connect_module>(module.password, connect_module);
@@ -322,6 +377,7 @@ error_type auth_database::exec(const auth_request&, const auth_request_msg_modul
         }
     }
     ICY_ERROR(txn.commit());
+    m_cache_mod.erase(key);
     return error_type();
 }
 error_type auth_database::exec(const auth_request&, const auth_request_msg_module_update& input, auth_response_msg_module_update&) noexcept
@@ -329,12 +385,12 @@ error_type auth_database::exec(const auth_request&, const auth_request_msg_modul
     database_txn_write txn;
     ICY_ERROR(txn.initialize(m_data));
 
+    auto key = input.module;
     {
         database_cursor_write cur;
         ICY_ERROR(cur.initialize(txn, m_dbi_mod));
 
         auth_module_data edit_module;
-        auto key = input.module;
         if (const auto error = cur.get_type_by_type(key, edit_module, database_oper_read::none))
         {
             if (error == database_error_not_found)
@@ -346,6 +402,7 @@ error_type auth_database::exec(const auth_request&, const auth_request_msg_modul
         ICY_ERROR(cur.put_type_by_type(key, database_oper_write::none, edit_module));
     }
     ICY_ERROR(txn.commit());
+    m_cache_mod.erase(key);
     return error_type();
 }
 error_type auth_database::clear_clients() noexcept
@@ -354,6 +411,8 @@ error_type auth_database::clear_clients() noexcept
     ICY_ERROR(txn.initialize(m_data));
     ICY_ERROR(m_dbi_usr.clear(txn));
     ICY_ERROR(txn.commit());
+    m_cache_usr.clear();
+    m_cache_ses.clear();
     return error_type();
 }
 error_type auth_database::clear_modules() noexcept
@@ -362,5 +421,17 @@ error_type auth_database::clear_modules() noexcept
     ICY_ERROR(txn.initialize(m_data));
     ICY_ERROR(m_dbi_mod.clear(txn));
     ICY_ERROR(txn.commit());
+    m_cache_mod.clear();
+    m_cache_ses.clear();
+    return error_type();
+}
+error_type auth_database::status(string& msg) const noexcept
+{
+    ICY_ERROR(msg.append("\r\n  Clients : "_s));
+    ICY_ERROR(m_cache_usr.status(msg));
+    ICY_ERROR(msg.append("\r\n  Modules : "_s));
+    ICY_ERROR(m_cache_mod.status(msg));
+    ICY_ERROR(msg.append("\r\n  Sessions: "_s));
+    ICY_ERROR(m_cache_ses.status(msg));
     return error_type();
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include <icy_auth/icy_auth.hpp>
 #include <icy_engine/utility/icy_database.hpp>
+#include "icy_auth_cache.hpp"
 
 static constexpr auto auth_date_length = sizeof("YYYY-MM-DD HH:MM:SS");
 class auth_config_dbase;
@@ -20,6 +21,14 @@ struct auth_module_data
     char addr[icy::auth_addr_length] = {};
     uint32_t timeout = 0;
 };
+struct auth_session_data
+{
+    uint64_t username = 0;
+    uint64_t module = 0;
+    uint64_t version = 0;   //  client and module records the session was issued for
+    icy::crypto_key session;
+    icy::auth_clock::time_point expire;
+};
 enum class auth_query_flag : uint32_t
 {
     none = 0x00,
@@ -76,7 +85,10 @@ public:
     icy::error_type query(const auth_query_flag flags, auth_query_callback& callback) const noexcept;
     icy::error_type clear_clients() noexcept;
     icy::error_type clear_modules() noexcept;
+    icy::error_type status(icy::string& msg) const noexcept;
 private:
+    icy::error_type find(const uint64_t key, auth_client_data& value) noexcept;
+    icy::error_type find(const uint64_t key, auth_module_data& value) noexcept;
     icy::error_type exec(const icy::auth_request& request, const icy::auth_request_msg_client_create& input, icy::auth_response_msg_client_create& output) noexcept;
     icy::error_type exec(const icy::auth_request& request, const icy::auth_request_msg_client_ticket& input, icy::auth_response_msg_client_ticket& output) noexcept;
     icy::error_type exec(const icy::auth_request& request, const icy::auth_request_msg_client_connect& input, icy::auth_response_msg_client_connect& output) noexcept;
@@ -90,4 +102,7 @@ private:
     size_t m_max_modules = 0;
     std::chrono::system_clock::duration m_timeout = {};
     icy::crypto_key m_password = icy::crypto_random;
+    auth_cache<auth_client_data> m_cache_usr;
+    auth_cache<auth_module_data> m_cache_mod;
+    auth_cache<auth_session_data> m_cache_ses;  //  (username, module, version) -> session reused while in first half of its life
 };
\ No newline at end of file
@@ -4,6 +4,9 @@
 
 using namespace icy;
 
+//  "reply" is called by every worker of every network system (they may share a log file)
+static mutex g_log_lock;
+
 error_type auth_network_system::initialize(const auth_config_network& config, const size_t cores, const const_array_view<auth_request_type> types) noexcept
 {
     ICY_ERROR(auth_config_network::copy(config, m_config));
@@ -42,10 +45,20 @@ error_type auth_network_system::status(string& msg) const noexcept
 }
 error_type auth_network_system::process(const string_view str_request, const network_address& address, json& json_output) noexcept
 {
-    error_type error;
+    auth_request auth_request;
+    auto error = parse(str_request, auth_request);
+
+    auth_response auth_response(auth_request);
+    if (!error)
+        error = m_dbase.exec(auth_request, auth_response);
 
+    ICY_ERROR(reply(auth_request, address, error, auth_response, json_output));
+    return error;
+}
+error_type auth_network_system::parse(const string_view str_request, auth_request& auth_request) const noexcept
+{
+    error_type error;
     json json_request;
-    auth_request auth_request;
 
     if (!error)
         error = to_value(str_request, json_request);
@@ -55,7 +68,6 @@ error_type auth_network_system::process(const string_view str_request, const net
     if (!error)
         error = auth_request.from_json(json_request);
 
-    auth_response auth_response(auth_request);
     if (!error)
     {
         const auto found = std::find(m_types.begin(), m_types.end(), auth_request.type);
@@ -68,30 +80,22 @@ error_type auth_network_system::process(const string_view str_request, const net
         if (auth_request.time > now || auth_request.time < now - m_config.http.timeout)
             error = make_auth_error(auth_error_code::timeout);
     }
-    if (!error)
-        error = m_dbase.exec(auth_request, auth_response);
-
+    return error;
+}
+error_type auth_network_system::reply(const auth_request& auth_request, const network_address& address, 
+    const error_type error, auth_response& auth_response, json& json_output) const noexcept
+{
     if (!error || error.source == error_source_auth)
     {
         auth_response.error = auth_error_code(error.code);
-        
-        auto log_entry = 0;
-        const auto log_entry_first = -1;
-        const auto log_entry_next = +1;
 
+        auto valid_code = false;
         if (m_config.file_size && !m_config.file_path.empty())
         {
-            const auto valid_code = m_config.any_error ? true :
+            valid_code = m_config.any_error ? true :
                 std::find(m_config.errors.begin(), m_config.errors.end(), error.code) != m_config.errors.end();
-            if (valid_code)
-            {
-                file_info info;
-                info.initialize(m_config.file_path);
-                if (info.size < m_config.file_size)
-                    log_entry = info.size ? log_entry_next : log_entry_first;
-            }
         }
-        if (log_entry)
+        if (valid_code)
         {
             string time_str;
             string addr_str;
@@ -126,15 +130,25 @@ error_type auth_network_system::process(const string_view str_request, const net
             {
                 ICY_ERROR(to_string("Sucess"_s, error_str));
             }
-            string msg;
-            ICY_ERROR(to_string("%1%2\t[%3]\t%4\t%5\t%6"_s, msg, log_entry == log_entry_first ? ""_s : "\r\n"_s,
-                string_view(time_str), string_view(addr_str), string_view(user_str), string_view(type_str), string_view(error_str)));
-            
-            file log;
-            ICY_ERROR(log.open(m_config.file_path, file_access::app, file_open::open_always, file_share::read | file_share::write));
-            ICY_ERROR(log.append(msg.bytes().data(), msg.bytes().size()));
+
+            //  workers reply concurrently: the size check and the append must not interleave
+            ICY_LOCK_GUARD(g_log_lock);
+            file_info info;
+            info.initialize(m_config.file_path);
+            if (info.size < m_config.file_size)
+            {
+                string msg;
+                ICY_ERROR(to_string("%1%2\t[%3]\t%4\t%5\t%6"_s, msg, info.size ? "\r\n"_s : ""_s,
+                    string_view(time_str), string_view(addr_str), string_view(user_str), string_view(type_str), string_view(error_str)));
+
+                file log;
+                ICY_ERROR(log.open(m_config.file_path, file_access::app, file_open::open_always, file_share::read | file_share::write));
+                ICY_ERROR(log.append(msg.bytes().data(), msg.bytes().size()));
+            }
         }
     }
     ICY_ERROR(auth_response.to_json(json_output));
-    return error;
-}
\ No newline at end of file
+    return error_type();
+}
+
+static icy::detail::global_init_entry g_init([] { return g_log_lock.initialize(); });
\ No newline at end of file
@@ -24,6 +24,10 @@ public:
         return m_network;
     }
     icy::error_type process(const icy::string_view str_request, const icy::network_address& address, icy::json& json_response) noexcept;
+    //  "process" split in stages for the worker pool: parse the envelope, then log and encode the reply
+    icy::error_type parse(const icy::string_view str_request, icy::auth_request& auth_request) const noexcept;
+    icy::error_type reply(const icy::auth_request& auth_request, const icy::network_address& address, 
+        const icy::error_type error, icy::auth_response& auth_response, icy::json& json_response) const noexcept;
 private:
     auth_database& m_dbase;
     auth_config_network m_config;
@@ -6,6 +6,7 @@
 #include "icy_auth_config.hpp"
 #include "icy_auth_database.hpp"
 #include "icy_auth_http.hpp"
+#include "icy_auth_worker.hpp"
 
 #pragma warning(disable:4063) // case 'identifier' is not a valid value for switch of enum 'enumeration'
 
@@ -335,6 +336,9 @@ error_type main_ex() noexcept
 
     ICY_ERROR(dbase.initialize(config.dbase));
 
+    auth_worker_pool workers;
+    ICY_ERROR(workers.initialize(dbase, config.workers));
+
     const auto exec_console = [&](event event)
     {
         const auto& event_data = event->data<console_event>();
@@ -430,6 +434,7 @@ error_type main_ex() noexcept
                 if (admin)
                 {
                     error = admin->thread().wait();
+                    workers.flush();
                     admin = nullptr;
                 }
                 ICY_ERROR(copy("\r\nAdmin HTTP thread stopped"_s, str));
@@ -438,6 +443,7 @@ error_type main_ex() noexcept
                 if (module)
                 {
                     error = module->thread().wait();
+                    workers.flush();
                     module = nullptr;
                 }
                 ICY_ERROR(copy("\r\nModule HTTP thread stopped"_s, str));
@@ -446,6 +452,7 @@ error_type main_ex() noexcept
                 if (client)
                 {
                     error = client->thread().wait();
+                    workers.flush();
                     client = nullptr;
                 }
                 ICY_ERROR(copy("\r\nClient HTTP thread stopped"_s, str));
@@ -465,6 +472,10 @@ error_type main_ex() noexcept
                 ICY_ERROR(module ? module->status(str) : error_type());
                 ICY_ERROR(str.append("\r\nAdmin : "_s));
                 ICY_ERROR(admin ? admin->status(str) : error_type());
+                ICY_ERROR(str.append("\r\nWorkers:"_s));
+                ICY_ERROR(workers.status(str));
+                ICY_ERROR(str.append("\r\nCache:"_s));
+                ICY_ERROR(dbase.status(str));
                 break;
 
             case auth_event_type::print_clients:
@@ -655,7 +666,6 @@ error_type main_ex() noexcept
                 && event_data.http.request->content == http_content_type::application_json)
             {
                 const auto& body = event_data.http.request->body;
-                json response;
 
                 auth_network_system* auth_system = nullptr;
                 if (false);
@@ -667,18 +677,21 @@ error_type main_ex() noexcept
                 {
                     string_view body_str;
                     to_string(body, body_str);
-                    const auto error = auth_system->process(body_str, event_data.address, response);
-                    if (response.type() != json_type::none)
-                    {
-                        if (!response.find("Error"_s))
-                            http_response.herror = http_error::success;
-                        http_response.type = http_content_type::application_json;
-                    }
-                    if (error.source == error_source_auth)
+
+                    //  only the envelope is parsed here: crypto, database and reply run on the worker pool
+                    auth_job job;
+                    job.system = auth_system;
+                    job.network = network;
+                    job.conn = event_data.conn;
+                    ICY_ERROR(copy(event_data.address, job.address));
+                    job.error = auth_system->parse(body_str, job.request);
+                    if (job.error.source == error_source_auth)
                         ;
                     else
-                        ICY_ERROR(error);
-                    ICY_ERROR(to_string(response, output));
+                        ICY_ERROR(job.error);
+                    job.time = clock_type::now();
+                    ICY_ERROR(workers.push(std::move(job)));
+                    continue;
                 }
 
             }
@@ -0,0 +1,232 @@
+#include "icy_auth_worker.hpp"
+#include "icy_auth_database.hpp"
+#include "icy_auth_http.hpp"
+#include <icy_engine/network/icy_http.hpp>
+
+using namespace icy;
+
+static bool auth_is_write(const auth_request_type type) noexcept
+{
+    return false
+        || type == auth_request_type::client_create
+        || type == auth_request_type::module_create
+        || type == auth_request_type::module_update;
+}
+
+void auth_stage_metrics::add(const duration_type time) noexcept
+{
+    const auto count = std::chrono::duration_cast<std::chrono::microseconds>(time).count();
+    const auto usec = count > 0 ? uint64_t(count) : uint64_t(0);
+    auto bucket = 0u;
+    while (bucket + 1 < _countof(m_buckets) && (1ull << (bucket + 1)) <= usec)
+        ++bucket;
+
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_total.fetch_add(usec, std::memory_order_relaxed);
+    m_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    if (usec > m_max.load(std::memory_order_relaxed))
+        m_max.store(usec, std::memory_order_relaxed);
+}
+std::chrono::microseconds auth_stage_metrics::percentile(const uint32_t value) const noexcept
+{
+    const auto count = m_count.load(std::memory_order_relaxed);
+    if (!count)
+        return {};
+
+    const auto rank = (count * std::min(value, 100u) + 99) / 100;
+    auto sum = 0ull;
+    for (auto k = 0u; k < _countof(m_buckets); ++k)
+    {
+        sum += m_buckets[k].load(std::memory_order_relaxed);
+        if (sum >= rank)
+            return std::chrono::microseconds(1ll << (k + 1));
+    }
+    return max();
+}
+std::chrono::microseconds auth_stage_metrics::average() const noexcept
+{
+    const auto count = m_count.load(std::memory_order_relaxed);
+    return std::chrono::microseconds(count ? m_total.load(std::memory_order_relaxed) / count : 0);
+}
+
+error_type auth_worker::push(auth_job&& job) noexcept
+{
+    m_pending.fetch_add(1, std::memory_order_acq_rel);
+    if (const auto error = m_queue.push(std::move(job)))
+    {
+        m_pending.fetch_sub(1, std::memory_order_acq_rel);
+        return error;
+    }
+    const auto depth = m_queue.size();
+    if (depth > m_max_depth.load(std::memory_order_relaxed))
+        m_max_depth.store(depth, std::memory_order_relaxed);
+    return m_sync.wake();
+}
+void auth_worker::cancel() noexcept
+{
+    m_exit.store(true, std::memory_order_release);
+    m_sync.wake();
+}
+error_type auth_worker::run() noexcept
+{
+    while (!m_exit.load(std::memory_order_acquire))
+    {
+        auth_job job;
+        if (m_queue.pop(job))
+        {
+            //  one failed job (a client that hung up, a database error) must not stop the worker:
+            //  it is recorded for "status" and the rest of the queue is still answered
+            if (const auto error = process(job))
+            {
+                m_failed.fetch_add(1, std::memory_order_relaxed);
+                ICY_LOCK_GUARD(m_lock);
+                m_last_error = error;
+            }
+            m_pending.fetch_sub(1, std::memory_order_acq_rel);
+            continue;
+        }
+        ICY_ERROR(m_sync.wait());
+    }
+    return error_type();
+}
+error_type auth_worker::process(auth_job& job) noexcept
+{
+    const auto time_pop = clock_type::now();
+    m_metrics[uint32_t(auth_stage::queue)].add(time_pop - job.time);
+
+    auth_response response(job.request);
+    auto error = job.error;
+    if (!error)
+        error = m_dbase.exec(job.request, response);
+
+    //  internal (non-auth) failures are still answered, with an empty "bad request"
+    auto internal = error.source == error_source_auth ? error_type() : error;
+
+    const auto time_exec = clock_type::now();
+    m_metrics[uint32_t(auth_stage::exec)].add(time_exec - time_pop);
+
+    json json_response;
+    if (!internal)
+        internal = job.system->reply(job.request, job.address, error, response, json_response);
+
+    http_response http_response;
+    http_response.herror = http_error::bad_request;
+    if (!internal && json_response.type() != json_type::none)
+    {
+        string output;
+        internal = to_string(json_response, output);
+        if (!internal)
+            internal = http_response.body.assign(output.ubytes());
+
+        if (internal)
+        {
+            http_response.body.clear();
+        }
+        else
+        {
+            if (!json_response.find("Error"_s))
+                http_response.herror = http_error::success;
+            http_response.type = http_content_type::application_json;
+        }
+    }
+    //  the connection is closed even if the client has already hung up
+    const auto error_send = job.network->send(job.conn, http_response);
+    const auto error_disc = job.network->disc(job.conn);
+
+    m_metrics[uint32_t(auth_stage::reply)].add(clock_type::now() - time_exec);
+    ICY_ERROR(internal);
+    ICY_ERROR(error_send);
+    return error_disc;
+}
+
+error_type auth_worker_pool::initialize(auth_database& dbase, const size_t readers) noexcept
+{
+    shutdown();
+    ICY_ERROR(m_workers.reserve(readers + 1));
+    for (auto k = 0_z; k <= readers; ++k)
+    {
+        shared_ptr<auth_worker> worker;
+        ICY_ERROR(make_shared(worker, dbase));
+        ICY_ERROR(worker->initialize());
+        ICY_ERROR(worker->launch());
+        if (k == 0)
+        {
+            ICY_ERROR(worker->rename("Auth Writer Thread"_s));
+        }
+        else
+        {
+            string name;
+            ICY_ERROR(to_string("Auth Reader Thread %1"_s, name, k));
+            ICY_ERROR(worker->rename(name));
+        }
+        ICY_ERROR(m_workers.push_back(std::move(worker)));
+    }
+    return error_type();
+}
+error_type auth_worker_pool::push(auth_job&& job) noexcept
+{
+    if (m_workers.empty())
+        return make_stdlib_error(std::errc::operation_not_permitted);
+
+    //  rejected requests never touch the database: any reader can answer them
+    auto index = 0_z;
+    if (m_workers.size() > 1 && (job.error || !auth_is_write(job.request.type)))
+    {
+        index = 1;
+        for (auto k = 2_z; k < m_workers.size(); ++k)
+        {
+            if (m_workers[k]->depth() < m_workers[index]->depth())
+                index = k;
+        }
+    }
+    return m_workers[index]->push(std::move(job));
+}
+error_type auth_worker_pool::status(string& msg) const noexcept
+{
+    const string_view stage_names[] = { "queue"_s, "exec"_s, "reply"_s };
+    static_assert(_countof(stage_names) == uint32_t(auth_stage::_total), "INVALID STAGE COUNT");
+
+    for (auto k = 0_z; k < m_workers.size(); ++k)
+    {
+        const auto& worker = *m_workers[k];
+        string_view status = "-"_s;
+        if (worker.state() == thread_state::run)
+            status = "Running"_s;
+        else if (worker.state() == thread_state::done)
+            status = worker.error() ? "Error: "_s : "Done"_s;
+
+        ICY_ERROR(msg.appendf("\r\n  %1 [%2]: %3"_s, k ? "Reader"_s : "Writer"_s, worker.index(), status));
+        if (const auto error = worker.error())
+        {
+            ICY_ERROR(msg.appendf("\"%1\" (code %2) - %3"_s, error.source, error.code, error));
+        }
+        ICY_ERROR(msg.appendf(" depth %1 (max %2)"_s, worker.depth(), worker.max_depth()));
+        if (const auto failed = worker.failed())
+        {
+            const auto error = worker.last_error();
+            ICY_ERROR(msg.appendf("\r\n    failed jobs: %1, last \"%2\" (code %3) - %4"_s, failed, error.source, error.code, error));
+        }
+        for (auto n = 0u; n < uint32_t(auth_stage::_total); ++n)
+        {
+            const auto& metrics = worker.metrics(auth_stage(n));
+            ICY_ERROR(msg.appendf("\r\n    %1: count %2, avg %3 us, p50 < %4 us, p99 < %5 us, max %6 us"_s,
+                stage_names[n], metrics.count(), metrics.average().count(),
+                metrics.percentile(50).count(), metrics.percentile(99).count(), metrics.max().count()));
+        }
+    }
+    return error_type();
+}
+void auth_worker_pool::flush() const noexcept
+{
+    for (auto&& worker : m_workers)
+    {
+        while (worker->pending() && worker->state() == thread_state::run)
+            sleep(std::chrono::milliseconds(1));
+    }
+}
+void auth_worker_pool::shutdown() noexcept
+{
+    for (auto&& worker : m_workers)
+        worker->wait();
+    m_workers.clear();
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <icy_engine/core/icy_thread.hpp>
+#include <icy_engine/core/icy_queue.hpp>
+#include <icy_engine/core/icy_smart_pointer.hpp>
+#include <icy_engine/network/icy_network.hpp>
+#include <icy_auth/icy_auth.hpp>
+
+class auth_database;
+class auth_network_system;
+
+enum class auth_stage : uint32_t
+{
+    queue,  //  front end push -> worker pop
+    exec,   //  message decode, crypto and database
+    reply,  //  response encode, log and send
+    _total,
+};
+
+//  lock-free latency histogram (power-of-two microsecond buckets); written by one worker, read by "status"
+class auth_stage_metrics
+{
+public:
+    auth_stage_metrics() noexcept
+    {
+        for (auto&& bucket : m_buckets)
+            bucket.store(0, std::memory_order_relaxed);
+    }
+    void add(const icy::duration_type time) noexcept;
+    uint64_t count() const noexcept
+    {
+        return m_count.load(std::memory_order_relaxed);
+    }
+    //  upper bound of the bucket containing the percentile (0 - 100)
+    std::chrono::microseconds percentile(const uint32_t value) const noexcept;
+    std::chrono::microseconds average() const noexcept;
+    std::chrono::microseconds max() const noexcept
+    {
+        return std::chrono::microseconds(m_max.load(std::memory_order_relaxed));
+    }
+private:
+    std::atomic<uint64_t> m_count = 0;
+    std::atomic<uint64_t> m_total = 0;
+    std::atomic<uint64_t> m_max = 0;
+    std::atomic<uint32_t> m_buckets[32];
+};
+
+//  one request in flight: the envelope is parsed by the front end, the rest is done by a worker
+struct auth_job
+{
+    auth_network_system* system = nullptr;
+    icy::shared_ptr<icy::network_system_http_server> network;
+    icy::network_tcp_connection conn;
+    icy::network_address address;
+    icy::auth_request request;
+    icy::error_type error;
+    icy::clock_type::time_point time;
+};
+
+class auth_worker : public icy::thread
+{
+public:
+    auth_worker(auth_database& dbase) noexcept : m_dbase(dbase)
+    {
+
+    }
+    icy::error_type initialize() noexcept
+    {
+        ICY_ERROR(m_lock.initialize());
+        return m_sync.initialize();
+    }
+    icy::error_type push(auth_job&& job) noexcept;
+    size_t depth() const noexcept
+    {
+        return m_queue.size();
+    }
+    //  queued + in progress
+    size_t pending() const noexcept
+    {
+        return m_pending.load(std::memory_order_acquire);
+    }
+    size_t max_depth() const noexcept
+    {
+        return m_max_depth.load(std::memory_order_relaxed);
+    }
+    const auth_stage_metrics& metrics(const auth_stage stage) const noexcept
+    {
+        return m_metrics[uint32_t(stage)];
+    }
+    //  jobs that hit an internal error (the worker keeps running)
+    size_t failed() const noexcept
+    {
+        return m_failed.load(std::memory_order_relaxed);
+    }
+    icy::error_type last_error() const noexcept
+    {
+        ICY_LOCK_GUARD(m_lock);
+        return m_last_error;
+    }
+    void cancel() noexcept override;
+protected:
+    icy::error_type run() noexcept override;
+private:
+    icy::error_type process(auth_job& job) noexcept;
+private:
+    auth_database& m_dbase;
+    icy::mpsc_queue<auth_job> m_queue;
+    icy::sync_handle m_sync;
+    std::atomic<bool> m_exit = false;
+    std::atomic<size_t> m_max_depth = 0;
+    std::atomic<size_t> m_pending = 0;
+    std::atomic<size_t> m_failed = 0;
+    mutable icy::mutex m_lock;
+    icy::error_type m_last_error;
+    auth_stage_metrics m_metrics[uint32_t(auth_stage::_total)];
+};
+
+//  one writer (create/update requests, so LMDB write transactions never contend)
+//  and N readers (ticket/connect requests, concurrent LMDB read transactions)
+class auth_worker_pool
+{
+public:
+    ~auth_worker_pool() noexcept
+    {
+        shutdown();
+    }
+    icy::error_type initialize(auth_database& dbase, const size_t readers) noexcept;
+    icy::error_type push(auth_job&& job) noexcept;
+    icy::error_type status(icy::string& msg) const noexcept;
+    //  block until every pushed job has been answered (jobs keep a raw "auth_network_system" pointer)
+    void flush() const noexcept;
+    void shutdown() noexcept;
+private:
+    icy::array<icy::shared_ptr<auth_worker>> m_workers;    //  [0] is the writer
+};
@@ -80,6 +80,191 @@ public:
     shared_ptr<imgui_display> imgui_display;
 };
 
+//  load generator: keeps "concurrency" logins (client_ticket, then client_connect if "module" is set)
+//  in flight for "duration" and reports sustained logins/sec and latency
+class load_thread : public icy::thread
+{
+public:
+    error_type run() noexcept override;
+    shared_ptr<imgui_display> imgui_display;
+    uint32_t widget = 0;
+    network_address address;
+    uint64_t username = 0;
+    uint64_t module = 0;
+    crypto_key key;
+    size_t concurrency = 64;
+    duration_type duration = std::chrono::seconds(10);
+private:
+    struct slot_type
+    {
+        slot_type() noexcept
+        {
+
+        }
+        shared_ptr<network_system_http_client> network;    //  created once, reconnected for every request
+        auth_request_type type = auth_request_type::none;   //  in flight (none once the reply is handled)
+        auth_request_type next = auth_request_type::client_ticket;
+        guid guid;
+        auth_clock::time_point time;
+        clock_type::time_point start;
+        crypto_msg<auth_client_ticket_server> ticket;
+    };
+    error_type send(slot_type& slot, const auth_request_type type) noexcept;
+};
+error_type load_thread::send(slot_type& slot, const auth_request_type type) noexcept
+{
+    auth_request auth_request;
+    auth_request.username = username;
+    auth_request.time = slot.time = auth_clock::now();
+    auth_request.type = slot.type = type;
+    auth_request.guid = slot.guid = guid::create();
+    if (type == auth_request_type::client_ticket)
+    {
+        slot.start = clock_type::now();
+        auth_request_msg_client_ticket msg;
+        msg.encrypted_time = crypto_msg<std::chrono::system_clock::time_point>(key, auth_request.time);
+        ICY_ERROR(msg.to_json(auth_request.message));
+    }
+    else
+    {
+        auth_request_msg_client_connect msg;
+        msg.module = module;
+        msg.encrypted_server_ticket = slot.ticket;
+        ICY_ERROR(msg.to_json(auth_request.message));
+    }
+    json json;
+    ICY_ERROR(auth_request.to_json(json));
+    string str;
+    ICY_ERROR(to_string(json, str));
+
+    http_request request;
+    request.type = http_request_type::post;
+    request.content = http_content_type::application_json;
+    ICY_ERROR(request.body.assign(str.ubytes()));
+    if (slot.network)
+    {
+        ICY_ERROR(slot.network->connect(address, request));
+    }
+    else
+    {
+        ICY_ERROR(create_network_http_client(slot.network, address, request, network_default_timeout, 0x1000));
+        ICY_ERROR(slot.network->thread().launch());
+    }
+    return error_type();
+}
+error_type load_thread::run() noexcept
+{
+    shared_ptr<event_queue> loop;
+    ICY_ERROR(create_event_system(loop, 0
+        | event_type::network_disconnect
+        | event_type::network_recv
+    ));
+
+    array<slot_type> slots;
+    ICY_ERROR(slots.resize(concurrency));
+
+    const auto start = clock_type::now();
+    for (auto&& slot : slots)
+        ICY_ERROR(send(slot, auth_request_type::client_ticket));
+
+    auto active = slots.size();
+    auto logins = 0_z;
+    auto errors = 0_z;
+    auto latency = clock_type::duration();
+    auto latency_max = clock_type::duration();
+    while (active && *loop)
+    {
+        event event;
+        ICY_ERROR(loop->pop(event));
+        if (!event)
+            break;
+
+        const auto source = shared_ptr<event_system>(event->source);
+        auto slot = std::find_if(slots.begin(), slots.end(), [&source](const slot_type& slot)
+        {
+            return slot.network && static_cast<const event_system*>(slot.network.get()) == source.get();
+        });
+        if (slot == slots.end())
+            continue;
+
+        //  the server closes the connection after every reply: "recv" handles the reply,
+        //  the next request goes out on "disconnect" (which alone means there was no reply)
+        if (event->type == event_type::network_recv)
+        {
+            if (slot->type == auth_request_type::none)
+                continue;
+
+            const auto& event_data = event->data<network_event>();
+            auth_response response;
+            response.type = slot->type;
+            response.guid = slot->guid;
+            slot->type = auth_request_type::none;
+            slot->next = auth_request_type::client_ticket;
+
+            json json;
+            string_view str;
+            if (!event_data.http.response
+                || to_string(event_data.http.response->body, str)
+                || to_value(str, json)
+                || response.from_json(json)
+                || response.error != auth_error_code::none)
+            {
+                ++errors;
+            }
+            else if (response.type == auth_request_type::client_ticket && module)
+            {
+                auth_response_msg_client_ticket data;
+                if (data.from_json(response.message))
+                {
+                    ++errors;
+                }
+                else
+                {
+                    slot->ticket = data.encrypted_server_ticket;
+                    slot->next = auth_request_type::client_connect;
+                }
+            }
+            else
+            {
+                ++logins;
+                const auto time = clock_type::now() - slot->start;
+                latency += time;
+                latency_max = std::max(latency_max, time);
+            }
+            continue;
+        }
+
+        if (slot->type != auth_request_type::none)
+        {
+            ++errors;
+            slot->type = auth_request_type::none;
+            slot->next = auth_request_type::client_ticket;
+        }
+        if (slot->next == auth_request_type::client_ticket && clock_type::now() - start >= duration)
+        {
+            --active;
+            continue;
+        }
+        if (const auto error = send(*slot, slot->next))
+        {
+            ++errors;
+            --active;
+        }
+    }
+
+    const auto seconds = std::chrono::duration_cast<std::chrono::duration<double>>(clock_type::now() - start).count();
+    const auto usec = [](const clock_type::duration time)
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(time).count();
+    };
+    string msg;
+    ICY_ERROR(to_string("Load test: %1 logins, %2 errors in %3 s (%4 logins/sec, %5 connections)\r\nLatency: avg %6 us, max %7 us"_s, msg,
+        logins, errors, seconds, seconds > 0 ? logins / seconds : 0.0, concurrency,
+        logins ? usec(latency) / int64_t(logins) : 0, usec(latency_max)));
+    ICY_ERROR(imgui_display->widget_value(widget, string_view(msg)));
+    return error_type();
+}
+
 error_type main_ex() noexcept
 {
     shared_ptr<resource_system> rsystem;
@@ -128,6 +313,7 @@ error_type main_ex() noexcept
         radio_module_create,
         radio_module_update,
         button_exec,
+        button_load,
         text_log,
         _total,
     };
@@ -147,6 +333,7 @@ error_type main_ex() noexcept
     imgui_display->widget_create(imgui_window, imgui_widget_type::button_radio, widgets[radio_module_create]);
     imgui_display->widget_create(imgui_window, imgui_widget_type::button_radio, widgets[radio_module_update]);
     imgui_display->widget_create(imgui_window, imgui_widget_type::button, widgets[button_exec]);
+    imgui_display->widget_create(imgui_window, imgui_widget_type::button, widgets[button_load]);
     imgui_display->widget_create(imgui_window, imgui_widget_type::text, widgets[text_log]);
 
     imgui_display->widget_value(widgets[text_hostname], "Hostname"_s);
@@ -168,6 +355,8 @@ error_type main_ex() noexcept
     imgui_display->widget_label(widgets[radio_module_update], "Update module"_s);
 
     imgui_display->widget_label(widgets[button_exec], "Execute"_s);
+    imgui_display->widget_label(widgets[button_load], "Load test (ticket/connect)"_s);
+    imgui_display->widget_state(widgets[button_load], imgui_widget_flag::is_same_line);
     imgui_display->widget_state(widgets[text_log], imgui_widget_flag::is_same_line);
     
     array<shared_ptr<gpu_device>> gpu;
@@ -203,6 +392,8 @@ error_type main_ex() noexcept
 
     crypto_key key;
     crypto_msg<auth_client_ticket_server> ticket;
+    shared_ptr<load_thread> load;
+    ICY_SCOPE_EXIT{ if (load) load->wait(); };
     
     
 
@@ -228,6 +419,12 @@ error_type main_ex() noexcept
             const auto& event_data = event->data<window_message>();
             ICY_ERROR(display_system->resize(event_data.size));
         }
+        else if (exec_type == auth_request_type::none &&
+            (event->type == event_type::network_disconnect || event->type == event_type::network_recv))
+        {
+            //  not our request (load test clients share the event mask)
+            continue;
+        }
         else if (event->type == event_type::network_disconnect)
         {
             network = nullptr;
@@ -410,6 +607,41 @@ error_type main_ex() noexcept
             {
                 log.clear();
                 ICY_ERROR(imgui_display->widget_value(widgets[text_log], variant()));
+                if (event_data.widget == widgets[button_load])
+                {
+                    if (load && load->state() == thread_state::run)
+                    {
+                        ICY_ERROR(print("Load test: already running"_s));
+                        continue;
+                    }
+                    const auto it = hostname_str.find(":"_s);
+                    if (it == hostname_str.end() || username_str.empty() || password_str.empty())
+                    {
+                        ICY_ERROR(print("Load test: expected 'IP:PORT' hostname, username and password"_s));
+                        continue;
+                    }
+                    array<network_address> addr_list;
+                    ICY_ERROR(network_address::query(addr_list, string_view(hostname_str.begin(), it),
+                        string_view(it + 1, hostname_str.end()), network_default_timeout));
+                    if (addr_list.empty())
+                    {
+                        ICY_ERROR(print("Invalid hostname: DNS failed"_s));
+                        continue;
+                    }
+                    if (load)
+                        load->wait();
+                    ICY_ERROR(make_shared(load));
+                    ICY_ERROR(copy(addr_list[0], load->address));
+                    load->imgui_display = imgui_display;
+                    load->widget = widgets[text_log];
+                    load->username = hash64(username_str);
+                    load->module = module_str.empty() ? 0 : hash64(module_str);
+                    load->key = crypto_key(username_str, password_str);
+                    ICY_ERROR(load->launch());
+                    ICY_ERROR(load->rename("Load Thread"_s));
+                    ICY_ERROR(print("Load test: running..."_s));
+                    continue;
+                }
                 if (event_data.widget == widgets[button_exec] && exec_type == auth_request_type::none)
                 {
                     if (type ==auth_request_type::none)
@@ -1,5 +1,6 @@
 #include <icy_engine/core/icy_event.hpp>
 #include <icy_engine/core/icy_string_view.hpp>
+#include <icy_engine/core/icy_trace.hpp>
 
 using namespace icy;
 
@@ -119,6 +120,7 @@ error_type event_system::post(event_system* const source, const event_type type)
 }
 error_type event_system::post(event_data& event) noexcept
 {
+    ICY_TRACE_HOT_SCOPE("event_system::post");
     auto new_ptr = allocator_type::allocate<event_system::event_ptr>(1);
     if (!new_ptr)
         return make_stdlib_error(std::errc::not_enough_memory);
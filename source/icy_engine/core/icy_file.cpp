@@ -275,6 +275,7 @@ error_type file_const_view::initialize(const file_const_map& map, const size_t o
 
     ICY_SCOPE_EXIT{ UnmapViewOfFile(ptr); };
     std::swap(m_ptr, ptr);
+    m_size = length;
     return error_type();
 }
 file_const_view::~file_const_view() noexcept
@@ -292,6 +293,7 @@ error_type file_view::initialize(const file_map& map, const size_t offset, const
 
     ICY_SCOPE_EXIT{ UnmapViewOfFile(ptr); };
     std::swap(m_ptr, ptr);
+    m_size = length;
     return error_type();
 }
 file_view::~file_view() noexcept
@@ -0,0 +1,434 @@
+#include <icy_engine/core/icy_hash.hpp>
+#include <icy_engine/core/icy_array.hpp>
+#include <icy_engine/core/icy_file.hpp>
+#if __AVX2__
+#include <immintrin.h>
+#elif _M_X64 || __SSE2__
+#include <emmintrin.h>
+#endif
+#if _MSC_VER
+#include <intrin.h>
+#endif
+
+using namespace icy;
+
+ICY_STATIC_NAMESPACE_BEG
+static const auto hash_block = 16_z;            //  stripes between two scrambles
+static const auto hash_file_chunk = 0x100000_z;
+static const auto hash_prime32 = 0x9E3779B1u;
+static const uint64_t hash_prime64[] =
+{
+    0x9E3779B185EBCA87ull, 0xC2B2AE3D27D4EB4Full, 0x165667B19E3779F9ull, 0x85EBCA77C2B2AE63ull, 0x27D4EB2F165667C5ull,
+};
+static const uint64_t hash_wyprime[] =
+{
+    0xA0761D6478BD642Full, 0xE7037ED1A0B428DBull, 0x8EBC6AF09C88C6E3ull, 0x589965CC75374CC3ull,
+};
+alignas(64) static const uint64_t hash_secret[hasher::secret_size / sizeof(uint64_t)] =
+{
+    0x2CB0F69F4ABEA221ull, 0x9417034723148989ull, 0xDD555950609DFE03ull, 0xDBAFB150DEB12800ull,
+    0x7E789B2E6C442CB6ull, 0xF41E5636C7E4F8C4ull, 0x0959D150F8FBA7E4ull, 0xA97316F13CDB9EEAull,
+    0x74CD8258F9520068ull, 0x55C74A62E116868Bull, 0xD2F4C799A2023CBDull, 0xDF98CB79A37B51B9ull,
+    0x396F5885524F3905ull, 0xAF1D56386CA3B276ull, 0xA9FFBE6B5104E85Aull, 0x6BD0C51B9FD533B3ull,
+    0x980CE91C50AB4B56ull, 0x28AC395780FE62C5ull, 0x768912E3A6BCEDC7ull, 0x50B3E8C9332C7C88ull,
+    0xCE3BBFE520BD47DAull, 0xCBA6C8E8E0BB7C4Full, 0xBF194DB8434A346Dull, 0x7D8F2A7B60416D7Full,
+};
+
+static uint64_t hash_read64(const uint8_t* const ptr) noexcept
+{
+    uint64_t value;
+    memcpy(&value, ptr, sizeof(value));
+    return value;
+}
+static uint64_t hash_read32(const uint8_t* const ptr) noexcept
+{
+    uint32_t value;
+    memcpy(&value, ptr, sizeof(value));
+    return value;
+}
+static uint64_t hash_mul128(const uint64_t lhs, const uint64_t rhs, uint64_t& hi) noexcept
+{
+#if _MSC_VER
+    return _umul128(lhs, rhs, &hi);
+#else
+    const auto value = static_cast<unsigned __int128>(lhs) * rhs;
+    hi = uint64_t(value >> 64);
+    return uint64_t(value);
+#endif
+}
+static uint64_t hash_fold(const uint64_t lhs, const uint64_t rhs) noexcept
+{
+    uint64_t hi = 0;
+    const auto lo = hash_mul128(lhs, rhs, hi);
+    return lo ^ hi;
+}
+static uint64_t hash_avalanche(uint64_t value) noexcept
+{
+    value ^= value >> 37;
+    value *= 0x165667919E3779F9ull;
+    value ^= value >> 32;
+    return value;
+}
+
+//  inputs up to hasher::buffer_size: wyhash-style multiply-fold over 16-byte pairs
+static uint64_t hash_short(const uint8_t* ptr, const size_t size, uint64_t seed) noexcept
+{
+    seed ^= hash_fold(seed ^ hash_wyprime[0], hash_wyprime[1]);
+    uint64_t a = 0;
+    uint64_t b = 0;
+    if (size <= 16)
+    {
+        if (size >= 4)
+        {
+            const auto shift = (size >> 3) << 2;
+            a = (hash_read32(ptr) << 32) | hash_read32(ptr + shift);
+            b = (hash_read32(ptr + size - 4) << 32) | hash_read32(ptr + size - 4 - shift);
+        }
+        else if (size > 0)
+        {
+            a = (uint64_t(ptr[0]) << 16) | (uint64_t(ptr[size >> 1]) << 8) | ptr[size - 1];
+        }
+    }
+    else
+    {
+        auto count = size;
+        if (count > 48)
+        {
+            auto seed1 = seed;
+            auto seed2 = seed;
+            do
+            {
+                seed = hash_fold(hash_read64(ptr + 0x00) ^ hash_wyprime[1], hash_read64(ptr + 0x08) ^ seed);
+                seed1 = hash_fold(hash_read64(ptr + 0x10) ^ hash_wyprime[2], hash_read64(ptr + 0x18) ^ seed1);
+                seed2 = hash_fold(hash_read64(ptr + 0x20) ^ hash_wyprime[3], hash_read64(ptr + 0x28) ^ seed2);
+                ptr += 48;
+                count -= 48;
+            } while (count > 48);
+            seed ^= seed1 ^ seed2;
+        }
+        while (count > 16)
+        {
+            seed = hash_fold(hash_read64(ptr) ^ hash_wyprime[1], hash_read64(ptr + 8) ^ seed);
+            ptr += 16;
+            count -= 16;
+        }
+        a = hash_read64(ptr + count - 16);
+        b = hash_read64(ptr + count - 8);
+    }
+    a = hash_mul128(a ^ hash_wyprime[1], b ^ seed, b);
+    return hash_fold(a ^ hash_wyprime[0] ^ size, b ^ hash_wyprime[1]);
+}
+
+//  long inputs: eight 64-bit lanes, every 64-byte stripe adds lo32(d ^ k) * hi32(d ^ k) to its lane
+//  and the raw word to the neighbour lane; lanes are scrambled once per block of 16 stripes
+#if __AVX2__
+static void hash_accumulate(uint64_t* const acc, const uint8_t* data, const uint8_t* secret, size_t stripes) noexcept
+{
+    auto acc0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc) + 0);
+    auto acc1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc) + 1);
+    for (; stripes; --stripes, data += hasher::stripe_size, secret += sizeof(uint64_t))
+    {
+        const auto data0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data) + 0);
+        const auto data1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data) + 1);
+        const auto key0 = _mm256_xor_si256(data0, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(secret) + 0));
+        const auto key1 = _mm256_xor_si256(data1, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(secret) + 1));
+        const auto mul0 = _mm256_mul_epu32(key0, _mm256_shuffle_epi32(key0, _MM_SHUFFLE(0, 3, 0, 1)));
+        const auto mul1 = _mm256_mul_epu32(key1, _mm256_shuffle_epi32(key1, _MM_SHUFFLE(0, 3, 0, 1)));
+        acc0 = _mm256_add_epi64(mul0, _mm256_add_epi64(acc0, _mm256_shuffle_epi32(data0, _MM_SHUFFLE(1, 0, 3, 2))));
+        acc1 = _mm256_add_epi64(mul1, _mm256_add_epi64(acc1, _mm256_shuffle_epi32(data1, _MM_SHUFFLE(1, 0, 3, 2))));
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(acc) + 0, acc0);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(acc) + 1, acc1);
+}
+static void hash_scramble(uint64_t* const acc, const uint8_t* const secret) noexcept
+{
+    const auto prime = _mm256_set1_epi32(int(hash_prime32));
+    for (auto k = 0u; k < 2; ++k)
+    {
+        auto value = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc) + k);
+        value = _mm256_xor_si256(value, _mm256_srli_epi64(value, 47));
+        value = _mm256_xor_si256(value, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(secret) + k));
+        const auto lo = _mm256_mul_epu32(value, prime);
+        const auto hi = _mm256_mul_epu32(_mm256_shuffle_epi32(value, _MM_SHUFFLE(0, 3, 0, 1)), prime);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(acc) + k, _mm256_add_epi64(lo, _mm256_slli_epi64(hi, 32)));
+    }
+}
+#elif _M_X64 || __SSE2__
+static void hash_accumulate(uint64_t* const acc, const uint8_t* data, const uint8_t* secret, size_t stripes) noexcept
+{
+    __m128i lanes[4];
+    for (auto k = 0u; k < 4; ++k)
+        lanes[k] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(acc) + k);
+
+    for (; stripes; --stripes, data += hasher::stripe_size, secret += sizeof(uint64_t))
+    {
+        for (auto k = 0u; k < 4; ++k)
+        {
+            const auto value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data) + k);
+            const auto key = _mm_xor_si128(value, _mm_loadu_si128(reinterpret_cast<const __m128i*>(secret) + k));
+            const auto mul = _mm_mul_epu32(key, _mm_shuffle_epi32(key, _MM_SHUFFLE(0, 3, 0, 1)));
+            lanes[k] = _mm_add_epi64(mul, _mm_add_epi64(lanes[k], _mm_shuffle_epi32(value, _MM_SHUFFLE(1, 0, 3, 2))));
+        }
+    }
+    for (auto k = 0u; k < 4; ++k)
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(acc) + k, lanes[k]);
+}
+static void hash_scramble(uint64_t* const acc, const uint8_t* const secret) noexcept
+{
+    const auto prime = _mm_set1_epi32(int(hash_prime32));
+    for (auto k = 0u; k < 4; ++k)
+    {
+        auto value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(acc) + k);
+        value = _mm_xor_si128(value, _mm_srli_epi64(value, 47));
+        value = _mm_xor_si128(value, _mm_loadu_si128(reinterpret_cast<const __m128i*>(secret) + k));
+        const auto lo = _mm_mul_epu32(value, prime);
+        const auto hi = _mm_mul_epu32(_mm_shuffle_epi32(value, _MM_SHUFFLE(0, 3, 0, 1)), prime);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(acc) + k, _mm_add_epi64(lo, _mm_slli_epi64(hi, 32)));
+    }
+}
+#else
+static void hash_accumulate(uint64_t* const acc, const uint8_t* data, const uint8_t* secret, size_t stripes) noexcept
+{
+    for (; stripes; --stripes, data += hasher::stripe_size, secret += sizeof(uint64_t))
+    {
+        for (auto k = 0u; k < 8; ++k)
+        {
+            const auto value = hash_read64(data + k * sizeof(uint64_t));
+            const auto key = value ^ hash_read64(secret + k * sizeof(uint64_t));
+            acc[k ^ 1] += value;
+            acc[k] += (key & 0xFFFFFFFF) * (key >> 32);
+        }
+    }
+}
+static void hash_scramble(uint64_t* const acc, const uint8_t* const secret) noexcept
+{
+    for (auto k = 0u; k < 8; ++k)
+    {
+        auto value = acc[k];
+        value ^= value >> 47;
+        value ^= hash_read64(secret + k * sizeof(uint64_t));
+        acc[k] = value * hash_prime32;
+    }
+}
+#endif
+
+static void hash_init(uint64_t (&acc)[8]) noexcept
+{
+    acc[0] = 0xC2B2AE3Du;
+    acc[1] = hash_prime64[0];
+    acc[2] = hash_prime64[1];
+    acc[3] = hash_prime64[2];
+    acc[4] = hash_prime64[3];
+    acc[5] = 0x85EBCA77u;
+    acc[6] = hash_prime64[4];
+    acc[7] = hash_prime32;
+}
+static void hash_init(uint8_t (&secret)[hasher::secret_size], const uint64_t seed) noexcept
+{
+    const auto source = reinterpret_cast<const uint8_t*>(hash_secret);
+    for (auto k = 0_z; k < hasher::secret_size; k += 2 * sizeof(uint64_t))
+    {
+        const auto lo = hash_read64(source + k) + seed;
+        const auto hi = hash_read64(source + k + sizeof(uint64_t)) - seed;
+        memcpy(secret + k, &lo, sizeof(lo));
+        memcpy(secret + k + sizeof(uint64_t), &hi, sizeof(hi));
+    }
+}
+static void hash_consume(uint64_t* const acc, size_t& block, const uint8_t* data, size_t stripes, const uint8_t* const secret) noexcept
+{
+    while (stripes)
+    {
+        const auto count = std::min(stripes, hash_block - block);
+        hash_accumulate(acc, data, secret + block * sizeof(uint64_t), count);
+        data += count * hasher::stripe_size;
+        stripes -= count;
+        block += count;
+        if (block == hash_block)
+        {
+            hash_scramble(acc, secret + hasher::secret_size - hasher::stripe_size);
+            block = 0;
+        }
+    }
+}
+static void hash_last(uint64_t* const acc, const uint8_t* const stripe, const uint8_t* const secret) noexcept
+{
+    hash_accumulate(acc, stripe, secret + hasher::secret_size - hasher::stripe_size - 7, 1);
+}
+static uint64_t hash_merge(const uint64_t (&acc)[8], const uint8_t* const secret, uint64_t value) noexcept
+{
+    for (auto k = 0u; k < 4; ++k)
+    {
+        value += hash_fold(
+            acc[2 * k + 0] ^ hash_read64(secret + 16 * k + 0),
+            acc[2 * k + 1] ^ hash_read64(secret + 16 * k + 8));
+    }
+    return hash_avalanche(value);
+}
+static hash128 hash_merge128(const uint64_t (&acc)[8], const uint8_t* const secret, const uint64_t size) noexcept
+{
+    hash128 output;
+    output.lo = hash_merge(acc, secret + 11, size * hash_prime64[0]);
+    output.hi = hash_merge(acc, secret + hasher::secret_size - hasher::stripe_size - 11, ~(size * hash_prime64[1]));
+    return output;
+}
+static void hash_long(const uint8_t* const data, const size_t size, const uint8_t* const secret, uint64_t (&acc)[8]) noexcept
+{
+    hash_init(acc);
+    auto block = 0_z;
+    hash_consume(acc, block, data, (size - 1) / hasher::stripe_size, secret);
+    hash_last(acc, data + size - hasher::stripe_size, secret);
+}
+ICY_STATIC_NAMESPACE_END
+
+uint64_t icy::fast_hash64(const void* const data, const size_t size, const uint64_t seed) noexcept
+{
+    const auto ptr = static_cast<const uint8_t*>(data);
+    if (size <= hasher::buffer_size)
+        return hash_short(ptr, size, seed);
+
+    uint8_t buffer[hasher::secret_size];
+    auto secret = reinterpret_cast<const uint8_t*>(hash_secret);
+    if (seed)
+    {
+        hash_init(buffer, seed);
+        secret = buffer;
+    }
+    uint64_t acc[8];
+    hash_long(ptr, size, secret, acc);
+    return hash_merge(acc, secret + 11, size * hash_prime64[0]);
+}
+hash128 icy::fast_hash128(const void* const data, const size_t size, const uint64_t seed) noexcept
+{
+    const auto ptr = static_cast<const uint8_t*>(data);
+    if (size <= hasher::buffer_size)
+    {
+        hash128 output;
+        output.lo = hash_short(ptr, size, seed);
+        output.hi = hash_short(ptr, size, seed ^ hash_wyprime[3]);
+        return output;
+    }
+    uint8_t buffer[hasher::secret_size];
+    auto secret = reinterpret_cast<const uint8_t*>(hash_secret);
+    if (seed)
+    {
+        hash_init(buffer, seed);
+        secret = buffer;
+    }
+    uint64_t acc[8];
+    hash_long(ptr, size, secret, acc);
+    return hash_merge128(acc, secret, uint64_t(size));
+}
+
+void hasher::reset(const uint64_t seed) noexcept
+{
+    hash_init(m_acc);
+    hash_init(m_secret, seed);
+    m_seed = seed;
+    m_size = 0;
+    m_buffered = 0;
+    m_stripes = 0;
+}
+void hasher::append(const void* data, size_t size) noexcept
+{
+    if (!size)
+        return;
+
+    auto ptr = static_cast<const uint8_t*>(data);
+    m_size += size;
+    if (m_buffered + size <= buffer_size)
+    {
+        memcpy(m_buffer + m_buffered, ptr, size);
+        m_buffered += size;
+        return;
+    }
+    //  more input follows, so the whole buffer can be consumed; its tail is kept for the last stripe
+    if (m_buffered)
+    {
+        const auto fill = buffer_size - m_buffered;
+        memcpy(m_buffer + m_buffered, ptr, fill);
+        ptr += fill;
+        size -= fill;
+        consume(m_buffer, buffer_size / stripe_size);
+        memcpy(m_last, m_buffer + buffer_size - stripe_size, stripe_size);
+        m_buffered = 0;
+    }
+    //  hash in place, leaving (192, 256] bytes in the buffer
+    if (size > buffer_size)
+    {
+        const auto stripes = (size - buffer_size + stripe_size - 1) / stripe_size;
+        consume(ptr, stripes);
+        ptr += stripes * stripe_size;
+        size -= stripes * stripe_size;
+    }
+    memcpy(m_buffer, ptr, size);
+    m_buffered = size;
+}
+uint64_t hasher::finish64() const noexcept
+{
+    if (m_size <= buffer_size)
+        return hash_short(m_buffer, size_t(m_size), m_seed);
+
+    uint64_t acc[8];
+    finish(acc);
+    return hash_merge(acc, m_secret + 11, m_size * hash_prime64[0]);
+}
+hash128 hasher::finish128() const noexcept
+{
+    if (m_size <= buffer_size)
+    {
+        hash128 output;
+        output.lo = hash_short(m_buffer, size_t(m_size), m_seed);
+        output.hi = hash_short(m_buffer, size_t(m_size), m_seed ^ hash_wyprime[3]);
+        return output;
+    }
+    uint64_t acc[8];
+    finish(acc);
+    return hash_merge128(acc, m_secret, m_size);
+}
+void hasher::consume(const uint8_t* data, const size_t stripes) noexcept
+{
+    hash_consume(m_acc, m_stripes, data, stripes, m_secret);
+}
+void hasher::finish(uint64_t (&acc)[8]) const noexcept
+{
+    memcpy(acc, m_acc, sizeof(m_acc));
+    auto block = m_stripes;
+    hash_consume(acc, block, m_buffer, (m_buffered - 1) / stripe_size, m_secret);
+
+    if (m_buffered >= stripe_size)
+    {
+        hash_last(acc, m_buffer + m_buffered - stripe_size, m_secret);
+    }
+    else
+    {
+        uint8_t stripe[stripe_size];
+        const auto tail = stripe_size - m_buffered;
+        memcpy(stripe, m_last + m_buffered, tail);
+        memcpy(stripe + tail, m_buffer, m_buffered);
+        hash_last(acc, stripe, m_secret);
+    }
+}
+
+error_type icy::hash_file(file& input, hash128& output, const uint64_t seed) noexcept
+{
+    array<uint8_t> buffer;
+    ICY_ERROR(buffer.resize(hash_file_chunk));
+
+    hasher hash(seed);
+    while (true)
+    {
+        auto size = buffer.size();
+        ICY_ERROR(input.read(buffer.data(), size));
+        if (!size)
+            break;
+        hash.append(buffer.data(), size);
+    }
+    output = hash.finish128();
+    return error_type();
+}
+error_type icy::hash_file(const string_view path, hash128& output, const uint64_t seed) noexcept
+{
+    file input;
+    ICY_ERROR(input.open(path, file_access::read, file_open::open_existing, file_share::read));
+    return hash_file(input, output, seed);
+}
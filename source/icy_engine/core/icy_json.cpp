@@ -2,6 +2,7 @@
 #include "jsmn.h"
 #include <cmath>
 #include <icy_engine/core/icy_color.hpp>
+#include <icy_engine/core/icy_trace.hpp>
 
 using namespace icy;
 
@@ -644,6 +645,7 @@ error_type icy::to_string(const json& json, string& str, const string_view tab)
 }
 error_type icy::to_value(const string_view str, json& root) noexcept
 {
+    ICY_TRACE_SCOPE("json::create");
     root = json_type::none;
     array<jsmntok_t> tokens;
     while (true)
@@ -0,0 +1,314 @@
+#include <icy_engine/core/icy_pixel.hpp>
+#if __AVX2__
+#include <immintrin.h>
+#elif _M_X64 || __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace icy;
+
+ICY_STATIC_NAMESPACE_BEG
+static const auto pixel_chunk = 256_z;  //  16-bit pixels are narrowed through a stack buffer
+//  JFIF YCbCr -> RGB in 2.14 fixed point (SIMD and scalar use the same integer math)
+static const auto pixel_shift = 14;
+static const auto pixel_one = 1 << pixel_shift;
+static const auto pixel_cr_r = 22970;   //  1.402
+static const auto pixel_cb_g = -5638;   //  -0.344136
+static const auto pixel_cr_g = -11700;  //  -0.714136
+static const auto pixel_cb_b = 29032;   //  1.772
+ICY_STATIC_NAMESPACE_END
+
+static inline uint8_t pixel_clamp(const int32_t value) noexcept
+{
+    return uint8_t(value < 0 ? 0 : value > 0xFF ? 0xFF : value);
+}
+//  round(value * 255 / 65535)
+static inline uint8_t pixel_narrow(const uint16_t value) noexcept
+{
+    return uint8_t((uint32_t(value) * 0xFF + 0x807F) >> 16);
+}
+
+static void pixel_rgb_to_bgra(const uint8_t* const src, color* const dst, const size_t count) noexcept
+{
+    auto k = 0_z;
+#if __AVX2__
+    //  8 pixels per step: two 16-byte loads (12 bytes used each) may read 4 bytes past the step
+    const auto shuffle = _mm256_setr_epi8(
+        2, 1, 0, -128, 5, 4, 3, -128, 8, 7, 6, -128, 11, 10, 9, -128,
+        2, 1, 0, -128, 5, 4, 3, -128, 8, 7, 6, -128, 11, 10, 9, -128);
+    const auto alpha = _mm256_set1_epi32(int(0xFF000000));
+    for (; k + 10 <= count; k += 8)
+    {
+        const auto lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 3 * k));
+        const auto hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 3 * k + 12));
+        const auto value = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + k), _mm256_or_si256(_mm256_shuffle_epi8(value, shuffle), alpha));
+    }
+#endif
+    for (; k < count; ++k)
+        dst[k] = color::from_bgra(src[3 * k + 2], src[3 * k + 1], src[3 * k + 0], 0xFF);
+}
+static void pixel_bgra_to_rgb(const color* const src, uint8_t* const dst, const size_t count) noexcept
+{
+    auto k = 0_z;
+#if __AVX2__
+    //  each 16-byte store carries 12 useful bytes; the next store overwrites the rest
+    const auto shuffle = _mm256_setr_epi8(
+        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -128, -128, -128, -128,
+        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -128, -128, -128, -128);
+    for (; k + 10 <= count; k += 8)
+    {
+        const auto value = _mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + k)), shuffle);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 3 * k), _mm256_castsi256_si128(value));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 3 * k + 12), _mm256_extracti128_si256(value, 1));
+    }
+#endif
+    for (; k < count; ++k)
+    {
+        dst[3 * k + 0] = src[k].r;
+        dst[3 * k + 1] = src[k].g;
+        dst[3 * k + 2] = src[k].b;
+    }
+}
+//  RGBA <-> BGRA (in place allowed)
+static void pixel_swizzle(const uint8_t* const src, uint8_t* const dst, const size_t count) noexcept
+{
+    auto k = 0_z;
+#if __AVX2__
+    const auto shuffle = _mm256_setr_epi8(
+        2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+        2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    for (; k + 8 <= count; k += 8)
+    {
+        const auto value = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + 4 * k));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + 4 * k), _mm256_shuffle_epi8(value, shuffle));
+    }
+#endif
+#if _M_X64 || __SSE2__
+    const auto mask = _mm_set1_epi32(0x00FF00FF);
+    for (; k + 4 <= count; k += 4)
+    {
+        const auto value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 4 * k));
+        const auto rb = _mm_and_si128(value, mask);
+        const auto swap = _mm_or_si128(_mm_slli_epi32(rb, 16), _mm_srli_epi32(rb, 16));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 4 * k), _mm_or_si128(_mm_andnot_si128(mask, value), swap));
+    }
+#endif
+    for (; k < count; ++k)
+    {
+        const uint8_t pixel[4] = { src[4 * k + 2], src[4 * k + 1], src[4 * k + 0], src[4 * k + 3] };
+        memcpy(dst + 4 * k, pixel, sizeof(pixel));
+    }
+}
+//  "count" samples
+static void pixel_narrow(const uint16_t* const src, uint8_t* const dst, const size_t count) noexcept
+{
+    auto k = 0_z;
+#if _M_X64 || __SSE2__
+    //  (v * 255 + 0x807F) >> 16 with 16-bit lanes: high half of the product plus the carry of the low half
+    const auto scale = _mm_set1_epi16(0xFF);
+    const auto sign = _mm_set1_epi16(short(0x8000));
+    const auto limit = _mm_set1_epi16(short(0x7F80 ^ 0x8000));
+    const auto narrow = [&](const __m128i value)
+    {
+        const auto lo = _mm_mullo_epi16(value, scale);
+        const auto hi = _mm_mulhi_epu16(value, scale);
+        const auto carry = _mm_cmpgt_epi16(_mm_xor_si128(lo, sign), limit);
+        return _mm_sub_epi16(hi, carry);
+    };
+    for (; k + 16 <= count; k += 16)
+    {
+        const auto lo = narrow(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + k)));
+        const auto hi = narrow(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + k + 8)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + k), _mm_packus_epi16(lo, hi));
+    }
+#endif
+    for (; k < count; ++k)
+        dst[k] = pixel_narrow(src[k]);
+}
+static void pixel_ycbcr_to_bgra(const uint8_t* const src, color* const dst, const size_t count) noexcept
+{
+    auto k = 0_z;
+#if __AVX2__
+    const auto pair = [](const int lo, const int hi)
+    {
+        return _mm256_set1_epi32(int((uint32_t(uint16_t(hi)) << 16) | uint16_t(lo)));
+    };
+    //  16-bit (Y, Cb), (Y, Cr) and (Cb, Cr) pairs per pixel, one "madd" per term pair
+    const auto shuffle_y_cb = _mm256_setr_epi8(
+        0, -128, 1, -128, 3, -128, 4, -128, 6, -128, 7, -128, 9, -128, 10, -128,
+        0, -128, 1, -128, 3, -128, 4, -128, 6, -128, 7, -128, 9, -128, 10, -128);
+    const auto shuffle_y_cr = _mm256_setr_epi8(
+        0, -128, 2, -128, 3, -128, 5, -128, 6, -128, 8, -128, 9, -128, 11, -128,
+        0, -128, 2, -128, 3, -128, 5, -128, 6, -128, 8, -128, 9, -128, 11, -128);
+    const auto shuffle_cb_cr = _mm256_setr_epi8(
+        1, -128, 2, -128, 4, -128, 5, -128, 7, -128, 8, -128, 10, -128, 11, -128,
+        1, -128, 2, -128, 4, -128, 5, -128, 7, -128, 8, -128, 10, -128, 11, -128);
+    const auto shuffle_out = _mm256_setr_epi8(
+        0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15,
+        0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+    const auto bias_y = pair(0, 128);
+    const auto bias_c = pair(128, 128);
+    const auto coef_r = pair(pixel_one, pixel_cr_r);
+    const auto coef_g0 = pair(pixel_one, pixel_cb_g);
+    const auto coef_g1 = pair(0, pixel_cr_g);
+    const auto coef_b = pair(pixel_one, pixel_cb_b);
+    const auto round = _mm256_set1_epi32(pixel_one / 2);
+    const auto alpha = _mm256_set1_epi32(0xFF);
+    for (; k + 10 <= count; k += 8)
+    {
+        const auto lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 3 * k));
+        const auto hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 3 * k + 12));
+        const auto value = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+        const auto y_cb = _mm256_sub_epi16(_mm256_shuffle_epi8(value, shuffle_y_cb), bias_y);
+        const auto y_cr = _mm256_sub_epi16(_mm256_shuffle_epi8(value, shuffle_y_cr), bias_y);
+        const auto cb_cr = _mm256_sub_epi16(_mm256_shuffle_epi8(value, shuffle_cb_cr), bias_c);
+
+        const auto r = _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(y_cr, coef_r), round), pixel_shift);
+        const auto g = _mm256_srai_epi32(_mm256_add_epi32(_mm256_add_epi32(
+            _mm256_madd_epi16(y_cb, coef_g0), _mm256_madd_epi16(cb_cr, coef_g1)), round), pixel_shift);
+        const auto b = _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(y_cb, coef_b), round), pixel_shift);
+
+        //  per lane: [b0..b3 g0..g3 r0..r3 a0..a3] -> [b0 g0 r0 a0 ...]
+        const auto bytes = _mm256_packus_epi16(_mm256_packs_epi32(b, g), _mm256_packs_epi32(r, alpha));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + k), _mm256_shuffle_epi8(bytes, shuffle_out));
+    }
+#endif
+    for (; k < count; ++k)
+    {
+        const auto y = int32_t(src[3 * k + 0]) * pixel_one + pixel_one / 2;
+        const auto cb = int32_t(src[3 * k + 1]) - 128;
+        const auto cr = int32_t(src[3 * k + 2]) - 128;
+        dst[k] = color::from_bgra(
+            pixel_clamp((y + pixel_cb_b * cb) >> pixel_shift),
+            pixel_clamp((y + pixel_cb_g * cb + pixel_cr_g * cr) >> pixel_shift),
+            pixel_clamp((y + pixel_cr_r * cr) >> pixel_shift), 0xFF);
+    }
+}
+
+size_t icy::pixel_size(const pixel_format format) noexcept
+{
+    switch (format)
+    {
+    case pixel_format::rgb8:
+    case pixel_format::ycbcr8:
+        return 3;
+    case pixel_format::rgba8:
+    case pixel_format::bgra8:
+        return 4;
+    case pixel_format::rgb16:
+        return 6;
+    case pixel_format::rgba16:
+        return 8;
+    default:
+        return 0;
+    }
+}
+error_type icy::pixel_convert(const pixel_format src_format, const void* const src,
+    const pixel_format dst_format, void* const dst, const size_t count) noexcept
+{
+    if (!count)
+        return error_type();
+    if (!src || !dst)
+        return make_stdlib_error(std::errc::invalid_argument);
+
+    const auto src_bytes = static_cast<const uint8_t*>(src);
+    const auto dst_bytes = static_cast<uint8_t*>(dst);
+    if (dst_format == pixel_format::bgra8)
+    {
+        const auto colors = static_cast<color*>(dst);
+        switch (src_format)
+        {
+        case pixel_format::rgb8:
+            pixel_rgb_to_bgra(src_bytes, colors, count);
+            return error_type();
+
+        case pixel_format::rgba8:
+            pixel_swizzle(src_bytes, dst_bytes, count);
+            return error_type();
+
+        case pixel_format::bgra8:
+            if (src != dst)
+                memcpy(dst, src, count * sizeof(color));
+            return error_type();
+
+        case pixel_format::ycbcr8:
+            pixel_ycbcr_to_bgra(src_bytes, colors, count);
+            return error_type();
+
+        case pixel_format::rgb16:
+        case pixel_format::rgba16:
+        {
+            const auto channels = src_format == pixel_format::rgb16 ? 3_z : 4_z;
+            const auto samples = static_cast<const uint16_t*>(src);
+            uint8_t buffer[pixel_chunk * 4];
+            for (auto offset = 0_z; offset < count; offset += pixel_chunk)
+            {
+                const auto size = std::min(pixel_chunk, count - offset);
+                pixel_narrow(samples + offset * channels, buffer, size * channels);
+                if (channels == 3)
+                    pixel_rgb_to_bgra(buffer, colors + offset, size);
+                else
+                    pixel_swizzle(buffer, dst_bytes + offset * sizeof(color), size);
+            }
+            return error_type();
+        }
+        default:
+            break;
+        }
+    }
+    else if (src_format == pixel_format::bgra8 && dst_format == pixel_format::rgba8)
+    {
+        pixel_swizzle(src_bytes, dst_bytes, count);
+        return error_type();
+    }
+    else if (src_format == pixel_format::bgra8 && dst_format == pixel_format::rgb8)
+    {
+        pixel_bgra_to_rgb(static_cast<const color*>(src), dst_bytes, count);
+        return error_type();
+    }
+    return make_stdlib_error(std::errc::invalid_argument);
+}
+error_type icy::pixel_convert(const pixel_format src_format, const void* const src, const size_t pitch, matrix_view<color> dst) noexcept
+{
+    const auto bytes = static_cast<const uint8_t*>(src);
+    for (auto row = 0_z; row < dst.rows(); ++row)
+        ICY_ERROR(pixel_convert(src_format, bytes + row * pitch, pixel_format::bgra8, dst.row(row).data(), dst.cols()));
+    return error_type();
+}
+void icy::pixel_premultiply(color* const data, const size_t count) noexcept
+{
+    auto k = 0_z;
+#if _M_X64 || __SSE2__
+    //  t = c * a + 128; (t + (t >> 8)) >> 8 is exact rounding of c * a / 255
+    const auto zero = _mm_setzero_si128();
+    const auto round = _mm_set1_epi16(0x80);
+    const auto alpha_mask = _mm_set1_epi32(int(0xFF000000));
+    const auto scale = [&](const __m128i value)
+    {
+        const auto alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(value, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+        const auto t = _mm_add_epi16(_mm_mullo_epi16(value, alpha), round);
+        return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+    };
+    for (; k + 4 <= count; k += 4)
+    {
+        const auto value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + k));
+        const auto lo = scale(_mm_unpacklo_epi8(value, zero));
+        const auto hi = scale(_mm_unpackhi_epi8(value, zero));
+        const auto result = _mm_or_si128(_mm_andnot_si128(alpha_mask, _mm_packus_epi16(lo, hi)), _mm_and_si128(value, alpha_mask));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(data + k), result);
+    }
+#endif
+    for (; k < count; ++k)
+    {
+        auto& pixel = data[k];
+        const auto scale = [&pixel](const uint8_t value)
+        {
+            const auto t = uint32_t(value) * pixel.a + 0x80;
+            return uint8_t((t + (t >> 8)) >> 8);
+        };
+        pixel.b = scale(pixel.b);
+        pixel.g = scale(pixel.g);
+        pixel.r = scale(pixel.r);
+    }
+}
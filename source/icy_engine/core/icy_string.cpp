@@ -1,6 +1,5 @@
 #include <icy_engine/core/icy_string.hpp>
 #include <icy_engine/core/icy_array.hpp>
-#include <guiddef.h>
 #include <Windows.h>
 #define snscanf _snscanf_s
 
@@ -8,8 +7,6 @@
 
 using namespace icy;
 
-static constexpr auto guid_string_length = sizeof("12345678-1234-1234-1234-1234567890AB");
-static constexpr auto guid_string_format = "%08lX-%04hX-%04hX-%02hhX%02hhX-%02hhX%02hhX%02hhX%02hhX%02hhX%02hhX";
 static constexpr auto time_string_format = "%d-%d-%d %d:%d:%d";
 
 string_iterator& string_iterator::operator++() noexcept
@@ -230,14 +227,6 @@ error_type string_view::to_utf16(wchar_t* const data, size_t* const size) const
     *size = size_t(length);
     return error_type();
 }
-error_type icy::to_value(const string_view str, float& value) noexcept
-{
-    return str.bytes().size() && snscanf(str.bytes().data(), str.bytes().size(), "%f", &value) == 1 ? error_type{} : make_stdlib_error(std::errc::illegal_byte_sequence);
-}
-error_type icy::to_value(const string_view str, double& value) noexcept
-{
-    return str.bytes().size() && snscanf(str.bytes().data(), str.bytes().size(), "%lf", &value) == 1 ? error_type{} : make_stdlib_error(std::errc::illegal_byte_sequence);
-}
 error_type icy::to_value(const string_view str, bool& value)  noexcept
 {
     if (str == "true"_s || str == "1"_s)
@@ -248,14 +237,6 @@ error_type icy::to_value(const string_view str, bool& value)  noexcept
         return make_stdlib_error(std::errc::illegal_byte_sequence);
     return error_type();
 }
-error_type icy::to_value(const string_view str, int64_t& value) noexcept
-{
-    return str.bytes().size() && snscanf(str.bytes().data(), str.bytes().size(), "%lli", &value) == 1 ? error_type{} : make_stdlib_error(std::errc::illegal_byte_sequence);
-}
-error_type icy::to_value(const string_view str, uint64_t& value) noexcept
-{
-    return str.bytes().size() && snscanf(str.bytes().data(), str.bytes().size(), "%llu", &value) == 1 ? error_type{} : make_stdlib_error(std::errc::illegal_byte_sequence);
-}
 error_type icy::to_value(const string_view str, std::chrono::system_clock::time_point& time, const bool local) noexcept
 {
     ::tm std_time = {};
@@ -285,21 +266,6 @@ error_type icy::to_value(const string_view str, clock_type::time_point& time, co
     time = now_steady - delta;
     return error_type();
 }
-error_type icy::to_value(const string_view str, guid& guid) noexcept
-{
-    auto& rguid = reinterpret_cast<GUID&>(guid);
-    if (str.bytes().size() + sizeof("") < guid_string_length)
-        return make_stdlib_error(std::errc::illegal_byte_sequence);
-
-    const auto count = str.bytes().size() ? snscanf(str.bytes().data(), str.bytes().size(), guid_string_format,
-        &rguid.Data1, &rguid.Data2, &rguid.Data3,
-        &rguid.Data4[0], &rguid.Data4[1], &rguid.Data4[2], &rguid.Data4[3],
-        &rguid.Data4[4], &rguid.Data4[5], &rguid.Data4[6], &rguid.Data4[7]) : 0;
-    if (count != 11)
-        return make_stdlib_error(std::errc::illegal_byte_sequence);
-    return error_type();
-}
-
 string::string(string&& rhs) noexcept : m_realloc(rhs.m_realloc), m_user(rhs.m_user)
 {
 	if (rhs.is_dynamic())
@@ -401,45 +367,6 @@ error_type icy::to_string(int64_t value, string& str) noexcept
 	memcpy(str.m_ptr, rbuffer, str.m_size = length - 1);
 	return error_type();
 }
-error_type icy::to_string(const guid& value, string& str) noexcept
-{
-    auto& rguid = reinterpret_cast<const GUID&>(value);
-	char buffer[guid_string_length];
-	const auto length = sprintf_s(buffer, guid_string_format,
-		rguid.Data1, rguid.Data2, rguid.Data3,
-        rguid.Data4[0], rguid.Data4[1], rguid.Data4[2], rguid.Data4[3],
-        rguid.Data4[4], rguid.Data4[5], rguid.Data4[6], rguid.Data4[7]);
-    ICY_ERROR(to_string(const_array_view<char>(buffer, length), str));
-    return error_type();
-}
-error_type icy::to_string(const double value, const float_type type, size_t precision, string& str) noexcept
-{
-	if (isnan(value) || isinf(value))
-		return make_stdlib_error(std::errc::invalid_argument);
-
-	char precision_fmt[3]{};
-	precision = DBL_DIG < precision ? DBL_DIG : precision;
-	auto digits = size_t(sprintf_s(precision_fmt, "%zu", precision));
-
-	char format[sizeof("%.##e")]{};
-	auto length = 0_z;
-	format[length++] = '%';
-	format[length++] = '.';
-	std::memcpy(format + length, precision_fmt, digits);
-	length += digits;
-	if (type == float_type_exp)
-		format[length++] = 'e';
-	else //if (type == float_type_fixed)
-		format[length++] = 'f';
-
-	char buf[512] = {};
-	digits = size_t(snprintf(nullptr, 0, format, value));
-	snprintf(buf, digits + 2, format, value);
-    string_view tmp;
-    ICY_ERROR(to_string(const_array_view<char>(buf, digits), tmp));
-    ICY_ERROR(copy(tmp, str));
-    return error_type();
-}
 error_type icy::to_string(const std::chrono::steady_clock::time_point time, string& str, const bool local) noexcept
 {   
     const auto now_system = std::chrono::system_clock::now();
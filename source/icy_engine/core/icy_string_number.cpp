@@ -0,0 +1,540 @@
+#include <icy_engine/core/icy_string.hpp>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <locale.h>
+#if __APPLE__
+#include <xlocale.h>
+#endif
+
+//  number and guid conversions: no platform headers, no dependency on the current locale, no allocations
+
+using namespace icy;
+
+static constexpr auto guid_string_length = sizeof("12345678-1234-1234-1234-1234567890AB");
+
+static const int8_t hex_value[256] =
+{
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+     0,  1,  2,  3,  4,  5,  6,  7,  8,  9, -1, -1, -1, -1, -1, -1,
+    -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+};
+static const char hex_digit[] = "0123456789ABCDEF";
+static const double exact_pow10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+static bool is_space(const char chr) noexcept
+{
+    return chr == ' ' || (chr >= '\t' && chr <= '\r');
+}
+//  SWAR: all 8 bytes are '0'..'9'
+static bool is_eight_digits(const uint64_t value) noexcept
+{
+    return ((value & 0xF0F0F0F0F0F0F0F0ull) |
+        (((value + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) >> 4)) == 0x3333333333333333ull;
+}
+//  SWAR: 8 little-endian ASCII digits -> value
+static uint32_t parse_eight_digits(uint64_t value) noexcept
+{
+    const auto mask = 0x000000FF000000FFull;
+    const auto mul1 = 0x000F424000000064ull;  //  100 + (1000000 << 32)
+    const auto mul2 = 0x0000271000000001ull;  //  1 + (10000 << 32)
+    value -= 0x3030303030303030ull;
+    value = (value * 10) + (value >> 8);
+    return uint32_t((((value & mask) * mul1) + (((value >> 16) & mask) * mul2)) >> 32);
+}
+//  decimal digits -> value, returns digit count; "overflow" is set when the value doesn't fit 64 bits
+static size_t parse_digits(const char* const begin, const char* const end, uint64_t& value, bool& overflow) noexcept
+{
+    auto ptr = begin;
+    value = 0;
+    overflow = false;
+    while (end - ptr >= 8 && value < 100000000000ull)
+    {
+        uint64_t chunk = 0;
+        memcpy(&chunk, ptr, sizeof(chunk));
+        if (!is_eight_digits(chunk))
+            break;
+        value = value * 100000000 + parse_eight_digits(chunk);
+        ptr += 8;
+    }
+    for (; ptr < end && *ptr >= '0' && *ptr <= '9'; ++ptr)
+    {
+        const auto digit = uint64_t(*ptr - '0');
+        if (value > (UINT64_MAX - digit) / 10)
+            overflow = true;
+        value = value * 10 + digit;
+    }
+    return size_t(ptr - begin);
+}
+//  [spaces][sign]digits or [spaces][sign]0x hex digits; trailing text is ignored (as with sscanf)
+static error_type parse_integer(const string_view str, uint64_t& value, bool& negative) noexcept
+{
+    auto ptr = str.bytes().data();
+    const auto end = ptr + str.bytes().size();
+    while (ptr < end && is_space(*ptr))
+        ++ptr;
+
+    negative = false;
+    if (ptr < end && (*ptr == '-' || *ptr == '+'))
+        negative = *ptr++ == '-';
+
+    if (end - ptr > 2 && ptr[0] == '0' && (ptr[1] == 'x' || ptr[1] == 'X') && hex_value[uint8_t(ptr[2])] >= 0)
+    {
+        value = 0;
+        ptr += 2;
+        const auto first = ptr;
+        for (; ptr < end && hex_value[uint8_t(*ptr)] >= 0; ++ptr)
+            value = (value << 4) | uint64_t(hex_value[uint8_t(*ptr)]);
+        return ptr - first > 16 ? make_stdlib_error(std::errc::result_out_of_range) : error_type();
+    }
+    auto overflow = false;
+    if (!parse_digits(ptr, end, value, overflow))
+        return make_stdlib_error(std::errc::illegal_byte_sequence);
+    if (overflow)
+        return make_stdlib_error(std::errc::result_out_of_range);
+    return error_type();
+}
+//  Clinger fast path: up to 19 significant digits and a decimal exponent where both the mantissa (<= 2^53)
+//  and the power of ten are exact doubles; anything else goes to the C-locale strtod
+static error_type parse_double(const string_view str, double& value) noexcept
+{
+    const auto begin = str.bytes().data();
+    const auto end = begin + str.bytes().size();
+    auto ptr = begin;
+    while (ptr < end && is_space(*ptr))
+        ++ptr;
+    const auto first = ptr;
+
+    auto negative = false;
+    if (ptr < end && (*ptr == '-' || *ptr == '+'))
+        negative = *ptr++ == '-';
+
+    auto mantissa = 0ull;
+    auto exponent = 0ll;
+    auto digits = 0;
+    auto any = false;
+    for (; ptr < end && *ptr >= '0' && *ptr <= '9'; ++ptr, any = true)
+    {
+        if (digits < 19)
+        {
+            mantissa = mantissa * 10 + uint64_t(*ptr - '0');
+            digits += mantissa != 0;
+        }
+        else
+        {
+            ++exponent;
+            digits = 20;
+        }
+    }
+    if (ptr < end && *ptr == '.')
+    {
+        for (++ptr; ptr < end && *ptr >= '0' && *ptr <= '9'; ++ptr, any = true)
+        {
+            if (digits < 19)
+            {
+                mantissa = mantissa * 10 + uint64_t(*ptr - '0');
+                digits += mantissa != 0;
+                --exponent;
+            }
+            else
+            {
+                digits = 20;
+            }
+        }
+    }
+    if (any && ptr < end && (*ptr == 'e' || *ptr == 'E'))
+    {
+        auto exp_ptr = ptr + 1;
+        auto exp_negative = false;
+        if (exp_ptr < end && (*exp_ptr == '-' || *exp_ptr == '+'))
+            exp_negative = *exp_ptr++ == '-';
+        auto exp_value = 0ll;
+        auto exp_any = false;
+        for (; exp_ptr < end && *exp_ptr >= '0' && *exp_ptr <= '9'; ++exp_ptr, exp_any = true)
+        {
+            if (exp_value < 100000)
+                exp_value = exp_value * 10 + (*exp_ptr - '0');
+        }
+        if (exp_any)
+            exponent += exp_negative ? -exp_value : exp_value;
+    }
+    if (any && digits <= 19 && mantissa <= (1ull << 53) && exponent >= -22 && exponent <= 22)
+    {
+        value = double(mantissa);
+        value = exponent < 0 ? value / exact_pow10[-exponent] : value * exact_pow10[exponent];
+        if (negative)
+            value = -value;
+        return error_type();
+    }
+
+    //  slow path (long mantissas, huge exponents, inf/nan, hex floats)
+    char buffer[512];
+    const auto length = std::min(size_t(end - first), sizeof(buffer) - 1);
+    if (!length)
+        return make_stdlib_error(std::errc::illegal_byte_sequence);
+    memcpy(buffer, first, length);
+    buffer[length] = '\0';
+    char* last = nullptr;
+#if _WIN32
+    static const auto locale = _create_locale(LC_NUMERIC, "C");
+    value = _strtod_l(buffer, &last, locale);
+#else
+    static const auto locale = newlocale(LC_NUMERIC_MASK, "C", locale_t(0));
+    value = strtod_l(buffer, &last, locale);
+#endif
+    return last == buffer ? make_stdlib_error(std::errc::illegal_byte_sequence) : error_type();
+}
+
+//  fixed-size unsigned integer for exact decimal printing: the largest intermediate value is
+//  2 * 2^53 * 10^339 (exponent form of the smallest subnormal), which fits in 1280 bits
+class decimal_number
+{
+public:
+    explicit decimal_number(const uint64_t value) noexcept : m_limbs{ uint32_t(value), uint32_t(value >> 32) }
+    {
+        m_size = m_limbs[1] ? 2 : m_limbs[0] ? 1 : 0;
+    }
+    bool is_odd() const noexcept
+    {
+        return m_size && (m_limbs[0] & 1);
+    }
+    //  the value if it fits 64 bits, UINT64_MAX otherwise
+    uint64_t value() const noexcept
+    {
+        if (m_size > 2)
+            return UINT64_MAX;
+        return (m_size > 1 ? uint64_t(m_limbs[1]) << 32 : 0) | (m_size ? m_limbs[0] : 0);
+    }
+    void shift_left(const size_t bits) noexcept
+    {
+        if (!m_size)
+            return;
+        const auto words = bits / 32;
+        const auto shift = bits % 32;
+        if (shift)
+        {
+            auto carry = 0u;
+            for (auto k = 0_z; k < m_size; ++k)
+            {
+                const auto limb = m_limbs[k];
+                m_limbs[k] = (limb << shift) | carry;
+                carry = limb >> (32 - shift);
+            }
+            if (carry)
+                m_limbs[m_size++] = carry;
+        }
+        if (words)
+        {
+            memmove(m_limbs + words, m_limbs, m_size * sizeof(m_limbs[0]));
+            memset(m_limbs, 0, words * sizeof(m_limbs[0]));
+            m_size += words;
+        }
+    }
+    //  returns true if any non-zero bits were shifted out
+    bool shift_right(const size_t bits) noexcept
+    {
+        const auto words = bits / 32;
+        const auto shift = bits % 32;
+        if (words >= m_size)
+        {
+            const auto inexact = m_size != 0;
+            m_size = 0;
+            return inexact;
+        }
+        auto inexact = false;
+        for (auto k = 0_z; k < words; ++k)
+            inexact |= m_limbs[k] != 0;
+        if (words)
+        {
+            memmove(m_limbs, m_limbs + words, (m_size - words) * sizeof(m_limbs[0]));
+            m_size -= words;
+        }
+        if (shift)
+        {
+            inexact |= (m_limbs[0] & ((1u << shift) - 1)) != 0;
+            for (auto k = 0_z; k < m_size; ++k)
+                m_limbs[k] = (m_limbs[k] >> shift) | (k + 1 < m_size ? m_limbs[k + 1] << (32 - shift) : 0);
+            if (!m_limbs[m_size - 1])
+                --m_size;
+        }
+        return inexact;
+    }
+    void multiply(const uint32_t factor) noexcept
+    {
+        auto carry = 0ull;
+        for (auto k = 0_z; k < m_size; ++k)
+        {
+            carry += uint64_t(m_limbs[k]) * factor;
+            m_limbs[k] = uint32_t(carry);
+            carry >>= 32;
+        }
+        if (carry)
+            m_limbs[m_size++] = uint32_t(carry);
+    }
+    //  returns the remainder
+    uint32_t divide(const uint32_t divisor) noexcept
+    {
+        auto remainder = 0ull;
+        for (auto k = m_size; k--; )
+        {
+            remainder = (remainder << 32) | m_limbs[k];
+            m_limbs[k] = uint32_t(remainder / divisor);
+            remainder %= divisor;
+        }
+        while (m_size && !m_limbs[m_size - 1])
+            --m_size;
+        return uint32_t(remainder);
+    }
+    void increment() noexcept
+    {
+        for (auto k = 0_z; k < m_size; ++k)
+        {
+            if (++m_limbs[k])
+                return;
+        }
+        m_limbs[m_size++] = 1;
+    }
+    bool is_zero() const noexcept
+    {
+        return !m_size;
+    }
+private:
+    uint32_t m_limbs[40];
+    size_t m_size = 0;
+};
+static const uint32_t small_pow10[] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000 };
+
+//  mantissa * 2^exp2 * 10^exp10 rounded to the nearest integer (ties to even, as printf does)
+static decimal_number scale_round(const uint64_t mantissa, const int exp2, const int exp10) noexcept
+{
+    //  one extra bit below the result keeps the half, "inexact" keeps everything under it
+    auto number = decimal_number(mantissa);
+    number.shift_left(1 + (exp2 > 0 ? size_t(exp2) : 0));
+    for (auto k = exp10; k > 0; k -= 9)
+        number.multiply(small_pow10[k < 9 ? k : 9]);
+
+    auto inexact = exp2 < 0 && number.shift_right(size_t(-exp2));
+    for (auto k = -exp10; k > 0; k -= 9)
+        inexact |= number.divide(small_pow10[k < 9 ? k : 9]) != 0;
+
+    const auto half = number.is_odd();
+    number.shift_right(1);
+    if (half && (inexact || number.is_odd()))
+        number.increment();
+    return number;
+}
+
+error_type icy::to_value(const string_view str, float& value) noexcept
+{
+    auto dvalue = 0.0;
+    ICY_ERROR(parse_double(str, dvalue));
+    value = float(dvalue);
+    return error_type();
+}
+error_type icy::to_value(const string_view str, double& value) noexcept
+{
+    return parse_double(str, value);
+}
+error_type icy::to_value(const string_view str, int64_t& value) noexcept
+{
+    uint64_t integer = 0;
+    auto negative = false;
+    ICY_ERROR(parse_integer(str, integer, negative));
+    if (integer > (negative ? 0x8000000000000000ull : 0x7FFFFFFFFFFFFFFFull))
+        return make_stdlib_error(std::errc::result_out_of_range);
+    value = negative ? int64_t(0 - integer) : int64_t(integer);
+    return error_type();
+}
+error_type icy::to_value(const string_view str, uint64_t& value) noexcept
+{
+    uint64_t integer = 0;
+    auto negative = false;
+    ICY_ERROR(parse_integer(str, integer, negative));
+    value = negative ? 0 - integer : integer;
+    return error_type();
+}
+error_type icy::to_value(const string_view str, guid& guid) noexcept
+{
+    //  XXXXXXXX-XXXX-XXXX-XXXX-XXXXXXXXXXXX: Data1, Data2, Data3 (native integers), then 8 bytes of Data4
+    static const uint8_t layout[] = { 4, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1 };
+    if (str.bytes().size() + sizeof("") < guid_string_length)
+        return make_stdlib_error(std::errc::illegal_byte_sequence);
+
+    auto ptr = str.bytes().data();
+    uint8_t bytes[sizeof(icy::guid)];
+    auto offset = 0_z;
+    for (auto k = 0u; k < sizeof(layout); ++k)
+    {
+        uint32_t field = 0;
+        for (auto n = 0u; n < layout[k] * 2u; ++n)
+        {
+            const auto digit = hex_value[uint8_t(*ptr++)];
+            if (digit < 0)
+                return make_stdlib_error(std::errc::illegal_byte_sequence);
+            field = (field << 4) | uint32_t(digit);
+        }
+        if (k < 3 || k == 4)
+        {
+            if (*ptr++ != '-')
+                return make_stdlib_error(std::errc::illegal_byte_sequence);
+        }
+
+        if (layout[k] == 4)
+        {
+            memcpy(bytes + offset, &field, 4);
+        }
+        else if (layout[k] == 2)
+        {
+            const auto half = uint16_t(field);
+            memcpy(bytes + offset, &half, 2);
+        }
+        else
+        {
+            bytes[offset] = uint8_t(field);
+        }
+        offset += layout[k];
+    }
+    memcpy(&guid, bytes, sizeof(bytes));
+    return error_type();
+}
+size_t icy::detail::double_to_chars(const double value, const float_type type, size_t precision, char* const buffer) noexcept
+{
+    if (!std::isfinite(value))
+        return 0;
+    precision = DBL_DIG < precision ? DBL_DIG : precision;
+
+    uint64_t bits = 0;
+    memcpy(&bits, &value, sizeof(bits));
+    const auto biased = int((bits >> 52) & 0x7FF);
+    auto mantissa = bits & ((1ull << 52) - 1);
+    if (biased)
+        mantissa |= 1ull << 52;
+    const auto exp2 = (biased ? biased : 1) - 1075;
+
+    auto ptr = buffer;
+    if (std::signbit(value))
+        *ptr++ = '-';
+
+    //  digits go backwards into "digits"; "first" is the most significant one
+    char digits[double_chars_max];
+    const auto end = digits + _countof(digits);
+    auto first = end;
+    auto exp10 = 0;
+    if (type == float_type_exp)
+    {
+        //  log10 only guesses the exponent: the loop settles it on exactly precision + 1 digits
+        auto scaled = 0ull;
+        if (mantissa)
+        {
+            exp10 = int(std::floor(std::log10(std::fabs(value))));
+            while (true)
+            {
+                scaled = scale_round(mantissa, exp2, int(precision) - exp10).value();
+                if (scaled >= uint64_t(exact_pow10[precision + 1]))
+                    ++exp10;
+                else if (scaled < uint64_t(exact_pow10[precision]))
+                    --exp10;
+                else
+                    break;
+            }
+        }
+        first -= detail::format_uint(scaled, end);
+    }
+    else
+    {
+        auto scaled = scale_round(mantissa, exp2, int(precision));
+        while (true)
+        {
+            const auto chunk = scaled.divide(small_pow10[9]);
+            if (scaled.is_zero())
+            {
+                first -= detail::format_uint(chunk, first);
+                break;
+            }
+            const auto length = detail::format_uint(chunk, first);
+            first -= length;
+            for (auto k = length; k < 9; ++k)
+                *--first = '0';
+        }
+    }
+    while (size_t(end - first) < precision + 1)
+        *--first = '0';
+
+    const auto whole = type == float_type_exp ? 1 : size_t(end - first) - precision;
+    memcpy(ptr, first, whole);
+    ptr += whole;
+    if (precision)
+    {
+        *ptr++ = '.';
+        memcpy(ptr, first + whole, precision);
+        ptr += precision;
+    }
+    if (type == float_type_exp)
+    {
+        *ptr++ = 'e';
+        *ptr++ = exp10 < 0 ? '-' : '+';
+        const auto abs = uint64_t(exp10 < 0 ? -exp10 : exp10);
+        if (abs < 10)
+            *ptr++ = '0';
+        ptr += detail::format_uint(abs, ptr + (abs < 10 ? 1 : abs < 100 ? 2 : 3));
+    }
+    return size_t(ptr - buffer);
+}
+error_type icy::to_string(const double value, const float_type type, const size_t precision, string& str) noexcept
+{
+    char buffer[detail::double_chars_max];
+    const auto length = detail::double_to_chars(value, type, precision, buffer);
+    if (!length)
+        return make_stdlib_error(std::errc::invalid_argument);
+    return to_string(string_view(buffer, length, string_view::constexpr_tag()), str);
+}
+size_t icy::detail::guid_to_chars(const guid& value, char* const buffer) noexcept
+{
+    uint8_t bytes[sizeof(guid)];
+    memcpy(bytes, &value, sizeof(bytes));
+    uint32_t data1 = 0;
+    uint16_t data2 = 0;
+    uint16_t data3 = 0;
+    memcpy(&data1, bytes + 0, 4);
+    memcpy(&data2, bytes + 4, 2);
+    memcpy(&data3, bytes + 6, 2);
+
+    auto ptr = buffer;
+    const auto write = [&ptr](const uint32_t field, const size_t digits)
+    {
+        for (auto k = digits; k--; )
+            *ptr++ = hex_digit[(field >> (4 * k)) & 0x0F];
+    };
+    write(data1, 8);
+    *ptr++ = '-';
+    write(data2, 4);
+    *ptr++ = '-';
+    write(data3, 4);
+    *ptr++ = '-';
+    write(bytes[8], 2);
+    write(bytes[9], 2);
+    *ptr++ = '-';
+    for (auto k = 10u; k < 16u; ++k)
+        write(bytes[k], 2);
+    return size_t(ptr - buffer);
+}
+error_type icy::to_string(const guid& value, string& str) noexcept
+{
+    char buffer[guid_string_length];
+    const auto length = detail::guid_to_chars(value, buffer);
+    return to_string(string_view(buffer, length, string_view::constexpr_tag()), str);
+}
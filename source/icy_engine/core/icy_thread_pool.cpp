@@ -0,0 +1,327 @@
+#include <icy_engine/core/icy_thread_pool.hpp>
+#include <icy_engine/core/icy_memory.hpp>
+#include <icy_engine/core/icy_trace.hpp>
+#include <windows.h>
+
+using namespace icy;
+
+ICY_STATIC_NAMESPACE_BEG
+enum : uint32_t
+{
+    pool_spin_count = 64,           //  empty polls before a worker goes to sleep
+    pool_closed = 0x80000000,       //  "pool_event_system::m_pending" after "shutdown"
+};
+struct pool_thread_data
+{
+    const thread_pool* pool = nullptr;          //  the pool this thread is a worker of
+    uint32_t index = 0;
+    const pool_event_system* drain = nullptr;   //  the system whose "handle" runs on this thread
+    bool closed = false;                        //  "drain" was shut down from its own "handle"
+};
+static thread_local pool_thread_data g_thread;
+ICY_STATIC_NAMESPACE_END
+
+class thread_pool::thread_type : public thread
+{
+public:
+    thread_type(thread_pool& pool, const size_t index) noexcept : m_pool(pool), m_index(index)
+    {
+
+    }
+    void cancel() noexcept override
+    {
+        //  "m_quit" is already set: wake up and exit once the queues are drained
+        m_sync.wake();
+    }
+protected:
+    error_type run() noexcept override
+    {
+        m_pool.work(m_index);
+        return error_type();
+    }
+public:
+    thread_pool& m_pool;
+    const size_t m_index;
+    mpmc_queue<thread_pool_task> m_queue;
+    sync_handle m_sync;
+    std::atomic<bool> m_idle = false;
+};
+
+thread_pool::thread_pool(tag) noexcept
+{
+
+}
+thread_pool::~thread_pool() noexcept
+{
+    m_quit.store(true, std::memory_order_seq_cst);
+    for (auto&& thread : m_threads)
+        thread->wait();
+}
+error_type thread_pool::initialize(const thread_pool_options& options) noexcept
+{
+    ICY_ERROR(m_lock.initialize());
+    const auto capacity = std::max(options.capacity, 1_z);
+    for (auto&& queue : m_queue)
+        ICY_ERROR(queue.initialize(capacity));
+
+    const auto count = options.threads ? options.threads : std::max(thread::cores(), 1_z);
+    ICY_ERROR(m_threads.reserve(count));
+    for (auto k = 0_z; k < count; ++k)
+    {
+        shared_ptr<thread_type> new_thread;
+        ICY_ERROR(make_shared(new_thread, *this, k));
+        ICY_ERROR(new_thread->m_queue.initialize(capacity));
+        ICY_ERROR(new_thread->m_sync.initialize());
+        ICY_ERROR(m_threads.push_back(std::move(new_thread)));
+    }
+    for (auto k = 0_z; k < count; ++k)
+    {
+        ICY_ERROR(m_threads[k]->launch());
+        if (options.pin && k < sizeof(DWORD_PTR) * 8)
+        {
+            if (!SetThreadAffinityMask(m_threads[k]->handle(), DWORD_PTR(1) << k))
+                return last_system_error();
+        }
+    }
+    return error_type();
+}
+error_type thread_pool::post(const thread_pool_task task, const thread_pool_priority priority, const uint32_t affinity) noexcept
+{
+    if (!task.func || priority >= thread_pool_priority::_total)
+        return make_stdlib_error(std::errc::invalid_argument);
+
+    auto index = affinity == any_thread ? m_threads.size() : affinity % m_threads.size();
+    auto task_copy = task;
+    auto& queue = index < m_threads.size() ? m_threads[index]->m_queue : m_queue[uint32_t(priority)];
+    if (!queue.push(std::move(task_copy)))
+        return make_stdlib_error(std::errc::no_buffer_space);
+
+    //  pairs with the fence in "work": either the worker sees the task or we see it idle
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    ICY_TRACE_HOT_COUNTER("thread_pool::idle", m_idle.load(std::memory_order_relaxed));
+    if (m_idle.load(std::memory_order_relaxed) == 0)
+        return error_type();
+
+    if (index < m_threads.size())
+    {
+        auto& thread = *m_threads[index];
+        auto idle = true;
+        if (thread.m_idle.compare_exchange_strong(idle, false, std::memory_order_acq_rel))
+        {
+            m_idle.fetch_sub(1, std::memory_order_release);
+            return thread.m_sync.wake();
+        }
+    }
+    //  any idle worker: it either takes the shared task or steals the pinned one
+    for (auto&& ptr : m_threads)
+    {
+        auto idle = true;
+        if (ptr->m_idle.compare_exchange_strong(idle, false, std::memory_order_acq_rel))
+        {
+            m_idle.fetch_sub(1, std::memory_order_release);
+            return ptr->m_sync.wake();
+        }
+    }
+    return error_type();
+}
+error_type thread_pool::error() const noexcept
+{
+    ICY_LOCK_GUARD(m_lock);
+    return m_error;
+}
+uint32_t thread_pool::this_index() const noexcept
+{
+    return g_thread.pool == this ? g_thread.index : any_thread;
+}
+bool thread_pool::pop(const size_t index, thread_pool_task& task) noexcept
+{
+    if (m_threads[index]->m_queue.pop(task))
+        return true;
+    for (auto&& queue : m_queue)
+    {
+        if (queue.pop(task))
+            return true;
+    }
+    for (auto k = 1_z; k < m_threads.size(); ++k)
+    {
+        if (m_threads[(index + k) % m_threads.size()]->m_queue.pop(task))
+            return true;
+    }
+    return false;
+}
+bool thread_pool::help(const size_t index) noexcept
+{
+    thread_pool_task task;
+    if (!pop(index, task))
+        return false;
+    exec(task);
+    return true;
+}
+void thread_pool::exec(const thread_pool_task& task) noexcept
+{
+    ICY_TRACE_HOT_SCOPE("thread_pool::task");
+    if (const auto error = task.func(task.user))
+    {
+        ICY_LOCK_GUARD(m_lock);
+        if (!m_error)
+            m_error = error;
+    }
+}
+void thread_pool::work(const size_t index) noexcept
+{
+    g_thread.pool = this;
+    g_thread.index = uint32_t(index);
+
+    auto& thread = *m_threads[index];
+    auto spin = 0u;
+    while (true)
+    {
+        thread_pool_task task;
+        if (pop(index, task))
+        {
+            spin = 0;
+            exec(task);
+            continue;
+        }
+        if (m_quit.load(std::memory_order_acquire))
+            break;
+        if (++spin < pool_spin_count)
+        {
+            sleep(clock_type::duration());
+            continue;
+        }
+        spin = 0;
+        m_idle.fetch_add(1, std::memory_order_release);
+        thread.m_idle.store(true, std::memory_order_release);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (pop(index, task) || m_quit.load(std::memory_order_acquire))
+        {
+            //  lost the race with "post": nobody woke us, undo the announcement ourselves
+            auto idle = true;
+            if (thread.m_idle.compare_exchange_strong(idle, false, std::memory_order_acq_rel))
+                m_idle.fetch_sub(1, std::memory_order_release);
+            if (task.func)
+                exec(task);
+            continue;
+        }
+        thread.m_sync.wait();
+        //  woken by "post" (which cleared "m_idle") or by "cancel"
+        auto idle = true;
+        if (thread.m_idle.compare_exchange_strong(idle, false, std::memory_order_acq_rel))
+            m_idle.fetch_sub(1, std::memory_order_release);
+    }
+}
+error_type icy::create_thread_pool(shared_ptr<thread_pool>& pool, const thread_pool_options& options) noexcept
+{
+    shared_ptr<thread_pool> new_pool;
+    ICY_ERROR(make_shared(new_pool, thread_pool::tag()));
+    ICY_ERROR(new_pool->initialize(options));
+    pool = std::move(new_pool);
+    return error_type();
+}
+
+error_type pool_event_system::initialize(shared_ptr<thread_pool> pool, const uint64_t mask, const thread_pool_priority priority, const uint32_t affinity) noexcept
+{
+    if (!pool)
+        return make_stdlib_error(std::errc::invalid_argument);
+
+    m_pool = std::move(pool);
+    m_priority = priority;
+    m_affinity = affinity;
+    m_pending.store(0, std::memory_order_release);
+    filter(mask);
+    return error_type();
+}
+void pool_event_system::shutdown() noexcept
+{
+    if (g_thread.drain == this)
+    {
+        //  from "handle": the pending drain is the caller and would never finish while we wait
+        g_thread.closed = true;
+        m_pending.store(pool_closed, std::memory_order_release);
+        filter(0);
+        return;
+    }
+    //  on a worker of our pool the drain may be queued behind the caller (a one-thread pool,
+    //  or the caller is the worker in "m_affinity"): run tasks here instead of sleeping
+    const auto index = m_pool ? m_pool->this_index() : thread_pool::any_thread;
+    auto pending = 0u;
+    while (!m_pending.compare_exchange_weak(pending, pool_closed, std::memory_order_acq_rel))
+    {
+        if (pending & pool_closed)
+            return;
+        pending = 0;
+        if (index == thread_pool::any_thread || !m_pool->help(index))
+            sleep(clock_type::duration());
+    }
+    filter(0);
+}
+error_type pool_event_system::signal(const event_data* event) noexcept
+{
+    if (!event)
+        return error_type();    //  quit: "drain" drops whatever is left
+
+    if (m_pending.fetch_add(1, std::memory_order_acq_rel) != 0)
+        return error_type();    //  already scheduled (or closed)
+
+    if (const auto error = schedule())
+    {
+        //  the event stays queued: the next signal retries
+        m_pending.store(0, std::memory_order_release);
+        return error;
+    }
+    return error_type();
+}
+error_type pool_event_system::schedule() noexcept
+{
+    thread_pool_task task;
+    task.func = &pool_event_system::drain;
+    task.user = this;
+    return m_pool->post(task, m_priority, m_affinity);
+}
+error_type pool_event_system::drain(void* user) noexcept
+{
+    const auto self = static_cast<pool_event_system*>(user);
+    //  "shutdown" may run another system's drain inline: keep the outer one
+    const auto prev_drain = g_thread.drain;
+    const auto prev_closed = g_thread.closed;
+    g_thread.drain = self;
+    g_thread.closed = false;
+    ICY_SCOPE_EXIT{ g_thread.drain = prev_drain; g_thread.closed = prev_closed; };
+
+    error_type error;
+    auto pending = self->m_pending.load(std::memory_order_acquire);
+    auto count = 0_z;
+    while (true)
+    {
+        while (count < drain_batch)
+        {
+            auto event = self->pop();
+            if (!event)
+                break;
+            ++count;
+            if (!*self || error)
+                continue;
+            error = self->handle(event);
+            if (g_thread.closed)
+                return error;   //  shut down from "handle": "self" may already be destroyed
+            if (error)
+                self->post_quit_event();
+        }
+        if (count == drain_batch && !error)
+        {
+            //  more may be queued: yield the worker and continue in a new task ("m_pending" stays set,
+            //  so signals meanwhile do not schedule another one). If the post fails, keep going here
+            if (!self->schedule())
+                return error_type();
+            count = 0;
+            continue;
+        }
+        count = 0;
+        //  a signal that arrived meanwhile bumped the counter: go around again;
+        //  once it is back to zero "self" may be destroyed and must not be touched
+        if (self->m_pending.compare_exchange_strong(pending, 0, std::memory_order_acq_rel))
+            break;
+    }
+    return error;
+}
@@ -0,0 +1,229 @@
+#include <icy_engine/core/icy_trace.hpp>
+#include <icy_engine/core/icy_array.hpp>
+#include <icy_engine/core/icy_atomic.hpp>
+#include <icy_engine/core/icy_file.hpp>
+#include <icy_engine/core/icy_string.hpp>
+#include <icy_engine/core/icy_thread.hpp>
+#include <cstdarg>
+#include <cstdio>
+
+using namespace icy;
+
+ICY_STATIC_NAMESPACE_BEG
+//  single writer (the owning thread) publishes "head" after filling the slot.
+//  Never freed: when its thread exits the ring is marked unused and the next new thread takes it over,
+//  so there are at most as many rings as threads that ever traced at the same time
+struct trace_buffer
+{
+    enum : uint64_t { capacity = 0x10000 };
+    std::atomic<uint64_t> head = 0;
+    std::atomic<uint64_t> first = 0;        //  "head" when the current thread took the ring over
+    std::atomic<uint32_t> thread = 0;
+    std::atomic<bool> used = true;
+    trace_buffer* next = nullptr;
+    trace_event events[capacity];
+};
+//  releases the calling thread's ring on thread exit; touched once per thread
+//  (unlike "g_buffer", it has a destructor, so every access would go through the TLS init guard)
+struct trace_thread
+{
+    ~trace_thread() noexcept;
+    trace_buffer* buffer = nullptr;
+};
+std::atomic<trace_buffer*> g_buffers = nullptr;
+std::atomic<trace_histogram*> g_histograms = nullptr;
+std::atomic<int64_t> g_begin = 0;     //  ticks
+mutex g_lock;
+int64_t g_calibrate_ticks = 0;      //  "trace_now" and "clock_type::now" sampled together
+clock_type::time_point g_calibrate_time;
+static thread_local trace_buffer* g_buffer = nullptr;
+static thread_local trace_thread g_thread;
+static thread_local bool g_exit = false;    //  events recorded during thread teardown are dropped
+
+trace_thread::~trace_thread() noexcept
+{
+    g_exit = true;
+    g_buffer = nullptr;
+    if (buffer)
+        buffer->used.store(false, std::memory_order_release);
+}
+
+static error_type trace_append(string& str, const char* const format, ...) noexcept
+{
+    char buffer[512];
+    va_list args;
+    va_start(args, format);
+    const auto length = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    if (length < 0 || size_t(length) >= sizeof(buffer))
+        return make_stdlib_error(std::errc::value_too_large);
+    return str.append(string_view(buffer, size_t(length), string_view::constexpr_tag()));
+}
+//  "%.3f" that ignores the C locale (a "," decimal separator would break the JSON)
+static error_type trace_append_time(string& str, const double value) noexcept
+{
+    char buffer[detail::double_chars_max];
+    const auto length = detail::double_to_chars(value, float_type_fixed, 3, buffer);
+    if (!length)
+        return make_stdlib_error(std::errc::invalid_argument);
+    return str.append(string_view(buffer, length, string_view::constexpr_tag()));
+}
+static int64_t trace_calibrate() noexcept
+{
+    ICY_LOCK_GUARD(g_lock);
+    g_calibrate_time = clock_type::now();
+    g_calibrate_ticks = trace_now();
+    return g_calibrate_ticks;
+}
+ICY_STATIC_NAMESPACE_END
+
+void icy::trace_record(const trace_event& event) noexcept
+{
+    auto buffer = g_buffer;
+    if (!buffer)
+    {
+        if (g_exit)
+            return;
+        for (auto it = g_buffers.load(std::memory_order_acquire); it; it = it->next)
+        {
+            auto used = false;
+            if (it->used.compare_exchange_strong(used, true, std::memory_order_acq_rel))
+            {
+                //  the previous owner's events stay until they are overwritten, but are not exported as ours
+                it->first.store(it->head.load(std::memory_order_relaxed), std::memory_order_release);
+                buffer = it;
+                break;
+            }
+        }
+        if (!buffer)
+        {
+            buffer = allocator_type::allocate<trace_buffer>(1);
+            if (!buffer)
+                return;
+            new (buffer) trace_buffer;
+
+            auto next = g_buffers.load(std::memory_order_acquire);
+            do
+            {
+                buffer->next = next;
+            }
+            while (!g_buffers.compare_exchange_weak(next, buffer, std::memory_order_acq_rel));
+        }
+        buffer->thread.store(thread::this_index(), std::memory_order_release);
+
+        auto begin = int64_t(0);
+        if (g_begin.compare_exchange_strong(begin, event.time, std::memory_order_acq_rel))
+            trace_calibrate();
+
+        g_buffer = buffer;
+        g_thread.buffer = buffer;
+    }
+    const auto head = buffer->head.load(std::memory_order_relaxed);
+    buffer->events[head % trace_buffer::capacity] = event;
+    buffer->head.store(head + 1, std::memory_order_release);
+}
+trace_histogram::trace_histogram(const char* const name) noexcept : m_name(name)
+{
+    auto next = g_histograms.load(std::memory_order_acquire);
+    do
+    {
+        m_next = next;
+    }
+    while (!g_histograms.compare_exchange_weak(next, this, std::memory_order_acq_rel));
+}
+void icy::trace_clear() noexcept
+{
+    g_begin.store(trace_calibrate(), std::memory_order_release);
+}
+error_type icy::trace_export(const string_view path) noexcept
+{
+    auto ns_per_tick = 1.0;
+    {
+        ICY_LOCK_GUARD(g_lock);
+        const auto ticks = trace_now() - g_calibrate_ticks;
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now() - g_calibrate_time).count();
+        if (ticks > 0 && ns > 0)
+            ns_per_tick = double(ns) / double(ticks);
+    }
+    const auto begin = g_begin.load(std::memory_order_acquire);
+    const auto us_per_tick = ns_per_tick / 1000.0;
+
+    string str;
+    ICY_ERROR(str.append("{\"displayTimeUnit\":\"ns\",\"traceEvents\":["_s));
+    auto separator = "\n";
+
+    array<trace_event> events;
+    for (auto buffer = g_buffers.load(std::memory_order_acquire); buffer; buffer = buffer->next)
+    {
+        const auto thread = buffer->thread.load(std::memory_order_acquire);
+        const auto first = buffer->first.load(std::memory_order_acquire);
+        const auto head = buffer->head.load(std::memory_order_acquire);
+        const auto tail = std::max(head > trace_buffer::capacity ? head - trace_buffer::capacity : 0, first);
+        events.clear();
+        ICY_ERROR(events.reserve(size_t(head - tail)));
+        for (auto k = tail; k < head; ++k)
+            ICY_ERROR(events.push_back(buffer->events[k % trace_buffer::capacity]));
+
+        //  the writer fills slot "head % capacity" before publishing "head + 1",
+        //  so everything the ring has lapped since the first load may be torn
+        const auto after = buffer->head.load(std::memory_order_acquire);
+        const auto valid = after >= trace_buffer::capacity ? after - trace_buffer::capacity + 1 : 0;
+
+        ICY_ERROR(trace_append(str, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"thread %u\"}}",
+            separator, thread, thread));
+        separator = ",\n";
+
+        for (auto k = 0_z; k < events.size(); ++k)
+        {
+            const auto& event = events[k];
+            if (tail + k < valid || event.time < begin)
+                continue;
+
+            const auto ts = double(event.time - begin) * us_per_tick;
+            if (event.type == trace_type::scope)
+            {
+                ICY_ERROR(trace_append(str, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":", separator, event.name, thread));
+                ICY_ERROR(trace_append_time(str, ts));
+                ICY_ERROR(str.append(",\"dur\":"_s));
+                ICY_ERROR(trace_append_time(str, double(event.value) * us_per_tick));
+                ICY_ERROR(str.append("}"_s));
+            }
+            else if (event.type == trace_type::counter)
+            {
+                ICY_ERROR(trace_append(str, "%s{\"name\":\"%s\",\"ph\":\"C\",\"pid\":1,\"tid\":%u,\"ts\":", separator, event.name, thread));
+                ICY_ERROR(trace_append_time(str, ts));
+                ICY_ERROR(trace_append(str, ",\"args\":{\"value\":%lld}}", static_cast<long long>(event.value)));
+            }
+        }
+    }
+    ICY_ERROR(str.append("\n],\"icyHistograms\":{"_s));
+    separator = "\n";
+    for (auto histogram = g_histograms.load(std::memory_order_acquire); histogram; histogram = histogram->m_next)
+    {
+        ICY_ERROR(trace_append(str, "%s\"%s\":{\"count\":%llu,\"sum\":%llu,\"buckets\":[", separator, histogram->m_name,
+            static_cast<unsigned long long>(histogram->m_count.load(std::memory_order_relaxed)),
+            static_cast<unsigned long long>(histogram->m_sum.load(std::memory_order_relaxed))));
+        separator = ",\n";
+
+        auto last = 0_z;
+        for (auto k = 0_z; k < trace_histogram::buckets; ++k)
+        {
+            if (histogram->m_buckets[k].load(std::memory_order_relaxed))
+                last = k + 1;
+        }
+        for (auto k = 0_z; k < last; ++k)
+        {
+            ICY_ERROR(trace_append(str, k ? ",%llu" : "%llu",
+                static_cast<unsigned long long>(histogram->m_buckets[k].load(std::memory_order_relaxed))));
+        }
+        ICY_ERROR(str.append("]}"_s));
+    }
+    ICY_ERROR(str.append("\n}}\n"_s));
+
+    file output;
+    ICY_ERROR(output.open(path, file_access::write, file_open::create_always, file_share::none, file_flag::none));
+    ICY_ERROR(output.append(str.bytes().data(), str.bytes().size()));
+    return error_type();
+}
+
+static icy::detail::global_init_entry g_init([] { return g_lock.initialize(); });
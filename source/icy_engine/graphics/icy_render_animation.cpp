@@ -0,0 +1,331 @@
+#include <icy_engine/graphics/icy_render_animation.hpp>
+#include <xmmintrin.h>
+#include <cmath>
+
+using namespace icy;
+
+ICY_STATIC_NAMESPACE_BEG
+static const auto default_fps = 25.0;   //  assimp fallback for unknown ticks per second
+static const auto quat_scale = 32767.0F;
+
+//  find the key pair around "time" starting from the cached cursor; returns the blend factor
+static float seek(const float* const times, const uint32_t count, const float time, uint32_t& cursor, uint32_t& next) noexcept
+{
+    if (count <= 1)
+    {
+        cursor = next = 0;
+        return 0;
+    }
+    auto k = cursor < count ? cursor : 0;
+    if (time < times[k])
+    {
+        //  rewind (loop or seek back)
+        const auto it = std::upper_bound(times, times + count, time);
+        k = it == times ? 0 : uint32_t(it - times) - 1;
+    }
+    else
+    {
+        while (k + 1 < count && times[k + 1] <= time)
+            ++k;
+    }
+    cursor = k;
+    if (k + 1 >= count)
+    {
+        next = k;
+        return 0;
+    }
+    next = k + 1;
+    const auto delta = times[next] - times[k];
+    return delta > 0 ? clamp((time - times[k]) / delta, 0.0F, 1.0F) : 0.0F;
+}
+//  times inside [0, frames] are used as is; "prefix" / "suffix" only decide what happens outside
+static double wrap(const double time, const double frames, const render_animation_type prefix, const render_animation_type suffix) noexcept
+{
+    if (frames <= 0)
+        return 0;
+    if (time >= 0 && time <= frames)
+        return time;
+    const auto type = time < 0 ? prefix : suffix;
+    if (type == render_animation_type::repeat)
+    {
+        const auto value = fmod(time, frames);
+        return value < 0 ? value + frames : value;
+    }
+    //  "first", "none" and "linear" hold the boundary key
+    return clamp(time, 0.0, frames);
+}
+
+struct lane_type
+{
+    float lhs[4] = {};
+    float rhs[4] = {};
+};
+static void lerp4(const lane_type(&lanes)[4], const float(&factor)[4], float(&output)[4][4]) noexcept
+{
+    auto ax = _mm_loadu_ps(lanes[0].lhs);
+    auto ay = _mm_loadu_ps(lanes[1].lhs);
+    auto az = _mm_loadu_ps(lanes[2].lhs);
+    auto aw = _mm_loadu_ps(lanes[3].lhs);
+    auto bx = _mm_loadu_ps(lanes[0].rhs);
+    auto by = _mm_loadu_ps(lanes[1].rhs);
+    auto bz = _mm_loadu_ps(lanes[2].rhs);
+    auto bw = _mm_loadu_ps(lanes[3].rhs);
+    _MM_TRANSPOSE4_PS(ax, ay, az, aw);
+    _MM_TRANSPOSE4_PS(bx, by, bz, bw);
+
+    const auto f = _mm_loadu_ps(factor);
+    auto rx = _mm_add_ps(ax, _mm_mul_ps(_mm_sub_ps(bx, ax), f));
+    auto ry = _mm_add_ps(ay, _mm_mul_ps(_mm_sub_ps(by, ay), f));
+    auto rz = _mm_add_ps(az, _mm_mul_ps(_mm_sub_ps(bz, az), f));
+    auto rw = _mm_add_ps(aw, _mm_mul_ps(_mm_sub_ps(bw, aw), f));
+    _MM_TRANSPOSE4_PS(rx, ry, rz, rw);
+    _mm_storeu_ps(output[0], rx);
+    _mm_storeu_ps(output[1], ry);
+    _mm_storeu_ps(output[2], rz);
+    _mm_storeu_ps(output[3], rw);
+}
+static void qlerp4(const lane_type(&lanes)[4], const float(&factor)[4], const render_animation_blend blend, float(&output)[4][4]) noexcept
+{
+    auto ax = _mm_loadu_ps(lanes[0].lhs);
+    auto ay = _mm_loadu_ps(lanes[1].lhs);
+    auto az = _mm_loadu_ps(lanes[2].lhs);
+    auto aw = _mm_loadu_ps(lanes[3].lhs);
+    auto bx = _mm_loadu_ps(lanes[0].rhs);
+    auto by = _mm_loadu_ps(lanes[1].rhs);
+    auto bz = _mm_loadu_ps(lanes[2].rhs);
+    auto bw = _mm_loadu_ps(lanes[3].rhs);
+    _MM_TRANSPOSE4_PS(ax, ay, az, aw);
+    _MM_TRANSPOSE4_PS(bx, by, bz, bw);
+
+    //  shortest arc: flip rhs where dot(lhs, rhs) < 0
+    auto dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_add_ps(_mm_mul_ps(az, bz), _mm_mul_ps(aw, bw)));
+    const auto sign = _mm_and_ps(_mm_cmplt_ps(dot, _mm_setzero_ps()), _mm_set1_ps(-0.0F));
+    bx = _mm_xor_ps(bx, sign);
+    by = _mm_xor_ps(by, sign);
+    bz = _mm_xor_ps(bz, sign);
+    bw = _mm_xor_ps(bw, sign);
+    dot = _mm_xor_ps(dot, sign);
+
+    auto w0 = _mm_sub_ps(_mm_set1_ps(1), _mm_loadu_ps(factor));
+    auto w1 = _mm_loadu_ps(factor);
+    if (blend == render_animation_blend::slerp)
+    {
+        float cosine[4];
+        float weight0[4];
+        float weight1[4];
+        _mm_storeu_ps(cosine, dot);
+        _mm_storeu_ps(weight0, w0);
+        _mm_storeu_ps(weight1, w1);
+        for (auto k = 0u; k < 4; ++k)
+        {
+            if (cosine[k] > 0.9995F)   //  nearly parallel: nlerp weights are exact enough
+                continue;
+            const auto theta = acosf(cosine[k]);
+            const auto sin_theta = sinf(theta);
+            weight0[k] = sinf(weight0[k] * theta) / sin_theta;
+            weight1[k] = sinf(weight1[k] * theta) / sin_theta;
+        }
+        w0 = _mm_loadu_ps(weight0);
+        w1 = _mm_loadu_ps(weight1);
+    }
+    auto rx = _mm_add_ps(_mm_mul_ps(ax, w0), _mm_mul_ps(bx, w1));
+    auto ry = _mm_add_ps(_mm_mul_ps(ay, w0), _mm_mul_ps(by, w1));
+    auto rz = _mm_add_ps(_mm_mul_ps(az, w0), _mm_mul_ps(bz, w1));
+    auto rw = _mm_add_ps(_mm_mul_ps(aw, w0), _mm_mul_ps(bw, w1));
+
+    const auto len = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(rx, rx), _mm_mul_ps(ry, ry)), _mm_add_ps(_mm_mul_ps(rz, rz), _mm_mul_ps(rw, rw))));
+    const auto inv = _mm_div_ps(_mm_set1_ps(1), _mm_max_ps(len, _mm_set1_ps(FLT_MIN)));
+    rx = _mm_mul_ps(rx, inv);
+    ry = _mm_mul_ps(ry, inv);
+    rz = _mm_mul_ps(rz, inv);
+    rw = _mm_mul_ps(rw, inv);
+    _MM_TRANSPOSE4_PS(rx, ry, rz, rw);
+    _mm_storeu_ps(output[0], rx);
+    _mm_storeu_ps(output[1], ry);
+    _mm_storeu_ps(output[2], rz);
+    _mm_storeu_ps(output[3], rw);
+}
+ICY_STATIC_NAMESPACE_END
+
+error_type render_animation_clip::initialize(const render_animation& animation, const uint32_t flags) noexcept
+{
+    render_animation_clip tmp;
+    tmp.m_frames = animation.frames;
+    tmp.m_fps = animation.fps > 0 ? animation.fps : default_fps;
+    tmp.m_flags = flags;
+
+    auto time_count = 0_z;
+    auto vec3_count = 0_z;
+    auto vec4_count = 0_z;
+    for (auto&& pair : animation.nodes)
+    {
+        time_count += pair.value.world.size() + pair.value.scale.size() + pair.value.angle.size();
+        vec3_count += pair.value.world.size() + pair.value.scale.size();
+        vec4_count += pair.value.angle.size();
+    }
+    ICY_ERROR(tmp.m_nodes.reserve(animation.nodes.size()));
+    ICY_ERROR(tmp.m_channels.reserve(animation.nodes.size()));
+    ICY_ERROR(tmp.m_times.reserve(time_count));
+    ICY_ERROR(tmp.m_vec3.reserve(vec3_count * 3));
+    if (flags & render_animation_flag_quantize)
+    {
+        ICY_ERROR(tmp.m_quat.reserve(vec4_count * 4));
+    }
+    else
+    {
+        ICY_ERROR(tmp.m_vec4.reserve(vec4_count * 4));
+    }
+
+    for (auto&& pair : animation.nodes)
+    {
+        const auto& node = pair.value;
+        channel_type channel;
+        channel.prefix = node.prefix;
+        channel.suffix = node.suffix;
+
+        const auto add_vec3 = [&tmp](const array<render_animation_node::step3>& keys, track_type& track)
+        {
+            track.time = uint32_t(tmp.m_times.size());
+            track.value = uint32_t(tmp.m_vec3.size() / 3);
+            track.count = uint32_t(keys.size());
+            for (auto&& key : keys)
+            {
+                ICY_ERROR(tmp.m_times.push_back(float(key.time)));
+                ICY_ERROR(tmp.m_vec3.append(key.value.vec, key.value.vec + 3));
+            }
+            return error_type();
+        };
+        ICY_ERROR(add_vec3(node.world, channel.tracks[track_world]));
+        ICY_ERROR(add_vec3(node.scale, channel.tracks[track_scale]));
+
+        auto& track = channel.tracks[track_angle];
+        track.time = uint32_t(tmp.m_times.size());
+        track.count = uint32_t(node.angle.size());
+        track.value = uint32_t((flags & render_animation_flag_quantize ? tmp.m_quat.size() : tmp.m_vec4.size()) / 4);
+        for (auto&& key : node.angle)
+        {
+            ICY_ERROR(tmp.m_times.push_back(float(key.time)));
+            if (flags & render_animation_flag_quantize)
+            {
+                for (auto k = 0u; k < 4; ++k)
+                    ICY_ERROR(tmp.m_quat.push_back(int16_t(lrintf(clamp(key.value.vec[k], -1.0F, 1.0F) * quat_scale))));
+            }
+            else
+            {
+                ICY_ERROR(tmp.m_vec4.append(key.value.vec, key.value.vec + 4));
+            }
+        }
+        ICY_ERROR(tmp.m_nodes.push_back(pair.key));
+        ICY_ERROR(tmp.m_channels.push_back(std::move(channel)));
+    }
+    *this = std::move(tmp);
+    return error_type();
+}
+void render_animation_clip::sample(const double time, render_animation_state& state, const render_animation_blend blend) const noexcept
+{
+    ICY_ASSERT(state.m_output.size() == m_channels.size(), "ANIMATION STATE IS NOT INITIALIZED FOR THIS CLIP");
+    const auto ticks = time * m_fps;
+    const auto size = m_channels.size();
+
+    for (auto base = 0_z; base < size; base += 4)
+    {
+        const auto count = std::min(size - base, 4_z);
+        lane_type lanes[_track_count][4];
+        float factor[_track_count][4] = {};
+
+        for (auto n = 0_z; n < 4; ++n)
+        {
+            //  unused tail lanes keep identity values
+            lanes[track_scale][n].lhs[0] = lanes[track_scale][n].lhs[1] = lanes[track_scale][n].lhs[2] = 1;
+            lanes[track_scale][n].rhs[0] = lanes[track_scale][n].rhs[1] = lanes[track_scale][n].rhs[2] = 1;
+            lanes[track_angle][n].lhs[3] = lanes[track_angle][n].rhs[3] = 1;
+            if (n >= count)
+                continue;
+
+            const auto& channel = m_channels[base + n];
+            const auto local = float(wrap(ticks, m_frames, channel.prefix, channel.suffix));
+            for (auto t = 0u; t < _track_count; ++t)
+            {
+                const auto& track = channel.tracks[t];
+                if (!track.count)
+                    continue;
+
+                auto& cursor = state.m_cursor[(base + n) * _track_count + t];
+                auto next = 0u;
+                factor[t][n] = seek(m_times.data() + track.time, track.count, local, cursor, next);
+                auto& lane = lanes[t][n];
+                if (t != track_angle)
+                {
+                    memcpy(lane.lhs, m_vec3.data() + (track.value + cursor) * 3, 3 * sizeof(float));
+                    memcpy(lane.rhs, m_vec3.data() + (track.value + next) * 3, 3 * sizeof(float));
+                }
+                else if (m_flags & render_animation_flag_quantize)
+                {
+                    const auto lhs = m_quat.data() + (track.value + cursor) * 4;
+                    const auto rhs = m_quat.data() + (track.value + next) * 4;
+                    for (auto k = 0u; k < 4; ++k)
+                    {
+                        lane.lhs[k] = lhs[k] / quat_scale;
+                        lane.rhs[k] = rhs[k] / quat_scale;
+                    }
+                }
+                else
+                {
+                    memcpy(lane.lhs, m_vec4.data() + (track.value + cursor) * 4, 4 * sizeof(float));
+                    memcpy(lane.rhs, m_vec4.data() + (track.value + next) * 4, 4 * sizeof(float));
+                }
+            }
+        }
+
+        float world[4][4];
+        float scale[4][4];
+        float angle[4][4];
+        lerp4(lanes[track_world], factor[track_world], world);
+        lerp4(lanes[track_scale], factor[track_scale], scale);
+        qlerp4(lanes[track_angle], factor[track_angle], blend, angle);
+        //  tracks without keys keep the pose stored by "bind"
+        for (auto n = 0_z; n < count; ++n)
+        {
+            const auto& channel = m_channels[base + n];
+            auto& output = state.m_output[base + n];
+            if (channel.tracks[track_world].count)
+                memcpy(output.world.vec, world[n], sizeof(output.world.vec));
+            if (channel.tracks[track_scale].count)
+                memcpy(output.scale.vec, scale[n], sizeof(output.scale.vec));
+            if (channel.tracks[track_angle].count)
+                memcpy(output.angle.vec, angle[n], sizeof(output.angle.vec));
+        }
+    }
+}
+
+error_type render_animation_state::initialize(const render_animation_clip& clip) noexcept
+{
+    m_cursor.clear();
+    m_target.clear();
+    m_output.clear();
+    ICY_ERROR(m_cursor.resize(clip.m_channels.size() * render_animation_clip::_track_count));
+    ICY_ERROR(m_output.resize(clip.m_channels.size()));
+    return error_type();
+}
+error_type render_animation_state::bind(const render_animation_clip& clip, const render_transform_buffer& buffer) noexcept
+{
+    ICY_ASSERT(m_output.size() == clip.m_channels.size(), "ANIMATION STATE IS NOT INITIALIZED FOR THIS CLIP");
+    m_target.clear();
+    ICY_ERROR(m_target.reserve(clip.m_nodes.size()));
+    for (auto k = 0_z; k < clip.m_nodes.size(); ++k)
+    {
+        const auto index = buffer.find(clip.m_nodes[k]);
+        ICY_ERROR(m_target.push_back(index));
+        m_output[k] = index != render_transform_buffer::invalid_index ? buffer.transform(index) : render_transform();
+    }
+    return error_type();
+}
+void render_animation_state::apply(render_transform_buffer& buffer) const noexcept
+{
+    const auto count = std::min(m_target.size(), m_output.size());
+    for (auto k = 0_z; k < count; ++k)
+    {
+        if (m_target[k] != render_transform_buffer::invalid_index)
+            buffer.assign(m_target[k], m_output[k]);
+    }
+}
@@ -23,6 +23,7 @@ static const auto key_compress = "compress"_s;
 static const auto key_blend = "blend"_s;
 static const auto key_width = "width"_s;
 static const auto key_height = "height"_s;
+static const auto key_levels = "levels"_s;
 static const auto key_bytes = "bytes"_s;
 static const auto key_index = "index"_s;
 static const auto key_oper = "oper"_s;
@@ -200,6 +201,7 @@ string_view icy::to_string(const render_texture_compress input) noexcept
 	{
 	case render_texture_compress::dds1: return "dds1"_s;
 	case render_texture_compress::dds5: return "dds5"_s;
+	case render_texture_compress::bc7: return "bc7"_s;
 	}
 	return string_view();
 }
@@ -427,8 +429,11 @@ error_type icy::to_value(const json& input, render_texture& output) noexcept
 		}
 	}
 	ICY_ERROR(find_enum(input.get(key_texture_type), output.type));
+	ICY_ERROR(find_enum(input.get(key_compress), output.compress));
 	ICY_ERROR(input.get(key_width, output.size.x));
 	ICY_ERROR(input.get(key_height, output.size.y));
+	if (const auto levels = input.find(key_levels))
+		ICY_ERROR(levels->get(output.levels));
 
 	const string_view str = input.get(key_bytes);
 	ICY_ERROR(output.bytes.resize(base64_decode_size(str.ubytes().size())));
@@ -758,6 +763,7 @@ error_type icy::to_json(const render_texture& input, json& output) noexcept
 	ICY_ERROR(output.insert(key_map_type, to_string(input.map_type)));
 	ICY_ERROR(output.insert(key_width, input.size.x));
 	ICY_ERROR(output.insert(key_height, input.size.y));
+	ICY_ERROR(output.insert(key_levels, input.levels));
 	ICY_ERROR(output.insert(key_texture_type, to_string(input.type)));
 
 	array<char> bytes;
@@ -0,0 +1,491 @@
+#include <icy_engine/graphics/icy_render_raster.hpp>
+#if _M_X64 || __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace icy;
+
+static const auto raster_subpixel = 16;                 //  28.4 fixed point
+static const auto raster_max_coord = 16384.0f;          //  pixels: keeps 4-wide edge steps inside int32
+static const auto raster_edge_clamp = int64_t(1) << 30;
+
+enum raster_attr : uint32_t
+{
+    raster_attr_r,
+    raster_attr_g,
+    raster_attr_b,
+    raster_attr_a,
+    raster_attr_u,
+    raster_attr_v,
+    raster_attr_count,
+};
+
+struct render_gui_raster::command_type
+{
+    const matrix<color>* texture = nullptr; //  null: white
+    int32_t clip[4] = {};                   //  x0, y0, x1, y1 (pixels, end exclusive)
+};
+struct render_gui_raster::triangle_type
+{
+    int32_t x[3];
+    int32_t y[3];
+    int32_t box[4];     //  x0, y0, x1, y1 (pixels, end exclusive, clipped)
+    float plane[raster_attr_count][3];  //  value = [0] + [1] * x + [2] * y at pixel centers
+    uint32_t command;
+};
+class render_gui_raster::thread_type : public thread
+{
+public:
+    thread_type(render_gui_raster& raster) noexcept : m_raster(raster)
+    {
+
+    }
+    void cancel() noexcept override
+    {
+        //  nothing to interrupt: "run" returns once the tiles are exhausted
+    }
+protected:
+    error_type run() noexcept override
+    {
+        m_raster.work();
+        return error_type();
+    }
+private:
+    render_gui_raster& m_raster;
+};
+
+static inline int32_t raster_floor16(const int32_t value) noexcept
+{
+    return value >> 4;
+}
+static inline int32_t raster_ceil16(const int32_t value) noexcept
+{
+    return -((-value) >> 4);
+}
+static void raster_sample(const matrix<color>& texture, const float u, const float v, float (&texel)[4]) noexcept
+{
+    const auto w = int32_t(texture.cols());
+    const auto h = int32_t(texture.rows());
+    const auto fu = u * w - 0.5f;
+    const auto fv = v * h - 0.5f;
+    const auto iu = int32_t(floorf(fu));
+    const auto iv = int32_t(floorf(fv));
+    const auto wu = fu - float(iu);
+    const auto wv = fv - float(iv);
+
+    const auto x0 = std::min(std::max(iu, 0), w - 1);
+    const auto x1 = std::min(std::max(iu + 1, 0), w - 1);
+    const auto y0 = std::min(std::max(iv, 0), h - 1);
+    const auto y1 = std::min(std::max(iv + 1, 0), h - 1);
+    const auto data = texture.data();
+    const auto& c00 = data[size_t(y0) * w + x0];
+    const auto& c01 = data[size_t(y0) * w + x1];
+    const auto& c10 = data[size_t(y1) * w + x0];
+    const auto& c11 = data[size_t(y1) * w + x1];
+
+    const auto lerp = [wu, wv](const uint8_t a, const uint8_t b, const uint8_t c, const uint8_t d)
+    {
+        const auto top = float(a) + (float(b) - float(a)) * wu;
+        const auto bot = float(c) + (float(d) - float(c)) * wu;
+        return top + (bot - top) * wv;
+    };
+    texel[0] = lerp(c00.r, c01.r, c10.r, c11.r);
+    texel[1] = lerp(c00.g, c01.g, c10.g, c11.g);
+    texel[2] = lerp(c00.b, c01.b, c10.b, c11.b);
+    texel[3] = lerp(c00.a, c01.a, c10.a, c11.a);
+}
+static inline uint8_t raster_unorm(const float value) noexcept
+{
+    return uint8_t(std::min(std::max(value, 0.0f), 255.0f) + 0.5f);
+}
+static inline void raster_blend(color& dst, const float (&src)[4]) noexcept
+{
+    const auto sa = uint32_t(raster_unorm(src[3]));
+    const auto da = 255 - sa;
+    dst.r = uint8_t((raster_unorm(src[0]) * sa + dst.r * da + 127) / 255);
+    dst.g = uint8_t((raster_unorm(src[1]) * sa + dst.g * da + 127) / 255);
+    dst.b = uint8_t((raster_unorm(src[2]) * sa + dst.b * da + 127) / 255);
+    dst.a = uint8_t(sa + (dst.a * da + 127) / 255);
+}
+
+render_gui_raster::render_gui_raster() noexcept
+{
+
+}
+render_gui_raster::~render_gui_raster() noexcept
+{
+    for (auto&& thread : m_threads)
+        thread->wait();
+}
+error_type render_gui_raster::initialize(const size_t threads) noexcept
+{
+    for (auto&& thread : m_threads)
+        thread->wait();
+    m_threads.clear();
+
+    const auto count = threads ? threads : std::max(thread::cores(), 1_z);
+    ICY_ERROR(m_threads.reserve(count - 1));
+    for (auto k = 1_z; k < count; ++k)
+    {
+        shared_ptr<thread_type> new_thread;
+        ICY_ERROR(make_shared(new_thread, *this));
+        ICY_ERROR(m_threads.push_back(std::move(new_thread)));
+    }
+    return error_type();
+}
+error_type render_gui_raster::texture(const guid& index, const const_matrix_view<color> image) noexcept
+{
+    matrix<color> new_image;
+    ICY_ERROR(copy(image, new_image));
+    if (const auto ptr = m_textures.try_find(index))
+    {
+        *ptr = std::move(new_image);
+    }
+    else
+    {
+        ICY_ERROR(m_textures.insert(index, std::move(new_image)));
+    }
+    return error_type();
+}
+void render_gui_raster::erase(const guid& index) noexcept
+{
+    const auto it = m_textures.find(index);
+    if (it != m_textures.end())
+        m_textures.erase(it);
+}
+error_type render_gui_raster::render(const render_gui_frame& frame, matrix<color>& output, const color clear) noexcept
+{
+    const auto width = uint32_t(std::max(lround(frame.viewport.vec[2]), 0l));
+    const auto height = uint32_t(std::max(lround(frame.viewport.vec[3]), 0l));
+    if (output.rows() != height || output.cols() != width)
+    {
+        output = matrix<color>(height, width);
+        if (output.size() != size_t(width) * height)
+            return make_stdlib_error(std::errc::not_enough_memory);
+    }
+    if (!width || !height)
+        return error_type();
+
+    m_pixels = output.data();
+    m_width = width;
+    m_height = height;
+    m_clear = clear;
+    ICY_ERROR(setup(frame, width, height));
+
+    m_next.store(0, std::memory_order_release);
+    const auto helpers = std::min(m_threads.size(), size_t(m_tiles_x * m_tiles_y) - 1);
+    auto launched = 0_z;
+    error_type error;
+    for (; launched < helpers && !error; ++launched)
+        error = m_threads[launched]->launch();
+    if (error)
+        --launched;
+
+    work();
+    for (auto k = 0_z; k < launched; ++k)
+    {
+        if (const auto wait_error = m_threads[k]->wait())
+        {
+            if (!error)
+                error = wait_error;
+        }
+    }
+    return error;
+}
+error_type render_gui_raster::setup(const render_gui_frame& frame, const uint32_t width, const uint32_t height) noexcept
+{
+    m_triangles.clear();
+    m_commands.clear();
+
+    const auto vx = frame.viewport.vec[0];
+    const auto vy = frame.viewport.vec[1];
+    const auto sx = 0.5f * frame.viewport.vec[2];
+    const auto sy = 0.5f * frame.viewport.vec[3];
+
+    for (auto&& list : frame.data)
+    {
+        for (auto&& cmd : list.cmd)
+        {
+            command_type command;
+            if (cmd.tex)
+            {
+                command.texture = m_textures.try_find(cmd.tex);
+                if (!command.texture || command.texture->empty())
+                    continue;
+            }
+            command.clip[0] = std::max(int32_t(lround(cmd.clip.x - vx)), 0);
+            command.clip[1] = std::max(int32_t(lround(cmd.clip.y - vy)), 0);
+            command.clip[2] = std::min(int32_t(lround(cmd.clip.z - vx)), int32_t(width));
+            command.clip[3] = std::min(int32_t(lround(cmd.clip.w - vy)), int32_t(height));
+            if (command.clip[0] >= command.clip[2] || command.clip[1] >= command.clip[3])
+                continue;
+
+            const auto command_index = uint32_t(m_commands.size());
+            ICY_ERROR(m_commands.push_back(command));
+
+            for (auto n = 0u; n + 3 <= cmd.size; n += 3)
+            {
+                const render_gui_vtx* vtx[3];
+                auto valid = true;
+                for (auto k = 0u; k < 3; ++k)
+                {
+                    const auto idx_offset = size_t(cmd.idx) + n + k;
+                    if (idx_offset >= list.idx.size())
+                    {
+                        valid = false;
+                        break;
+                    }
+                    const auto vtx_offset = size_t(cmd.vtx) + list.idx[idx_offset];
+                    if (vtx_offset >= list.vtx.size())
+                    {
+                        valid = false;
+                        break;
+                    }
+                    vtx[k] = &list.vtx[vtx_offset];
+                }
+                if (!valid)
+                    continue;
+
+                float px[3];
+                float py[3];
+                triangle_type tri;
+                for (auto k = 0u; k < 3; ++k)
+                {
+                    px[k] = std::min(std::max((vtx[k]->pos.x + 1) * sx, -raster_max_coord), raster_max_coord);
+                    py[k] = std::min(std::max((1 - vtx[k]->pos.y) * sy, -raster_max_coord), raster_max_coord);
+                    tri.x[k] = int32_t(lround(px[k] * raster_subpixel));
+                    tri.y[k] = int32_t(lround(py[k] * raster_subpixel));
+                }
+                const auto area = int64_t(tri.x[1] - tri.x[0]) * (tri.y[2] - tri.y[0]) - int64_t(tri.y[1] - tri.y[0]) * (tri.x[2] - tri.x[0]);
+                if (area == 0)
+                    continue;
+                if (area < 0)
+                {
+                    //  edge functions below expect clockwise (screen space) winding
+                    std::swap(tri.x[1], tri.x[2]);
+                    std::swap(tri.y[1], tri.y[2]);
+                    std::swap(px[1], px[2]);
+                    std::swap(py[1], py[2]);
+                    std::swap(vtx[1], vtx[2]);
+                }
+
+                //  pixel k is sampled at 16 * k + 8
+                const auto min_x = std::min({ tri.x[0], tri.x[1], tri.x[2] });
+                const auto min_y = std::min({ tri.y[0], tri.y[1], tri.y[2] });
+                const auto max_x = std::max({ tri.x[0], tri.x[1], tri.x[2] });
+                const auto max_y = std::max({ tri.y[0], tri.y[1], tri.y[2] });
+                tri.box[0] = std::max(raster_ceil16(min_x - 8), command.clip[0]);
+                tri.box[1] = std::max(raster_ceil16(min_y - 8), command.clip[1]);
+                tri.box[2] = std::min(raster_floor16(max_x - 8) + 1, command.clip[2]);
+                tri.box[3] = std::min(raster_floor16(max_y - 8) + 1, command.clip[3]);
+                if (tri.box[0] >= tri.box[2] || tri.box[1] >= tri.box[3])
+                    continue;
+
+                const auto det = (px[1] - px[0]) * (py[2] - py[0]) - (px[2] - px[0]) * (py[1] - py[0]);
+                if (det == 0)
+                    continue;
+
+                float attr[3][raster_attr_count];
+                for (auto k = 0u; k < 3; ++k)
+                {
+                    attr[k][raster_attr_r] = vtx[k]->col.r;
+                    attr[k][raster_attr_g] = vtx[k]->col.g;
+                    attr[k][raster_attr_b] = vtx[k]->col.b;
+                    attr[k][raster_attr_a] = vtx[k]->col.a;
+                    attr[k][raster_attr_u] = vtx[k]->tex.u;
+                    attr[k][raster_attr_v] = vtx[k]->tex.v;
+                }
+                for (auto a = 0u; a < raster_attr_count; ++a)
+                {
+                    const auto d1 = attr[1][a] - attr[0][a];
+                    const auto d2 = attr[2][a] - attr[0][a];
+                    const auto dx = (d1 * (py[2] - py[0]) - d2 * (py[1] - py[0])) / det;
+                    const auto dy = (d2 * (px[1] - px[0]) - d1 * (px[2] - px[0])) / det;
+                    tri.plane[a][0] = attr[0][a] - dx * px[0] - dy * py[0];
+                    tri.plane[a][1] = dx;
+                    tri.plane[a][2] = dy;
+                }
+                tri.command = command_index;
+                ICY_ERROR(m_triangles.push_back(tri));
+            }
+        }
+    }
+
+    //  bin triangles by tile (counting sort keeps submission order inside every tile)
+    m_tiles_x = (width + tile_size - 1) / tile_size;
+    m_tiles_y = (height + tile_size - 1) / tile_size;
+    const auto tiles = size_t(m_tiles_x) * m_tiles_y;
+    m_bins.clear();
+    ICY_ERROR(m_bins.resize(tiles + 1));
+    for (auto&& tri : m_triangles)
+    {
+        for (auto ty = uint32_t(tri.box[1]) / tile_size; ty <= uint32_t(tri.box[3] - 1) / tile_size; ++ty)
+        {
+            for (auto tx = uint32_t(tri.box[0]) / tile_size; tx <= uint32_t(tri.box[2] - 1) / tile_size; ++tx)
+                m_bins[ty * m_tiles_x + tx + 1] += 1;
+        }
+    }
+    for (auto k = 0_z; k < tiles; ++k)
+        m_bins[k + 1] += m_bins[k];
+
+    m_items.clear();
+    ICY_ERROR(m_items.resize(m_bins[tiles]));
+    for (auto k = 0u; k < m_triangles.size(); ++k)
+    {
+        const auto& tri = m_triangles[k];
+        for (auto ty = uint32_t(tri.box[1]) / tile_size; ty <= uint32_t(tri.box[3] - 1) / tile_size; ++ty)
+        {
+            for (auto tx = uint32_t(tri.box[0]) / tile_size; tx <= uint32_t(tri.box[2] - 1) / tile_size; ++tx)
+                m_items[m_bins[ty * m_tiles_x + tx]++] = k;
+        }
+    }
+    //  "m_bins[k]" now points past tile k: shift back to the tile start
+    for (auto k = tiles; k > 0; --k)
+        m_bins[k] = m_bins[k - 1];
+    m_bins[0] = 0;
+    return error_type();
+}
+void render_gui_raster::work() noexcept
+{
+    const auto tiles = m_tiles_x * m_tiles_y;
+    while (true)
+    {
+        const auto tile = m_next.fetch_add(1, std::memory_order_acq_rel);
+        if (tile >= tiles)
+            break;
+        draw(tile);
+    }
+}
+void render_gui_raster::draw(const uint32_t tile) noexcept
+{
+    const auto tile_x0 = int32_t(tile % m_tiles_x * tile_size);
+    const auto tile_y0 = int32_t(tile / m_tiles_x * tile_size);
+    const auto tile_x1 = std::min(tile_x0 + int32_t(tile_size), int32_t(m_width));
+    const auto tile_y1 = std::min(tile_y0 + int32_t(tile_size), int32_t(m_height));
+
+    for (auto y = tile_y0; y < tile_y1; ++y)
+    {
+        const auto row = m_pixels + size_t(y) * m_width;
+        for (auto x = tile_x0; x < tile_x1; ++x)
+            row[x] = m_clear;
+    }
+
+    for (auto item = m_bins[tile]; item < m_bins[tile + 1]; ++item)
+    {
+        const auto& tri = m_triangles[m_items[item]];
+        const auto& command = m_commands[tri.command];
+        const auto x0 = std::max(tri.box[0], tile_x0);
+        const auto y0 = std::max(tri.box[1], tile_y0);
+        const auto x1 = std::min(tri.box[2], tile_x1);
+        const auto y1 = std::min(tri.box[3], tile_y1);
+        if (x0 >= x1 || y0 >= y1)
+            continue;
+
+        //  E(X, Y) = A * (X - xa) + B * (Y - ya) >= 0 inside; non top-left edges are biased by -1
+        int32_t edge_a[3];
+        int32_t edge_b[3];
+        int32_t edge_c[3];
+        for (auto k = 0u; k < 3; ++k)
+        {
+            const auto n = (k + 1) % 3;
+            edge_a[k] = tri.y[k] - tri.y[n];
+            edge_b[k] = tri.x[n] - tri.x[k];
+            const auto top_left = edge_a[k] > 0 || (edge_a[k] == 0 && edge_b[k] > 0);
+            edge_c[k] = top_left ? 0 : -1;
+        }
+
+        //  GUI quads usually sample a single texel (font atlas white pixel): hoist it
+        auto constant_texel = true;
+        float texel[4] = { 255, 255, 255, 255 };
+        if (command.texture)
+        {
+            if (tri.plane[raster_attr_u][1] == 0 && tri.plane[raster_attr_u][2] == 0 &&
+                tri.plane[raster_attr_v][1] == 0 && tri.plane[raster_attr_v][2] == 0)
+                raster_sample(*command.texture, tri.plane[raster_attr_u][0], tri.plane[raster_attr_v][0], texel);
+            else
+                constant_texel = false;
+        }
+
+        for (auto y = y0; y < y1; ++y)
+        {
+            const auto row = m_pixels + size_t(y) * m_width;
+            const auto fy = float(y) + 0.5f;
+            float base[raster_attr_count];
+            for (auto a = 0u; a < raster_attr_count; ++a)
+                base[a] = tri.plane[a][0] + tri.plane[a][2] * fy;
+
+            const auto shade = [&](const int32_t x)
+            {
+                const auto fx = float(x) + 0.5f;
+                float value[raster_attr_count];
+                for (auto a = 0u; a < raster_attr_count; ++a)
+                    value[a] = base[a] + tri.plane[a][1] * fx;
+
+                float sample[4];
+                if (constant_texel)
+                {
+                    sample[0] = texel[0];
+                    sample[1] = texel[1];
+                    sample[2] = texel[2];
+                    sample[3] = texel[3];
+                }
+                else
+                {
+                    raster_sample(*command.texture, value[raster_attr_u], value[raster_attr_v], sample);
+                }
+                const float src[4] =
+                {
+                    value[raster_attr_r] * sample[0] * (1.0f / 255),
+                    value[raster_attr_g] * sample[1] * (1.0f / 255),
+                    value[raster_attr_b] * sample[2] * (1.0f / 255),
+                    value[raster_attr_a] * sample[3] * (1.0f / 255),
+                };
+                raster_blend(row[x], src);
+            };
+
+            const auto px = int64_t(x0) * raster_subpixel + raster_subpixel / 2;
+            const auto py = int64_t(y) * raster_subpixel + raster_subpixel / 2;
+            int32_t edge_row[3];
+            int32_t edge_step[3];
+            for (auto k = 0u; k < 3; ++k)
+            {
+                const auto value = int64_t(edge_a[k]) * (px - tri.x[k]) + int64_t(edge_b[k]) * (py - tri.y[k]) + edge_c[k];
+                edge_row[k] = int32_t(std::min(std::max(value, -raster_edge_clamp), raster_edge_clamp));
+                edge_step[k] = edge_a[k] * raster_subpixel;
+            }
+
+#if _M_X64 || __SSE2__
+            __m128i e[3];
+            __m128i step4[3];
+            for (auto k = 0u; k < 3; ++k)
+            {
+                e[k] = _mm_setr_epi32(edge_row[k], edge_row[k] + edge_step[k],
+                    edge_row[k] + 2 * edge_step[k], edge_row[k] + 3 * edge_step[k]);
+                step4[k] = _mm_set1_epi32(4 * edge_step[k]);
+            }
+            for (auto x = x0; x < x1; x += 4)
+            {
+                const auto outside = _mm_or_si128(_mm_or_si128(e[0], e[1]), e[2]);
+                auto mask = uint32_t(~_mm_movemask_ps(_mm_castsi128_ps(outside))) & 0x0F;
+                if (x1 - x < 4)
+                    mask &= (1u << (x1 - x)) - 1;
+                for (auto lane = 0; mask; ++lane, mask >>= 1)
+                {
+                    if (mask & 1)
+                        shade(x + lane);
+                }
+                for (auto k = 0u; k < 3; ++k)
+                    e[k] = _mm_add_epi32(e[k], step4[k]);
+            }
+#else
+            for (auto x = x0; x < x1; ++x)
+            {
+                if ((edge_row[0] | edge_row[1] | edge_row[2]) >= 0)
+                    shade(x);
+                for (auto k = 0u; k < 3; ++k)
+                    edge_row[k] += edge_step[k];
+            }
+#endif
+        }
+    }
+}
@@ -0,0 +1,576 @@
+#include <icy_engine/graphics/icy_render_stream.hpp>
+#include <icy_engine/core/icy_hash.hpp>
+
+using namespace icy;
+
+//  message: u32 body size, then
+//      u32 magic, u8 version, u8 flags, f32 viewport[4], varint vbuffer, varint ibuffer,
+//      varint texture count { guid, varint rows, varint cols, color[rows * cols] },
+//      varint list count { u64 hash, u8 kind, (kind == full) list }
+//  list: varint idx count { zigzag(idx - prev idx) },
+//      varint vtx count { zigzag(bits - prev bits) for pos.x, pos.y, tex.u, tex.v; col ^ prev col },
+//      varint cmd count { f32 clip[4], u8 has tex, (has tex) guid, varint vtx, varint idx, varint size }
+
+static const auto stream_magic = 0x47594349u;   //  "ICYG"
+static const auto stream_max_message = 256_z << 20;
+static const auto stream_header_size = sizeof(uint32_t);
+
+enum stream_flag : uint8_t
+{
+    stream_flag_reset = 0x01,   //  drop cached lists
+};
+enum stream_list : uint8_t
+{
+    stream_list_cached,
+    stream_list_full,
+};
+
+static_assert(sizeof(render_gui_vtx) == 20, "INVALID VTX LAYOUT");      //  hashed as raw bytes: no padding
+static_assert(sizeof(render_gui_cmd) == 44, "INVALID CMD LAYOUT");
+
+static uint64_t stream_hash(const render_gui_list& list) noexcept
+{
+    auto hash = fast_hash64(list.idx.data(), list.idx.size() * sizeof(list.idx[0]));
+    hash = fast_hash64(list.vtx.data(), list.vtx.size() * sizeof(list.vtx[0]), hash);
+    hash = fast_hash64(list.cmd.data(), list.cmd.size() * sizeof(list.cmd[0]), hash);
+    return hash;
+}
+static inline uint32_t stream_bits(const float value) noexcept
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+static inline float stream_float(const uint32_t bits) noexcept
+{
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+static inline uint32_t stream_zigzag(const uint32_t value, const uint32_t prev) noexcept
+{
+    const auto delta = int32_t(value - prev);
+    return (uint32_t(delta) << 1) ^ uint32_t(delta >> 31);
+}
+static inline uint32_t stream_unzigzag(const uint32_t value, const uint32_t prev) noexcept
+{
+    return prev + ((value >> 1) ^ (0u - (value & 1)));
+}
+
+//  writes into storage sized by "encode" for the worst case
+class stream_writer
+{
+public:
+    stream_writer(uint8_t* ptr) noexcept : m_ptr(ptr)
+    {
+
+    }
+    uint8_t* ptr() const noexcept
+    {
+        return m_ptr;
+    }
+    void bytes(const void* data, const size_t size) noexcept
+    {
+        memcpy(m_ptr, data, size);
+        m_ptr += size;
+    }
+    template<typename T>
+    void value(const T& data) noexcept
+    {
+        bytes(&data, sizeof(data));
+    }
+    void varint(uint64_t data) noexcept
+    {
+        while (data >= 0x80)
+        {
+            *m_ptr++ = uint8_t(data | 0x80);
+            data >>= 7;
+        }
+        *m_ptr++ = uint8_t(data);
+    }
+private:
+    uint8_t* m_ptr;
+};
+//  every read is bounds checked: a short or malformed message fails instead of overrunning
+class stream_reader
+{
+public:
+    stream_reader(const const_array_view<uint8_t> bytes) noexcept : m_ptr(bytes.data()), m_end(bytes.data() + bytes.size())
+    {
+
+    }
+    size_t size() const noexcept
+    {
+        return size_t(m_end - m_ptr);
+    }
+    bool bytes(void* data, const size_t size) noexcept
+    {
+        if (this->size() < size)
+            return false;
+        memcpy(data, m_ptr, size);
+        m_ptr += size;
+        return true;
+    }
+    template<typename T>
+    bool value(T& data) noexcept
+    {
+        return bytes(&data, sizeof(data));
+    }
+    bool varint(uint64_t& data) noexcept
+    {
+        data = 0;
+        for (auto shift = 0u; shift < 64; shift += 7)
+        {
+            if (m_ptr == m_end)
+                return false;
+            const auto byte = *m_ptr++;
+            data |= uint64_t(byte & 0x7F) << shift;
+            if (!(byte & 0x80))
+                return true;
+        }
+        return false;
+    }
+    bool varint(uint32_t& data) noexcept
+    {
+        uint64_t value = 0;
+        if (!varint(value) || value > 0xFFFF'FFFFu)
+            return false;
+        data = uint32_t(value);
+        return true;
+    }
+    //  element count that cannot exceed the remaining bytes (each element takes at least "min_size")
+    bool count(size_t& data, const size_t min_size) noexcept
+    {
+        uint64_t value = 0;
+        if (!varint(value) || value > size() / min_size)
+            return false;
+        data = size_t(value);
+        return true;
+    }
+private:
+    const uint8_t* m_ptr;
+    const uint8_t* m_end;
+};
+
+static size_t stream_capacity(const render_gui_list& list) noexcept
+{
+    return 0
+        + sizeof(uint64_t) + 1 + 3 * 10
+        + list.idx.size() * 5
+        + list.vtx.size() * 5 * 5
+        + list.cmd.size() * (sizeof(render_vec4) + 1 + sizeof(guid) + 3 * 5);
+}
+static void stream_write(stream_writer& writer, const render_gui_list& list) noexcept
+{
+    writer.varint(list.idx.size());
+    auto prev_idx = 0u;
+    for (auto&& idx : list.idx)
+    {
+        writer.varint(stream_zigzag(idx, prev_idx));
+        prev_idx = idx;
+    }
+
+    writer.varint(list.vtx.size());
+    uint32_t prev[5] = {};
+    for (auto&& vtx : list.vtx)
+    {
+        const uint32_t next[5] =
+        {
+            stream_bits(vtx.pos.x), stream_bits(vtx.pos.y),
+            stream_bits(vtx.tex.u), stream_bits(vtx.tex.v), vtx.col.bgra,
+        };
+        for (auto k = 0u; k < 4; ++k)
+            writer.varint(stream_zigzag(next[k], prev[k]));
+        writer.varint(next[4] ^ prev[4]);
+        memcpy(prev, next, sizeof(prev));
+    }
+
+    writer.varint(list.cmd.size());
+    guid prev_tex;
+    for (auto&& cmd : list.cmd)
+    {
+        writer.value(cmd.clip.vec);
+        if (cmd.tex == prev_tex)
+        {
+            writer.value(uint8_t(0));
+        }
+        else
+        {
+            writer.value(uint8_t(1));
+            writer.value(cmd.tex);
+            prev_tex = cmd.tex;
+        }
+        writer.varint(cmd.vtx);
+        writer.varint(cmd.idx);
+        writer.varint(cmd.size);
+    }
+}
+static bool stream_read(stream_reader& reader, render_gui_list& list) noexcept
+{
+    size_t count = 0;
+    if (!reader.count(count, 1) || list.idx.resize(count))
+        return false;
+    auto prev_idx = 0u;
+    for (auto&& idx : list.idx)
+    {
+        if (!reader.varint(idx))
+            return false;
+        idx = prev_idx = stream_unzigzag(idx, prev_idx);
+    }
+
+    if (!reader.count(count, 5) || list.vtx.resize(count))
+        return false;
+    uint32_t prev[5] = {};
+    for (auto&& vtx : list.vtx)
+    {
+        uint32_t next[5];
+        for (auto k = 0u; k < 5; ++k)
+        {
+            if (!reader.varint(next[k]))
+                return false;
+        }
+        for (auto k = 0u; k < 4; ++k)
+            prev[k] = stream_unzigzag(next[k], prev[k]);
+        prev[4] ^= next[4];
+        vtx.pos.x = stream_float(prev[0]);
+        vtx.pos.y = stream_float(prev[1]);
+        vtx.tex.u = stream_float(prev[2]);
+        vtx.tex.v = stream_float(prev[3]);
+        vtx.col.bgra = prev[4];
+    }
+
+    if (!reader.count(count, sizeof(render_vec4) + 4) || list.cmd.resize(count))
+        return false;
+    guid prev_tex;
+    for (auto&& cmd : list.cmd)
+    {
+        uint8_t has_tex = 0;
+        if (!reader.value(cmd.clip.vec) || !reader.value(has_tex))
+            return false;
+        if (has_tex)
+        {
+            if (!reader.value(prev_tex))
+                return false;
+        }
+        cmd.tex = prev_tex;
+        if (!reader.varint(cmd.vtx) || !reader.varint(cmd.idx) || !reader.varint(cmd.size))
+            return false;
+    }
+    return true;
+}
+
+error_type render_gui_encoder::texture(const guid& index, const const_matrix_view<color> image) noexcept
+{
+    texture_type new_texture;
+    ICY_ERROR(copy(image, new_texture.image));
+    if (const auto ptr = m_textures.try_find(index))
+    {
+        *ptr = std::move(new_texture);
+    }
+    else
+    {
+        ICY_ERROR(m_textures.insert(index, std::move(new_texture)));
+    }
+    return error_type();
+}
+void render_gui_encoder::reset() noexcept
+{
+    m_reset = true;
+}
+error_type render_gui_encoder::encode(const render_gui_frame& frame, array<uint8_t>& output) noexcept
+{
+    const auto time = clock_type::now();
+    if (m_reset)
+    {
+        m_lists.clear();
+        for (auto&& texture : m_textures.vals())
+            texture.sent = false;
+    }
+
+    array<uint64_t> hashes;
+    ICY_ERROR(hashes.reserve(frame.data.size()));
+    auto capacity = stream_header_size + sizeof(stream_magic) + 2 + sizeof(render_vec4) + 2 * 10 + 2 * 10;
+    for (auto&& texture : m_textures.vals())
+    {
+        if (!texture.sent)
+            capacity += sizeof(guid) + 2 * 10 + texture.image.size() * sizeof(color);
+    }
+    for (auto&& list : frame.data)
+    {
+        ICY_ERROR(hashes.push_back(stream_hash(list)));
+        capacity += stream_capacity(list);
+    }
+
+    const auto offset = output.size();
+    ICY_ERROR(output.resize(offset + capacity));
+    stream_writer writer(output.data() + offset + stream_header_size);
+    writer.value(stream_magic);
+    writer.value(uint8_t(render_gui_stream_version));
+    writer.value(uint8_t(m_reset ? stream_flag_reset : 0));
+    writer.value(frame.viewport.vec);
+    writer.varint(frame.vbuffer);
+    writer.varint(frame.ibuffer);
+
+    auto texture_count = 0_z;
+    for (auto&& texture : m_textures.vals())
+        texture_count += !texture.sent;
+    writer.varint(texture_count);
+    for (auto k = 0_z; k < m_textures.size(); ++k)
+    {
+        auto& texture = m_textures.vals()[k];
+        if (texture.sent)
+            continue;
+        writer.value(m_textures.keys()[k]);
+        writer.varint(texture.image.rows());
+        writer.varint(texture.image.cols());
+        writer.bytes(texture.image.data(), texture.image.size() * sizeof(color));
+    }
+
+    //  the decoder keeps exactly the lists of this message for the next one
+    auto count_full = 0_z;
+    auto count_cached = 0_z;
+    auto raw_bytes = 0_z;
+    set<uint64_t> new_lists;
+    ICY_ERROR(new_lists.reserve(frame.data.size()));
+    writer.varint(frame.data.size());
+    for (auto k = 0_z; k < frame.data.size(); ++k)
+    {
+        const auto& list = frame.data[k];
+        const auto hash = hashes[k];
+        writer.value(hash);
+        if (m_lists.try_find(hash) || new_lists.try_find(hash))
+        {
+            writer.value(uint8_t(stream_list_cached));
+            count_cached += 1;
+        }
+        else
+        {
+            writer.value(uint8_t(stream_list_full));
+            stream_write(writer, list);
+            count_full += 1;
+        }
+        ICY_ERROR(new_lists.try_insert(hash));
+        raw_bytes += list.idx.size() * sizeof(list.idx[0])
+            + list.vtx.size() * sizeof(list.vtx[0]) + list.cmd.size() * sizeof(list.cmd[0]);
+    }
+
+    const auto body = size_t(writer.ptr() - (output.data() + offset)) - stream_header_size;
+    if (body > stream_max_message)
+    {
+        output.resize(offset);
+        return make_stdlib_error(std::errc::message_size);
+    }
+    const auto body_size = uint32_t(body);
+    memcpy(output.data() + offset, &body_size, sizeof(body_size));
+    output.resize(offset + stream_header_size + body);
+
+    //  only a message that is actually queued changes the encoder state
+    for (auto&& texture : m_textures.vals())
+    {
+        if (texture.sent)
+            continue;
+        texture.sent = true;
+        m_stats.textures += 1;
+        raw_bytes += texture.image.size() * sizeof(color);
+    }
+    m_lists = std::move(new_lists);
+    m_stats.lists += count_full;
+    m_stats.cached += count_cached;
+    m_stats.raw_bytes += raw_bytes;
+    m_reset = false;
+    m_stats.frames += 1;
+    m_stats.bytes += stream_header_size + body;
+    m_stats.time += clock_type::now() - time;
+    return error_type();
+}
+
+error_type render_gui_decoder::decode(const const_array_view<uint8_t> bytes, array<render_gui_frame>& frames, array<guid>* textures) noexcept
+{
+    const auto time = clock_type::now();
+    ICY_SCOPE_EXIT{ m_stats.time += clock_type::now() - time; };
+
+    //  complete messages are decoded in place; only a partial tail is buffered.
+    //  A rejected message is skipped (its size prefix still frames the next one): the first
+    //  such error is returned once the rest of the input is decoded
+    auto rejected = error_type();
+    const auto next = [&](const_array_view<uint8_t>& input, bool& done) -> error_type
+    {
+        done = true;
+        if (input.size() < stream_header_size)
+            return error_type();
+
+        uint32_t body = 0;
+        memcpy(&body, input.data(), sizeof(body));
+        if (body > stream_max_message)
+            return make_stdlib_error(std::errc::illegal_byte_sequence);
+        if (input.size() < stream_header_size + body)
+            return error_type();
+
+        const auto bytes = const_array_view<uint8_t>(input.data() + stream_header_size, body);
+        input = const_array_view<uint8_t>(input.data() + stream_header_size + body, input.size() - stream_header_size - body);
+        m_stats.bytes += stream_header_size + body;
+        done = false;
+
+        render_gui_frame frame;
+        if (const auto error = message(bytes, frame, textures))
+        {
+            m_stats.rejected += 1;
+            if (!rejected)
+                rejected = error;
+            return error_type();
+        }
+        ICY_ERROR(frames.push_back(std::move(frame)));
+        return error_type();
+    };
+    const auto append = [this](const_array_view<uint8_t>& input, const size_t size) -> error_type
+    {
+        const auto offset = m_buffer.size();
+        ICY_ERROR(m_buffer.resize(offset + size));
+        memcpy(m_buffer.data() + offset, input.data(), size);
+        input = const_array_view<uint8_t>(input.data() + size, input.size() - size);
+        return error_type();
+    };
+
+    auto input = bytes;
+    if (!m_buffer.empty())
+    {
+        //  complete the buffered message first
+        if (m_buffer.size() < stream_header_size)
+        {
+            ICY_ERROR(append(input, std::min(stream_header_size - m_buffer.size(), input.size())));
+            if (m_buffer.size() < stream_header_size)
+                return error_type();
+        }
+        uint32_t body = 0;
+        memcpy(&body, m_buffer.data(), sizeof(body));
+        if (body > stream_max_message)
+        {
+            //  framing is lost: nothing after this can be trusted
+            m_buffer.clear();
+            return make_stdlib_error(std::errc::illegal_byte_sequence);
+        }
+        ICY_ERROR(append(input, std::min(stream_header_size + body - m_buffer.size(), input.size())));
+        if (m_buffer.size() < stream_header_size + body)
+            return error_type();
+
+        //  the buffer is released even if the message is rejected
+        const auto buffer = std::move(m_buffer);
+        auto view = const_array_view<uint8_t>(buffer);
+        auto done = false;
+        ICY_ERROR(next(view, done));
+    }
+    while (true)
+    {
+        auto done = false;
+        ICY_ERROR(next(input, done));
+        if (done)
+            break;
+    }
+    if (!input.empty())
+    {
+        ICY_ERROR(append(input, input.size()));
+    }
+    return rejected;
+}
+error_type render_gui_decoder::message(const const_array_view<uint8_t> bytes, render_gui_frame& frame, array<guid>* textures) noexcept
+{
+    const auto invalid = make_stdlib_error(std::errc::illegal_byte_sequence);
+    stream_reader reader(bytes);
+
+    uint32_t magic = 0;
+    uint8_t version = 0;
+    uint8_t flags = 0;
+    if (!reader.value(magic) || !reader.value(version) || !reader.value(flags))
+        return invalid;
+    if (magic != stream_magic || version != render_gui_stream_version)
+        return invalid;
+    if (flags & stream_flag_reset)
+        m_lists.clear();
+
+    if (!reader.value(frame.viewport.vec) || !reader.varint(frame.vbuffer) || !reader.varint(frame.ibuffer))
+        return invalid;
+
+    size_t texture_count = 0;
+    if (!reader.count(texture_count, sizeof(guid) + 2))
+        return invalid;
+    for (auto k = 0_z; k < texture_count; ++k)
+    {
+        guid index;
+        uint64_t rows = 0;
+        uint64_t cols = 0;
+        if (!reader.value(index) || !reader.varint(rows) || !reader.varint(cols))
+            return invalid;
+        if (rows && cols > reader.size() / sizeof(color) / rows)
+            return invalid;
+
+        matrix<color> image(rows, cols);
+        if (image.size() != rows * cols)
+            return make_stdlib_error(std::errc::not_enough_memory);
+        if (!reader.bytes(image.data(), image.size() * sizeof(color)))
+            return invalid;
+
+        if (const auto ptr = m_textures.try_find(index))
+        {
+            *ptr = std::move(image);
+        }
+        else
+        {
+            ICY_ERROR(m_textures.insert(index, std::move(image)));
+        }
+        if (textures)
+        {
+            ICY_ERROR(textures->push_back(index));
+        }
+        m_stats.textures += 1;
+        m_stats.raw_bytes += rows * cols * sizeof(color);
+    }
+
+    size_t list_count = 0;
+    if (!reader.count(list_count, sizeof(uint64_t) + 1))
+        return invalid;
+    ICY_ERROR(frame.data.resize(list_count));
+
+    map<uint64_t, render_gui_list> new_lists;
+    for (auto&& list : frame.data)
+    {
+        uint64_t hash = 0;
+        uint8_t kind = 0;
+        if (!reader.value(hash) || !reader.value(kind))
+            return invalid;
+
+        if (kind == stream_list_cached)
+        {
+            auto cached = new_lists.try_find(hash);
+            if (!cached)
+                cached = m_lists.try_find(hash);
+            if (!cached)
+                return make_stdlib_error(std::errc::invalid_argument);  //  out of sync: encoder needs a "reset"
+            ICY_ERROR(copy(*cached, list));
+            m_stats.cached += 1;
+        }
+        else if (kind == stream_list_full)
+        {
+            if (!stream_read(reader, list))
+                return invalid;
+            m_stats.lists += 1;
+        }
+        else
+        {
+            return invalid;
+        }
+        if (!new_lists.try_find(hash))
+        {
+            render_gui_list copy_list;
+            ICY_ERROR(copy(list, copy_list));
+            ICY_ERROR(new_lists.insert(hash, std::move(copy_list)));
+        }
+        m_stats.raw_bytes += list.idx.size() * sizeof(list.idx[0])
+            + list.vtx.size() * sizeof(list.vtx[0]) + list.cmd.size() * sizeof(list.cmd[0]);
+    }
+    if (reader.size())
+        return invalid;
+
+    m_lists = std::move(new_lists);
+    m_stats.frames += 1;
+    return error_type();
+}
@@ -0,0 +1,813 @@
+#include <icy_engine/graphics/icy_render_texture.hpp>
+#if _M_X64 || __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace icy;
+
+ICY_STATIC_NAMESPACE_BEG
+static const auto texture_kaiser_taps = 8;      //  offsets -3 .. +4 around 2 * x
+static const auto texture_kaiser_alpha = 4.0;
+static const auto texture_kaiser_width = 2.0;   //  in output pixels
+static const auto texture_pi = 3.14159265358979323846;
+static const auto texture_bc7_mode6 = 0x40u;    //  6 zero bits, then 1
+static const uint32_t texture_bc7_weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+static const uint32_t texture_bc1_weights[4] = { 0, 3, 1, 2 };  //  index -> thirds towards c1
+static const auto texture_parallel_rows = 16u;  //  block rows below which the calling thread works alone
+ICY_STATIC_NAMESPACE_END
+
+#if _M_X64 || __SSE2__
+using texture_vec = __m128;
+static inline texture_vec texture_zero() noexcept
+{
+    return _mm_setzero_ps();
+}
+static inline texture_vec texture_load(const float* const ptr) noexcept
+{
+    return _mm_loadu_ps(ptr);
+}
+static inline void texture_store(float* const ptr, const texture_vec value) noexcept
+{
+    _mm_storeu_ps(ptr, value);
+}
+static inline texture_vec texture_madd(const texture_vec acc, const texture_vec value, const float weight) noexcept
+{
+    return _mm_add_ps(acc, _mm_mul_ps(value, _mm_set1_ps(weight)));
+}
+#else
+struct texture_vec
+{
+    float value[4];
+};
+static inline texture_vec texture_zero() noexcept
+{
+    return {};
+}
+static inline texture_vec texture_load(const float* const ptr) noexcept
+{
+    return { ptr[0], ptr[1], ptr[2], ptr[3] };
+}
+static inline void texture_store(float* const ptr, const texture_vec value) noexcept
+{
+    memcpy(ptr, value.value, sizeof(value.value));
+}
+static inline texture_vec texture_madd(const texture_vec acc, const texture_vec value, const float weight) noexcept
+{
+    return
+    {
+        acc.value[0] + value.value[0] * weight, acc.value[1] + value.value[1] * weight,
+        acc.value[2] + value.value[2] * weight, acc.value[3] + value.value[3] * weight,
+    };
+}
+#endif
+
+static const float* texture_srgb_to_linear() noexcept
+{
+    static const auto table = []
+    {
+        std::array<float, 256> values;
+        for (auto k = 0u; k < 256; ++k)
+        {
+            const auto c = k / 255.0;
+            values[k] = float(c <= 0.04045 ? c / 12.92 : pow((c + 0.055) / 1.055, 2.4));
+        }
+        return values;
+    }();
+    return table.data();
+}
+static uint8_t texture_linear_to_srgb(const float value) noexcept
+{
+    const auto c = std::min(std::max(value, 0.0f), 1.0f);
+    const auto s = c <= 0.0031308f ? c * 12.92f : 1.055f * powf(c, 1 / 2.4f) - 0.055f;
+    return uint8_t(s * 255 + 0.5f);
+}
+static inline uint8_t texture_unorm(const float value) noexcept
+{
+    return uint8_t(std::min(std::max(value, 0.0f), 1.0f) * 255 + 0.5f);
+}
+static double texture_bessel0(const double x) noexcept
+{
+    auto sum = 1.0;
+    auto term = 1.0;
+    for (auto k = 1; k < 32; ++k)
+    {
+        term *= (x / (2 * k)) * (x / (2 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+//  linear premultiplied RGBA floats <-> "color"
+static void texture_to_float(const const_matrix_view<color> image, const bool srgb, float* output) noexcept
+{
+    const auto table = texture_srgb_to_linear();
+    for (auto row = 0_z; row < image.rows(); ++row)
+    {
+        for (auto col = 0_z; col < image.cols(); ++col, output += 4)
+        {
+            const auto pixel = image.at(row, col);
+            const auto alpha = pixel.a / 255.0f;
+            output[0] = (srgb ? table[pixel.r] : pixel.r / 255.0f) * alpha;
+            output[1] = (srgb ? table[pixel.g] : pixel.g / 255.0f) * alpha;
+            output[2] = (srgb ? table[pixel.b] : pixel.b / 255.0f) * alpha;
+            output[3] = alpha;
+        }
+    }
+}
+static void texture_from_float(const float* input, const bool srgb, matrix<color>& image) noexcept
+{
+    for (auto row = 0_z; row < image.rows(); ++row)
+    {
+        for (auto col = 0_z; col < image.cols(); ++col, input += 4)
+        {
+            auto& pixel = image.at(row, col);
+            const auto alpha = std::min(std::max(input[3], 0.0f), 1.0f);
+            const auto scale = alpha > 0 ? 1 / alpha : 0.0f;
+            const float value[3] = { input[0] * scale, input[1] * scale, input[2] * scale };
+            pixel.r = srgb ? texture_linear_to_srgb(value[0]) : texture_unorm(value[0]);
+            pixel.g = srgb ? texture_linear_to_srgb(value[1]) : texture_unorm(value[1]);
+            pixel.b = srgb ? texture_linear_to_srgb(value[2]) : texture_unorm(value[2]);
+            pixel.a = texture_unorm(alpha);
+        }
+    }
+}
+static void texture_box(const float* const input, const uint32_t width, const uint32_t height,
+    float* output, const uint32_t out_width, const uint32_t out_height) noexcept
+{
+    for (auto y = 0u; y < out_height; ++y)
+    {
+        const auto y0 = std::min(2 * y, height - 1);
+        const auto y1 = std::min(2 * y + 1, height - 1);
+        for (auto x = 0u; x < out_width; ++x, output += 4)
+        {
+            const auto x0 = std::min(2 * x, width - 1);
+            const auto x1 = std::min(2 * x + 1, width - 1);
+            auto sum = texture_zero();
+            sum = texture_madd(sum, texture_load(input + 4 * (size_t(y0) * width + x0)), 0.25f);
+            sum = texture_madd(sum, texture_load(input + 4 * (size_t(y0) * width + x1)), 0.25f);
+            sum = texture_madd(sum, texture_load(input + 4 * (size_t(y1) * width + x0)), 0.25f);
+            sum = texture_madd(sum, texture_load(input + 4 * (size_t(y1) * width + x1)), 0.25f);
+            texture_store(output, sum);
+        }
+    }
+}
+//  separable: rows into "buffer" (out_width x height), then columns
+static void texture_kaiser(const float* const input, const uint32_t width, const uint32_t height,
+    float* const buffer, float* output, const uint32_t out_width, const uint32_t out_height) noexcept
+{
+    float weights[texture_kaiser_taps];
+    auto sum = 0.0;
+    for (auto k = 0; k < texture_kaiser_taps; ++k)
+    {
+        //  tap k samples input pixel 2x + k - 3; its center is (k - 3.5) input pixels from the output center
+        const auto t = (k - 3.5) / 2;
+        const auto sinc = t == 0 ? 1.0 : sin(texture_pi * t) / (texture_pi * t);
+        const auto r = t / texture_kaiser_width;
+        const auto window = texture_bessel0(texture_kaiser_alpha * sqrt(std::max(0.0, 1 - r * r))) / texture_bessel0(texture_kaiser_alpha);
+        weights[k] = float(sinc * window);
+        sum += weights[k];
+    }
+    for (auto&& weight : weights)
+        weight = float(weight / sum);
+
+    const auto clamp = [](const int value, const uint32_t size)
+    {
+        return uint32_t(std::min(std::max(value, 0), int(size) - 1));
+    };
+    for (auto y = 0u; y < height; ++y)
+    {
+        const auto row = input + 4 * size_t(y) * width;
+        for (auto x = 0u; x < out_width; ++x)
+        {
+            auto value = texture_zero();
+            for (auto k = 0; k < texture_kaiser_taps; ++k)
+                value = texture_madd(value, texture_load(row + 4 * clamp(int(2 * x) + k - 3, width)), weights[k]);
+            texture_store(buffer + 4 * (size_t(y) * out_width + x), value);
+        }
+    }
+    for (auto y = 0u; y < out_height; ++y)
+    {
+        size_t rows[texture_kaiser_taps];
+        for (auto k = 0; k < texture_kaiser_taps; ++k)
+            rows[k] = size_t(clamp(int(2 * y) + k - 3, height)) * out_width;
+        for (auto x = 0u; x < out_width; ++x, output += 4)
+        {
+            auto value = texture_zero();
+            for (auto k = 0; k < texture_kaiser_taps; ++k)
+                value = texture_madd(value, texture_load(buffer + 4 * (rows[k] + x)), weights[k]);
+            texture_store(output, value);
+        }
+    }
+}
+
+//  dominant eigenvector of the covariance of "count" points (power iteration)
+template<size_t N>
+static void texture_axis(const float (&points)[16][N], float (&mean)[N], float (&axis)[N]) noexcept
+{
+    for (auto c = 0_z; c < N; ++c)
+    {
+        mean[c] = 0;
+        for (auto k = 0u; k < 16; ++k)
+            mean[c] += points[k][c];
+        mean[c] /= 16;
+    }
+    float cov[N][N] = {};
+    for (auto k = 0u; k < 16; ++k)
+    {
+        for (auto i = 0_z; i < N; ++i)
+        {
+            for (auto j = 0_z; j < N; ++j)
+                cov[i][j] += (points[k][i] - mean[i]) * (points[k][j] - mean[j]);
+        }
+    }
+    for (auto c = 0_z; c < N; ++c)
+        axis[c] = 1;
+    for (auto iter = 0; iter < 8; ++iter)
+    {
+        float next[N] = {};
+        auto norm = 0.0f;
+        for (auto i = 0_z; i < N; ++i)
+        {
+            for (auto j = 0_z; j < N; ++j)
+                next[i] += cov[i][j] * axis[j];
+            norm = std::max(norm, fabsf(next[i]));
+        }
+        if (norm == 0)
+            break;
+        for (auto c = 0_z; c < N; ++c)
+            axis[c] = next[c] / norm;
+    }
+}
+//  endpoints on the axis through the mean, spanning the projections of all points
+template<size_t N>
+static void texture_endpoints(const float (&points)[16][N], float (&e0)[N], float (&e1)[N]) noexcept
+{
+    float mean[N];
+    float axis[N];
+    texture_axis(points, mean, axis);
+    auto tmin = FLT_MAX;
+    auto tmax = -FLT_MAX;
+    auto len = 0.0f;
+    for (auto c = 0_z; c < N; ++c)
+        len += axis[c] * axis[c];
+    for (auto k = 0u; k < 16; ++k)
+    {
+        auto t = 0.0f;
+        for (auto c = 0_z; c < N; ++c)
+            t += (points[k][c] - mean[c]) * axis[c];
+        tmin = std::min(tmin, t);
+        tmax = std::max(tmax, t);
+    }
+    if (len > 0)
+    {
+        tmin /= len;
+        tmax /= len;
+    }
+    else
+    {
+        tmin = tmax = 0;
+    }
+    for (auto c = 0_z; c < N; ++c)
+    {
+        e0[c] = std::min(std::max(mean[c] + axis[c] * tmax, 0.0f), 255.0f);
+        e1[c] = std::min(std::max(mean[c] + axis[c] * tmin, 0.0f), 255.0f);
+    }
+}
+//  least squares endpoints for fixed interpolation weights (w = share of e1); false if degenerate
+template<size_t N>
+static bool texture_solve(const float (&points)[16][N], const float (&weights)[16], float (&e0)[N], float (&e1)[N]) noexcept
+{
+    auto aa = 0.0f;
+    auto bb = 0.0f;
+    auto ab = 0.0f;
+    float ax[N] = {};
+    float bx[N] = {};
+    for (auto k = 0u; k < 16; ++k)
+    {
+        const auto b = weights[k];
+        const auto a = 1 - b;
+        aa += a * a;
+        bb += b * b;
+        ab += a * b;
+        for (auto c = 0_z; c < N; ++c)
+        {
+            ax[c] += a * points[k][c];
+            bx[c] += b * points[k][c];
+        }
+    }
+    const auto det = aa * bb - ab * ab;
+    if (fabsf(det) < 1e-6f)
+        return false;
+    for (auto c = 0_z; c < N; ++c)
+    {
+        e0[c] = std::min(std::max((ax[c] * bb - bx[c] * ab) / det, 0.0f), 255.0f);
+        e1[c] = std::min(std::max((bx[c] * aa - ax[c] * ab) / det, 0.0f), 255.0f);
+    }
+    return true;
+}
+
+static inline uint16_t texture_pack565(const float (&value)[3]) noexcept
+{
+    const auto r = uint32_t(value[0] * 31 / 255 + 0.5f);
+    const auto g = uint32_t(value[1] * 63 / 255 + 0.5f);
+    const auto b = uint32_t(value[2] * 31 / 255 + 0.5f);
+    return uint16_t((r << 11) | (g << 5) | b);
+}
+static inline void texture_unpack565(const uint16_t value, int32_t (&rgb)[3]) noexcept
+{
+    const auto r = (value >> 11) & 0x1F;
+    const auto g = (value >> 5) & 0x3F;
+    const auto b = value & 0x1F;
+    rgb[0] = (r << 3) | (r >> 2);
+    rgb[1] = (g << 2) | (g >> 4);
+    rgb[2] = (b << 3) | (b >> 2);
+}
+//  4-color mode palette and nearest indices for (c0, c1); returns the squared error
+static uint32_t texture_bc1_fit(const float (&points)[16][3], const uint16_t c0, const uint16_t c1, uint8_t (&indices)[16]) noexcept
+{
+    int32_t palette[4][3];
+    texture_unpack565(c0, palette[0]);
+    texture_unpack565(c1, palette[1]);
+    for (auto c = 0u; c < 3; ++c)
+    {
+        palette[2][c] = (2 * palette[0][c] + palette[1][c] + 1) / 3;
+        palette[3][c] = (palette[0][c] + 2 * palette[1][c] + 1) / 3;
+    }
+    auto total = 0u;
+    for (auto k = 0u; k < 16; ++k)
+    {
+        auto best = UINT32_MAX;
+        for (auto n = 0u; n < 4; ++n)
+        {
+            auto error = 0u;
+            for (auto c = 0u; c < 3; ++c)
+            {
+                const auto delta = int32_t(points[k][c]) - palette[n][c];
+                error += uint32_t(delta * delta);
+            }
+            if (error < best)
+            {
+                best = error;
+                indices[k] = uint8_t(n);
+            }
+        }
+        total += best;
+    }
+    return total;
+}
+static void texture_bc1(const color (&block)[16], uint8_t* const output) noexcept
+{
+    float points[16][3];
+    for (auto k = 0u; k < 16; ++k)
+    {
+        points[k][0] = block[k].r;
+        points[k][1] = block[k].g;
+        points[k][2] = block[k].b;
+    }
+    float e0[3];
+    float e1[3];
+    texture_endpoints(points, e0, e1);
+
+    auto c0 = texture_pack565(e0);
+    auto c1 = texture_pack565(e1);
+    uint8_t indices[16];
+    auto error = texture_bc1_fit(points, c0, c1, indices);
+
+    float weights[16];
+    for (auto k = 0u; k < 16; ++k)
+        weights[k] = texture_bc1_weights[indices[k]] / 3.0f;
+    if (error && texture_solve(points, weights, e0, e1))
+    {
+        const auto r0 = texture_pack565(e0);
+        const auto r1 = texture_pack565(e1);
+        uint8_t refined[16];
+        const auto refined_error = texture_bc1_fit(points, r0, r1, refined);
+        if (refined_error < error)
+        {
+            c0 = r0;
+            c1 = r1;
+            error = refined_error;
+            memcpy(indices, refined, sizeof(indices));
+        }
+    }
+
+    //  c0 > c1 selects the 4-color mode
+    if (c0 < c1)
+    {
+        std::swap(c0, c1);
+        for (auto&& index : indices)
+            index ^= 1;
+    }
+    else if (c0 == c1)
+    {
+        memset(indices, 0, sizeof(indices));
+    }
+    auto bits = 0u;
+    for (auto k = 0u; k < 16; ++k)
+        bits |= uint32_t(indices[k]) << (2 * k);
+    memcpy(output + 0, &c0, sizeof(c0));
+    memcpy(output + 2, &c1, sizeof(c1));
+    memcpy(output + 4, &bits, sizeof(bits));
+}
+//  BC3 alpha: 8-value mode between max and min
+static void texture_bc3_alpha(const color (&block)[16], uint8_t* const output) noexcept
+{
+    auto a0 = 0u;
+    auto a1 = 255u;
+    for (auto&& pixel : block)
+    {
+        a0 = std::max(a0, uint32_t(pixel.a));
+        a1 = std::min(a1, uint32_t(pixel.a));
+    }
+    uint32_t palette[8] = { a0, a1 };
+    for (auto k = 1u; k < 7; ++k)
+        palette[k + 1] = ((7 - k) * a0 + k * a1 + 3) / 7;
+
+    uint64_t bits = 0;
+    if (a0 != a1)
+    {
+        for (auto k = 0u; k < 16; ++k)
+        {
+            auto best = 0u;
+            auto best_error = UINT32_MAX;
+            for (auto n = 0u; n < 8; ++n)
+            {
+                const auto delta = int32_t(block[k].a) - int32_t(palette[n]);
+                const auto error = uint32_t(delta * delta);
+                if (error < best_error)
+                {
+                    best_error = error;
+                    best = n;
+                }
+            }
+            bits |= uint64_t(best) << (3 * k);
+        }
+    }
+    output[0] = uint8_t(a0);
+    output[1] = uint8_t(a1);
+    for (auto k = 0u; k < 6; ++k)
+        output[2 + k] = uint8_t(bits >> (8 * k));
+}
+
+//  BC7 mode 6: 8-bit endpoint channel = 7-bit value << 1 | p-bit (one p-bit per endpoint)
+struct texture_bc7_endpoint
+{
+    uint32_t value[4];
+    uint32_t pbit;
+};
+static texture_bc7_endpoint texture_bc7_quantize(const float (&value)[4]) noexcept
+{
+    texture_bc7_endpoint best = {};
+    auto best_error = FLT_MAX;
+    for (auto p = 0u; p < 2; ++p)
+    {
+        texture_bc7_endpoint next = {};
+        next.pbit = p;
+        auto error = 0.0f;
+        for (auto c = 0u; c < 4; ++c)
+        {
+            const auto q = std::min(std::max(int32_t(floorf((value[c] - p) / 2 + 0.5f)), 0), 127);
+            next.value[c] = uint32_t(q);
+            const auto delta = value[c] - float((q << 1) | p);
+            error += delta * delta;
+        }
+        if (error < best_error)
+        {
+            best_error = error;
+            best = next;
+        }
+    }
+    return best;
+}
+static uint32_t texture_bc7_fit(const float (&points)[16][4], const texture_bc7_endpoint& e0, const texture_bc7_endpoint& e1, uint8_t (&indices)[16]) noexcept
+{
+    int32_t palette[16][4];
+    for (auto c = 0u; c < 4; ++c)
+    {
+        const auto v0 = (e0.value[c] << 1) | e0.pbit;
+        const auto v1 = (e1.value[c] << 1) | e1.pbit;
+        for (auto n = 0u; n < 16; ++n)
+            palette[n][c] = int32_t(((64 - texture_bc7_weights[n]) * v0 + texture_bc7_weights[n] * v1 + 32) >> 6);
+    }
+    auto total = 0u;
+    for (auto k = 0u; k < 16; ++k)
+    {
+        auto best = UINT32_MAX;
+        for (auto n = 0u; n < 16; ++n)
+        {
+            auto error = 0u;
+            for (auto c = 0u; c < 4; ++c)
+            {
+                const auto delta = int32_t(points[k][c]) - palette[n][c];
+                error += uint32_t(delta * delta);
+            }
+            if (error < best)
+            {
+                best = error;
+                indices[k] = uint8_t(n);
+            }
+        }
+        total += best;
+    }
+    return total;
+}
+class texture_bit_writer
+{
+public:
+    texture_bit_writer(uint8_t* const output) noexcept : m_output(output)
+    {
+
+    }
+    void write(const uint32_t value, const uint32_t count) noexcept
+    {
+        for (auto k = 0u; k < count; ++k, ++m_offset)
+        {
+            if ((value >> k) & 1)
+                m_output[m_offset >> 3] |= uint8_t(1 << (m_offset & 7));
+        }
+    }
+private:
+    uint8_t* m_output;
+    uint32_t m_offset = 0;
+};
+static void texture_bc7(const color (&block)[16], uint8_t* const output) noexcept
+{
+    float points[16][4];
+    for (auto k = 0u; k < 16; ++k)
+    {
+        points[k][0] = block[k].r;
+        points[k][1] = block[k].g;
+        points[k][2] = block[k].b;
+        points[k][3] = block[k].a;
+    }
+    float f0[4];
+    float f1[4];
+    texture_endpoints(points, f0, f1);
+
+    auto e0 = texture_bc7_quantize(f0);
+    auto e1 = texture_bc7_quantize(f1);
+    uint8_t indices[16];
+    auto error = texture_bc7_fit(points, e0, e1, indices);
+
+    float weights[16];
+    for (auto k = 0u; k < 16; ++k)
+        weights[k] = texture_bc7_weights[indices[k]] / 64.0f;
+    if (error && texture_solve(points, weights, f0, f1))
+    {
+        const auto r0 = texture_bc7_quantize(f0);
+        const auto r1 = texture_bc7_quantize(f1);
+        uint8_t refined[16];
+        const auto refined_error = texture_bc7_fit(points, r0, r1, refined);
+        if (refined_error < error)
+        {
+            e0 = r0;
+            e1 = r1;
+            memcpy(indices, refined, sizeof(indices));
+        }
+    }
+
+    //  the anchor (first) index is stored with its top bit implied zero
+    if (indices[0] & 8)
+    {
+        std::swap(e0, e1);
+        for (auto&& index : indices)
+            index = uint8_t(15 - index);
+    }
+    memset(output, 0, 16);
+    texture_bit_writer writer(output);
+    writer.write(texture_bc7_mode6, 7);
+    for (auto c = 0u; c < 4; ++c)
+    {
+        writer.write(e0.value[c], 7);
+        writer.write(e1.value[c], 7);
+    }
+    writer.write(e0.pbit, 1);
+    writer.write(e1.pbit, 1);
+    writer.write(indices[0], 3);
+    for (auto k = 1u; k < 16; ++k)
+        writer.write(indices[k], 4);
+}
+
+class render_texture_encoder::thread_type : public thread
+{
+public:
+    thread_type(render_texture_encoder& encoder) noexcept : m_encoder(encoder)
+    {
+
+    }
+    void cancel() noexcept override
+    {
+        //  nothing to interrupt: "run" returns once the block rows are exhausted
+    }
+protected:
+    error_type run() noexcept override
+    {
+        m_encoder.work();
+        return error_type();
+    }
+private:
+    render_texture_encoder& m_encoder;
+};
+
+error_type icy::render_texture_mips(const const_matrix_view<color> image, const render_texture_options& options, array<matrix<color>>& mips) noexcept
+{
+    mips.clear();
+    if (image.empty())
+        return make_stdlib_error(std::errc::invalid_argument);
+
+    auto width = uint32_t(image.cols());
+    auto height = uint32_t(image.rows());
+    auto levels = 1u;
+    while ((width >> levels) || (height >> levels))
+        ++levels;
+    if (options.levels)
+        levels = std::min(levels, options.levels);
+
+    ICY_ERROR(mips.reserve(levels));
+    matrix<color> level0;
+    ICY_ERROR(copy(image, level0));
+    ICY_ERROR(mips.push_back(std::move(level0)));
+    if (levels == 1)
+        return error_type();
+
+    array<float> input;
+    array<float> output;
+    array<float> buffer;
+    ICY_ERROR(input.resize(size_t(width) * height * 4));
+    texture_to_float(image, options.srgb, input.data());
+    for (auto level = 1u; level < levels; ++level)
+    {
+        const auto out_width = std::max(width / 2, 1u);
+        const auto out_height = std::max(height / 2, 1u);
+        ICY_ERROR(output.resize(size_t(out_width) * out_height * 4));
+        if (options.filter == render_texture_filter::kaiser)
+        {
+            ICY_ERROR(buffer.resize(size_t(out_width) * height * 4));
+            texture_kaiser(input.data(), width, height, buffer.data(), output.data(), out_width, out_height);
+        }
+        else
+        {
+            texture_box(input.data(), width, height, output.data(), out_width, out_height);
+        }
+
+        matrix<color> mip(out_height, out_width);
+        if (mip.size() != size_t(out_width) * out_height)
+            return make_stdlib_error(std::errc::not_enough_memory);
+        texture_from_float(output.data(), options.srgb, mip);
+        ICY_ERROR(mips.push_back(std::move(mip)));
+
+        std::swap(input, output);
+        width = out_width;
+        height = out_height;
+    }
+    return error_type();
+}
+size_t icy::render_texture_level_size(const render_texture_compress compress, const uint32_t width, const uint32_t height) noexcept
+{
+    const auto blocks = size_t((width + 3) / 4) * ((height + 3) / 4);
+    switch (compress)
+    {
+    case render_texture_compress::none:
+        return size_t(width) * height * sizeof(color);
+    case render_texture_compress::dds1:
+        return blocks * 8;
+    case render_texture_compress::dds5:
+    case render_texture_compress::bc7:
+        return blocks * 16;
+    default:
+        return 0;
+    }
+}
+
+render_texture_encoder::render_texture_encoder() noexcept
+{
+
+}
+render_texture_encoder::~render_texture_encoder() noexcept
+{
+    for (auto&& thread : m_threads)
+        thread->wait();
+}
+error_type render_texture_encoder::initialize(const size_t threads) noexcept
+{
+    for (auto&& thread : m_threads)
+        thread->wait();
+    m_threads.clear();
+
+    const auto count = threads ? threads : std::max(thread::cores(), 1_z);
+    ICY_ERROR(m_threads.reserve(count - 1));
+    for (auto k = 1_z; k < count; ++k)
+    {
+        shared_ptr<thread_type> new_thread;
+        ICY_ERROR(make_shared(new_thread, *this));
+        ICY_ERROR(m_threads.push_back(std::move(new_thread)));
+    }
+    return error_type();
+}
+error_type render_texture_encoder::encode(const const_matrix_view<color> image, const render_texture_options& options, render_texture& texture) noexcept
+{
+    array<matrix<color>> mips;
+    ICY_ERROR(render_texture_mips(image, options, mips));
+
+    auto size = 0_z;
+    for (auto&& mip : mips)
+        size += render_texture_level_size(options.compress, uint32_t(mip.cols()), uint32_t(mip.rows()));
+    if (!size)
+        return make_stdlib_error(std::errc::invalid_argument);
+
+    array<uint8_t> bytes;
+    ICY_ERROR(bytes.resize(size));
+    auto offset = 0_z;
+    for (auto&& mip : mips)
+    {
+        ICY_ERROR(encode(mip, options.compress, bytes.data() + offset));
+        offset += render_texture_level_size(options.compress, uint32_t(mip.cols()), uint32_t(mip.rows()));
+    }
+    texture.size = window_size(uint32_t(image.cols()), uint32_t(image.rows()));
+    texture.compress = options.compress;
+    texture.levels = uint32_t(mips.size());
+    texture.bytes = std::move(bytes);
+    return error_type();
+}
+error_type render_texture_encoder::encode(const const_matrix_view<color> image, const render_texture_compress compress, uint8_t* const output) noexcept
+{
+    if (image.empty() || !output)
+        return make_stdlib_error(std::errc::invalid_argument);
+
+    if (compress == render_texture_compress::none)
+    {
+        for (auto row = 0_z; row < image.rows(); ++row)
+            memcpy(output + row * image.cols() * sizeof(color), image.row(row).data(), image.cols() * sizeof(color));
+        return error_type();
+    }
+    if (compress != render_texture_compress::dds1 && compress != render_texture_compress::dds5 && compress != render_texture_compress::bc7)
+        return make_stdlib_error(std::errc::invalid_argument);
+
+    m_image = image;
+    m_compress = compress;
+    m_output = output;
+    m_blocks_x = uint32_t((image.cols() + 3) / 4);
+    m_blocks_y = uint32_t((image.rows() + 3) / 4);
+    m_next.store(0, std::memory_order_release);
+
+    auto launched = 0_z;
+    error_type error;
+    if (m_blocks_y >= texture_parallel_rows)
+    {
+        const auto helpers = std::min(m_threads.size(), size_t(m_blocks_y) - 1);
+        for (; launched < helpers && !error; ++launched)
+            error = m_threads[launched]->launch();
+        if (error)
+            --launched;
+    }
+    work();
+    for (auto k = 0_z; k < launched; ++k)
+    {
+        if (const auto wait_error = m_threads[k]->wait())
+        {
+            if (!error)
+                error = wait_error;
+        }
+    }
+    return error;
+}
+void render_texture_encoder::work() noexcept
+{
+    const auto block_size = m_compress == render_texture_compress::dds1 ? 8u : 16u;
+    const auto rows = m_image.rows();
+    const auto cols = m_image.cols();
+    while (true)
+    {
+        const auto block_y = m_next.fetch_add(1, std::memory_order_acq_rel);
+        if (block_y >= m_blocks_y)
+            break;
+
+        for (auto block_x = 0u; block_x < m_blocks_x; ++block_x)
+        {
+            //  partial edge blocks repeat the last row / column
+            color block[16];
+            for (auto k = 0u; k < 16; ++k)
+            {
+                const auto row = std::min(size_t(block_y) * 4 + k / 4, rows - 1);
+                const auto col = std::min(size_t(block_x) * 4 + k % 4, cols - 1);
+                block[k] = m_image.at(row, col);
+            }
+            const auto output = m_output + (size_t(block_y) * m_blocks_x + block_x) * block_size;
+            switch (m_compress)
+            {
+            case render_texture_compress::dds1:
+                texture_bc1(block, output);
+                break;
+            case render_texture_compress::dds5:
+                texture_bc3_alpha(block, output);
+                texture_bc1(block, output + 8);
+                break;
+            case render_texture_compress::bc7:
+                texture_bc7(block, output);
+                break;
+            default:
+                break;
+            }
+        }
+    }
+}
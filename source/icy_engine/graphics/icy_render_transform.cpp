@@ -0,0 +1,310 @@
+#include <icy_engine/graphics/icy_render_transform.hpp>
+#include <xmmintrin.h>
+#if __AVX__
+#include <immintrin.h>
+#endif
+
+using namespace icy;
+
+ICY_STATIC_NAMESPACE_BEG
+#if __AVX__
+static const auto lane_block = 8_z;
+#else
+static const auto lane_block = 4_z;
+#endif
+
+//  compose S * R(q) * T for 4 nodes (one node per lane) and store 4 row-major matrices
+static void compose4(const __m128 (&in)[10], render_matrix* const output) noexcept
+{
+    const auto one = _mm_set1_ps(1);
+    const auto two = _mm_set1_ps(2);
+    const auto zero = _mm_setzero_ps();
+
+    const auto qx = in[6];
+    const auto qy = in[7];
+    const auto qz = in[8];
+    const auto qw = in[9];
+
+    const auto xx = _mm_mul_ps(qx, qx);
+    const auto yy = _mm_mul_ps(qy, qy);
+    const auto zz = _mm_mul_ps(qz, qz);
+    const auto xy = _mm_mul_ps(qx, qy);
+    const auto xz = _mm_mul_ps(qx, qz);
+    const auto yz = _mm_mul_ps(qy, qz);
+    const auto xw = _mm_mul_ps(qx, qw);
+    const auto yw = _mm_mul_ps(qy, qw);
+    const auto zw = _mm_mul_ps(qz, qw);
+
+    auto r00 = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz)));
+    auto r01 = _mm_mul_ps(two, _mm_add_ps(xy, zw));
+    auto r02 = _mm_mul_ps(two, _mm_sub_ps(xz, yw));
+    auto r10 = _mm_mul_ps(two, _mm_sub_ps(xy, zw));
+    auto r11 = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz)));
+    auto r12 = _mm_mul_ps(two, _mm_add_ps(yz, xw));
+    auto r20 = _mm_mul_ps(two, _mm_add_ps(xz, yw));
+    auto r21 = _mm_mul_ps(two, _mm_sub_ps(yz, xw));
+    auto r22 = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy)));
+
+    r00 = _mm_mul_ps(r00, in[3]);
+    r01 = _mm_mul_ps(r01, in[3]);
+    r02 = _mm_mul_ps(r02, in[3]);
+    r10 = _mm_mul_ps(r10, in[4]);
+    r11 = _mm_mul_ps(r11, in[4]);
+    r12 = _mm_mul_ps(r12, in[4]);
+    r20 = _mm_mul_ps(r20, in[5]);
+    r21 = _mm_mul_ps(r21, in[5]);
+    r22 = _mm_mul_ps(r22, in[5]);
+
+    auto r03 = zero;
+    auto r13 = zero;
+    auto r23 = zero;
+    auto tx = in[0];
+    auto ty = in[1];
+    auto tz = in[2];
+    auto tw = one;
+
+    //  SoA -> AoS: after each transpose lane N holds the row of node N
+    _MM_TRANSPOSE4_PS(r00, r01, r02, r03);
+    _MM_TRANSPOSE4_PS(r10, r11, r12, r13);
+    _MM_TRANSPOSE4_PS(r20, r21, r22, r23);
+    _MM_TRANSPOSE4_PS(tx, ty, tz, tw);
+
+    const __m128 rows[4][4] =
+    {
+        { r00, r10, r20, tx },
+        { r01, r11, r21, ty },
+        { r02, r12, r22, tz },
+        { r03, r13, r23, tw },
+    };
+    for (auto k = 0u; k < 4; ++k)
+    {
+        _mm_storeu_ps(output[k].row[0], rows[k][0]);
+        _mm_storeu_ps(output[k].row[1], rows[k][1]);
+        _mm_storeu_ps(output[k].row[2], rows[k][2]);
+        _mm_storeu_ps(output[k].row[3], rows[k][3]);
+    }
+}
+static void multiply(const render_matrix& lhs, const render_matrix& rhs, render_matrix& output) noexcept
+{
+    const auto b0 = _mm_loadu_ps(rhs.row[0]);
+    const auto b1 = _mm_loadu_ps(rhs.row[1]);
+    const auto b2 = _mm_loadu_ps(rhs.row[2]);
+    const auto b3 = _mm_loadu_ps(rhs.row[3]);
+    for (auto k = 0u; k < 4; ++k)
+    {
+        auto row = _mm_mul_ps(_mm_set1_ps(lhs.row[k][0]), b0);
+        row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(lhs.row[k][1]), b1));
+        row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(lhs.row[k][2]), b2));
+        row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(lhs.row[k][3]), b3));
+        _mm_storeu_ps(output.row[k], row);
+    }
+}
+
+ICY_STATIC_NAMESPACE_END
+
+render_matrix icy::to_matrix(const render_transform& transform) noexcept
+{
+    __m128 in[10];
+    const float values[10] =
+    {
+        transform.world.x, transform.world.y, transform.world.z,
+        transform.scale.x, transform.scale.y, transform.scale.z,
+        transform.angle.x, transform.angle.y, transform.angle.z, transform.angle.w,
+    };
+    for (auto k = 0u; k < _countof(in); ++k)
+        in[k] = _mm_set1_ps(values[k]);
+
+    render_matrix output[4];
+    compose4(in, output);
+    return output[0];
+}
+render_matrix icy::operator*(const render_matrix& lhs, const render_matrix& rhs) noexcept
+{
+    render_matrix output;
+    multiply(lhs, rhs, output);
+    return output;
+}
+
+error_type render_transform_buffer::initialize(const map<guid, render_node>& nodes) noexcept
+{
+    clear();
+
+    const auto size = uint32_t(nodes.size());
+    const auto keys = nodes.keys();
+    const auto vals = nodes.vals();
+
+    //  CSR adjacency (parent -> children) from the parent links; index "size" collects roots
+    array<uint32_t> offset;
+    array<uint32_t> child;
+    ICY_ERROR(offset.resize(size + 2));
+    ICY_ERROR(child.resize(size));
+
+    array<uint32_t> parent;
+    ICY_ERROR(parent.resize(size));
+    for (auto k = 0u; k < size; ++k)
+    {
+        const auto it = std::lower_bound(keys.begin(), keys.end(), vals[k].parent);
+        parent[k] = vals[k].parent && it != keys.end() && *it == vals[k].parent ?
+            uint32_t(std::distance(keys.begin(), it)) : size;
+        offset[parent[k] + 1] += 1;
+    }
+    for (auto k = 0u; k <= size; ++k)
+        offset[k + 1] += offset[k];
+    {
+        array<uint32_t> fill;
+        ICY_ERROR(fill.assign(offset));
+        for (auto k = 0u; k < size; ++k)
+            child[fill[parent[k]]++] = k;
+    }
+
+    ICY_ERROR(m_keys.assign(keys));
+    ICY_ERROR(m_order.resize(size));
+    ICY_ERROR(m_nodes.reserve(size));
+    ICY_ERROR(m_parent.reserve(size));
+
+    //  breadth-first: roots first, then every level in turn
+    for (auto k = offset[size]; k < offset[size + 1]; ++k)
+    {
+        m_order[child[k]] = uint32_t(m_nodes.size());
+        ICY_ERROR(m_nodes.push_back(keys[child[k]]));
+        ICY_ERROR(m_parent.push_back(invalid_index));
+    }
+    array<uint32_t> queue;
+    ICY_ERROR(queue.append(child.begin() + offset[size], child.begin() + offset[size + 1]));
+    for (auto k = 0_z; k < queue.size(); ++k)
+    {
+        const auto index = queue[k];
+        for (auto n = offset[index]; n < offset[index + 1]; ++n)
+        {
+            m_order[child[n]] = uint32_t(m_nodes.size());
+            ICY_ERROR(m_nodes.push_back(keys[child[n]]));
+            ICY_ERROR(m_parent.push_back(m_order[index]));
+            ICY_ERROR(queue.push_back(child[n]));
+        }
+    }
+    if (m_nodes.size() != size)     //  parent cycle
+    {
+        clear();
+        return make_stdlib_error(std::errc::invalid_argument);
+    }
+
+    //  lanes are padded to full SIMD blocks with identity transforms
+    const auto capacity = round_up(size_t(size), lane_block);
+    for (auto k = 0u; k < _lanes; ++k)
+        ICY_ERROR(m_lanes[k].resize(capacity));
+    for (auto k = size_t(size); k < capacity; ++k)
+    {
+        m_lanes[scale_x][k] = m_lanes[scale_y][k] = m_lanes[scale_z][k] = 1;
+        m_lanes[angle_w][k] = 1;
+    }
+    ICY_ERROR(m_dirty.resize(capacity));
+    ICY_ERROR(m_local.resize(capacity));
+    ICY_ERROR(m_world.resize(size));
+
+    for (auto k = 0u; k < size; ++k)
+        assign(m_order[k], vals[k].transform);
+
+    update();
+    return error_type();
+}
+void render_transform_buffer::clear() noexcept
+{
+    m_keys.clear();
+    m_order.clear();
+    m_nodes.clear();
+    m_parent.clear();
+    for (auto&& lane : m_lanes)
+        lane.clear();
+    m_dirty.clear();
+    m_local.clear();
+    m_world.clear();
+    m_dirty_count = 0;
+}
+uint32_t render_transform_buffer::find(const guid& node) const noexcept
+{
+    const auto it = std::lower_bound(m_keys.begin(), m_keys.end(), node);
+    if (it != m_keys.end() && *it == node)
+        return m_order[size_t(std::distance(m_keys.begin(), it))];
+    return invalid_index;
+}
+render_transform render_transform_buffer::transform(const uint32_t index) const noexcept
+{
+    render_transform output;
+    output.world = render_vec3(m_lanes[world_x][index], m_lanes[world_y][index], m_lanes[world_z][index]);
+    output.scale = render_vec3(m_lanes[scale_x][index], m_lanes[scale_y][index], m_lanes[scale_z][index]);
+    output.angle = render_vec4(m_lanes[angle_x][index], m_lanes[angle_y][index], m_lanes[angle_z][index], m_lanes[angle_w][index]);
+    return output;
+}
+void render_transform_buffer::assign(const uint32_t index, const render_transform& transform) noexcept
+{
+    ICY_ASSERT(index < m_nodes.size(), "INVALID TRANSFORM INDEX");
+    m_lanes[world_x][index] = transform.world.x;
+    m_lanes[world_y][index] = transform.world.y;
+    m_lanes[world_z][index] = transform.world.z;
+    m_lanes[scale_x][index] = transform.scale.x;
+    m_lanes[scale_y][index] = transform.scale.y;
+    m_lanes[scale_z][index] = transform.scale.z;
+    m_lanes[angle_x][index] = transform.angle.x;
+    m_lanes[angle_y][index] = transform.angle.y;
+    m_lanes[angle_z][index] = transform.angle.z;
+    m_lanes[angle_w][index] = transform.angle.w;
+    if (!m_dirty[index])
+    {
+        m_dirty[index] = 1;
+        ++m_dirty_count;
+    }
+}
+void render_transform_buffer::update() noexcept
+{
+    if (!m_dirty_count)
+        return;
+
+    //  local matrices: recompose every block that has at least one dirty lane
+    const auto capacity = m_dirty.size();
+    for (auto k = 0_z; k < capacity; k += lane_block)
+    {
+        auto any = 0u;
+        for (auto n = 0_z; n < lane_block; ++n)
+            any |= m_dirty[k + n];
+        if (!any)
+            continue;
+
+#if __AVX__
+        __m128 lo[_lanes];
+        __m128 hi[_lanes];
+        for (auto n = 0u; n < _lanes; ++n)
+        {
+            const auto lane = _mm256_loadu_ps(m_lanes[n].data() + k);
+            lo[n] = _mm256_castps256_ps128(lane);
+            hi[n] = _mm256_extractf128_ps(lane, 1);
+        }
+        compose4(lo, m_local.data() + k + 0);
+        compose4(hi, m_local.data() + k + 4);
+#else
+        __m128 in[_lanes];
+        for (auto n = 0u; n < _lanes; ++n)
+            in[n] = _mm_loadu_ps(m_lanes[n].data() + k);
+        compose4(in, m_local.data() + k);
+#endif
+    }
+
+    //  world matrices: parents always precede children, so one forward pass
+    //  propagates both the recomputed values and the dirty flags down the tree
+    const auto size = m_nodes.size();
+    for (auto k = 0_z; k < size; ++k)
+    {
+        const auto parent = m_parent[k];
+        if (parent == invalid_index)
+        {
+            if (m_dirty[k])
+                m_world[k] = m_local[k];
+            continue;
+        }
+        if (m_dirty[parent])
+            m_dirty[k] = 1;
+        if (m_dirty[k])
+            multiply(m_local[k], m_world[parent], m_world[k]);
+    }
+    memset(m_dirty.data(), 0, m_dirty.size());
+    m_dirty_count = 0;
+}
@@ -2,6 +2,9 @@
 #include "../../libs/css/libcss/include/libcss/libcss.h"
 #include "../../libs/css/libwapcaplet/include/libwapcaplet/libwapcaplet.h"
 #include <icy_engine/core/icy_color.hpp>
+#include <icy_engine/core/icy_thread.hpp>
+#include <icy_engine/core/icy_atomic.hpp>
+#include <icy_engine/core/icy_smart_pointer.hpp>
 
 using namespace icy;
 
@@ -21,7 +24,7 @@ static error_type css_error_to_string(const unsigned code, const string_view, st
 	const auto ptr = css_error_to_string(css_error(code));
 	if (!ptr)
 		return make_stdlib_error(std::errc::invalid_argument);
-	return icy::to_string(string_view(ptr, strlen(ptr)), str);
+	return icy::to_string(string_view(ptr, strlen(ptr), string_view::constexpr_tag()), str);
 }
 
 class css_handler : public css_select_handler
@@ -31,8 +34,11 @@ public:
 	{
 		lwc_context* ctx = nullptr;
 		html_document_css* doc = nullptr;
+		uint32_t task_parent = UINT32_MAX;  //  cascade task: siblings before "task_first" may be styled
+		uint32_t task_first = 0;            //  by another worker and are not style sharing candidates
 	};
 	css_handler() noexcept;
+	static error_type apply(const css_system& system, pair_type& pair, const uint32_t index) noexcept;
 };
 class css_system::data_type
 {
@@ -49,69 +55,119 @@ public:
 	css_system system;
 };
 
+static css_handler g_handler;
+
+static uint64_t css_atom_bit(const lwc_string* const atom) noexcept
+{
+	return 1ull << ((uint64_t(uintptr_t(atom)) * 0x9E3779B97F4A7C15ull) >> 58);
+}
+
+//  the caseless form is interned too: libcss compares names caselessly during selection,
+//  and interning is not safe on cascade worker threads
+static error_type css_intern_caseless(lwc_context* const ctx, lwc_string* const atom) noexcept
+{
+	lwc_hash hash = 0;
+	if (lwc_string_caseless_hash_value(ctx, atom, &hash))
+		return make_stdlib_error(std::errc::not_enough_memory);
+	return error_type();
+}
+
+static const auto css_cascade_chunk = 64u;  //  children per cascade task
+
+class css_cascade
+{
+public:
+	class thread_type;
+	struct task_type
+	{
+		uint32_t parent = 0;
+		uint32_t begin = 0;     //  range in the parent's "children"
+		uint32_t end = 0;
+	};
+public:
+	css_cascade(const css_system& system, html_document_css& doc) noexcept : m_system(system), m_doc(doc)
+	{
+
+	}
+	error_type initialize() noexcept
+	{
+		ICY_ERROR(m_lock.initialize());
+		return m_sync.initialize();
+	}
+	error_type push(const uint32_t parent) noexcept;
+	void work() noexcept;
+	error_type error() const noexcept
+	{
+		return m_error;
+	}
+private:
+	error_type run(const task_type& task, css_handler::pair_type& pair) noexcept;
+	void fail(const error_type error) noexcept;
+	//  wakes one idle worker; a woken worker wakes the next while there are tasks (or the cascade is over)
+	void notify() noexcept;
+private:
+	const css_system& m_system;
+	html_document_css& m_doc;
+	mutex m_lock;
+	sync_handle m_sync;
+	array<task_type> m_tasks;
+	uint32_t m_waiting = 0;                 //  workers blocked on "m_sync" (under "m_lock")
+	std::atomic<uint32_t> m_pending = 0;    //  tasks queued or running
+	std::atomic<bool> m_failed = false;
+	error_type m_error;
+};
+class css_cascade::thread_type : public thread
+{
+public:
+	thread_type(css_cascade& cascade) noexcept : m_cascade(cascade)
+	{
+
+	}
+	void cancel() noexcept override
+	{
+		//  nothing to interrupt: "run" returns once the tasks are exhausted
+	}
+protected:
+	error_type run() noexcept override
+	{
+		m_cascade.work();
+		return error_type();
+	}
+private:
+	css_cascade& m_cascade;
+};
+
 css_handler::css_handler() noexcept
 {
 	handler_version = CSS_SELECT_HANDLER_VERSION_1;
 	node_name = [](void* pw, void* node, css_qname* qname)
 	{
-		qname->name = nullptr;
-		qname->ns = nullptr;
-
-		const auto pair = static_cast<pair_type*>(pw);
 		const auto cnode = static_cast<const html_node_css*>(node);
-		auto error = lwc_intern_string(pair->ctx, cnode->tag().bytes().data(), cnode->tag().bytes().size(), &qname->name);
-		return error ? CSS_NOMEM : CSS_OK;
+		qname->name = lwc_string_ref(cnode->m_tag_atom);
+		qname->ns = nullptr;
+		return CSS_OK;
 	};
 	node_classes = [](void* pw, void* node, lwc_string*** classes, uint32_t* n_classes)
 	{
+		//  libcss unrefs the strings but does not free the array: hand out the document's atoms
 		*classes = nullptr;
 		*n_classes = 0;
 
 		const auto pair = static_cast<pair_type*>(pw);
 		const auto cnode = static_cast<const html_node_css*>(node);
-		const auto str = cnode->find("class"_s);
-
-		array<string_view> vec(pair->ctx->realloc, pair->ctx->user);
-		if (split(str, vec))
-			return CSS_NOMEM;
-
-		if (vec.empty())
-			return CSS_OK;
-
-		*n_classes = uint32_t(vec.size());
-		*classes = static_cast<lwc_string**>(pair->ctx->realloc(nullptr,
-			sizeof(lwc_string*) * vec.size(), pair->ctx->user));
-		memset(*classes, 0, sizeof(lwc_string*) * vec.size());
-		auto k = 0u;
-		for (; k < vec.size(); ++k)
+		if (cnode->m_class_count)
 		{
-			auto& addr = (*classes)[k];
-			if (lwc_intern_string(pair->ctx, vec[k].bytes().data(), vec[k].bytes().size(), &addr))
-				break;
-		}
-		if (k != vec.size())
-		{
-			for (*n_classes = k; *n_classes; --(*n_classes))
-				lwc_string_unref(pair->ctx, (*classes)[k]);
-
-			pair->ctx->realloc(*classes, 0, pair->ctx->user);
-			*classes = nullptr;
-			return CSS_NOMEM;
+			*classes = pair->doc->m_atoms.data() + cnode->m_class_offset;
+			*n_classes = cnode->m_class_count;
+			for (auto k = 0u; k < cnode->m_class_count; ++k)
+				lwc_string_ref((*classes)[k]);
 		}
 		return CSS_OK;
 	};
 	node_id = [](void* pw, void* node, lwc_string** id)
 	{
-		*id = nullptr;
-		const auto pair = static_cast<pair_type*>(pw);
 		const auto cnode = static_cast<const html_node_css*>(node);
-
-		const auto str = cnode->find("id"_s);
-		if (!str.empty())
-		{
-			if (lwc_intern_string(pair->ctx, str.bytes().data(), str.bytes().size(), id))
-				return CSS_NOMEM;
-		}
+		*id = cnode->m_id_atom ? lwc_string_ref(cnode->m_id_atom) : nullptr;
 		return CSS_OK;
 	};
 	named_ancestor_node = [](void* pw, void* node, const css_qname* qname, void** ancestor)
@@ -119,19 +175,17 @@ css_handler::css_handler() noexcept
 		*ancestor = nullptr;
 		const auto pair = static_cast<pair_type*>(pw);
 		auto cnode = static_cast<const html_node_css*>(node);
-		const auto name = string_view(lwc_string_data(qname->name), strlen(lwc_string_data(qname->name)));
 
 		while (cnode->index())
 		{
 			const auto pnode = pair->doc->node(cnode->parent());
-			if (pnode->tag() == name)
+			if (pnode->m_tag_atom == qname->name)
 			{
 				*ancestor = pnode;
 				break;
 			}
 			cnode = pnode;
 		}
-
 		return CSS_OK;
 	};
 	named_parent_node = [](void* pw, void* node, const css_qname* qname, void** parent)
@@ -139,63 +193,44 @@ css_handler::css_handler() noexcept
 		*parent = nullptr;
 		const auto pair = static_cast<pair_type*>(pw);
 		const auto cnode = static_cast<const html_node_css*>(node);
-		const auto name = string_view(lwc_string_data(qname->name), strlen(lwc_string_data(qname->name)));
 
 		if (cnode->index())
 		{
 			const auto pnode = pair->doc->node(cnode->parent());
-			if (pnode->tag() == name)
+			if (pnode->m_tag_atom == qname->name)
 				*parent = pnode;
 		}
 		return CSS_OK;
 	};
 	named_sibling_node = [](void* pw, void* node, const css_qname* qname, void** sibling)
 	{
+		//  "E + F": the element right before "node"
 		*sibling = nullptr;
 		const auto pair = static_cast<pair_type*>(pw);
 		const auto cnode = static_cast<const html_node_css*>(node);
-		const auto name = string_view(lwc_string_data(qname->name), strlen(lwc_string_data(qname->name)));
 
-		if (cnode->index())
+		if (cnode->m_prev)
 		{
-			const auto pnode = pair->doc->node(cnode->parent());
-			const auto children = pnode->children();
-			const auto it = std::find(children.begin(), children.end(), cnode->index());
-			ICY_ASSERT(it != children.end(), "CORRUPTED DOM TREE");
-			html_node_css* next = nullptr;
-			if (it + 1 != children.end())
-				next = pair->doc->node(*(it + 1));
-			if (next && next->tag() == name)
-			{
-				*sibling = next;
-				return CSS_OK;
-			}
+			const auto snode = pair->doc->node(cnode->m_prev);
+			if (snode->m_tag_atom == qname->name)
+				*sibling = snode;
 		}
 		return CSS_OK;
 	};
 	named_generic_sibling_node = [](void* pw, void* node, const css_qname* qname, void** sibling)
 	{
+		//  "E ~ F" (and the style sharing candidate): any element before "node"
 		*sibling = nullptr;
 		const auto pair = static_cast<pair_type*>(pw);
-		const auto cnode = static_cast<const html_node_css*>(node);
-		const auto name = string_view(lwc_string_data(qname->name), strlen(lwc_string_data(qname->name)));
+		auto cnode = static_cast<const html_node_css*>(node);
 
-		if (cnode->index())
+		while (cnode->m_prev)
 		{
-			const auto pnode = pair->doc->node(cnode->parent());
-			const auto children = pnode->children();
-			auto it = std::find(children.begin(), children.end(), cnode->index());
-			ICY_ASSERT(it != children.end(), "CORRUPTED DOM TREE");
-			++it;
-			while (it != children.end())
+			cnode = pair->doc->node(cnode->m_prev);
+			if (cnode->m_tag_atom == qname->name)
 			{
-				const auto snode = pair->doc->node(*it);
-				if (snode->tag() == name)
-				{
-					*sibling = snode;
-					break;
-				}
-				++it;
+				*sibling = const_cast<html_node_css*>(cnode);
+				break;
 			}
 		}
 		return CSS_OK;
@@ -215,26 +250,15 @@ css_handler::css_handler() noexcept
 		*sibling = nullptr;
 		const auto pair = static_cast<pair_type*>(pw);
 		const auto cnode = static_cast<const html_node_css*>(node);
-		if (cnode->index())
-		{
-			const auto pnode = pair->doc->node(cnode->parent());
-			const auto children = pnode->children();
-			auto it = std::find(children.begin(), children.end(), cnode->index());
-			ICY_ASSERT(it != children.end(), "CORRUPTED DOM TREE");
-			++it;
-			if (it != children.end())
-				*sibling = pair->doc->node(*it);
-		}
+		if (cnode->m_prev)
+			*sibling = pair->doc->node(cnode->m_prev);
+
 		return CSS_OK;
 	};
 	node_has_name = [](void* pw, void* node, const css_qname* qname, bool* match)
 	{
-		*match = false;
-		const auto pair = static_cast<pair_type*>(pw);
 		const auto cnode = static_cast<const html_node_css*>(node);
-		const auto name = string_view(lwc_string_data(qname->name), strlen(lwc_string_data(qname->name)));
-		if (cnode->tag() == name)
-			*match = true;
+		*match = cnode->m_tag_atom == qname->name;
 		return CSS_OK;
 	};
 	node_has_class = [](void* pw, void* node, lwc_string* name, bool* match)
@@ -242,30 +266,24 @@ css_handler::css_handler() noexcept
 		*match = false;
 		const auto pair = static_cast<pair_type*>(pw);
 		const auto cnode = static_cast<const html_node_css*>(node);
-		const auto sname = string_view(lwc_string_data(name), strlen(lwc_string_data(name)));
-
-		const auto str = cnode->find("class"_s);
-		array<string_view> vec(pair->ctx->realloc, pair->ctx->user);
-		if (split(str, vec))
-			return CSS_NOMEM;
-
-		const auto it = std::find(vec.begin(), vec.end(), sname);
-		if (it != vec.end())
-			*match = true;
+		if (!(cnode->m_class_mask & css_atom_bit(name)))
+			return CSS_OK;
 
+		const auto classes = pair->doc->m_atoms.data() + cnode->m_class_offset;
+		for (auto k = 0u; k < cnode->m_class_count; ++k)
+		{
+			if (classes[k] == name)
+			{
+				*match = true;
+				break;
+			}
+		}
 		return CSS_OK;
 	};
 	node_has_id = [](void* pw, void* node, lwc_string* name, bool* match)
 	{
-		*match = false;
-		const auto pair = static_cast<pair_type*>(pw);
 		const auto cnode = static_cast<const html_node_css*>(node);
-		const auto sname = string_view(lwc_string_data(name), strlen(lwc_string_data(name)));
-
-		const auto id = cnode->find("id"_s);
-		if (id == sname)
-			*match = true;
-
+		*match = cnode->m_id_atom == name;
 		return CSS_OK;
 	};
 	node_has_attribute = [](void* pw, void* node, const css_qname* qname, bool* match)
@@ -273,7 +291,7 @@ css_handler::css_handler() noexcept
 		*match = false;
 		const auto pair = static_cast<pair_type*>(pw);
 		const auto cnode = static_cast<const html_node_css*>(node);
-		const auto name = string_view(lwc_string_data(qname->name), strlen(lwc_string_data(qname->name)));
+		const auto name = string_view(lwc_string_data(qname->name), strlen(lwc_string_data(qname->name)), string_view::constexpr_tag());
 
 		if (!cnode->find(name).empty())
 			*match = true;
@@ -285,8 +303,8 @@ css_handler::css_handler() noexcept
 		*match = false;
 		const auto pair = static_cast<pair_type*>(pw);
 		const auto cnode = static_cast<const html_node_css*>(node);
-		const auto name = string_view(lwc_string_data(qname->name), strlen(lwc_string_data(qname->name)));
-		const auto svalue = string_view(lwc_string_data(value), strlen(lwc_string_data(value)));
+		const auto name = string_view(lwc_string_data(qname->name), strlen(lwc_string_data(qname->name)), string_view::constexpr_tag());
+		const auto svalue = string_view(lwc_string_data(value), strlen(lwc_string_data(value)), string_view::constexpr_tag());
 
 		const auto str = cnode->find(name);
 		if (str == svalue)
@@ -302,19 +320,30 @@ css_handler::css_handler() noexcept
 	node_has_attribute_includes = [](void* pw, void* node, const css_qname* qname, lwc_string* value, bool* match)
 	{
 		*match = false;
-		const auto pair = static_cast<pair_type*>(pw);
 		const auto cnode = static_cast<const html_node_css*>(node);
-		const auto name = string_view(lwc_string_data(qname->name), strlen(lwc_string_data(qname->name)));
-		const auto svalue = string_view(lwc_string_data(value), strlen(lwc_string_data(value)));
-
-		const auto str = cnode->find(name);
-		array<string_view> vec(pair->ctx->realloc, pair->ctx->user);
-		if (split(str, vec))
-			return CSS_NOMEM;
-
-		if (std::find(vec.begin(), vec.end(), svalue) != vec.end())
-			*match = true;
+		const auto name = string_view(lwc_string_data(qname->name), strlen(lwc_string_data(qname->name)), string_view::constexpr_tag());
+		const auto svalue = string_view(lwc_string_data(value), strlen(lwc_string_data(value)), string_view::constexpr_tag());
+		if (svalue.empty())
+			return CSS_OK;
 
+		//  whitespace-separated word match in place (no "split" into a temporary array)
+		const auto str = cnode->find(name).bytes();
+		const auto word = svalue.bytes();
+		auto ptr = str.data();
+		const auto end = ptr + str.size();
+		while (ptr != end)
+		{
+			while (ptr != end && isspace(uint8_t(*ptr)))
+				++ptr;
+			const auto beg = ptr;
+			while (ptr != end && !isspace(uint8_t(*ptr)))
+				++ptr;
+			if (size_t(ptr - beg) == word.size() && memcmp(beg, word.data(), word.size()) == 0)
+			{
+				*match = true;
+				break;
+			}
+		}
 		return CSS_OK;
 	};
 	node_has_attribute_prefix = [](void* pw, void* node, const css_qname* qname, lwc_string* value, bool* match)
@@ -322,8 +351,8 @@ css_handler::css_handler() noexcept
 		*match = false;
 		const auto pair = static_cast<pair_type*>(pw);
 		const auto cnode = static_cast<const html_node_css*>(node);
-		const auto name = string_view(lwc_string_data(qname->name), strlen(lwc_string_data(qname->name)));
-		const auto svalue = string_view(lwc_string_data(value), strlen(lwc_string_data(value)));
+		const auto name = string_view(lwc_string_data(qname->name), strlen(lwc_string_data(qname->name)), string_view::constexpr_tag());
+		const auto svalue = string_view(lwc_string_data(value), strlen(lwc_string_data(value)), string_view::constexpr_tag());
 
 		const auto str = cnode->find(name);
 		if (str.bytes().size() >= svalue.bytes().size())
@@ -338,8 +367,8 @@ css_handler::css_handler() noexcept
 		*match = false;
 		const auto pair = static_cast<pair_type*>(pw);
 		const auto cnode = static_cast<const html_node_css*>(node);
-		const auto name = string_view(lwc_string_data(qname->name), strlen(lwc_string_data(qname->name)));
-		const auto svalue = string_view(lwc_string_data(value), strlen(lwc_string_data(value)));
+		const auto name = string_view(lwc_string_data(qname->name), strlen(lwc_string_data(qname->name)), string_view::constexpr_tag());
+		const auto svalue = string_view(lwc_string_data(value), strlen(lwc_string_data(value)), string_view::constexpr_tag());
 
 		const auto str = cnode->find(name);
 		if (str.bytes().size() >= svalue.bytes().size())
@@ -355,8 +384,8 @@ css_handler::css_handler() noexcept
 		*match = false;
 		const auto pair = static_cast<pair_type*>(pw);
 		const auto cnode = static_cast<const html_node_css*>(node);
-		const auto name = string_view(lwc_string_data(qname->name), strlen(lwc_string_data(qname->name)));
-		const auto svalue = string_view(lwc_string_data(value), strlen(lwc_string_data(value)));
+		const auto name = string_view(lwc_string_data(qname->name), strlen(lwc_string_data(qname->name)), string_view::constexpr_tag());
+		const auto svalue = string_view(lwc_string_data(value), strlen(lwc_string_data(value)), string_view::constexpr_tag());
 
 		const auto str = cnode->find(name);
 		if (str.find(svalue) != str.end())
@@ -376,48 +405,11 @@ css_handler::css_handler() noexcept
 	};
 	node_count_siblings = [](void* pw, void* node, bool same_name, bool after, int32_t* count)
 	{
-		*count = 0;
-		const auto pair = static_cast<pair_type*>(pw);
 		const auto cnode = static_cast<const html_node_css*>(node);
-		if (cnode->index())
-		{
-			const auto pnode = pair->doc->node(cnode->parent());
-			const auto children = pnode->children();
-			auto it = std::find(children.begin(), children.end(), cnode->index());
-			ICY_ASSERT(it != children.end(), "CORRUPTED DOM TREE");
-			if (same_name)
-			{
-				if (after)
-				{
-					++it;
-					while (it != children.end())
-					{
-						const auto snode = pair->doc->node(*it);
-						if (snode->tag() == cnode->tag())
-							(*count)++;
-						++it;
-					}
-				}
-				else if (it != children.begin())
-				{
-					--it;
-					while (it != children.begin())
-					{
-						const auto snode = pair->doc->node(*it);
-						if (snode->tag() == cnode->tag())
-							(*count)++;
-						--it;
-					}
-				}
-			}
-			else
-			{
-				if (after)
-					*count = uint32_t(std::distance(it + 1, children.end()));
-				else
-					*count = uint32_t(std::distance(children.begin(), it));
-			}
-		}
+		if (same_name)
+			*count = int32_t(after ? cnode->m_after_tag : cnode->m_before_tag);
+		else
+			*count = int32_t(after ? cnode->m_after : cnode->m_before);
 		return CSS_OK;
 	};
 	node_is_empty = [](void* pw, void* node, bool* match)
@@ -515,7 +507,7 @@ css_handler::css_handler() noexcept
 		*match = false;
 		const auto pair = static_cast<pair_type*>(pw);
 		const auto cnode = static_cast<const html_node_css*>(node);
-		const auto slang = string_view(lwc_string_data(lang), strlen(lwc_string_data(lang)));
+		const auto slang = string_view(lwc_string_data(lang), strlen(lwc_string_data(lang)), string_view::constexpr_tag());
 		const auto vlang = cnode->find("lang"_s);
 		if (vlang == slang)
 			*match = true;
@@ -567,11 +559,26 @@ css_handler::css_handler() noexcept
 	};
 	set_libcss_node_data = [](void* pw, void* node, void* libcss_node_data)
 	{
+		//  keeping the node data lets libcss use the parent's bloom filter and share sibling styles;
+		//  "css_libcss_node_data_handler" is only ever called with CSS_NODE_DELETED (from "release")
+		const auto pair = static_cast<pair_type*>(pw);
+		const auto cnode = static_cast<html_node_css*>(node);
+		if (cnode->m_select != libcss_node_data)
+		{
+			cnode->release();
+			cnode->m_system = pair->doc->m_system;
+			cnode->m_select = libcss_node_data;
+		}
 		return CSS_OK;
 	};
 	get_libcss_node_data = [](void* pw, void* node, void** libcss_node_data)
 	{
-		*libcss_node_data = nullptr;
+		const auto pair = static_cast<pair_type*>(pw);
+		const auto cnode = static_cast<const html_node_css*>(node);
+		if (cnode->index() && cnode->parent() == pair->task_parent && cnode->index() < pair->task_first)
+			*libcss_node_data = nullptr;
+		else
+			*libcss_node_data = cnode->m_select;
 		return CSS_OK;
 	};
 }
@@ -679,16 +686,157 @@ error_type css_system::erase(const css_style& style) noexcept
 
 	return error_type();
 }
+error_type css_system::prepare(html_document_css& doc) const noexcept
+{
+	if (!data)
+		return make_stdlib_error(std::errc::invalid_argument);
+
+	const auto ctx = data->ctx;
+	doc.release();
+	if (doc.m_system.data != data)
+	{
+		//  blooms and shared styles belong to the old selection context
+		for (auto&& node : doc.m_data)
+			node.release();
+		doc.m_system = *this;
+	}
+
+	array<string_view> words(ctx->realloc, ctx->user);
+	for (auto&& node : doc.m_data)
+	{
+		const auto tag = node.tag().bytes();
+		if (lwc_intern_string(ctx, tag.data(), tag.size(), &node.m_tag_atom))
+			return make_stdlib_error(std::errc::not_enough_memory);
+		ICY_ERROR(css_intern_caseless(ctx, node.m_tag_atom));
+
+		const auto id = node.find("id"_s).bytes();
+		if (!id.empty())
+		{
+			if (lwc_intern_string(ctx, id.data(), id.size(), &node.m_id_atom))
+				return make_stdlib_error(std::errc::not_enough_memory);
+			ICY_ERROR(css_intern_caseless(ctx, node.m_id_atom));
+		}
+
+		ICY_ERROR(split(node.find("class"_s), words));
+		ICY_ERROR(doc.m_atoms.reserve(doc.m_atoms.size() + words.size()));
+		node.m_class_offset = uint32_t(doc.m_atoms.size());
+		for (auto&& word : words)
+		{
+			lwc_string* atom = nullptr;
+			if (lwc_intern_string(ctx, word.bytes().data(), word.bytes().size(), &atom))
+				return make_stdlib_error(std::errc::not_enough_memory);
+			ICY_ERROR(doc.m_atoms.push_back(atom));
+			node.m_class_mask |= css_atom_bit(atom);
+			++node.m_class_count;
+			ICY_ERROR(css_intern_caseless(ctx, atom));
+		}
+	}
+
+	//  element sibling positions; "tags" counts the same tag among the elements seen so far
+	map<lwc_string*, uint32_t> tags(ctx->realloc, ctx->user);
+	for (auto&& node : doc.m_data)
+	{
+		const auto children = node.children();
+		tags.clear();
+		auto prev = 0u;
+		auto count = 0u;
+		for (auto&& index : children)
+		{
+			auto& child = doc.m_data[index];
+			if (child.type() != html_type::node)
+				continue;
+
+			auto it = tags.find(child.m_tag_atom);
+			if (it == tags.end())
+				ICY_ERROR(tags.insert(child.m_tag_atom, 0u, &it));
+			child.m_prev = prev;
+			child.m_before = count++;
+			child.m_before_tag = it->value++;
+			prev = index;
+		}
+		for (auto&& index : children)
+		{
+			auto& child = doc.m_data[index];
+			if (child.type() != html_type::node)
+				continue;
+			child.m_after = count - 1 - child.m_before;
+			child.m_after_tag = *tags.try_find(child.m_tag_atom) - 1 - child.m_before_tag;
+		}
+	}
+	doc.m_prepared = doc.m_data.size();
+	return error_type();
+}
 error_type css_system::apply(html_document_css& doc, const uint32_t index) const noexcept
 {
-	auto node = doc.node(index);
-	if (!data || !node)
+	if (!data || index >= doc.size())
 		return make_stdlib_error(std::errc::invalid_argument);
 
+	if (doc.m_system.data != data || doc.m_prepared != doc.size())
+		ICY_ERROR(prepare(doc));
+
+	css_handler::pair_type pair;
+	pair.ctx = data->ctx;
+	pair.doc = &doc;
+	return css_handler::apply(*this, pair, index);
+}
+error_type css_system::cascade(html_document_css& doc, const size_t threads) const noexcept
+{
+	if (!data || !doc.size())
+		return make_stdlib_error(std::errc::invalid_argument);
+
+	if (doc.m_system.data != data || doc.m_prepared != doc.size())
+		ICY_ERROR(prepare(doc));
+
+	css_handler::pair_type pair;
+	pair.ctx = data->ctx;
+	pair.doc = &doc;
+	ICY_ERROR(css_handler::apply(*this, pair, 0));
+
+	css_cascade cascade(*this, doc);
+	ICY_ERROR(cascade.initialize());
+	ICY_ERROR(cascade.push(0));
+
+	const auto count = threads ? threads : std::max(thread::cores(), 1_z);
+	array<shared_ptr<css_cascade::thread_type>> workers;
+	ICY_ERROR(workers.reserve(count - 1));
+	for (auto k = 1_z; k < count; ++k)
+	{
+		shared_ptr<css_cascade::thread_type> new_thread;
+		ICY_ERROR(make_shared(new_thread, cascade));
+		ICY_ERROR(workers.push_back(std::move(new_thread)));
+	}
+
+	auto launched = 0_z;
+	for (; launched < workers.size(); ++launched)
+	{
+		//  fewer workers only make the cascade slower
+		if (workers[launched]->launch())
+			break;
+	}
+	cascade.work();
+
+	error_type error;
+	for (auto k = 0_z; k < launched; ++k)
+	{
+		if (const auto wait_error = workers[k]->wait())
+		{
+			if (!error)
+				error = wait_error;
+		}
+	}
+	if (const auto cascade_error = cascade.error())
+		return cascade_error;
+	return error;
+}
+
+error_type css_handler::apply(const css_system& system, pair_type& pair, const uint32_t index) noexcept
+{
+	const auto data = system.data;
+	const auto node = pair.doc->node(index);
 	const html_node_css* pnode = nullptr;
 	if (index)
 	{
-		pnode = doc.node(node->parent());
+		pnode = pair.doc->node(node->parent());
 		if (!pnode->m_style)
 			return make_stdlib_error(std::errc::invalid_argument);			
 	}
@@ -696,34 +844,162 @@ error_type css_system::apply(html_document_css& doc, const uint32_t index) const
 	css_media media = {};
 	media.type = css_media_type::CSS_MEDIA_SCREEN;
 
-	css_handler handler;
-	css_handler::pair_type pair;
-	pair.ctx = data->ctx;
-	pair.doc = &doc;
-
 	css_select_results* results = nullptr;
-	if (const auto error = css_select_style(data->select, node, &media, nullptr, &handler, &pair, &results))
+	if (const auto error = css_select_style(data->select, node, &media, nullptr, &g_handler, &pair, &results))
 		return make_css_error(error);
-	ICY_SCOPE_EXIT{ css_select_results_destroy(data->ctx, results); };
+	ICY_SCOPE_EXIT{ css_select_results_destroy(results); };
 
 	css_computed_style* style = nullptr;
 	if (const auto error = css_computed_style_compose(data->ctx, pnode ? pnode->m_style : nullptr,
-		results->styles[CSS_PSEUDO_ELEMENT_NONE], handler.compute_font_size, &pair, &style))
+		results->styles[CSS_PSEUDO_ELEMENT_NONE], g_handler.compute_font_size, &pair, &style))
 		return make_css_error(error);
 
 	if (node->m_style)
 		css_computed_style_destroy(node->m_style);
 
-	node->m_system = *this;
+	node->m_system = system;
 	node->m_style = style;
 	return error_type();
 }
 
+error_type css_cascade::push(const uint32_t parent) noexcept
+{
+	const auto size = uint32_t(m_doc.node(parent)->children().size());
+	{
+		ICY_LOCK_GUARD(m_lock);
+		for (auto begin = 0u; begin < size; begin += css_cascade_chunk)
+		{
+			task_type task;
+			task.parent = parent;
+			task.begin = begin;
+			task.end = std::min(begin + css_cascade_chunk, size);
+			ICY_ERROR(m_tasks.push_back(task));
+			m_pending.fetch_add(1, std::memory_order_acq_rel);
+		}
+	}
+	notify();
+	return error_type();
+}
+void css_cascade::fail(const error_type error) noexcept
+{
+	{
+		ICY_LOCK_GUARD(m_lock);
+		if (!m_error)
+			m_error = error;
+		m_failed.store(true, std::memory_order_release);
+	}
+	notify();
+}
+void css_cascade::notify() noexcept
+{
+	{
+		ICY_LOCK_GUARD(m_lock);
+		if (!m_waiting)
+			return;
+	}
+	//  the event stays set until a worker takes it, so a wake before "wait" is not lost
+	if (const auto error = m_sync.wake())
+	{
+		ICY_LOCK_GUARD(m_lock);
+		if (!m_error)
+			m_error = error;
+		m_failed.store(true, std::memory_order_release);
+	}
+}
+void css_cascade::work() noexcept
+{
+	css_handler::pair_type pair;
+	pair.ctx = m_system.data->ctx;
+	pair.doc = &m_doc;
+	while (true)
+	{
+		task_type task;
+		auto found = false;
+		auto done = false;
+		auto more = false;
+		{
+			ICY_LOCK_GUARD(m_lock);
+			if (m_failed.load(std::memory_order_acquire) || !m_pending.load(std::memory_order_acquire))
+			{
+				done = true;
+			}
+			else if (!m_tasks.empty())
+			{
+				task = m_tasks.back();
+				m_tasks.pop_back();
+				found = true;
+				more = !m_tasks.empty();
+			}
+			else
+			{
+				//  the remaining tasks wait for parents that other workers are styling
+				++m_waiting;
+			}
+		}
+		if (done || more)
+			notify();
+		if (done)
+			break;
+
+		if (!found)
+		{
+			const auto error = m_sync.wait();
+			{
+				ICY_LOCK_GUARD(m_lock);
+				--m_waiting;
+			}
+			if (error)
+				fail(error);
+			continue;
+		}
+		if (const auto error = run(task, pair))
+			fail(error);
+		if (m_pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			notify();
+	}
+}
+error_type css_cascade::run(const task_type& task, css_handler::pair_type& pair) noexcept
+{
+	//  siblings in one task are styled in document order, so earlier ones can be shared
+	const auto children = m_doc.node(task.parent)->children();
+	pair.task_parent = task.parent;
+	pair.task_first = UINT32_MAX;
+	for (auto k = task.begin; k < task.end; ++k)
+	{
+		const auto index = children[k];
+		const auto node = m_doc.node(index);
+		if (node->type() != html_type::node)
+			continue;
+
+		pair.task_first = std::min(pair.task_first, index);
+		ICY_ERROR(css_handler::apply(m_system, pair, index));
+		for (auto&& child : node->children())
+		{
+			if (m_doc.node(child)->type() == html_type::node)
+			{
+				ICY_ERROR(push(index));
+				break;
+			}
+		}
+	}
+	return error_type();
+}
+
 html_node_css::~html_node_css() noexcept
 {
+	release();
 	if (m_style)
 		css_computed_style_destroy(m_style);
 }
+void html_node_css::release() noexcept
+{
+	if (m_select && m_system.data)
+	{
+		css_libcss_node_data_handler(m_system.data->ctx, &g_handler,
+			CSS_NODE_DELETED, nullptr, this, nullptr, m_select);
+	}
+	m_select = nullptr;
+}
 color html_node_css::color() const noexcept
 {
 	css_color clr = 0;
@@ -733,6 +1009,32 @@ color html_node_css::color() const noexcept
 	return icy::color();
 }
 
+html_document_css::~html_document_css() noexcept
+{
+	release();
+}
+void html_document_css::release() noexcept
+{
+	if (m_system.data)
+	{
+		const auto ctx = m_system.data->ctx;
+		for (auto&& node : m_data)
+		{
+			if (node.m_tag_atom) lwc_string_unref(ctx, node.m_tag_atom);
+			if (node.m_id_atom) lwc_string_unref(ctx, node.m_id_atom);
+			node.m_tag_atom = nullptr;
+			node.m_id_atom = nullptr;
+			node.m_class_mask = 0;
+			node.m_class_offset = 0;
+			node.m_class_count = 0;
+		}
+		for (auto&& atom : m_atoms)
+			lwc_string_unref(ctx, atom);
+	}
+	m_atoms.clear();
+	m_prepared = 0;
+}
+
 error_type icy::create_css_system(heap* const heap, css_system& system) noexcept
 {
 	auto realloc = heap ? heap_realloc : global_realloc;
@@ -1,5 +1,9 @@
 #include <icy_engine/html/icy_html.hpp>
+#include <icy_engine/core/icy_array.hpp>
 #include "../../libs/gumbo/gumbo.h"
+#include "../../libs/gumbo/parser.h"
+#include "../../libs/gumbo/tokenizer.h"
+#include "../../libs/gumbo/error.h"
 
 #if _DEBUG
 #pragma comment(lib, "gumbod")
@@ -9,51 +13,294 @@
 
 using namespace icy;
 
+static const auto html_arena_chunk = 64_z * 1024;
+static const auto html_arena_chunk_max = 1024_z * 1024;
+
+struct html_arena::chunk_type
+{
+    chunk_type* prev = nullptr;
+    size_t size = 0;
+    size_t offset = 0;
+};
+
+static string_view html_tag_name(const GumboTag tag) noexcept
+{
+    const auto ptr = gumbo_normalized_tagname(tag);
+    return ptr ? string_view(ptr, strlen(ptr), string_view::constexpr_tag()) : string_view();
+}
+static bool html_tag_void(const GumboTag tag) noexcept
+{
+    switch (tag)
+    {
+    case GUMBO_TAG_AREA:
+    case GUMBO_TAG_BASE:
+    case GUMBO_TAG_BR:
+    case GUMBO_TAG_COL:
+    case GUMBO_TAG_EMBED:
+    case GUMBO_TAG_HR:
+    case GUMBO_TAG_IMG:
+    case GUMBO_TAG_INPUT:
+    case GUMBO_TAG_KEYGEN:
+    case GUMBO_TAG_LINK:
+    case GUMBO_TAG_META:
+    case GUMBO_TAG_PARAM:
+    case GUMBO_TAG_SOURCE:
+    case GUMBO_TAG_TRACK:
+    case GUMBO_TAG_WBR:
+        return true;
+    }
+    return false;
+}
+static size_t html_utf8(const int chr, char (&buffer)[4]) noexcept
+{
+    const auto value = uint32_t(chr);
+    if (value < 0x80)
+    {
+        buffer[0] = char(value);
+        return 1;
+    }
+    else if (value < 0x800)
+    {
+        buffer[0] = char(0xc0 | (value >> 6));
+        buffer[1] = char(0x80 | (value & 0x3f));
+        return 2;
+    }
+    else if (value < 0x10000)
+    {
+        buffer[0] = char(0xe0 | (value >> 12));
+        buffer[1] = char(0x80 | ((value >> 6) & 0x3f));
+        buffer[2] = char(0x80 | (value & 0x3f));
+        return 3;
+    }
+    buffer[0] = char(0xf0 | ((value >> 18) & 0x07));
+    buffer[1] = char(0x80 | ((value >> 12) & 0x3f));
+    buffer[2] = char(0x80 | ((value >> 6) & 0x3f));
+    buffer[3] = char(0x80 | (value & 0x3f));
+    return 4;
+}
+//  pools only grow in the streaming path: the old block stays in the arena until the document goes away
+template<typename T>
+static error_type html_pool_reserve(html_arena& arena, T*& data, size_t& capacity, const size_t size, const size_t count) noexcept
+{
+    if (size + count <= capacity)
+        return error_type();
+    if (size + count > UINT32_MAX)
+        return make_stdlib_error(std::errc::value_too_large);
+
+    const auto new_capacity = std::min(std::max(capacity * 2, size + count), size_t(UINT32_MAX));
+    const auto new_data = static_cast<T*>(arena.allocate(new_capacity * sizeof(T), alignof(T)));
+    if (!new_data)
+        return make_stdlib_error(std::errc::not_enough_memory);
+    if (size)
+        memcpy(new_data, data, size * sizeof(T));
+    data = new_data;
+    capacity = new_capacity;
+    return error_type();
+}
+
+void* html_arena::allocate(const size_t size, const size_t align) noexcept
+{
+    if (m_chunk)
+    {
+        const auto base = reinterpret_cast<uintptr_t>(m_chunk + 1);
+        const auto offset = ((base + m_chunk->offset + align - 1) & ~uintptr_t(align - 1)) - base;
+        if (offset + size <= m_chunk->size)
+        {
+            m_chunk->offset = offset + size;
+            return reinterpret_cast<void*>(base + offset);
+        }
+    }
+    //  large blocks get a chunk of their own behind the current one, so its tail is not lost
+    const auto large = size + align > html_arena_chunk / 2;
+    auto capacity = size + align;
+    if (!large)
+        capacity = m_chunk ? std::min(m_chunk->size * 2, html_arena_chunk_max) : html_arena_chunk;
+
+    const auto bytes = sizeof(chunk_type) + capacity;
+    const auto ptr = m_heap ? m_heap->realloc(nullptr, bytes) : icy::realloc(nullptr, bytes);
+    if (!ptr)
+        return nullptr;
+
+    const auto chunk = new (ptr) chunk_type;
+    chunk->size = capacity;
+    m_bytes += bytes;
+    if (large && m_chunk)
+    {
+        chunk->prev = m_chunk->prev;
+        m_chunk->prev = chunk;
+        const auto base = reinterpret_cast<uintptr_t>(chunk + 1);
+        const auto offset = ((base + align - 1) & ~uintptr_t(align - 1)) - base;
+        chunk->offset = offset + size;
+        return reinterpret_cast<void*>(base + offset);
+    }
+    chunk->prev = m_chunk;
+    m_chunk = chunk;
+    return allocate(size, align);
+}
+void html_arena::clear() noexcept
+{
+    while (m_chunk)
+    {
+        const auto prev = m_chunk->prev;
+        m_heap ? m_heap->realloc(m_chunk, 0) : icy::realloc(m_chunk, 0);
+        m_chunk = prev;
+    }
+    m_bytes = 0;
+}
+
 string_view icy::html_tag_normalize(const string_view tag) noexcept
 {
     const auto tagn = gumbo_tagn_enum(tag.bytes().data(), uint32_t(tag.bytes().size()));
     if (tagn < GumboTag::GUMBO_TAG_UNKNOWN)
+        return html_tag_name(tagn);
+    return string_view();
+}
+
+error_type html_document_base::reserve_pools(const size_t strings, const size_t attributes) noexcept
+{
+    ICY_ERROR(html_pool_reserve(m_arena, m_strings, m_strings_capacity, m_strings_size, strings));
+    ICY_ERROR(html_pool_reserve(m_arena, m_attributes, m_attributes_capacity, m_attributes_size, attributes));
+    return error_type();
+}
+error_type html_document_base::append(const char* const ptr, const size_t size) noexcept
+{
+    ICY_ERROR(html_pool_reserve(m_arena, m_strings, m_strings_capacity, m_strings_size, size));
+    memcpy(m_strings + m_strings_size, ptr, size);
+    m_strings_size += size;
+    return error_type();
+}
+error_type html_document_base::append(html_node& node, const string_view key, const string_view val) noexcept
+{
+    ICY_ERROR(html_pool_reserve(m_arena, m_attributes, m_attributes_capacity, m_attributes_size, 1));
+
+    html_attribute attribute;
+    attribute.key = uint32_t(m_strings_size);
+    attribute.key_size = uint32_t(key.bytes().size());
+    ICY_ERROR(append(key.bytes().data(), key.bytes().size()));
+    attribute.val = uint32_t(m_strings_size);
+    attribute.val_size = uint32_t(val.bytes().size());
+    ICY_ERROR(append(val.bytes().data(), val.bytes().size()));
+
+    ICY_ASSERT(!node.m_attributes_count || node.m_attributes + node.m_attributes_count == m_attributes_size, "INVALID ATTRIBUTE ORDER");
+    if (!node.m_attributes_count)
+        node.m_attributes = uint32_t(m_attributes_size);
+    m_attributes[m_attributes_size++] = attribute;
+    node.m_attributes_count += 1;
+    return error_type();
+}
+error_type html_document_base::finish() noexcept
+{
+    //  children are counted per parent, then listed in document order (counting sort by parent)
+    const auto count = size();
+    if (!count)
+        return error_type();
+
+    m_children = static_cast<uint32_t*>(m_arena.allocate((count - 1) * sizeof(uint32_t), alignof(uint32_t)));
+    if (!m_children)
+        return make_stdlib_error(std::errc::not_enough_memory);
+
+    for (auto k = 1_z; k < count; ++k)
+        node(node(k)->m_parent)->m_children_count += 1;
+
+    auto offset = 0u;
+    for (auto k = 0_z; k < count; ++k)
     {
-        auto ptr = gumbo_normalized_tagname(tagn);
-        return string_view(ptr, strlen(ptr));
+        const auto ptr = node(k);
+        ptr->m_children = offset;
+        offset += ptr->m_children_count;
+        ptr->m_children_count = 0;
+
+        if (ptr->m_attributes_count > 1)
+        {
+            const auto strings = m_strings;
+            std::sort(m_attributes + ptr->m_attributes, m_attributes + ptr->m_attributes + ptr->m_attributes_count,
+                [strings](const html_attribute& lhs, const html_attribute& rhs)
+            {
+                return string_view(strings + lhs.key, lhs.key_size, string_view::constexpr_tag()) <
+                    string_view(strings + rhs.key, rhs.key_size, string_view::constexpr_tag());
+            });
+        }
     }
-    return string_view();
+    for (auto k = 1_z; k < count; ++k)
+    {
+        const auto parent = node(node(k)->m_parent);
+        m_children[parent->m_children + parent->m_children_count++] = uint32_t(k);
+    }
+    return error_type();
 }
 
 error_type html_document_base::initialize(const const_array_view<char> parse) noexcept
 {
-    const GumboAllocatorFunction heap_alloc = [](void* user, size_t size) { return static_cast<icy::heap*>(user)->realloc(nullptr, size); };
-    const GumboDeallocatorFunction heap_free = [](void* user, void* ptr) { static_cast<icy::heap*>(user)->realloc(ptr, 0); };
+    if (size())
+        return make_stdlib_error(std::errc::invalid_argument);
 
+    //  gumbo frees nothing: its whole output goes away with the parse arena
+    html_arena arena(m_heap);
     GumboOptions options = kGumboDefaultOptions;
-    options.allocator = m_heap ? heap_alloc : [](void*, size_t size) { return icy::realloc(nullptr, size); };
-    options.deallocator = m_heap ? heap_free : [](void*, void* ptr) { icy::realloc(ptr, 0); };
+    options.allocator = [](void* user, size_t size) { return static_cast<html_arena*>(user)->allocate(size); };
+    options.deallocator = [](void*, void*) {};
+    options.userdata = &arena;
+    options.max_errors = 0;
 
-    auto output = gumbo_parse_with_options(&options, parse.data(), parse.size());
+    const auto output = gumbo_parse_with_options(&options, parse.data(), parse.size());
     if (!output)
         return make_stdlib_error(std::errc::not_enough_memory);
-    ICY_SCOPE_EXIT{ gumbo_destroy_output(&options, output); };
-
     if (!output->root)
         return make_stdlib_error(std::errc::invalid_argument);
-    
+
+    struct count_type
+    {
+        size_t nodes = 0;
+        size_t strings = 0;
+        size_t attributes = 0;
+    };
+    using count_func_type = void(*)(const GumboNode& node, count_type& count);
+    static count_func_type count_func = [](const GumboNode& node, count_type& count)
+    {
+        switch (node.type)
+        {
+        case GumboNodeType::GUMBO_NODE_ELEMENT:
+        {
+            const auto& elem = node.v.element;
+            count.nodes += 1;
+            for (auto k = 0u; k < elem.attributes.length; ++k)
+            {
+                const auto attribute = static_cast<GumboAttribute*>(elem.attributes.data[k]);
+                if (!attribute->name)
+                    continue;
+                count.attributes += 1;
+                count.strings += strlen(attribute->name);
+                count.strings += attribute->value ? strlen(attribute->value) : 0;
+            }
+            for (auto k = 0u; k < elem.children.length; ++k)
+                count_func(*static_cast<const GumboNode*>(elem.children.data[k]), count);
+            break;
+        }
+        case GumboNodeType::GUMBO_NODE_TEXT:
+        case GumboNodeType::GUMBO_NODE_CDATA:
+        case GumboNodeType::GUMBO_NODE_WHITESPACE:
+            count.nodes += 1;
+            count.strings += strlen(node.v.text.text);
+            break;
+        }
+    };
+    count_type count;
+    count_func(*output->root, count);
+    ICY_ERROR(reserve(count.nodes));
+    ICY_ERROR(reserve_pools(count.strings, count.attributes));
+
     using func_type = error_type(*)(html_document_base& self, const GumboNode& node, const uint32_t parent);
     static func_type func = [](html_document_base& self, const GumboNode& node, const uint32_t parent)
     {
-        const auto index = self.size();
+        const auto index = uint32_t(self.size());
         switch (node.type)
         {
         case GumboNodeType::GUMBO_NODE_ELEMENT:
         {
             const auto& elem = node.v.element;
-            const auto tag_str = gumbo_normalized_tagname(elem.tag);
-            const auto tag = tag_str ? string_view(tag_str, strlen(tag_str)) : string_view();
-
-            ICY_ERROR(self.insert(html_type::node, tag, parent));
+            ICY_ERROR(self.insert(html_type::node, html_tag_name(elem.tag), parent));
             const auto new_node = self.node(index);
             ICY_ASSERT(new_node, "INVALID NODE");
-            if (index)
-                ICY_ERROR(new_node->initialize(*self.node(parent)));
 
             for (auto k = 0u; k < elem.attributes.length; ++k)
             {
@@ -61,17 +308,14 @@ error_type html_document_base::initialize(const const_array_view<char> parse) no
                 if (!attribute->name)
                     continue;
 
-                const auto str_key = attribute->name ? string_view(attribute->name, strlen(attribute->name)) : string_view();
-                const auto str_val = attribute->value ? string_view(attribute->value, strlen(attribute->value)) : string_view();
-                string new_key(self.m_heap);
-                string new_val(self.m_heap);
-                ICY_ERROR(copy(str_key, new_key));
-                ICY_ERROR(copy(str_val, new_val));
-                ICY_ERROR(new_node->m_attributes.insert(std::move(new_key), std::move(new_val)));
+                const auto str_key = string_view(attribute->name, strlen(attribute->name), string_view::constexpr_tag());
+                const auto str_val = attribute->value ?
+                    string_view(attribute->value, strlen(attribute->value), string_view::constexpr_tag()) : string_view();
+                ICY_ERROR(self.append(*new_node, str_key, str_val));
             }
             for (auto k = 0u; k < elem.children.length; ++k)
-                ICY_ERROR(func(self, *static_cast<const GumboNode*>(elem.children.data[k]), uint32_t(index)));
-            
+                ICY_ERROR(func(self, *static_cast<const GumboNode*>(elem.children.data[k]), index));
+
             break;
         }
 
@@ -82,14 +326,150 @@ error_type html_document_base::initialize(const const_array_view<char> parse) no
             ICY_ERROR(self.insert(html_type::text, string_view(), parent));
             const auto new_node = self.node(index);
             ICY_ASSERT(new_node, "INVALID NODE");
-            ICY_ERROR(new_node->initialize(*self.node(parent)));
-            const auto text = string_view(node.v.text.text, strlen(node.v.text.text));
-            ICY_ERROR(copy(text, new_node->m_text));
+            const auto length = strlen(node.v.text.text);
+            new_node->m_text = uint32_t(self.m_strings_size);
+            new_node->m_text_size = uint32_t(length);
+            ICY_ERROR(self.append(node.v.text.text, length));
             break;
         }
         }
         return error_type();
     };
-    ICY_ERROR(func(*this, *output->root, 0));    
-    return error_type();
+    ICY_ERROR(func(*this, *output->root, 0));
+    return finish();
+}
+error_type html_document_base::initialize_stream(const const_array_view<char> parse) noexcept
+{
+    if (size())
+        return make_stdlib_error(std::errc::invalid_argument);
+
+    //  tokens are freed one by one, so gumbo uses the heap here instead of an arena
+    GumboOptions options = kGumboDefaultOptions;
+    options.allocator = [](void* user, size_t size)
+    {
+        return user ? static_cast<icy::heap*>(user)->realloc(nullptr, size) : icy::realloc(nullptr, size);
+    };
+    options.deallocator = [](void* user, void* ptr)
+    {
+        user ? static_cast<icy::heap*>(user)->realloc(ptr, 0) : icy::realloc(ptr, 0);
+    };
+    options.userdata = m_heap;
+    options.max_errors = 0;
+
+    GumboOutput output = {};
+    GumboParser parser = {};
+    parser._options = &options;
+    parser._output = &output;
+    gumbo_init_errors(&parser);
+    gumbo_tokenizer_state_init(&parser, parse.data(), parse.size());
+    ICY_SCOPE_EXIT
+    {
+        gumbo_tokenizer_state_destroy(&parser);
+        gumbo_destroy_errors(&parser);
+    };
+
+    //  text and attribute values usually take well under the source size
+    ICY_ERROR(reserve_pools(parse.size() / 2, 0));
+    ICY_ERROR(insert(html_type::node, html_tag_name(GUMBO_TAG_HTML), 0));
+
+    array<uint32_t> stack(m_heap);  //  open elements, root first
+    ICY_ERROR(stack.push_back(0));
+    html_node* text = nullptr;      //  character tokens are appended to the last text node until the next tag
+
+    GumboToken token;
+    do
+    {
+        gumbo_lex(&parser, &token);
+        ICY_SCOPE_EXIT{ gumbo_token_destroy(&parser, &token); };
+
+        switch (token.type)
+        {
+        case GUMBO_TOKEN_WHITESPACE:
+        case GUMBO_TOKEN_CHARACTER:
+        case GUMBO_TOKEN_CDATA:
+        {
+            if (!text)
+            {
+                const auto index = size();
+                ICY_ERROR(insert(html_type::text, string_view(), stack.back()));
+                text = node(index);
+                text->m_text = uint32_t(m_strings_size);
+            }
+            char buffer[4];
+            const auto length = html_utf8(token.v.character, buffer);
+            ICY_ERROR(append(buffer, length));
+            text->m_text_size += uint32_t(length);
+            break;
+        }
+        case GUMBO_TOKEN_START_TAG:
+        {
+            text = nullptr;
+            const auto& tag = token.v.start_tag;
+
+            //  <html> before any content gives its attributes to the root
+            auto index = size();
+            if (tag.tag == GUMBO_TAG_HTML && index == 1)
+                index = 0;
+            else
+                ICY_ERROR(insert(html_type::node, html_tag_name(tag.tag), stack.back()));
+
+            const auto new_node = node(index);
+            for (auto k = 0u; k < tag.attributes.length; ++k)
+            {
+                const auto attribute = static_cast<GumboAttribute*>(tag.attributes.data[k]);
+                if (!attribute || !attribute->name)
+                    continue;
+
+                const auto str_key = string_view(attribute->name, strlen(attribute->name), string_view::constexpr_tag());
+                const auto str_val = attribute->value ?
+                    string_view(attribute->value, strlen(attribute->value), string_view::constexpr_tag()) : string_view();
+                ICY_ERROR(append(*new_node, str_key, str_val));
+            }
+            if (!index || tag.is_self_closing || html_tag_void(tag.tag))
+                break;
+
+            ICY_ERROR(stack.push_back(uint32_t(index)));
+            switch (tag.tag)
+            {
+            case GUMBO_TAG_TITLE:
+            case GUMBO_TAG_TEXTAREA:
+                gumbo_tokenizer_set_state(&parser, GUMBO_LEX_RCDATA);
+                break;
+            case GUMBO_TAG_STYLE:
+            case GUMBO_TAG_XMP:
+            case GUMBO_TAG_IFRAME:
+            case GUMBO_TAG_NOEMBED:
+            case GUMBO_TAG_NOFRAMES:
+                gumbo_tokenizer_set_state(&parser, GUMBO_LEX_RAWTEXT);
+                break;
+            case GUMBO_TAG_SCRIPT:
+                gumbo_tokenizer_set_state(&parser, GUMBO_LEX_SCRIPT);
+                break;
+            case GUMBO_TAG_PLAINTEXT:
+                gumbo_tokenizer_set_state(&parser, GUMBO_LEX_PLAINTEXT);
+                break;
+            }
+            break;
+        }
+        case GUMBO_TOKEN_END_TAG:
+        {
+            text = nullptr;
+            const auto name = html_tag_name(token.v.end_tag);
+            for (auto k = stack.size(); k > 1; --k)
+            {
+                if (node(stack[k - 1])->tag() == name)
+                {
+                    stack.pop_back(stack.size() - k + 1);
+                    break;
+                }
+            }
+            break;
+        }
+        case GUMBO_TOKEN_COMMENT:
+            text = nullptr;
+            break;
+        }
+    } while (token.type != GUMBO_TOKEN_EOF);
+
+    return finish();
 }
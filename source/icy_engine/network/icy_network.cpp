@@ -126,6 +126,15 @@ error_type network_system_http_client::recv() noexcept
     ICY_ERROR(bytes.resize(m_data->config().buffer));
     return m_data->post(network_tcp_connection(), event_type::network_recv, std::move(bytes));
 }
+error_type network_system_http_client::connect(const network_address& address, const http_request& request) noexcept
+{
+    string str;
+    ICY_ERROR(to_string(request, str));
+    array<uint8_t> bytes;
+    ICY_ERROR(bytes.append(str.ubytes()));
+    ICY_ERROR(bytes.append(request.body));
+    return m_data->reconnect(address, std::move(bytes));
+}
 
 network_system_tcp_server::~network_system_tcp_server() noexcept
 {
@@ -1,5 +1,6 @@
 #include "icy_network_system.hpp"
 #include "icy_network_address.hpp"
+#include <icy_engine/core/icy_trace.hpp>
 
 using namespace icy;
 using namespace detail;
@@ -371,6 +372,9 @@ error_type detail::network_system_data::launch(const network_server_config& args
 error_type detail::network_system_data::connect(const network_address& address, 
     const const_array_view<uint8_t> bytes, const duration_type timeout, array<uint8_t>&& recv_buffer) noexcept
 {
+    m_timeout = timeout;
+    m_recv_size = recv_buffer.size();
+
     network_address tmp;
     ICY_ERROR(network_address_query::create(tmp, address.addr_type()));
 
@@ -394,15 +398,20 @@ error_type detail::network_system_data::connect(const network_address& address,
             return make_system_error(make_system_error_code(uint32_t(error)));
     }
     OVERLAPPED_ENTRY entry = {};
-    if (!GetQueuedCompletionStatusEx(m_iocp, &entry, 1, &count, ms_timeout(timeout), TRUE))
+    do
     {
-        const auto error = last_system_error();
-        if (error == make_system_error(make_system_error_code(ERROR_TIMEOUT)) ||
-            error == make_system_error(make_system_error_code(WAIT_TIMEOUT)))
-            return make_stdlib_error(std::errc::timed_out);
-        else
-            return error;
+        //  on "reconnect" the loop's wake-up packets share the port: skip them
+        if (!GetQueuedCompletionStatusEx(m_iocp, &entry, 1, &count, ms_timeout(timeout), TRUE))
+        {
+            const auto error = last_system_error();
+            if (error == make_system_error(make_system_error_code(ERROR_TIMEOUT)) ||
+                error == make_system_error(make_system_error_code(WAIT_TIMEOUT)))
+                return make_stdlib_error(std::errc::timed_out);
+            else
+                return error;
+        }
     }
+    while (!entry.lpOverlapped);
     if (entry.lpOverlapped == &ovl)
     {
         if (network_func_setsockopt(m_socket, SOL_SOCKET, SO_UPDATE_CONNECT_CONTEXT, nullptr, 0) == SOCKET_ERROR)
@@ -415,6 +424,23 @@ error_type detail::network_system_data::connect(const network_address& address,
     }
     return make_stdlib_error(std::errc::not_connected);
 }
+error_type detail::network_system_data::reconnect(const network_address& address, array<uint8_t>&& bytes) noexcept
+{
+    if (m_config.port || m_conn.empty())
+        return make_stdlib_error(std::errc::invalid_argument);
+
+    network_command cmd;
+    cmd.conn = network_tcp_connection(1, 0);
+    cmd.type = event_type::network_connect;
+    cmd.bytes = std::move(bytes);
+    ICY_ERROR(copy(address, cmd.address));
+
+    ICY_ERROR(m_cmds.push(std::move(cmd)));
+    if (!PostQueuedCompletionStatus(m_iocp, 0, 0, nullptr))
+        return last_system_error();
+
+    return error_type();
+}
 error_type detail::network_system_data::cancel() noexcept
 {
     if (!PostQueuedCompletionStatus(m_iocp, 0, 0, nullptr))
@@ -532,6 +558,19 @@ error_type detail::network_system_data::loop_tcp(event_system& system) noexcept
     network_command cmd;
     while (m_cmds.pop(cmd))
     {
+        ICY_TRACE_SCOPE("network_system::command");
+        if (cmd.type == event_type::network_connect && !m_config.port)
+        {
+            //  client reconnect: nothing else waits on the port while the loop thread is here
+            network_event event;
+            array<uint8_t> recv_buffer;
+            event.error = recv_buffer.resize(m_recv_size);
+            if (!event.error)
+                event.error = connect(cmd.address, cmd.bytes, m_timeout, std::move(recv_buffer));
+            if (event.error)
+                ICY_ERROR(event::post(&system, event_type::network_disconnect, std::move(event)));
+            continue;
+        }
         auto conn = &m_conn[cmd.conn.index() - 1];
         if (cmd.conn.version() != conn->version)
             continue;
@@ -584,6 +623,8 @@ error_type detail::network_system_data::loop_tcp(event_system& system) noexcept
     GetQueuedCompletionStatus(m_iocp, &entry.dwNumberOfBytesTransferred,
         &entry.lpCompletionKey, &entry.lpOverlapped, INFINITE);
     
+    ICY_TRACE_SCOPE("network_system::loop_tcp");
+    ICY_TRACE_VALUE("network_system::bytes", entry.dwNumberOfBytesTransferred);
     auto ovl = reinterpret_cast<network_tcp_overlapped*>(entry.lpOverlapped);
     if (!ovl)
         return last_system_error();
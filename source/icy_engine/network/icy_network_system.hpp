@@ -66,6 +66,8 @@ public:
     error_type launch(const network_server_config& args, const network_socket::type sock_type) noexcept;
     error_type connect(const network_address& address, const_array_view<uint8_t> bytes,
         const duration_type timeout, array<uint8_t>&& recv_buffer = {}) noexcept;
+    //  client only: the previous connection must be closed; runs "connect" on the loop thread
+    error_type reconnect(const network_address& address, array<uint8_t>&& bytes) noexcept;
     error_type cancel() noexcept;
     error_type post(const network_tcp_connection conn, const event_type type, array<uint8_t>&& bytes, const network_address* addr = nullptr) noexcept;
     error_type post(const network_tcp_connection conn, unique_ptr<http_response>&& response) noexcept;
@@ -100,4 +102,6 @@ private:
         mpsc_queue<detail::network_udp_overlapped> queue;
     } m_udp_send;
     bool m_http = false;
+    duration_type m_timeout = {};   //  client: kept for "reconnect"
+    size_t m_recv_size = 0;
 };
\ No newline at end of file
@@ -2,9 +2,11 @@
 #include <icy_engine/utility/icy_database.hpp>
 #include <icy_engine/core/icy_file.hpp>
 #include <icy_engine/core/icy_json.hpp>
+#include <icy_engine/core/icy_trace.hpp>
 
 #if 1
 #include <icy_engine/graphics/icy_render_core.hpp>
+#include <icy_engine/graphics/icy_render_texture.hpp>
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
@@ -26,6 +28,9 @@ struct internal_message
     resource_header header;
     string path;
     array<uint8_t> bytes;
+    matrix<color> image;
+    render_texture_options options;
+    promise<resource_event> result;     //  empty: broadcast the result
 };
 class assimp_scene
 {
@@ -176,7 +181,15 @@ private:
     error_type store(const resource_header& header, const string_view path) noexcept override;
     error_type store(const resource_header& header, const const_array_view<uint8_t> bytes) noexcept override;
     error_type store(const guid& index, const const_matrix_view<color> colors) noexcept override;
+    error_type store(const resource_header& header, const const_matrix_view<color> image, const render_texture_options& options) noexcept override;
+    error_type load(const resource_header& header, future<resource_event>& future) noexcept override;
+    error_type store(const resource_header& header, const string_view path, future<resource_event>& future) noexcept override;
+    error_type store(const resource_header& header, const const_array_view<uint8_t> bytes, future<resource_event>& future) noexcept override;
     error_type load(const resource_header& header, resource_event& new_event) const noexcept;
+    error_type load(const resource_header& header, promise<resource_event>&& result) noexcept;
+    error_type store(const resource_header& header, const string_view path, promise<resource_event>&& result) noexcept;
+    error_type store(const resource_header& header, const const_array_view<uint8_t> bytes, promise<resource_event>&& result) noexcept;
+    error_type complete(promise<resource_event>& result, const event_type type, resource_event&& new_event) noexcept;
     error_type list(map<guid, resource_data>& output) const noexcept override;
     error_type list(const resource_locale locale, array<resource_event>& output) const noexcept override;
 private:
@@ -191,6 +204,7 @@ private:
     database_dbi m_dbi_header;
     database_dbi m_dbi_binary;
     map<guid, matrix<color>> m_images;
+    render_texture_encoder m_texture;
 };
 ICY_STATIC_NAMESPACE_END
 
@@ -366,6 +380,7 @@ error_type resource_system_data::initialize(const string_view path, const size_t
         ICY_ERROR(m_dbi_binary.initialize_create_any_key(txn, "binary"_s));
         ICY_ERROR(txn.commit());
     }
+    ICY_ERROR(m_texture.initialize());
     ICY_ERROR(make_shared(m_thread));
     m_thread->system = this;
     filter(event_type::system_internal);
@@ -380,7 +395,9 @@ error_type resource_system_data::exec() noexcept
             if (event->type != event_type::system_internal)
                 continue;
 
-            const auto& event_data = event->data<internal_message>();
+            ICY_TRACE_SCOPE("resource_system::exec");
+
+            auto& event_data = event->data<internal_message>();
             
             resource_event new_event;
             new_event.header.index = event_data.header.index;
@@ -402,8 +419,22 @@ error_type resource_system_data::exec() noexcept
                 if (!new_event.error) write = bytes;
             }
 
-            if (!write.empty())
+            if (!write.empty() || !event_data.image.empty())
             {
+                //  mips and block compression run before the write transaction (LMDB has a single writer)
+                string texture_str;
+                if (new_event.header.type == resource_type::texture)
+                {
+                    render_texture texture;
+                    icy::json json;
+                    if (event_data.image.empty())
+                        new_event.error = make_stdlib_error(std::errc::invalid_argument);
+                    if (!new_event.error) new_event.error = m_texture.encode(event_data.image, event_data.options, texture);
+                    if (!new_event.error) new_event.error = to_json(texture, json);
+                    if (!new_event.error) new_event.error = json.insert(key_type, to_string(resource_type::texture));
+                    if (!new_event.error) new_event.error = to_string(json, texture_str);
+                }
+
                 txn_write txn;
                 if (!new_event.error) new_event.error = txn.initialize(*this);
 
@@ -430,6 +461,12 @@ error_type resource_system_data::exec() noexcept
                         new_event.error = txn.store(event_data.header, write);
                     break;
                 }
+                case resource_type::texture:
+                {
+                    if (!new_event.error)
+                        new_event.error = txn.store(event_data.header, texture_str.ubytes());
+                    break;
+                }
                 default:
                     new_event.error = make_stdlib_error(std::errc::invalid_argument);
                     break;
@@ -441,48 +478,69 @@ error_type resource_system_data::exec() noexcept
                     txn.cur_header = {};
                     new_event.error = txn.txn.commit();
                 }
-                ICY_ERROR(event::post(this, event_type::resource_store, std::move(new_event)));
+                ICY_ERROR(complete(event_data.result, event_type::resource_store, std::move(new_event)));
             }
             else
             {
                 ICY_ERROR(load(event_data.header, new_event));
-                ICY_ERROR(event::post(this, event_type::resource_load, std::move(new_event)));
+                ICY_ERROR(complete(event_data.result, event_type::resource_load, std::move(new_event)));
             }          
         }
         ICY_ERROR(m_sync.wait());
     }
     return error_type();
 }
+error_type resource_system_data::complete(promise<resource_event>& result, const event_type type, resource_event&& new_event) noexcept
+{
+    if (result)
+    {
+        result.set_value(std::move(new_event));
+        return error_type();
+    }
+    return event::post(this, type, std::move(new_event));
+}
 error_type resource_system_data::load(const resource_header& header) noexcept
+{
+    return load(header, promise<resource_event>());
+}
+error_type resource_system_data::load(const resource_header& header, future<resource_event>& future) noexcept
+{
+    promise<resource_event> result;
+    ICY_ERROR(result.initialize(future));
+    return load(header, std::move(result));
+}
+error_type resource_system_data::load(const resource_header& header, promise<resource_event>&& result) noexcept
 {
     if (!header)
         return make_stdlib_error(std::errc::invalid_argument);
 
     if (header.type == resource_type::image)
     {
-        ICY_LOCK_GUARD(m_lock);
-        const auto image = m_images.try_find(header.index);
-        if (image)
+        resource_event new_event;
         {
-            resource_event new_event;
-            new_event.header.index = header.index;
-            new_event.header.type = header.type;
+            ICY_LOCK_GUARD(m_lock);
+            if (const auto image = m_images.try_find(header.index))
+            {
+                new_event.header.index = header.index;
+                new_event.header.type = header.type;
 
-            auto new_image = make_unique<matrix<color>>();
-            if (!new_image)
-                return make_stdlib_error(std::errc::not_enough_memory);
-            
-            ICY_ERROR(copy(const_matrix_view<color>(*image), *new_image));
-            new_event.bytes = new_image.release();
-            ICY_ERROR(event::post(this, event_type::resource_load, std::move(new_event)));
-            return error_type();
-        }
+                auto new_image = make_unique<matrix<color>>();
+                if (!new_image)
+                    return make_stdlib_error(std::errc::not_enough_memory);
 
+                ICY_ERROR(copy(const_matrix_view<color>(*image), *new_image));
+                new_event.bytes = new_image.release();
+            }
+        }
+        //  outside the lock: a continuation may call back into the system
+        if (new_event.bytes)
+            return complete(result, event_type::resource_load, std::move(new_event));
     }
     internal_message msg;
     msg.header.index = header.index;
     msg.header.locale = header.locale;
     msg.header.type = header.type;
+    msg.result = std::move(result);
     ICY_ERROR(event_system::post(nullptr, event_type::system_internal, std::move(msg)));
     return error_type();
 }
@@ -608,6 +666,16 @@ error_type resource_system_data::load(const resource_header& header, resource_ev
     return error_type();
 }
 error_type resource_system_data::store(const resource_header& header, const string_view path) noexcept
+{
+    return store(header, path, promise<resource_event>());
+}
+error_type resource_system_data::store(const resource_header& header, const string_view path, future<resource_event>& future) noexcept
+{
+    promise<resource_event> result;
+    ICY_ERROR(result.initialize(future));
+    return store(header, path, std::move(result));
+}
+error_type resource_system_data::store(const resource_header& header, const string_view path, promise<resource_event>&& result) noexcept
 {
     if (!header || path.empty())
         return make_stdlib_error(std::errc::invalid_argument);
@@ -617,11 +685,22 @@ error_type resource_system_data::store(const resource_header& header, const stri
     msg.header.type = header.type;
     ICY_ERROR(copy(header.name, msg.header.name));
     ICY_ERROR(copy(path, msg.path));
+    msg.result = std::move(result);
     ICY_ERROR(event_system::post(nullptr, event_type::system_internal, std::move(msg)));
     return error_type();
 
 }
 error_type resource_system_data::store(const resource_header& header, const const_array_view<uint8_t> bytes) noexcept
+{
+    return store(header, bytes, promise<resource_event>());
+}
+error_type resource_system_data::store(const resource_header& header, const const_array_view<uint8_t> bytes, future<resource_event>& future) noexcept
+{
+    promise<resource_event> result;
+    ICY_ERROR(result.initialize(future));
+    return store(header, bytes, std::move(result));
+}
+error_type resource_system_data::store(const resource_header& header, const const_array_view<uint8_t> bytes, promise<resource_event>&& result) noexcept
 {
     if (!header || bytes.empty())
         return make_stdlib_error(std::errc::invalid_argument);
@@ -631,6 +710,7 @@ error_type resource_system_data::store(const resource_header& header, const cons
     msg.header.type = header.type;
     ICY_ERROR(copy(header.name, msg.header.name));
     ICY_ERROR(msg.bytes.assign(bytes));
+    msg.result = std::move(result);
     ICY_ERROR(event_system::post(nullptr, event_type::system_internal, std::move(msg)));
     return error_type();
 }
@@ -645,6 +725,20 @@ error_type resource_system_data::store(const guid& index, const const_matrix_vie
     ICY_ERROR(m_images.insert(index, std::move(tmp)));
     return error_type();
 }
+error_type resource_system_data::store(const resource_header& header, const const_matrix_view<color> image, const render_texture_options& options) noexcept
+{
+    if (!header || header.type != resource_type::texture || image.empty())
+        return make_stdlib_error(std::errc::invalid_argument);
+    internal_message msg;
+    msg.header.index = header.index;
+    msg.header.locale = header.locale;
+    msg.header.type = header.type;
+    msg.options = options;
+    ICY_ERROR(copy(header.name, msg.header.name));
+    ICY_ERROR(copy(image, msg.image));
+    ICY_ERROR(event_system::post(nullptr, event_type::system_internal, std::move(msg)));
+    return error_type();
+}
 error_type resource_system_data::list(map<guid, resource_data>& output) const noexcept
 {
     database_txn_read txn;
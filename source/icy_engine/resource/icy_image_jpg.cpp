@@ -1,4 +1,5 @@
 #include "icy_image_core.hpp"
+#include <icy_engine/core/icy_pixel.hpp>
 #include <jpeg/jpeglib.h>
 #if _DEBUG
 #pragma comment(lib, "libjpegd")
@@ -73,25 +74,42 @@ error_type image_jpg::load(const_array_view<uint8_t> bytes) noexcept
     info.src = &src;
     if (!jpeg_read_header(&info, true))
         return make_stdlib_error(std::errc::illegal_byte_sequence);
-    info.out_color_space = JCS_RGB;
+    //  YCbCr -> BGRA is done by "pixel_convert" (libjpeg's colour conversion is table-driven scalar code)
+    auto format = pixel_format::rgb8;
+    if (info.jpeg_color_space == JCS_YCbCr)
+    {
+        info.out_color_space = JCS_YCbCr;
+        format = pixel_format::ycbcr8;
+    }
+    else
+    {
+        info.out_color_space = JCS_RGB;
+    }
     jpeg_start_decompress(&info);
 
     size = { info.output_width, info.output_height };
-    data = static_cast<uint8_t*>(realloc(data, size.x * size.y * 3, user));
+    data = static_cast<uint8_t*>(realloc(data, size.x * size.y * sizeof(color), user));
     if (!data)
         return make_stdlib_error(std::errc::not_enough_memory);
-    
-    for (auto k = 0u; k < size.y;)
+
+    const auto pitch = size.x * 3;
+    auto buffer = static_cast<uint8_t*>(realloc(nullptr, pitch * 8, user));
+    if (!buffer)
+        return make_stdlib_error(std::errc::not_enough_memory);
+    ICY_SCOPE_EXIT{ realloc(buffer, 0, user); };
+
+    while (info.output_scanline < size.y)
     {
-        auto row = data;
-        row += info.output_scanline * size.x * 3;
+        const auto first = info.output_scanline;
         uint8_t* rows[8] = {};
         for (auto n = 0u; n < _countof(rows); ++n)
-        {
-            rows[n] = row;
-            row += size.x * 3;
-        }
-        k += jpeg_read_scanlines(&info, rows, _countof(rows));
+            rows[n] = buffer + n * pitch;
+
+        const auto count = jpeg_read_scanlines(&info, rows, _countof(rows));
+        if (!count)
+            return make_stdlib_error(std::errc::illegal_byte_sequence);
+        ICY_ERROR(pixel_convert(format, buffer, pitch,
+            matrix_view<color>(reinterpret_cast<color*>(data) + first * size.x, size.x, count, size.x, 0, 0)));
     }
     jpeg_finish_decompress(&info);
     return {};
@@ -101,15 +119,9 @@ error_type image_jpg::view(const image_size offset, matrix_view<color> colors) c
     const auto dx = size.x;
     for (auto row = offset.y; row < offset.y + colors.rows(); ++row)
     {
-        const auto src = data + (row * dx + offset.x) * 3;
+        const auto src = data + (row * dx + offset.x) * sizeof(color);
         const auto dst = colors.row(row - offset.y).data();
-        for (auto k = 0u; k < colors.cols(); ++k)
-        {
-            dst[k].b = src[3 * k + 2];
-            dst[k].g = src[3 * k + 1];
-            dst[k].r = src[3 * k + 0];
-            dst[k].a = 0xFF;
-        }
+        memcpy(dst, src, colors.cols() * sizeof(color));
     }
     return {};
 }
@@ -1,4 +1,5 @@
 #include "icy_image_core.hpp"
+#include <icy_engine/core/icy_pixel.hpp>
 #include <png/png.h>
 #if _DEBUG
 #pragma comment(lib, "libpngd")
@@ -64,6 +65,7 @@ error_type image_png::load(const_array_view<uint8_t> bytes) noexcept
         return png_make_error();
 
     array<uint8_t*> rows;
+    array<uint8_t> source;
     if (setjmp(png_jmpbuf(png)))
         return png_make_error();
 
@@ -83,24 +85,38 @@ error_type image_png::load(const_array_view<uint8_t> bytes) noexcept
     auto dy = 0u;
     auto bits = 0;
     auto type = 0;
-    png_get_IHDR(png, info, &dx, &dy, &bits, &type, nullptr, nullptr, nullptr);    
-    png_set_bgr(png);
-    png_set_strip_16(png);
+    png_get_IHDR(png, info, &dx, &dy, &bits, &type, nullptr, nullptr, nullptr);
+    //  libpng only expands to 8/16-bit RGB(A); channel order, alpha and 16 -> 8 bits are done by "pixel_convert"
     png_set_packing(png);
     png_set_gray_to_rgb(png);
     png_set_expand_gray_1_2_4_to_8(png);
     png_set_palette_to_rgb(png);
-    png_set_filler(png, 0xFF, PNG_FILLER_AFTER);
     png_set_tRNS_to_alpha(png);
+    if (bits == 16)
+        png_set_swap(png);
+    png_set_interlace_handling(png);
     png_read_update_info(png, info);
 
+    const auto channels = png_get_channels(png, info);
+    const auto depth = png_get_bit_depth(png, info);
+    auto format = pixel_format::none;
+    if (depth == 8)
+        format = channels == 4 ? pixel_format::rgba8 : pixel_format::rgb8;
+    else if (depth == 16)
+        format = channels == 4 ? pixel_format::rgba16 : pixel_format::rgb16;
+    if (format == pixel_format::none || (channels != 3 && channels != 4))
+        return make_stdlib_error(std::errc::illegal_byte_sequence);
+
+    const auto pitch = png_get_rowbytes(png, info);
+    ICY_ERROR(source.resize(pitch * dy));
     ICY_ERROR(rows.resize(dy));
-    ICY_ERROR(data.resize(dx * dy * sizeof(color)));    
-    auto pointer = data.data();
-    for (auto k = 0u; k < dy; ++k, pointer += dx * sizeof(color))
-        rows[k] = pointer;
+    for (auto k = 0u; k < dy; ++k)
+        rows[k] = source.data() + k * pitch;
 
     png_read_image(png, rows.data());
+    ICY_ERROR(data.resize(dx * dy * sizeof(color)));
+    ICY_ERROR(pixel_convert(format, source.data(), pitch,
+        matrix_view<color>(reinterpret_cast<color*>(data.data()), dx, dy, dx, 0, 0)));
     png_read_end(png, info);
     size = { dx, dy };
     return {};
@@ -1,4 +1,5 @@
 #include <icy_engine/utility/icy_crypto.hpp>
+#include <icy_engine/core/icy_hash.hpp>
 
 #define SODIUM_STATIC 1
 
@@ -10,6 +11,7 @@
 #include "../../libs/sodium/include/crypto_generichash.h"
 #include "../../libs/sodium/include/randombytes.h"
 #include "../../libs/sodium/include/crypto_box.h"
+#include "../../libs/sodium/include/utils.h"
 #pragma warning(pop)
 
 #if _DEBUG
@@ -20,6 +22,8 @@
 
 using namespace icy;
 
+static const auto crypto_batch_nonces = 64_z;
+
 static_assert(true
     && sizeof(crypto_nonce) == crypto_secretbox_NONCEBYTES
     && sizeof(crypto_salt) == crypto_pwhash_SALTBYTES
@@ -27,6 +31,9 @@ static_assert(true
     && sizeof(crypto_key) == crypto_secretbox_KEYBYTES
     && sizeof(crypto_login) == crypto_hash_BYTES
     && sizeof(crypto_mac) == crypto_secretbox_MACBYTES
+    && sizeof(crypto_key) == crypto_box_BEFORENMBYTES
+    && sizeof(crypto_nonce) == crypto_box_NONCEBYTES
+    && sizeof(crypto_mac) == crypto_box_MACBYTES
     , "INVALID CRYPTO SIZE");
 
 crypto_nonce::crypto_nonce(decltype(crypto_random)) noexcept
@@ -71,6 +78,158 @@ crypto_login::crypto_login(const string_view login) noexcept
     crypto_hash(m_array, reinterpret_cast<const uint8_t*>(login.bytes().data()), login.bytes().size());
 }
 
+error_type crypto_session::initialize(const crypto_key& public_key, const crypto_key& private_key) noexcept
+{
+    if (crypto_box_beforenm(m_key.data(), public_key.data(), private_key.data()) != 0)
+        return make_stdlib_error(std::errc::invalid_argument);
+    return error_type();
+}
+
+error_type crypto_session_cache::initialize(const size_t capacity) noexcept
+{
+    if (!capacity || capacity >= UINT32_MAX)
+        return make_stdlib_error(std::errc::invalid_argument);
+
+    //  at most half full, so probe sequences stay short
+    auto slots = 2_z;
+    while (slots < 2 * capacity)
+        slots *= 2;
+
+    ICY_ERROR(m_lock.initialize());
+    ICY_ERROR(m_entries.reserve(capacity));
+    ICY_ERROR(m_slots.resize(slots));
+    for (auto&& slot : m_slots)
+        slot = UINT32_MAX;
+    m_capacity = capacity;
+    return error_type();
+}
+error_type crypto_session_cache::find(const crypto_key& public_key, const crypto_key& private_key, crypto_session& session) noexcept
+{
+    uint8_t pair[2 * sizeof(crypto_key)];
+    memcpy(pair, public_key.data(), sizeof(crypto_key));
+    memcpy(pair + sizeof(crypto_key), private_key.data(), sizeof(crypto_key));
+    const auto hash = fast_hash64(pair, sizeof(pair));
+
+    ICY_LOCK_GUARD(m_lock);
+    auto slot = find_slot(hash);
+    if (m_slots[slot] != UINT32_MAX)
+    {
+        const auto index = m_slots[slot];
+        auto& entry = m_entries[index];
+        if (memcmp(entry.public_key.data(), public_key.data(), sizeof(crypto_key)) == 0 &&
+            memcmp(entry.private_key.data(), private_key.data(), sizeof(crypto_key)) == 0)
+        {
+            unlink(index);
+            link(index);
+            session = entry.session;
+            ++m_hits;
+            return error_type();
+        }
+    }
+    ++m_misses;
+    crypto_session new_session;
+    ICY_ERROR(new_session.initialize(public_key, private_key));
+
+    auto index = m_slots[slot];
+    if (index != UINT32_MAX)
+    {
+        //  64-bit hash collision: reuse the slot
+        unlink(index);
+    }
+    else if (m_entries.size() < m_capacity)
+    {
+        index = uint32_t(m_entries.size());
+        ICY_ERROR(m_entries.push_back(entry_type()));
+        m_slots[slot] = index;
+    }
+    else
+    {
+        index = m_tail;
+        unlink(index);
+        erase_slot(find_slot(m_entries[index].hash));
+        m_slots[find_slot(hash)] = index;
+    }
+    auto& entry = m_entries[index];
+    entry.public_key = public_key;
+    entry.private_key = private_key;
+    entry.session = new_session;
+    entry.hash = hash;
+    link(index);
+    session = new_session;
+    return error_type();
+}
+void crypto_session_cache::clear() noexcept
+{
+    ICY_LOCK_GUARD(m_lock);
+    sodium_memzero(m_entries.data(), m_entries.size() * sizeof(entry_type));
+    m_entries.clear();
+    for (auto&& slot : m_slots)
+        slot = UINT32_MAX;
+    m_head = UINT32_MAX;
+    m_tail = UINT32_MAX;
+    m_hits = 0;
+    m_misses = 0;
+}
+size_t crypto_session_cache::size() const noexcept
+{
+    ICY_LOCK_GUARD(m_lock);
+    return m_entries.size();
+}
+size_t crypto_session_cache::hits() const noexcept
+{
+    ICY_LOCK_GUARD(m_lock);
+    return m_hits;
+}
+size_t crypto_session_cache::misses() const noexcept
+{
+    ICY_LOCK_GUARD(m_lock);
+    return m_misses;
+}
+size_t crypto_session_cache::find_slot(const uint64_t hash) const noexcept
+{
+    //  the slot holding "hash" or the empty slot that ends its probe sequence
+    const auto mask = m_slots.size() - 1;
+    auto slot = size_t(hash) & mask;
+    while (m_slots[slot] != UINT32_MAX && m_entries[m_slots[slot]].hash != hash)
+        slot = (slot + 1) & mask;
+    return slot;
+}
+void crypto_session_cache::erase_slot(size_t slot) noexcept
+{
+    //  backward shift: move later entries of the cluster into the hole unless that
+    //  would put them before their home slot (no tombstones, lookups stay exact)
+    const auto mask = m_slots.size() - 1;
+    for (auto next = (slot + 1) & mask; m_slots[next] != UINT32_MAX; next = (next + 1) & mask)
+    {
+        const auto home = size_t(m_entries[m_slots[next]].hash) & mask;
+        if (((next - home) & mask) >= ((next - slot) & mask))
+        {
+            m_slots[slot] = m_slots[next];
+            slot = next;
+        }
+    }
+    m_slots[slot] = UINT32_MAX;
+}
+void crypto_session_cache::unlink(const uint32_t index) noexcept
+{
+    auto& entry = m_entries[index];
+    if (entry.prev != UINT32_MAX) m_entries[entry.prev].next = entry.next;
+    else m_head = entry.next;
+    if (entry.next != UINT32_MAX) m_entries[entry.next].prev = entry.prev;
+    else m_tail = entry.prev;
+    entry.prev = UINT32_MAX;
+    entry.next = UINT32_MAX;
+}
+void crypto_session_cache::link(const uint32_t index) noexcept
+{
+    auto& entry = m_entries[index];
+    entry.prev = UINT32_MAX;
+    entry.next = m_head;
+    if (m_head != UINT32_MAX) m_entries[m_head].prev = index;
+    else m_tail = index;
+    m_head = index;
+}
+
 error_type icy::crypto_msg_encode(const crypto_key& key, const const_array_view<uint8_t> input, array_view<uint8_t> output) noexcept
 {
     if (output.size() != input.size() + crypto_msg_size)
@@ -146,6 +305,68 @@ error_type icy::crypto_msg_decode(const crypto_key& public_key, const crypto_key
     return {};
 }
 
+error_type icy::crypto_msg_encode(const crypto_session& session, const const_array_view<uint8_t> input, array_view<uint8_t> output) noexcept
+{
+    if (output.size() != input.size() + crypto_msg_size)
+        return make_stdlib_error(std::errc::message_size);
+
+    const auto nonce = crypto_nonce{ crypto_random };
+    memcpy(output.data(), nonce.data(), nonce.size());
+    crypto_box_easy_afternm(output.data() + nonce.size(), input.data(), input.size(), nonce.data(), session.key().data());
+    return {};
+}
+error_type icy::crypto_msg_decode(const crypto_session& session, const const_array_view<uint8_t> input, array_view<uint8_t> output) noexcept
+{
+    if (output.size() + crypto_msg_size != input.size())
+        return make_stdlib_error(std::errc::message_size);
+
+    const auto nonce = input.data();
+    const auto error = crypto_box_open_easy_afternm(output.data(), nonce + sizeof(crypto_nonce),
+        input.size() - sizeof(crypto_nonce), nonce, session.key().data());
+    if (error)
+        return make_stdlib_error(std::errc::illegal_byte_sequence);
+    return {};
+}
+error_type icy::crypto_msg_encode(const crypto_session& session, const size_t size, const const_array_view<uint8_t> input, array_view<uint8_t> output) noexcept
+{
+    const auto block = size + crypto_msg_size;
+    if (!size || input.size() % size || output.size() != input.size() / size * block)
+        return make_stdlib_error(std::errc::message_size);
+
+    //  one random call per group of nonces instead of one per message
+    uint8_t nonces[crypto_batch_nonces * sizeof(crypto_nonce)];
+    const auto count = input.size() / size;
+    for (auto k = 0_z; k < count; ++k)
+    {
+        const auto offset = k % crypto_batch_nonces;
+        if (offset == 0)
+            randombytes_buf(nonces, std::min(count - k, crypto_batch_nonces) * sizeof(crypto_nonce));
+
+        const auto nonce = nonces + offset * sizeof(crypto_nonce);
+        const auto dst = output.data() + k * block;
+        memcpy(dst, nonce, sizeof(crypto_nonce));
+        crypto_box_easy_afternm(dst + sizeof(crypto_nonce), input.data() + k * size, size, nonce, session.key().data());
+    }
+    return {};
+}
+error_type icy::crypto_msg_decode(const crypto_session& session, const size_t size, const const_array_view<uint8_t> input, array_view<uint8_t> output) noexcept
+{
+    const auto block = size + crypto_msg_size;
+    if (!size || output.size() % size || input.size() != output.size() / size * block)
+        return make_stdlib_error(std::errc::message_size);
+
+    const auto count = output.size() / size;
+    for (auto k = 0_z; k < count; ++k)
+    {
+        const auto src = input.data() + k * block;
+        const auto error = crypto_box_open_easy_afternm(output.data() + k * size, src + sizeof(crypto_nonce),
+            block - sizeof(crypto_nonce), src, session.key().data());
+        if (error)
+            return make_stdlib_error(std::errc::illegal_byte_sequence);
+    }
+    return {};
+}
+
 crypto_msg_base::crypto_msg_base(const crypto_key& key, const size_t size, const void* const input, void* const output) noexcept : m_nonce(crypto_random)
 {
     crypto_secretbox_detached
@@ -171,6 +392,18 @@ crypto_msg_base::crypto_msg_base(const crypto_key& public_key, const crypto_key&
         private_key.data()
     );
 }
+crypto_msg_base::crypto_msg_base(const crypto_session& session, const size_t size, const void* input, void* const output) noexcept : m_nonce(crypto_random)
+{
+    crypto_box_detached_afternm
+    (
+        static_cast<uint8_t*>(output),
+        m_mac.data(),
+        static_cast<const uint8_t*>(input),
+        size,
+        m_nonce.data(),
+        session.key().data()
+    );
+}
 error_type crypto_msg_base::decode(const crypto_key& key, const size_t size, const void* const input, void* const output) const noexcept
 {
     const auto error = crypto_secretbox_open_detached
@@ -202,5 +435,20 @@ error_type crypto_msg_base::decode(const crypto_key& public_key, const crypto_ke
         return make_stdlib_error(std::errc::illegal_byte_sequence);
     return {};
 }
+error_type crypto_msg_base::decode(const crypto_session& session, const size_t size, const void* const input, void* const output) const noexcept
+{
+    const auto error = crypto_box_open_detached_afternm
+    (
+        static_cast<uint8_t*>(output),
+        static_cast<const uint8_t*>(input),
+        m_mac.data(),
+        size,
+        m_nonce.data(),
+        session.key().data()
+    );
+    if (error)
+        return make_stdlib_error(std::errc::illegal_byte_sequence);
+    return {};
+}
 
 const crypto_random_type icy::crypto_random;
\ No newline at end of file
@@ -1,5 +1,11 @@
 #include <icy_engine/core/icy_array.hpp>
 #include <icy_engine/core/icy_set.hpp>
+#include <icy_engine/core/icy_map.hpp>
+#include <icy_engine/core/icy_hash.hpp>
+#include <icy_engine/core/icy_atomic.hpp>
+#include <icy_engine/core/icy_json.hpp>
+#include <icy_engine/core/icy_matrix.hpp>
+#include <icy_engine/core/icy_color.hpp>
 #include <icy_engine/utility/icy_lua.hpp>
 //extern "C"
 //{
@@ -53,15 +59,350 @@ struct lua_object_init
     lua_default_library lib = lua_default_library::none;
     int index = 0;
 };
+class lua_system_data;
+//  full userdata behind a view (see "lua_system::make_view"), pointing at data owned by the caller
+struct lua_view_data
+{
+    enum class kind_type : uint32_t
+    {
+        bytes,
+        image,
+        json,
+        map,
+    };
+    kind_type kind = kind_type::bytes;
+    const void* data = nullptr;                 //  bytes, json or map
+    size_t size = 0;                            //  bytes
+    const_matrix_view<color> image;
+    const lua_system_data* system = nullptr;    //  map values are pushed as variables
+};
+static const char* const lua_view_meta = "icy_view";   //  registry name of the view metatable
+static const char* const lua_pool_meta = "icy_pool";   //  registry name of the checkin snapshot (see "lua_pool_data")
+
+//  per-state allocator: blocks up to "small_max" bytes are carved from 64 KB pages in 16 byte size classes
+//  and reused through per-class free lists, larger blocks go to "realloc". A state is used by one thread
+//  at a time, so nothing is locked; pages are returned when the state is closed.
+class lua_arena
+{
+public:
+    static const size_t page_size = 64 * 1024;
+    static const size_t small_step = 16;
+    static const size_t small_max = 512;
+public:
+    lua_arena(const realloc_func realloc, void* const user) noexcept : m_realloc(realloc), m_user(user)
+    {
+
+    }
+    lua_arena(const lua_arena&) = delete;
+    ~lua_arena() noexcept
+    {
+        while (m_page)
+        {
+            const auto next = *static_cast<void**>(m_page);
+            m_realloc(m_page, 0, m_user);
+            m_page = next;
+        }
+    }
+    size_t pages() const noexcept
+    {
+        return m_pages;
+    }
+    uint64_t reused() const noexcept
+    {
+        return m_reused;
+    }
+    //  "osize" is 0 for a new block (Lua passes the object type there)
+    void* realloc(void* const ptr, const size_t osize, const size_t nsize) noexcept
+    {
+        if (nsize == 0)
+        {
+            deallocate(ptr, osize);
+            return nullptr;
+        }
+        if (ptr)
+        {
+            if (osize > small_max && nsize > small_max)
+                return m_realloc(ptr, nsize, m_user);
+            if (osize <= small_max && nsize <= small_max && size_class(osize) == size_class(nsize))
+                return ptr;
+        }
+        const auto new_ptr = allocate(nsize);
+        if (!new_ptr)
+        {
+            //  Lua expects shrinking to succeed: the old block is kept (out of memory only: a large block
+            //  then ends up on a small free list and is not returned until the process exits)
+            return nsize <= osize ? ptr : nullptr;
+        }
+        if (ptr)
+        {
+            memcpy(new_ptr, ptr, std::min(osize, nsize));
+            deallocate(ptr, osize);
+        }
+        return new_ptr;
+    }
+private:
+    static size_t size_class(const size_t size) noexcept
+    {
+        return (size - 1) / small_step;
+    }
+    void* allocate(const size_t size) noexcept
+    {
+        if (size > small_max)
+            return m_realloc(nullptr, size, m_user);
+
+        const auto index = size_class(size);
+        if (const auto ptr = m_free[index])
+        {
+            m_free[index] = *static_cast<void**>(ptr);
+            ++m_reused;
+            return ptr;
+        }
+        const auto bytes = (index + 1) * small_step;
+        if (m_next + bytes > m_end)
+        {
+            //  the first "small_step" bytes link the pages
+            const auto page = static_cast<uint8_t*>(m_realloc(nullptr, page_size, m_user));
+            if (!page)
+                return nullptr;
+            *reinterpret_cast<void**>(page) = m_page;
+            m_page = page;
+            ++m_pages;
+            m_next = page + small_step;
+            m_end = page + page_size;
+        }
+        const auto ptr = m_next;
+        m_next += bytes;
+        return ptr;
+    }
+    void deallocate(void* const ptr, const size_t size) noexcept
+    {
+        if (!ptr)
+            return;
+        if (size > small_max)
+        {
+            m_realloc(ptr, 0, m_user);
+            return;
+        }
+        const auto index = size_class(size);
+        *static_cast<void**>(ptr) = m_free[index];
+        m_free[index] = ptr;
+    }
+private:
+    const realloc_func m_realloc;
+    void* const m_user;
+    void* m_page = nullptr;
+    uint8_t* m_next = nullptr;
+    uint8_t* m_end = nullptr;
+    void* m_free[small_max / small_step] = {};
+    size_t m_pages = 0;
+    uint64_t m_reused = 0;     //  small blocks taken from a free list
+};
+
+//  compiled chunks (lua_dump output) by a 128-bit hash of chunk name and source.
+//  Split into shards by "hash128::hi", each with its own lock, slot table and LRU list;
+//  a shard evicts its least recently used chunks past "shard_capacity" chunks or "shard_bytes".
+class lua_cache_data
+{
+public:
+    enum : size_t
+    {
+        shard_count = 16,
+        shard_capacity = 256,
+        shard_bytes = 4_mb,
+    };
+    lua_cache_data(const realloc_func realloc, void* const user) noexcept : m_realloc(realloc), m_user(user)
+    {
+
+    }
+    error_type initialize() noexcept;
+    //  copies the chunk to "bytes" (the entry may be evicted once the lock is released)
+    bool find(const hash128& key, array<uint8_t>& bytes) noexcept;
+    error_type insert(const hash128& key, array<uint8_t>&& bytes) noexcept;
+    void stats(lua_system_stats& stats) const noexcept;
+private:
+    struct entry_type
+    {
+        hash128 key;
+        array<uint8_t> bytes;
+        uint32_t prev = UINT32_MAX;
+        uint32_t next = UINT32_MAX;
+    };
+    struct alignas(64) shard_type
+    {
+        mutable mutex lock;
+        array<entry_type> entries;
+        array<uint32_t> slots;  //  open addressing (linear probing) over "hash128::lo", UINT32_MAX is empty
+        array<uint32_t> free;   //  evicted entries
+        size_t bytes = 0;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+        uint32_t head = UINT32_MAX; //  most recently used
+        uint32_t tail = UINT32_MAX; //  least recently used
+    };
+    static size_t find_slot(const shard_type& shard, const hash128& key) noexcept;
+    static void erase_slot(shard_type& shard, size_t slot) noexcept;
+    static void unlink(shard_type& shard, const uint32_t index) noexcept;
+    static void link(shard_type& shard, const uint32_t index) noexcept;
+    shard_type& shard(const hash128& key) noexcept
+    {
+        return m_shards[key.hi % shard_count];
+    }
+private:
+    const realloc_func m_realloc;
+    void* const m_user;
+    shard_type m_shards[shard_count];
+};
+error_type lua_cache_data::initialize() noexcept
+{
+    for (auto&& shard : m_shards)
+    {
+        ICY_ERROR(shard.lock.initialize());
+        shard.entries = array<entry_type>(m_realloc, m_user);
+        shard.slots = array<uint32_t>(m_realloc, m_user);
+        shard.free = array<uint32_t>(m_realloc, m_user);
+        ICY_ERROR(shard.entries.reserve(shard_capacity));
+        ICY_ERROR(shard.free.reserve(shard_capacity));
+        ICY_ERROR(shard.slots.resize(2 * shard_capacity));
+        for (auto&& slot : shard.slots)
+            slot = UINT32_MAX;
+    }
+    return error_type();
+}
+bool lua_cache_data::find(const hash128& key, array<uint8_t>& bytes) noexcept
+{
+    auto& shard = this->shard(key);
+    ICY_LOCK_GUARD(shard.lock);
+    const auto index = shard.slots[find_slot(shard, key)];
+    if (index == UINT32_MAX)
+    {
+        ++shard.misses;
+        return false;
+    }
+    ++shard.hits;
+    unlink(shard, index);
+    link(shard, index);
+    const auto& entry = shard.entries[index];
+    bytes.clear();
+    return !bytes.append(entry.bytes.begin(), entry.bytes.end());
+}
+error_type lua_cache_data::insert(const hash128& key, array<uint8_t>&& bytes) noexcept
+{
+    if (bytes.empty() || bytes.size() > shard_bytes)
+        return error_type();
+
+    auto& shard = this->shard(key);
+    ICY_LOCK_GUARD(shard.lock);
+    if (shard.slots[find_slot(shard, key)] != UINT32_MAX)  //  compiled by another system meanwhile
+        return error_type();
+
+    while (shard.tail != UINT32_MAX && ((shard.free.empty() && shard.entries.size() == shard_capacity)
+        || shard.bytes + bytes.size() > shard_bytes))
+    {
+        const auto index = shard.tail;
+        auto& entry = shard.entries[index];
+        unlink(shard, index);
+        erase_slot(shard, find_slot(shard, entry.key));
+        shard.bytes -= entry.bytes.size();
+        entry.bytes = array<uint8_t>();
+        ++shard.evictions;
+        ICY_ERROR(shard.free.push_back(index));
+    }
+
+    auto index = UINT32_MAX;
+    if (shard.free.empty())
+    {
+        index = uint32_t(shard.entries.size());
+        ICY_ERROR(shard.entries.push_back(entry_type()));
+    }
+    else
+    {
+        index = shard.free.back();
+        shard.free.pop_back();
+    }
+    auto& entry = shard.entries[index];
+    entry.key = key;
+    shard.bytes += bytes.size();
+    entry.bytes = std::move(bytes);
+    shard.slots[find_slot(shard, key)] = index;
+    link(shard, index);
+    return error_type();
+}
+void lua_cache_data::stats(lua_system_stats& stats) const noexcept
+{
+    for (auto&& shard : m_shards)
+    {
+        ICY_LOCK_GUARD(shard.lock);
+        stats.cache_hits += shard.hits;
+        stats.cache_misses += shard.misses;
+        stats.cache_evictions += shard.evictions;
+        stats.cache_chunks += shard.entries.size() - shard.free.size();
+    }
+}
+size_t lua_cache_data::find_slot(const shard_type& shard, const hash128& key) noexcept
+{
+    //  the slot holding "key" or the empty slot that ends its probe sequence
+    const auto mask = shard.slots.size() - 1;
+    auto slot = size_t(key.lo) & mask;
+    while (shard.slots[slot] != UINT32_MAX && shard.entries[shard.slots[slot]].key != key)
+        slot = (slot + 1) & mask;
+    return slot;
+}
+void lua_cache_data::erase_slot(shard_type& shard, size_t slot) noexcept
+{
+    //  backward shift (see "crypto_session_cache::erase_slot")
+    const auto mask = shard.slots.size() - 1;
+    for (auto next = (slot + 1) & mask; shard.slots[next] != UINT32_MAX; next = (next + 1) & mask)
+    {
+        const auto home = size_t(shard.entries[shard.slots[next]].key.lo) & mask;
+        if (((next - home) & mask) >= ((next - slot) & mask))
+        {
+            shard.slots[slot] = shard.slots[next];
+            slot = next;
+        }
+    }
+    shard.slots[slot] = UINT32_MAX;
+}
+void lua_cache_data::unlink(shard_type& shard, const uint32_t index) noexcept
+{
+    auto& entry = shard.entries[index];
+    if (entry.prev != UINT32_MAX)
+        shard.entries[entry.prev].next = entry.next;
+    else
+        shard.head = entry.next;
+    if (entry.next != UINT32_MAX)
+        shard.entries[entry.next].prev = entry.prev;
+    else
+        shard.tail = entry.prev;
+    entry.prev = UINT32_MAX;
+    entry.next = UINT32_MAX;
+}
+void lua_cache_data::link(shard_type& shard, const uint32_t index) noexcept
+{
+    auto& entry = shard.entries[index];
+    entry.prev = UINT32_MAX;
+    entry.next = shard.head;
+    if (shard.head != UINT32_MAX)
+        shard.entries[shard.head].prev = index;
+    shard.head = index;
+    if (shard.tail == UINT32_MAX)
+        shard.tail = index;
+}
+
 class lua_system_data : public lua_system
 {
+    friend class lua_pool_data;
 public:
-    lua_system_data(const realloc_func realloc, void* const user) noexcept : m_realloc(realloc), m_user(user)
+    lua_system_data(const realloc_func realloc, void* const user, const shared_ptr<lua_cache_data>& cache) noexcept :
+        m_realloc(realloc), m_user(user), m_arena(realloc, user), m_cache(cache), m_chunk(realloc, user)
     {
 
     }
     ~lua_system_data() noexcept override
     {
+        //  preloaded library objects must let go of their tables before the state is closed
+        for (auto&& var : m_libraries)
+            var = lua_variable();
         if (m_state)
             lua_close(m_state);
     }
@@ -69,13 +410,15 @@ public:
     error_type destroy(lua_object_data* self) const LUA_NOEXCEPT;
     error_type find(const lua_object_data& object, const lua_variable& key, lua_variable& val) const LUA_NOEXCEPT;
     error_type insert(const lua_object_data& object, const lua_variable& key, const lua_variable& val) const LUA_NOEXCEPT;
-    error_type map(const lua_object_data& object, array<lua_variable>& keys, array<lua_variable>& vals) const LUA_NOEXCEPT;
+    error_type next(const lua_object_data& object, lua_variable& key, lua_variable& val) const LUA_NOEXCEPT;
     error_type exec(const lua_object_data& object, const const_array_view<lua_variable> input, array<lua_variable>* output) const LUA_NOEXCEPT;
     error_type meta(const lua_object_data& object, lua_variable& table) const LUA_NOEXCEPT;
     error_type debug(lua_object_data& object) const noexcept;
     void push(const lua_variable& var) const LUA_NOEXCEPT;
     void push(const lua_object_data& object) const LUA_NOEXCEPT;
     error_type to_value(const int index, lua_variable& var) const LUA_NOEXCEPT;
+    error_type snapshot() const LUA_NOEXCEPT;
+    error_type reset() const LUA_NOEXCEPT;
 private:   
     error_type parse(lua_variable& func, const string_view parse, const char* const name) const LUA_NOEXCEPT override;
     error_type global(lua_variable& var) const LUA_NOEXCEPT override;
@@ -86,6 +429,10 @@ private:
     error_type make_function(lua_variable& var, const lua_cfunction func, void* fdata) const LUA_NOEXCEPT override;
     error_type make_varfunction(lua_variable& var, const lua_cvarfunction func, const const_array_view<lua_variable> vars) const LUA_NOEXCEPT override;
     error_type make_library(lua_variable& var, const lua_default_library lib) const LUA_NOEXCEPT override;
+    error_type make_view(lua_variable& var, const const_array_view<uint8_t> bytes) const LUA_NOEXCEPT override;
+    error_type make_view(lua_variable& var, const const_matrix_view<color>& image) const LUA_NOEXCEPT override;
+    error_type make_view(lua_variable& var, const json& json) const LUA_NOEXCEPT override;
+    error_type make_view(lua_variable& var, const map<string, lua_variable>& map) const LUA_NOEXCEPT override;
     error_type copy(const lua_variable& src, lua_variable& dst) const LUA_NOEXCEPT override;
     error_type post_error(const string_view msg) const LUA_NOEXCEPT override;
     error_type print(const lua_variable& var, error_type(*pfunc)(void* pdata, const string_view str), void* const pdata) const LUA_NOEXCEPT override;
@@ -97,6 +444,14 @@ private:
     {
         return m_user;
     }
+    lua_system_stats stats() const noexcept override
+    {
+        lua_system_stats stats;
+        m_cache->stats(stats);
+        stats.arena_pages = m_arena.pages();
+        stats.arena_reused = m_arena.reused();
+        return stats;
+    }
 private:    
     template<typename func_type> error_type safe_call(const func_type& func, const bool only_safe = false) const LUA_NOEXCEPT
     {
@@ -107,13 +462,19 @@ private:
         return safe_call(proc, &func, only_safe);
     }
     error_type create(lua_variable& var, lua_object_init&& init) const LUA_NOEXCEPT;
+    error_type make_view(lua_variable& var, const lua_view_data& view) const LUA_NOEXCEPT;
     error_type print(int index, error_type(*func)(void* pdata, const string_view str), void* const pdata, const string_view tabs = ""_s) const LUA_NOEXCEPT;
     error_type safe_call(error_type(*func)(const void* const ptr), const void* const data, const bool only_safe) const LUA_NOEXCEPT;
+    void load(const string_view source, const char* const name) const LUA_NOEXCEPT;
 private:
     const realloc_func m_realloc;
     void* const m_user;
+    lua_arena m_arena;
     lua_State* m_state = nullptr;
     mutable bool m_safe = false;
+    mutable shared_ptr<lua_cache_data> m_cache;   //  shared, locked inside
+    mutable array<uint8_t> m_chunk;     //  "load" copies cached chunks here
+    lua_variable m_libraries[size_t(lua_default_library::_total)];  //  preloaded by "lua_pool_data"
 };
 class lua_object_data : public lua_object
 {
@@ -153,10 +514,10 @@ private:
             return ptr->insert(*this, key, val);
         return error_type();
     }
-    error_type map(array<lua_variable>& keys, array<lua_variable>& vals) LUA_NOEXCEPT override
+    error_type next(lua_variable& key, lua_variable& val) LUA_NOEXCEPT override
     {
         if (auto ptr = shared_ptr<lua_system_data>(m_system))
-            return ptr->map(*this, keys, vals);
+            return ptr->next(*this, key, val);
         return error_type();
     }
     error_type operator()(const const_array_view<lua_variable> input, array<lua_variable>* output) LUA_NOEXCEPT
@@ -197,17 +558,9 @@ error_type lua_system_data::initialize() noexcept
 {
     const lua_Alloc lua_realloc = [](void* user, void* ptr, size_t osize, size_t nsize)
     {
-        if (nsize == 0 || nsize > osize)
-        {
-            const auto self = static_cast<lua_system_data*>(user);
-            return self->m_realloc(ptr, nsize, self->m_user);
-        }
-        else
-        {
-            return ptr;
-        }
+        return static_cast<lua_arena*>(user)->realloc(ptr, ptr ? osize : 0, nsize);
     };
-    m_state = lua_newstate(lua_realloc, this);
+    m_state = lua_newstate(lua_realloc, &m_arena);
     if (!m_state)
         return make_stdlib_error(std::errc::not_enough_memory);
     return error_type();
@@ -274,42 +627,60 @@ error_type lua_system_data::insert(const lua_object_data& object, const lua_vari
             return make_stdlib_error(std::errc::not_enough_memory);
 
         push(object);
+        ICY_SCOPE_EXIT{ lua_pop(lua, 1); };
+        if (luaL_testudata(lua, -1, lua_view_meta))     //  views are read-only
+            return make_stdlib_error(std::errc::operation_not_permitted);
+
         push(key);
         push(val);
         lua_settable(lua, -3);
-        lua_pop(lua, 1);
         return error_type();
     };
     return safe_call(proc);
 }
-error_type lua_system_data::map(const lua_object_data& object, array<lua_variable>& keys, array<lua_variable>& vals) const LUA_NOEXCEPT
+error_type lua_system_data::next(const lua_object_data& object, lua_variable& key, lua_variable& val) const LUA_NOEXCEPT
 {
     const auto proc = [&]
     {
         const auto lua = m_state;
-        if (!lua_checkstack(lua, 3))
+        if (!lua_checkstack(lua, 5))
             return make_stdlib_error(std::errc::not_enough_memory);
 
-        keys = array<lua_variable>(m_realloc, m_user);
-        vals = array<lua_variable>(m_realloc, m_user);
-
-        push(object);
+        push(object);                           //  table
         ICY_SCOPE_EXIT{ lua_pop(lua, 1); };
-
-        lua_pushnil(lua);
-        while (lua_next(lua, -2))
-        {
-            auto success = false;
-            ICY_SCOPE_EXIT{ if (!success) lua_pop(lua, 2); };
-            lua_variable key;
-            lua_variable val;
-            ICY_ERROR(to_value(-2, key));
-            ICY_ERROR(to_value(-1, val));
-            ICY_ERROR(keys.push_back(std::move(key)));
-            ICY_ERROR(vals.push_back(std::move(val)));
-            success = true;
-            lua_pop(lua, 1);
+        if (luaL_testudata(lua, -1, lua_view_meta))
+        {
+            //  the view "__pairs" iterator is stateless: ask for it again on every step
+            luaL_getmetafield(lua, -1, "__pairs");  //  view; pairs
+            lua_pushvalue(lua, -2);                 //  view; pairs; view
+            lua_call(lua, 1, 2);                    //  view; next; view
+            push(key);                              //  view; next; view; key
+            lua_call(lua, 2, 2);                    //  view; ?next_key; ?next_val
+            if (::lua_type(lua, -2) == LUA_TNIL)
+            {
+                lua_pop(lua, 2);
+                key = lua_variable();
+                val = lua_variable();
+                return error_type();
+            }
         }
+        else if (::lua_type(lua, -1) != LUA_TTABLE)
+        {
+            return make_stdlib_error(std::errc::invalid_argument);
+        }
+        else
+        {
+            push(key);                          //  table; key
+            if (!lua_next(lua, -2))             //  table; ?next_key; ?next_val
+            {
+                key = lua_variable();
+                val = lua_variable();
+                return error_type();
+            }
+        }
+        ICY_SCOPE_EXIT{ lua_pop(lua, 2); };
+        ICY_ERROR(to_value(-2, key));
+        ICY_ERROR(to_value(-1, val));
         return error_type();
     };
     return safe_call(proc);
@@ -388,7 +759,7 @@ error_type lua_system_data::debug(lua_object_data& object) const noexcept
             {
                 object.m_name = string(m_realloc, m_user);
                 return object.m_name.appendf("%1..%2 %3"_s, debug.linedefined,
-                    debug.lastlinedefined, string_view(debug.source, strlen(debug.source)));                
+                    debug.lastlinedefined, string_view(debug.source, strlen(debug.source), string_view::constexpr_tag()));                
             }
         }
         return error_type();
@@ -498,7 +869,7 @@ error_type lua_system_data::to_value(const int index, lua_variable& var) const L
         auto len = 0_z;
         auto ptr = lua_tolstring(lua, index, &len);
         string str(m_realloc, m_user);
-        ICY_ERROR(icy::copy(string_view(ptr, len), str));
+        ICY_ERROR(icy::copy(string_view(ptr, len, string_view::constexpr_tag()), str));
         var = std::move(str);
         break;
     }
@@ -547,6 +918,13 @@ error_type lua_system_data::to_value(const int index, lua_variable& var) const L
     }
     case LUA_TUSERDATA:
     {
+        if (luaL_testudata(lua, index, lua_view_meta))
+        {
+            auto init = lua_object_init(lua_object_init::type::unknown);
+            init.index = index;
+            ICY_ERROR(create(var, std::move(init)));
+            break;
+        }
         const auto ptr = static_cast<const uint8_t*>(lua_touserdata(lua, index));
         const auto len = lua_rawlen(lua, index);
         array<uint8_t> vec(m_realloc, m_user);
@@ -590,7 +968,7 @@ error_type lua_system_data::make_print(lua_variable& var, error_type(*pfunc)(arr
 
     array<lua_variable> vec_vars;
     ICY_ERROR(vec_vars.push_back(this));
-    ICY_ERROR(vec_vars.push_back(pfunc));
+    ICY_ERROR(vec_vars.push_back(reinterpret_cast<const void*>(pfunc)));
     for (auto&& var : pvars)
     {
         lua_variable copy_var;
@@ -616,7 +994,7 @@ error_type lua_system_data::make_print(lua_variable& var, error_type(*pfunc)(arr
                 
                 error_type error;
                 if (&var != input.data()) error = str.append(", "_s);
-                if (!error) error = error = str.append(string_view(ptr, len));
+                if (!error) error = error = str.append(string_view(ptr, len, string_view::constexpr_tag()));
                 lua_pop(lua, 2);
                 ICY_ERROR(error);
             }
@@ -682,9 +1060,13 @@ error_type lua_system_data::make_varfunction(lua_variable& var, const lua_cvarfu
 }
 error_type lua_system_data::make_library(lua_variable& var, const lua_default_library lib) const LUA_NOEXCEPT
 {
-    if (lib == lua_default_library::none)
+    if (lib == lua_default_library::none || lib >= lua_default_library::_total)
         return make_stdlib_error(std::errc::invalid_argument);
 
+    const auto& preloaded = m_libraries[size_t(lib)];
+    if (preloaded.type() != lua_type::none)
+        return copy(preloaded, var);
+
     const auto proc = [&]
     {
         lua_object_init init(lua_object_init::type::library);
@@ -693,6 +1075,312 @@ error_type lua_system_data::make_library(lua_variable& var, const lua_default_li
     };
     return safe_call(proc);
 }
+
+static void lua_view_push(lua_State* const lua, const lua_view_data& view);
+static size_t lua_view_size(const lua_view_data& view) noexcept
+{
+    switch (view.kind)
+    {
+    case lua_view_data::kind_type::bytes:
+        return view.size;
+    case lua_view_data::kind_type::image:
+        return view.image.size();
+    case lua_view_data::kind_type::json:
+        return static_cast<const json*>(view.data)->size();
+    case lua_view_data::kind_type::map:
+        return static_cast<const map<string, lua_variable>*>(view.data)->size();
+    }
+    return 0;
+}
+static void lua_view_push_json(lua_State* const lua, const json& value)
+{
+    switch (value.type())
+    {
+    case json_type::boolean:
+    {
+        auto boolean = false;
+        value.get(boolean);
+        lua_pushboolean(lua, boolean);
+        break;
+    }
+    case json_type::integer:
+    {
+        auto integer = int64_t();
+        value.get(integer);
+        lua_pushinteger(lua, lua_Integer(integer));
+        break;
+    }
+    case json_type::floating:
+    {
+        auto number = 0.0;
+        value.get(number);
+        lua_pushnumber(lua, number);
+        break;
+    }
+    case json_type::string:
+    {
+        const auto str = value.get();
+        lua_pushlstring(lua, str.bytes().data(), str.bytes().size());
+        break;
+    }
+    case json_type::array:
+    case json_type::object:
+    {
+        lua_view_data view;
+        view.kind = lua_view_data::kind_type::json;
+        view.data = &value;
+        lua_view_push(lua, view);
+        break;
+    }
+    default:
+        lua_pushnil(lua);
+        break;
+    }
+}
+//  sorted keys of json objects and maps (empty for views indexed 1..n)
+static const_array_view<string> lua_view_keys(const lua_view_data& view) noexcept
+{
+    if (view.kind == lua_view_data::kind_type::json)
+        return static_cast<const json*>(view.data)->keys();
+    else if (view.kind == lua_view_data::kind_type::map)
+        return static_cast<const map<string, lua_variable>*>(view.data)->keys();
+    return const_array_view<string>();
+}
+//  "index" is 0-based and in range
+static void lua_view_push_key(lua_State* const lua, const lua_view_data& view, const size_t index)
+{
+    const auto keys = lua_view_keys(view);
+    if (keys.empty())
+        lua_pushinteger(lua, lua_Integer(index + 1));
+    else
+        lua_pushlstring(lua, keys[index].bytes().data(), keys[index].bytes().size());
+}
+static void lua_view_push_value(lua_State* const lua, const lua_view_data& view, const size_t index)
+{
+    switch (view.kind)
+    {
+    case lua_view_data::kind_type::bytes:
+        lua_pushinteger(lua, static_cast<const uint8_t*>(view.data)[index]);
+        break;
+    case lua_view_data::kind_type::image:
+        lua_pushinteger(lua, view.image.at(index / view.image.cols(), index % view.image.cols()).bgra);
+        break;
+    case lua_view_data::kind_type::json:
+        lua_view_push_json(lua, static_cast<const json*>(view.data)->vals()[index]);
+        break;
+    case lua_view_data::kind_type::map:
+        view.system->push(static_cast<const map<string, lua_variable>*>(view.data)->vals()[index]);
+        break;
+    }
+}
+static int lua_view_sub(lua_State* lua)
+{
+    const auto& view = *static_cast<const lua_view_data*>(luaL_checkudata(lua, 1, lua_view_meta));
+    luaL_argcheck(lua, view.kind == lua_view_data::kind_type::bytes, 1, "byte view expected");
+    const auto first = luaL_optinteger(lua, 2, 1);
+    const auto last = luaL_optinteger(lua, 3, lua_Integer(view.size));
+    luaL_argcheck(lua, first >= 1 && size_t(first) <= view.size + 1, 2, "out of range");
+    luaL_argcheck(lua, last >= first - 1 && size_t(last) <= view.size, 3, "out of range");
+    lua_pushlstring(lua, static_cast<const char*>(view.data) + first - 1, size_t(last - first + 1));
+    return 1;
+}
+static int lua_view_get(lua_State* lua)
+{
+    const auto& view = *static_cast<const lua_view_data*>(luaL_checkudata(lua, 1, lua_view_meta));
+    luaL_argcheck(lua, view.kind == lua_view_data::kind_type::image, 1, "image view expected");
+    const auto x = luaL_checkinteger(lua, 2);
+    const auto y = luaL_checkinteger(lua, 3);
+    luaL_argcheck(lua, x >= 1 && size_t(x) <= view.image.cols(), 2, "out of range");
+    luaL_argcheck(lua, y >= 1 && size_t(y) <= view.image.rows(), 3, "out of range");
+    const auto& value = view.image.at(size_t(y - 1), size_t(x - 1));
+    lua_pushinteger(lua, value.r);
+    lua_pushinteger(lua, value.g);
+    lua_pushinteger(lua, value.b);
+    lua_pushinteger(lua, value.a);
+    return 4;
+}
+static int lua_view_index(lua_State* lua)
+{
+    const auto& view = *static_cast<const lua_view_data*>(luaL_checkudata(lua, 1, lua_view_meta));
+    const auto keyed = view.kind == lua_view_data::kind_type::map ||
+        view.kind == lua_view_data::kind_type::json && static_cast<const json*>(view.data)->type() == json_type::object;
+
+    if (::lua_type(lua, 2) == LUA_TNUMBER)
+    {
+        auto is_integer = 0;
+        const auto index = lua_tointegerx(lua, 2, &is_integer);
+        if (!keyed && is_integer && index >= 1 && size_t(index) <= lua_view_size(view))
+            lua_view_push_value(lua, view, size_t(index - 1));
+        else
+            lua_pushnil(lua);
+        return 1;
+    }
+    auto len = 0_z;
+    const auto ptr = lua_tolstring(lua, 2, &len);
+    if (!ptr)
+    {
+        lua_pushnil(lua);
+        return 1;
+    }
+    const auto key = string_view(ptr, len, string_view::constexpr_tag());
+    switch (view.kind)
+    {
+    case lua_view_data::kind_type::bytes:
+        if (key == "sub"_s)
+        {
+            lua_pushcfunction(lua, lua_view_sub);
+            return 1;
+        }
+        break;
+    case lua_view_data::kind_type::image:
+        if (key == "width"_s)
+        {
+            lua_pushinteger(lua, lua_Integer(view.image.cols()));
+            return 1;
+        }
+        else if (key == "height"_s)
+        {
+            lua_pushinteger(lua, lua_Integer(view.image.rows()));
+            return 1;
+        }
+        else if (key == "get"_s)
+        {
+            lua_pushcfunction(lua, lua_view_get);
+            return 1;
+        }
+        break;
+    case lua_view_data::kind_type::json:
+        if (const auto value = static_cast<const json*>(view.data)->find(key))
+        {
+            lua_view_push_json(lua, *value);
+            return 1;
+        }
+        break;
+    case lua_view_data::kind_type::map:
+        if (const auto value = static_cast<const map<string, lua_variable>*>(view.data)->try_find(key))
+        {
+            view.system->push(*value);
+            return 1;
+        }
+        break;
+    }
+    lua_pushnil(lua);
+    return 1;
+}
+static int lua_view_len(lua_State* lua)
+{
+    const auto& view = *static_cast<const lua_view_data*>(luaL_checkudata(lua, 1, lua_view_meta));
+    lua_pushinteger(lua, lua_Integer(lua_view_size(view)));
+    return 1;
+}
+//  stateless iterator (like "next"): the position comes from the previous key, a binary search
+//  for json objects and maps, so "lua_system_data::next" can resume from any key
+static int lua_view_next(lua_State* lua)
+{
+    const auto& view = *static_cast<const lua_view_data*>(luaL_checkudata(lua, 1, lua_view_meta));
+    lua_settop(lua, 2);
+
+    auto index = 0_z;
+    if (::lua_type(lua, 2) != LUA_TNIL)
+    {
+        const auto keys = lua_view_keys(view);
+        if (keys.empty())
+        {
+            auto is_integer = 0;
+            const auto key = lua_tointegerx(lua, 2, &is_integer);
+            luaL_argcheck(lua, is_integer && key >= 1 && size_t(key) <= lua_view_size(view), 2, "invalid key to 'next'");
+            index = size_t(key);
+        }
+        else
+        {
+            auto len = 0_z;
+            const auto ptr = ::lua_type(lua, 2) == LUA_TSTRING ? lua_tolstring(lua, 2, &len) : nullptr;
+            const auto it = ptr ? binary_search(keys.begin(), keys.end(), string_view(ptr, len, string_view::constexpr_tag())) : keys.end();
+            luaL_argcheck(lua, it != keys.end(), 2, "invalid key to 'next'");
+            index = size_t(it - keys.begin()) + 1;
+        }
+    }
+    if (index >= lua_view_size(view))
+    {
+        lua_pushnil(lua);
+        return 1;
+    }
+    lua_view_push_key(lua, view, index);
+    lua_view_push_value(lua, view, index);
+    return 2;
+}
+static int lua_view_pairs(lua_State* lua)
+{
+    luaL_checkudata(lua, 1, lua_view_meta);
+    lua_pushcfunction(lua, lua_view_next);      //  next
+    lua_pushvalue(lua, 1);                      //  next; view
+    lua_pushnil(lua);                           //  next; view; nil
+    return 3;
+}
+void lua_view_push(lua_State* const lua, const lua_view_data& view)
+{
+    const auto ptr = lua_newuserdata(lua, sizeof(lua_view_data));   //  view
+    new (ptr) lua_view_data(view);
+    if (luaL_newmetatable(lua, lua_view_meta))  //  view; meta
+    {
+        lua_pushcfunction(lua, lua_view_index);
+        lua_setfield(lua, -2, "__index");
+        lua_pushcfunction(lua, lua_view_len);
+        lua_setfield(lua, -2, "__len");
+        lua_pushcfunction(lua, lua_view_pairs);
+        lua_setfield(lua, -2, "__pairs");
+    }
+    lua_setmetatable(lua, -2);                  //  view
+}
+error_type lua_system_data::make_view(lua_variable& var, const lua_view_data& view) const LUA_NOEXCEPT
+{
+    const auto proc = [&]
+    {
+        const auto lua = m_state;
+        if (!lua_checkstack(lua, 4))
+            return make_stdlib_error(std::errc::not_enough_memory);
+
+        lua_view_push(lua, view);
+        ICY_SCOPE_EXIT{ lua_pop(lua, 1); };
+        lua_object_init init(lua_object_init::type::unknown);
+        init.index = -1;
+        return create(var, std::move(init));
+    };
+    return safe_call(proc);
+}
+error_type lua_system_data::make_view(lua_variable& var, const const_array_view<uint8_t> bytes) const LUA_NOEXCEPT
+{
+    lua_view_data view;
+    view.kind = lua_view_data::kind_type::bytes;
+    view.data = bytes.data();
+    view.size = bytes.size();
+    return make_view(var, view);
+}
+error_type lua_system_data::make_view(lua_variable& var, const const_matrix_view<color>& image) const LUA_NOEXCEPT
+{
+    lua_view_data view;
+    view.kind = lua_view_data::kind_type::image;
+    view.image = image;
+    return make_view(var, view);
+}
+error_type lua_system_data::make_view(lua_variable& var, const json& json) const LUA_NOEXCEPT
+{
+    if (json.type() != json_type::array && json.type() != json_type::object)
+        return make_stdlib_error(std::errc::invalid_argument);
+
+    lua_view_data view;
+    view.kind = lua_view_data::kind_type::json;
+    view.data = &json;
+    return make_view(var, view);
+}
+error_type lua_system_data::make_view(lua_variable& var, const map<string, lua_variable>& map) const LUA_NOEXCEPT
+{
+    lua_view_data view;
+    view.kind = lua_view_data::kind_type::map;
+    view.data = &map;
+    view.system = this;
+    return make_view(var, view);
+}
 error_type lua_system_data::copy(const lua_variable& src, lua_variable& dst) const LUA_NOEXCEPT
 {
     switch (src.type())
@@ -791,7 +1479,7 @@ error_type lua_system_data::create(lua_variable& var, lua_object_init&& init) co
         {
             type = lua_type::function;
         }
-        else
+        else if (!luaL_testudata(lua, abs, lua_view_meta))  //  views are indexed like tables
         {
             return make_stdlib_error(std::errc::invalid_argument);
         }
@@ -932,8 +1620,7 @@ error_type lua_system_data::create(lua_variable& var, lua_object_init&& init) co
         {
             type = lua_type::function;
             lua_pushstring(lua, "__call");          //  new_object; table; meta; "__call"
-            if (const auto code = luaL_loadbufferx(lua, init.parse.bytes().data(), init.parse.bytes().size(), init.name, "t"))
-                lua_error(lua);
+            load(init.parse, init.name);
                                             //  new_object; table; meta; "__call"; lua_script; 
             lua_createtable(lua, 0, 0);     //  new_object; table; meta; "__call"; lua_script; env
             lua_pushstring(lua, "_G");      //  new_object; table; meta; "__call"; lua_script; env; "_G"
@@ -992,7 +1679,7 @@ error_type lua_system_data::print(int index, error_type(*func)(void* pdata, cons
     {
         auto len = 0_z;
         auto ptr = lua_tolstring(lua, index, &len);
-        ICY_ERROR(func(pdata, string_view(ptr, len)));
+        ICY_ERROR(func(pdata, string_view(ptr, len, string_view::constexpr_tag())));
         break;
     }
     case LUA_TLIGHTUSERDATA:
@@ -1024,7 +1711,7 @@ error_type lua_system_data::print(int index, error_type(*func)(void* pdata, cons
             auto upvalue = 1u;
             while (auto ptr = lua_getupvalue(lua, index, upvalue++))
             {
-                const auto error = proc(tabs_str, string_view(ptr, strlen(ptr)), 0);
+                const auto error = proc(tabs_str, string_view(ptr, strlen(ptr), string_view::constexpr_tag()), 0);
                 lua_pop(lua, 1);
                 ICY_ERROR(error);
             }
@@ -1099,7 +1786,7 @@ error_type lua_system_data::safe_call(error_type(*func)(const void* const ptr),
     const auto lua = m_state;
     const auto lua_proc = [](lua_State* lua)
     {
-        const auto func = static_cast<error_type(*)(const void* const ptr)>(lua_touserdata(lua, lua_upvalueindex(1)));
+        const auto func = reinterpret_cast<error_type(*)(const void* const ptr)>(lua_touserdata(lua, lua_upvalueindex(1)));
         const auto data = lua_touserdata(lua, lua_upvalueindex(2));
         const auto system = static_cast<lua_system_data*>(lua_touserdata(lua, lua_upvalueindex(3)));
 
@@ -1140,7 +1827,7 @@ error_type lua_system_data::safe_call(error_type(*func)(const void* const ptr),
         lua_pushcclosure(lua, err_proc, 0);
         const auto err_index = lua_gettop(lua);
 
-        lua_pushlightuserdata(lua, func);
+        lua_pushlightuserdata(lua, reinterpret_cast<void*>(func));
         lua_pushlightuserdata(lua, const_cast<void*>(data));
         lua_pushlightuserdata(lua, const_cast<lua_system_data*>(this));
         lua_pushcclosure(lua, lua_proc, 3);
@@ -1166,7 +1853,7 @@ error_type lua_system_data::safe_call(error_type(*func)(const void* const ptr),
         if (!lua_checkstack(lua, 3))
             return make_stdlib_error(std::errc::not_enough_memory);
 
-        lua_pushlightuserdata(lua, func);
+        lua_pushlightuserdata(lua, reinterpret_cast<void*>(func));
         lua_pushlightuserdata(lua, const_cast<void*>(data));
         lua_pushlightuserdata(lua, const_cast<lua_system_data*>(this));
         lua_pushcclosure(lua, lua_proc, 3);
@@ -1174,6 +1861,204 @@ error_type lua_system_data::safe_call(error_type(*func)(const void* const ptr),
     }
     return error_type();
 }
+void lua_system_data::load(const string_view source, const char* const name) const LUA_NOEXCEPT
+{
+    const auto lua = m_state;
+    const auto key = fast_hash128(source, name ? fast_hash64(name, strlen(name)) : 0);
+    if (m_cache->find(key, m_chunk))
+    {
+        if (luaL_loadbufferx(lua, reinterpret_cast<const char*>(m_chunk.data()), m_chunk.size(), name, "b"))
+            lua_error(lua);
+        return;
+    }
+    if (luaL_loadbufferx(lua, source.bytes().data(), source.bytes().size(), name, "t"))
+        lua_error(lua);
+
+    //  a chunk that could not be dumped or stored is compiled again next time
+    array<uint8_t> dump(m_realloc, m_user);
+    const auto writer = [](lua_State*, const void* ptr, size_t size, void* user)
+    {
+        const auto data = static_cast<const uint8_t*>(ptr);
+        return static_cast<array<uint8_t>*>(user)->append(data, data + size) ? 1 : 0;
+    };
+    if (lua_dump(lua, writer, &dump, 0) == 0)
+        m_cache->insert(key, std::move(dump));
+}
+
+//  keeps a shallow copy of the global table, "package.loaded" (when there is one) and every preloaded library table
+error_type lua_system_data::snapshot() const LUA_NOEXCEPT
+{
+    const auto proc = [&]
+    {
+        const auto lua = m_state;
+        if (!lua_checkstack(lua, 8))
+            return make_stdlib_error(std::errc::not_enough_memory);
+
+        const auto copy = [lua]
+        {                                       //  snapshot; table
+            lua_createtable(lua, 0, 0);         //  snapshot; table; copy
+            lua_pushnil(lua);                   //  snapshot; table; copy; nil
+            while (lua_next(lua, -3))           //  snapshot; table; copy; key; val
+            {
+                lua_pushvalue(lua, -2);         //  snapshot; table; copy; key; val; key
+                lua_insert(lua, -2);            //  snapshot; table; copy; key; key; val
+                lua_rawset(lua, -4);            //  snapshot; table; copy; key
+            }                                   //  snapshot; table; copy
+            lua_rawset(lua, -3);                //  snapshot
+        };
+        lua_createtable(lua, 0, 0);             //  snapshot
+        lua_pushglobaltable(lua);               //  snapshot; globals
+        copy();
+        if (lua_getfield(lua, LUA_REGISTRYINDEX, LUA_LOADED_TABLE) == LUA_TTABLE)
+            copy();
+        else
+            lua_pop(lua, 1);
+        for (auto&& var : m_libraries)
+        {
+            if (var.type() == lua_type::none)
+                continue;
+            push(var);                          //  snapshot; library
+            if (::lua_type(lua, -1) == LUA_TTABLE)
+                copy();
+            else
+                lua_pop(lua, 1);
+        }                                       //  snapshot
+        lua_setfield(lua, LUA_REGISTRYINDEX, lua_pool_meta);
+        return error_type();
+    };
+    return safe_call(proc);
+}
+//  puts back the fields "snapshot" copied: fields added since are removed, changed ones restored
+error_type lua_system_data::reset() const LUA_NOEXCEPT
+{
+    const auto proc = [&]
+    {
+        const auto lua = m_state;
+        if (!lua_checkstack(lua, 8))
+            return make_stdlib_error(std::errc::not_enough_memory);
+
+        if (lua_getfield(lua, LUA_REGISTRYINDEX, lua_pool_meta) != LUA_TTABLE)
+        {
+            lua_pop(lua, 1);
+            return error_type();
+        }                                       //  snapshot
+        lua_pushnil(lua);                       //  snapshot; nil
+        while (lua_next(lua, -2))               //  snapshot; table; copy
+        {
+            //  clearing a field during traversal is allowed
+            lua_pushnil(lua);                   //  snapshot; table; copy; nil
+            while (lua_next(lua, -3))           //  snapshot; table; copy; key; val
+            {
+                lua_pop(lua, 1);                //  snapshot; table; copy; key
+                lua_pushvalue(lua, -1);         //  snapshot; table; copy; key; key
+                if (lua_rawget(lua, -3) == LUA_TNIL)
+                {                               //  snapshot; table; copy; key; nil
+                    lua_pushvalue(lua, -2);     //  snapshot; table; copy; key; nil; key
+                    lua_insert(lua, -2);        //  snapshot; table; copy; key; key; nil
+                    lua_rawset(lua, -5);        //  snapshot; table; copy; key
+                }
+                else
+                {
+                    lua_pop(lua, 1);            //  snapshot; table; copy; key
+                }
+            }                                   //  snapshot; table; copy
+            lua_pushnil(lua);                   //  snapshot; table; copy; nil
+            while (lua_next(lua, -2))           //  snapshot; table; copy; key; val
+            {
+                lua_pushvalue(lua, -2);         //  snapshot; table; copy; key; val; key
+                lua_insert(lua, -2);            //  snapshot; table; copy; key; key; val
+                lua_rawset(lua, -5);            //  snapshot; table; copy; key
+            }                                   //  snapshot; table; copy
+            lua_pop(lua, 1);                    //  snapshot; table
+        }                                       //  snapshot
+        lua_pop(lua, 1);                        //  -
+        return error_type();
+    };
+    return safe_call(proc);
+}
+
+class lua_pool_data : public lua_pool
+{
+public:
+    lua_pool_data(const realloc_func realloc, void* const user) noexcept : 
+        m_realloc(realloc), m_user(user), m_libraries(realloc, user), m_idle(realloc, user)
+    {
+
+    }
+    error_type initialize(const const_array_view<lua_default_library> libraries, const size_t size) noexcept;
+    error_type checkout(shared_ptr<lua_system>& system) noexcept override;
+    error_type checkin(shared_ptr<lua_system>&& system) noexcept override;
+private:
+    error_type create(shared_ptr<lua_system_data>& system) const noexcept;
+private:
+    const realloc_func m_realloc;
+    void* const m_user;
+    shared_ptr<lua_cache_data> m_cache;
+    array<lua_default_library> m_libraries;
+    mutex m_lock;
+    array<shared_ptr<lua_system_data>> m_idle;
+};
+error_type lua_pool_data::initialize(const const_array_view<lua_default_library> libraries, const size_t size) noexcept
+{
+    ICY_ERROR(m_lock.initialize());
+    ICY_ERROR(make_shared(m_cache, m_realloc, m_user));
+    ICY_ERROR(m_cache->initialize());
+    for (auto&& lib : libraries)
+    {
+        if (lib == lua_default_library::none || lib >= lua_default_library::_total)
+            return make_stdlib_error(std::errc::invalid_argument);
+        ICY_ERROR(m_libraries.push_back(lib));
+    }
+    ICY_ERROR(m_idle.reserve(size));
+    for (auto k = 0_z; k < size; ++k)
+    {
+        shared_ptr<lua_system_data> system;
+        ICY_ERROR(create(system));
+        ICY_ERROR(m_idle.push_back(std::move(system)));
+    }
+    return error_type();
+}
+error_type lua_pool_data::checkout(shared_ptr<lua_system>& system) noexcept
+{
+    {
+        ICY_LOCK_GUARD(m_lock);
+        if (!m_idle.empty())
+        {
+            system = std::move(m_idle.back());
+            m_idle.pop_back();
+            return error_type();
+        }
+    }
+    shared_ptr<lua_system_data> new_system;
+    ICY_ERROR(create(new_system));
+    system = std::move(new_system);
+    return error_type();
+}
+error_type lua_pool_data::checkin(shared_ptr<lua_system>&& system) noexcept
+{
+    shared_ptr<lua_system_data> ptr = std::move(system);
+    if (!ptr || ptr->m_cache.get() != m_cache.get())
+        return make_stdlib_error(std::errc::invalid_argument);
+
+    ICY_ERROR(ptr->reset());
+    ICY_LOCK_GUARD(m_lock);
+    return m_idle.push_back(std::move(ptr));
+}
+error_type lua_pool_data::create(shared_ptr<lua_system_data>& system) const noexcept
+{
+    shared_ptr<lua_system_data> new_system;
+    ICY_ERROR(make_shared(new_system, m_realloc, m_user, m_cache));
+    ICY_ERROR(new_system->initialize());
+    for (auto&& lib : m_libraries)
+    {
+        auto& var = new_system->m_libraries[size_t(lib)];
+        if (var.type() == lua_type::none)
+            ICY_ERROR(new_system->make_library(var, lib));
+    }
+    ICY_ERROR(new_system->snapshot());
+    system = std::move(new_system);
+    return error_type();
+}
 
 static error_type lua_error_to_string(unsigned int code, string_view locale, string& str) noexcept
 {
@@ -1214,13 +2099,13 @@ string_view icy::to_string(const lua_default_library lib) noexcept
     default:
         break;
     }
-    return ptr ? string_view(ptr, strlen(ptr)) : string_view();
+    return ptr ? string_view(ptr, strlen(ptr), string_view::constexpr_tag()) : string_view();
 }
 error_type icy::lua_error_to_string(const error_type& error, string& msg) noexcept
 {
     if (error.message)
     {
-        auto error_msg = string_view(static_cast<const char*>(error.message->data()), error.message->size());
+        auto error_msg = string_view(static_cast<const char*>(error.message->data()), error.message->size(), string_view::constexpr_tag());
         array<string_view> lines;
         ICY_ERROR(split(error_msg, lines, "\r\n"_s));
 
@@ -1252,12 +2137,28 @@ error_type icy::create_lua_system(shared_ptr<lua_system>& system, realloc_func r
     if (!realloc)
         realloc = icy::global_realloc;
 
+    shared_ptr<lua_cache_data> cache;
+    ICY_ERROR(make_shared(cache, realloc, user));
+    ICY_ERROR(cache->initialize());
+
     shared_ptr<lua_system_data> new_ptr;
-    ICY_ERROR(make_shared(new_ptr, realloc, user));
+    ICY_ERROR(make_shared(new_ptr, realloc, user, cache));
     ICY_ERROR(new_ptr->initialize());
     system = std::move(new_ptr);
     return error_type();
 }
+error_type icy::create_lua_pool(shared_ptr<lua_pool>& pool, const const_array_view<lua_default_library> libraries,
+    const size_t size, realloc_func realloc, void* const user) noexcept
+{
+    if (!realloc)
+        realloc = icy::global_realloc;
+
+    shared_ptr<lua_pool_data> new_ptr;
+    ICY_ERROR(make_shared(new_ptr, realloc, user));
+    ICY_ERROR(new_ptr->initialize(libraries, size));
+    pool = std::move(new_ptr);
+    return error_type();
+}
 
 const char* icy::lua_keywords = "and break do else elseif end false for function goto"
 " if in local nil not or repeat return then true until while";
\ No newline at end of file
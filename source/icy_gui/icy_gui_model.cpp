@@ -1,45 +1,185 @@
 #include "icy_gui_model.hpp"
 #include "icy_gui_system.hpp"
+#include <icy_engine/core/icy_hash.hpp>
 
 using namespace icy;
 
-error_type gui_node_data::insert(map<uint32_t, unique_ptr<gui_node_data>>& data, const uint32_t parent, const uint32_t index, const child_type& args) noexcept
+error_type gui_node_pool::initialize() noexcept
 {
-    auto it = data.find(parent);
-    auto& children = it->value->children;
-    
-    unique_ptr<gui_node_data> new_node;
-    ICY_ERROR(make_unique(gui_node_data(it->value.get(), index), new_node));
-    ICY_ERROR(children.reserve(children.size() + 1));
-    ICY_ERROR(data.reserve(data.size() + 1));
-    ICY_ERROR(children.insert(new_node.get(), args));
-    ICY_ERROR(data.insert(index, std::move(new_node)));
+    *this = gui_node_pool();
+    ICY_ERROR(resize(1));
+    m_parent[0] = npos;
+    m_state[0] = gui_node_state::_default;
+    m_size = 1;
+    return error_type();
+}
+size_t gui_node_pool::memory() const noexcept
+{
+    const auto slot_size = 6 * sizeof(uint32_t) + sizeof(child_type) + sizeof(gui_node_state);
+    const auto sparse = m_user.size() + m_row_header.size() + m_col_header.size();
+    return m_index.capacity() * slot_size + m_data.capacity() * sizeof(gui_variant) + sparse * (sizeof(uint32_t) + sizeof(gui_variant));
+}
+error_type gui_node_pool::resize(const size_t size) noexcept
+{
+    const auto offset = m_index.size();
+    ICY_ERROR(m_index.resize(size));
+    ICY_ERROR(m_parent.resize(size));
+    ICY_ERROR(m_first.resize(size));
+    ICY_ERROR(m_last.resize(size));
+    ICY_ERROR(m_next.resize(size));
+    ICY_ERROR(m_prev.resize(size));
+    ICY_ERROR(m_child.resize(size));
+    ICY_ERROR(m_state.resize(size));
+    ICY_ERROR(m_data.resize(size));
+    for (auto k = offset; k < size; ++k)
+    {
+        m_index[k] = uint32_t(k);
+        m_parent[k] = npos - 1;
+        m_first[k] = m_last[k] = m_next[k] = m_prev[k] = npos;
+    }
     return error_type();
 }
-void gui_node_data::erase(map<uint32_t, unique_ptr<gui_node_data>>& data, const uint32_t index) noexcept
+error_type gui_node_pool::insert(const uint32_t parent, const uint32_t index, const child_type& args) noexcept
+{
+    const auto k = slot(index);
+    if (!valid(parent) || k == 0)
+        return make_stdlib_error(std::errc::invalid_argument);
+    if (k >= m_index.size())
+    {
+        ICY_ERROR(resize(k + 1));
+    }
+    if (m_index[k] != index || m_parent[k] != npos - 1)
+        return make_stdlib_error(std::errc::invalid_argument);
+
+    const auto p = slot(parent);
+    m_parent[k] = p;
+    m_first[k] = m_last[k] = m_next[k] = npos;
+    m_prev[k] = m_last[p];
+    if (m_last[p] != npos)
+        m_next[m_last[p]] = k;
+    else
+        m_first[p] = k;
+    m_last[p] = k;
+    m_child[k] = args;
+    m_state[k] = gui_node_state::_default;
+    ++m_size;
+    return error_type();
+}
+error_type gui_node_pool::discard(const uint32_t index, array<uint32_t>& freed) noexcept
+{
+    const auto k = slot(index);
+    if (k == 0)
+        return make_stdlib_error(std::errc::invalid_argument);
+    if (k >= m_index.size())
+    {
+        ICY_ERROR(resize(k + 1));
+    }
+    if (m_index[k] != index || m_parent[k] != npos - 1)
+        return error_type();
+
+    ICY_ERROR(freed.push_back(m_index[k] = next_index(index)));
+    return error_type();
+}
+error_type gui_node_pool::erase(const uint32_t index, array<uint32_t>& freed) noexcept
+{
+    if (!valid(index))
+        return error_type();
+
+    const auto release = [this, &freed](const uint32_t k)
+    {
+        m_parent[k] = npos - 1;
+        m_first[k] = m_last[k] = m_next[k] = m_prev[k] = npos;
+        m_index[k] = next_index(m_index[k]);
+        m_data[k] = gui_variant();
+        for (auto sparse : { &m_user, &m_row_header, &m_col_header })
+        {
+            const auto it = sparse->find(k);
+            if (it != sparse->end())
+                sparse->erase(it);
+        }
+        --m_size;
+        return freed.push_back(m_index[k]);
+    };
+
+    if (index == 0)
+    {
+        ICY_ERROR(freed.reserve(freed.size() + m_size - 1));
+        for (auto k = 1u; k < m_index.size(); ++k)
+        {
+            if (m_parent[k] != npos - 1)
+                ICY_ERROR(release(k));
+        }
+        m_first[0] = m_last[0] = npos;
+        m_data[0] = gui_variant();
+        m_state[0] = gui_node_state::_default;
+        return error_type();
+    }
+
+    //  post-order walk without a stack: descend to a leaf, free it, resume from its parent
+    const auto root = slot(index);
+    auto k = root;
+    while (true)
+    {
+        while (m_first[k] != npos)
+            k = m_first[k];
+
+        const auto p = m_parent[k];
+        unlink(k);
+        ICY_ERROR(release(k));
+        if (k == root)
+            break;
+        k = p;
+    }
+    return error_type();
+}
+void gui_node_pool::unlink(const uint32_t k) noexcept
+{
+    const auto p = m_parent[k];
+    const auto prev = m_prev[k];
+    const auto next = m_next[k];
+    if (prev != npos)
+        m_next[prev] = next;
+    else
+        m_first[p] = next;
+    if (next != npos)
+        m_prev[next] = prev;
+    else
+        m_last[p] = prev;
+}
+const gui_variant& gui_node_pool::find(const map<uint32_t, gui_variant>& map, const uint32_t index) noexcept
+{
+    static const gui_variant empty;
+    if (const auto ptr = map.try_find(slot(index)))
+        return *ptr;
+    return empty;
+}
+error_type gui_node_pool::assign(map<uint32_t, gui_variant>& map, const uint32_t index, const gui_variant& value) noexcept
 {
-    auto it = data.find(index);
-    if (it != data.end())
+    const auto k = slot(index);
+    if (!value)
     {
-        auto ptr = std::move(it->value);
-        data.erase(it);
-        auto children = std::move(ptr->children);
-        for (auto&& pair : children)
-            erase(data, pair.key->index);
-        
-        auto& parent_children = ptr->parent->children;
-        auto jt = parent_children.find(ptr.get());
-        if (jt != parent_children.end())
-            parent_children.erase(jt);
+        const auto it = map.find(k);
+        if (it != map.end())
+            map.erase(it);
     }
+    else if (const auto ptr = map.try_find(k))
+    {
+        *ptr = value;
+    }
+    else
+    {
+        ICY_ERROR(map.insert(k, gui_variant(value)));
+    }
+    return error_type();
 }
-error_type gui_node_data::modify(const gui_node_prop prop, const gui_variant& value) noexcept
+error_type gui_node_pool::modify(const uint32_t index, const gui_node_prop prop, const gui_variant& value) noexcept
 {
+    const auto k = slot(index);
     auto state_flag = gui_node_state::none;
     switch (prop)
     {
     case gui_node_prop::data:
-        data = value;
+        m_data[k] = value;
         break;
 
     case gui_node_prop::enabled:
@@ -63,15 +203,15 @@ error_type gui_node_data::modify(const gui_node_prop prop, const gui_variant& va
         break;
     
     case gui_node_prop::user:
-        user = value;
+        ICY_ERROR(assign(m_user, index, value));
         break;
     
     case gui_node_prop::row_header:
-        row_header = value;
+        ICY_ERROR(assign(m_row_header, index, value));
         break;
 
     case gui_node_prop::col_header:
-        col_header = value;
+        ICY_ERROR(assign(m_col_header, index, value));
         break;
 
     default:
@@ -80,6 +220,7 @@ error_type gui_node_data::modify(const gui_node_prop prop, const gui_variant& va
 
     if (state_flag != gui_node_state::none)
     {
+        auto& state = m_state[k];
         auto flag = false;
         if (to_value(value, flag))
         {
@@ -99,6 +240,32 @@ error_type gui_node_data::modify(const gui_node_prop prop, const gui_variant& va
 
     return error_type();
 }
+gui_variant gui_node_pool::query(const uint32_t index, const gui_node_prop prop) const noexcept
+{
+    const auto state = m_state[slot(index)];
+    switch (prop)
+    {
+    case gui_node_prop::enabled:
+        return gui_node_state_isset(state, gui_node_state::enabled);
+    case gui_node_prop::selected:
+        return gui_node_state_isset(state, gui_node_state::selected);
+    case gui_node_prop::visible:
+        return gui_node_state_isset(state, gui_node_state::visible);
+    case gui_node_prop::checked:
+        return gui_node_state_isset(state, gui_node_state::checked);
+    case gui_node_prop::checkable:
+        return gui_node_state_isset(state, gui_node_state::checkable);
+    case gui_node_prop::data:
+        return data(index);
+    case gui_node_prop::user:
+        return user(index);
+    case gui_node_prop::row_header:
+        return row_header(index);
+    case gui_node_prop::col_header:
+        return col_header(index);
+    }
+    return gui_variant();
+}
 
 gui_model_data_usr::~gui_model_data_usr() noexcept
 {
@@ -106,6 +273,7 @@ gui_model_data_usr::~gui_model_data_usr() noexcept
     //    gui_model_event_type::clear(event);
     while (auto event = static_cast<gui_model_event_type*>(m_events_sys.pop()))
         gui_model_event_type::clear(event);
+    gui_model_event_type::clear(m_txn_event);
     if (auto system = shared_ptr<gui_system>(m_system))
         static_cast<gui_system_data*>(system.get())->wake();
 }
@@ -179,18 +347,14 @@ error_type gui_model_data_usr::modify(const gui_node node, const gui_node_prop p
     if (it == m_data.end())
         return error_type();*/
 
-    gui_model_event_type* new_event = nullptr;
-    ICY_ERROR(gui_model_event_type::make(new_event, gui_model_event_type::modify));
-    ICY_SCOPE_EXIT{ gui_model_event_type::clear(new_event); };
-
     //ICY_ERROR(it->value->modify(prop, value));
 
-    new_event->index = node.index;
-    new_event->prop = prop;
-    new_event->val = value;
-
-    notify(new_event);
-    return error_type();
+    gui_model_action action;
+    action.type = gui_model_action::modify;
+    action.index = node.index;
+    action.prop = prop;
+    action.val = value;
+    return append(std::move(action));
 }
 error_type gui_model_data_usr::insert(const gui_node parent, const uint32_t row, const uint32_t col, gui_node& node) noexcept
 {
@@ -210,148 +374,213 @@ error_type gui_model_data_usr::insert(const gui_node parent, const uint32_t row,
         }
     }*/
 
-    gui_node_data::child_type args;
+    gui_node_pool::child_type args;
     args.col = col;
     args.row = row;
-    //args.index = m_index;
     
-    gui_model_event_type* new_event = nullptr;
-    ICY_ERROR(gui_model_event_type::make(new_event, gui_model_event_type::create));
-    ICY_SCOPE_EXIT{ gui_model_event_type::clear(new_event); };
-
-    //ICY_ERROR(gui_node_data::insert(m_data, parent.index, m_index, args));
-
-    new_event->index = parent.index;
-    new_event->val = std::make_pair(m_index, args);
-    notify(new_event);
-    node.index = m_index++;
+    auto index = 0u;
+    ICY_ERROR(next_index(index));
+
+    gui_model_action action;
+    action.type = gui_model_action::create;
+    action.index = parent.index;
+    action.val = std::make_pair(index, args);
+    ICY_ERROR(append(std::move(action)));
+    
+    if (m_free.empty())
+        ++m_slot;
+    else
+        m_free.pop_back();
+    node.index = index;
     return error_type();
 }
 error_type gui_model_data_usr::destroy(const gui_node node) noexcept
 {
     //ICY_ERROR(update());
 
-    gui_model_event_type* new_event = nullptr;
-    ICY_ERROR(gui_model_event_type::make(new_event, gui_model_event_type::destroy));
-    new_event->index = node.index;
-    //gui_node_data::erase(m_data, node.index);
-    notify(new_event);
-    return error_type();
+    gui_model_action action;
+    action.type = gui_model_action::destroy;
+    action.index = node.index;
+    return append(std::move(action));
 }
-void gui_model_data_usr::notify(gui_model_event_type*& event) noexcept
+error_type gui_model_data_usr::begin() noexcept
 {
-    if (auto system = shared_ptr<gui_system>(m_system))
+    if (m_txn == 0)
     {
-        m_events_sys.push(event);
-        static_cast<gui_system_data*>(system.get())->wake();
+        ICY_ERROR(gui_model_event_type::make(m_txn_event, gui_model_action::none));
     }
-    event = nullptr;
+    ++m_txn;
+    return error_type();
 }
-gui_variant gui_model_data_usr::process(const gui_model_query_type& query) const noexcept
+error_type gui_model_data_usr::commit() noexcept
 {
-    switch (query.type)
-    {
-    case gui_model_query_type::index:
+    if (m_txn == 0)
+        return make_stdlib_error(std::errc::invalid_argument);
+    if (--m_txn)
+        return error_type();
+
+    m_txn_modify = array<txn_modify_type>();
+    m_txn_modify_size = 0;
+    if (m_txn_event->actions.empty())
+        gui_model_event_type::clear(m_txn_event);
+    else
+        notify(m_txn_event);
+    return error_type();
+}
+error_type gui_model_data_usr::append(gui_model_action&& action) noexcept
+{
+    if (m_txn == 0)
     {
-        if (query.node)
-            return query.node->index;
-        break;
+        gui_model_event_type* new_event = nullptr;
+        ICY_ERROR(gui_model_event_type::make(new_event, gui_model_action::none));
+        ICY_SCOPE_EXIT{ gui_model_event_type::clear(new_event); };
+        new_event->action = std::move(action);
+        notify(new_event);
+        return error_type();
     }
-    case gui_model_query_type::row:
-    case gui_model_query_type::col:
+
+    auto& actions = m_txn_event->actions;
+    ICY_ERROR(actions.reserve(actions.size() + 1));
+    const auto offset = uint32_t(actions.size());
+    if (action.type == gui_model_action::modify)
     {
-        if (query.node && query.node->parent)
+        const auto key = (uint64_t(action.index) << 32) | uint32_t(action.prop);
+        auto slot = 0_z;
+        ICY_ERROR(find_modify(key, slot));
+        auto& entry = m_txn_modify[slot];
+        if (entry.offset != UINT32_MAX)
         {
-            auto& children = query.node->parent->children;
-            auto it = children.find(query.node);
-            if (it != children.end())
+            //  "checked" also changes "checkable": those two must stay in call order
+            if (action.prop != gui_node_prop::checked && action.prop != gui_node_prop::checkable)
             {
-                switch (query.type)
-                {
-                case gui_model_query_type::index:
-                    return it->key->index;
-                case gui_model_query_type::row:
-                    return it->value.row;
-                case gui_model_query_type::col:
-                    return it->value.col;
-                }
+                actions[entry.offset].val = std::move(action.val);
+                return error_type();
             }
+            actions[entry.offset].type = gui_model_action::none;
         }
-        break;
+        else
+        {
+            entry.key = key;
+            ++m_txn_modify_size;
+        }
+        entry.offset = offset;
     }
-    case gui_model_query_type::qprop:
+    ICY_ERROR(actions.push_back(std::move(action)));
+    return error_type();
+}
+error_type gui_model_data_usr::find_modify(const uint64_t key, size_t& slot) noexcept
+{
+    if (2 * (m_txn_modify_size + 1) > m_txn_modify.size())
     {
-        if (query.node)
+        array<txn_modify_type> table;
+        ICY_ERROR(table.resize(std::max(64_z, 2 * m_txn_modify.size())));
+        const auto mask = table.size() - 1;
+        for (auto&& entry : m_txn_modify)
         {
-            switch (query.prop)
-            {
-            case gui_node_prop::visible:
-                return gui_node_state_isset(query.node->state, gui_node_state::visible);
-            case gui_node_prop::enabled:
-                return gui_node_state_isset(query.node->state, gui_node_state::enabled);
-            case gui_node_prop::checked:
-                return gui_node_state_isset(query.node->state, gui_node_state::checked);
-            case gui_node_prop::checkable:
-                return gui_node_state_isset(query.node->state, gui_node_state::selected);
-            case gui_node_prop::selected:
-                return gui_node_state_isset(query.node->state, gui_node_state::checkable);
-            case gui_node_prop::data:
-                return query.node->data;
-            case gui_node_prop::user:
-                return query.node->user;
-            }
+            if (entry.offset == UINT32_MAX)
+                continue;
+            auto k = size_t(hash_mix(entry.key)) & mask;
+            while (table[k].offset != UINT32_MAX)
+                k = (k + 1) & mask;
+            table[k] = entry;
         }
-        break;
-    }
+        m_txn_modify = std::move(table);
     }
-    return gui_variant();
+    const auto mask = m_txn_modify.size() - 1;
+    slot = size_t(hash_mix(key)) & mask;
+    while (m_txn_modify[slot].offset != UINT32_MAX && m_txn_modify[slot].key != key)
+        slot = (slot + 1) & mask;
+    return error_type();
 }
+error_type gui_model_data_usr::recycle(array<uint32_t>&& indices) noexcept
+{
+    if (indices.empty())
+        return error_type();
 
+    ICY_LOCK_GUARD(m_lock);
+    if (m_free_shared.empty())
+    {
+        m_free_shared = std::move(indices);
+        return error_type();
+    }
+    ICY_ERROR(m_free_shared.reserve(m_free_shared.size() + indices.size()));
+    for (auto&& index : indices)
+        ICY_ERROR(m_free_shared.push_back(index));
+    return error_type();
+}
+error_type gui_model_data_usr::next_index(uint32_t& index) noexcept
+{
+    if (m_free.empty())
+    {
+        ICY_LOCK_GUARD(m_lock);
+        std::swap(m_free, m_free_shared);
+    }
+    if (!m_free.empty())
+    {
+        index = m_free.back();
+    }
+    else if (m_slot <= gui_node_pool::slot_mask)
+    {
+        index = m_slot;
+    }
+    else
+    {
+        return make_stdlib_error(std::errc::not_enough_memory);
+    }
+    return error_type();
+}
+void gui_model_data_usr::notify(gui_model_event_type*& event) noexcept
+{
+    if (auto system = shared_ptr<gui_system>(m_system))
+    {
+        m_events_sys.push(event);
+        static_cast<gui_system_data*>(system.get())->wake();
+    }
+    event = nullptr;
+}
 error_type gui_model_data_sys::process(const gui_model_event_type& event, set<uint32_t>& output) noexcept
+{
+    for (auto&& action : event.actions)
+        ICY_ERROR(process(action, output));
+    return process(event.action, output);
+}
+error_type gui_model_data_sys::process(const gui_model_action& event, set<uint32_t>& output) noexcept
 {
     auto bind_node = 0u;
     switch (event.type)
     {
-    case gui_model_event_type::create:
+    case gui_model_action::none:
+        return error_type();
+
+    case gui_model_action::create:
     {
-        std::pair<uint32_t, gui_node_data::child_type> args;
-        if (event.val.get(args))
-        {
-            ICY_ERROR(gui_node_data::insert(m_data, event.index, args.first, args.second));
-            bind_node = event.index;
-        }
+        std::pair<uint32_t, gui_node_pool::child_type> args;
+        if (!event.val.get(args))
+            return error_type();
+
+        if (!m_data.valid(event.index))
+            return m_data.discard(args.first, m_free);
+
+        ICY_ERROR(m_data.insert(event.index, args.first, args.second));
+        bind_node = event.index;
         break;
     }
-    case gui_model_event_type::destroy:
+    case gui_model_action::destroy:
     {
-        if (event.index == 0)
-        {
-            icy::unique_ptr<gui_node_data> root;
-            ICY_ERROR(icy::make_unique(gui_node_data(nullptr, 0), root));
-            m_data.clear();
-            ICY_ERROR(m_data.insert(0u, std::move(root)));                        
-        }
-        else
-        {
-
-            auto it = m_data.find(event.index);
-            if (it == m_data.end())
-                return error_type();
+        if (!m_data.valid(event.index))
+            return error_type();
 
-            auto parent = it->value->parent;
-            gui_node_data::erase(m_data, event.index);
-            if (parent)
-                bind_node = parent->index;
-        }
+        const auto parent = event.index ? m_data.parent(event.index) : 0u;
+        ICY_ERROR(m_data.erase(event.index, m_free));
+        bind_node = parent;
         break;
     }
-    case gui_model_event_type::modify:
+    case gui_model_action::modify:
     {
-        auto it = m_data.find(event.index);
-        if (it == m_data.end())
+        if (!m_data.valid(event.index))
             return error_type();
 
-        ICY_ERROR(it->value->modify(event.prop, event.val));
+        ICY_ERROR(m_data.modify(event.index, event.prop, event.val));
         if (event.prop == gui_node_prop::user || event.prop == gui_node_prop::none)
             return error_type();
 
@@ -363,37 +592,27 @@ error_type gui_model_data_sys::process(const gui_model_event_type& event, set<ui
     while (true)
     {
         ICY_ERROR(output.try_insert(bind_node));
-        if (bind_node == 0)
+        const auto parent = bind_node ? m_data.parent(bind_node) : gui_node_pool::npos;
+        if (parent == gui_node_pool::npos)
             break;
-
-        auto it = m_data.find(bind_node);        
-        if (const auto parent = it->value->parent)
-        {
-            bind_node = parent->index;
-        }
-        else
-        {
-            break;
-        }
+        bind_node = parent;
     }
     
     return error_type();
 }
 error_type gui_model_data_sys::send_data(gui_window_data_sys& window, const gui_widget widget, const gui_node node, const gui_data_bind& func, bool& erase) const noexcept
 {
-    auto it = m_data.find(node.index);
-    if (it == m_data.end())
+    if (!m_data.valid(node.index))
     {
         erase = true;
         return error_type();
     }
-    ICY_ERROR(window.recv_data(gui_model_proxy_read(*this), *it->value, widget, func, erase));
+    ICY_ERROR(window.recv_data(gui_model_proxy_read(*this), node, widget, func, erase));
     return error_type();
 }
-error_type gui_model_data_sys::recv_data(gui_window_data_sys& window, gui_widget_data& widget, const gui_node index, const gui_data_bind& func, bool& erase) noexcept
+error_type gui_model_data_sys::recv_data(gui_window_data_sys& window, gui_widget_data& widget, const gui_node node, const gui_data_bind& func, bool& erase) noexcept
 {
-    auto it = m_data.find(index.index);
-    if (it == m_data.end())
+    if (!m_data.valid(node.index))
     {
         erase = true;
         return error_type();
@@ -401,26 +620,26 @@ error_type gui_model_data_sys::recv_data(gui_window_data_sys& window, gui_widget
     gui_model_proxy_read proxy_read(*this);
     //gui_model_proxy_write proxy_write(*this);
 
-    auto& node = *it->value;
     switch (widget.type)
     {
     case gui_widget_type::edit_line:
     case gui_widget_type::edit_text:
     {
-        node.data = gui_variant();
+        auto& data = m_data.data(node.index);
+        data = gui_variant();
         for (auto&& item : widget.items)
         {
             if (item.type == gui_widget_item_type::text && gui_node_state_isset(item.state, gui_node_state::editable))
             {
                 auto decline = false;
-                ICY_ERROR(func.notify(proxy_read, { node.index }, gui_node_prop::data, item.value, decline));
+                ICY_ERROR(func.notify(proxy_read, node, gui_node_prop::data, item.value, decline));
                 if (!decline)
                 {
-                    node.data = item.value;
+                    data = item.value;
                 }
                 else
                 {
-                    item.value = node.data;
+                    item.value = data;
                     ICY_ERROR(window.reset(gui_reset_reason::update_render_list));
                 }
                 break;
@@ -434,30 +653,25 @@ error_type gui_model_data_sys::recv_data(gui_window_data_sys& window, gui_widget
         {
             if (item.type == gui_widget_item_type::text)
             {
-                gui_node_data* child = nullptr;
-                for (auto&& pair : node.children)
-                {
-                    if (pair.key->index == item.node)
-                    {
-                        child = pair.key;
-                        break;
-                    }
-                }
-                if (!child)
+                auto child = m_data.first_child(node.index);
+                while (child != gui_node_pool::npos && child != item.node)
+                    child = m_data.next_sibling(child);
+                if (child == gui_node_pool::npos)
                     continue;
 
+                auto& state = m_data.state(node.index);
                 const auto item_select = gui_node_state_isset(item.state, gui_node_state::selected);
-                const auto node_select = gui_node_state_isset(child->state, gui_node_state::selected);
+                const auto node_select = gui_node_state_isset(m_data.state(child), gui_node_state::selected);
                 if (item_select != node_select)
                 {
                     auto decline = false;
-                    ICY_ERROR(func.notify(proxy_read, { node.index }, gui_node_prop::selected, item_select, decline));
+                    ICY_ERROR(func.notify(proxy_read, node, gui_node_prop::selected, item_select, decline));
                     if (!decline)
                     {
                         if (item_select)
-                            gui_node_state_set(node.state, gui_node_state::selected);
+                            gui_node_state_set(state, gui_node_state::selected);
                         else
-                            gui_node_state_unset(node.state, gui_node_state::selected);
+                            gui_node_state_unset(state, gui_node_state::selected);
                     }
                     else
                     {
@@ -488,64 +702,25 @@ error_type gui_model_data_sys::recv_data(gui_window_data_sys& window, gui_widget
 }
 gui_node gui_model_data_sys::parent(const gui_node node) const noexcept
 {
-    const auto it = m_data.find(node.index);
-    if (it != m_data.end())
+    if (m_data.valid(node.index))
     {
-        if (const auto parent = it->value->parent)
-            return { parent->index };
+        const auto parent = m_data.parent(node.index);
+        if (parent != gui_node_pool::npos)
+            return { parent };
     }
     return gui_node();
 }
 uint32_t gui_model_data_sys::row(const gui_node node) const noexcept
 {
-    const auto it = m_data.find(node.index);
-    if (it != m_data.end())
-    {
-        if (const auto parent = it->value->parent)
-        {
-            const auto jt = parent->children.find(it->value.get());
-            if (jt != parent->children.end())
-                return jt->value.row;
-        }
-    }
-    return 0u;
+    return m_data.valid(node.index) ? m_data.row(node.index) : 0u;
 }
 uint32_t gui_model_data_sys::col(const gui_node node) const noexcept
 {
-    const auto it = m_data.find(node.index);
-    if (it != m_data.end())
-    {
-        if (const auto parent = it->value->parent)
-        {
-            const auto jt = parent->children.find(it->value.get());
-            if (jt != parent->children.end())
-                return jt->value.col;
-        }
-    }
-    return 0u;
+    return m_data.valid(node.index) ? m_data.col(node.index) : 0u;
 }
 gui_variant gui_model_data_sys::query(const gui_node node, const gui_node_prop prop) const noexcept
 {
-    auto it = m_data.find(node.index);
-    if (it != m_data.end())
-    {
-        switch (prop)
-        {
-        case gui_node_prop::enabled:
-            return gui_node_state_isset(it->value->state, gui_node_state::enabled);
-        case gui_node_prop::selected:
-            return gui_node_state_isset(it->value->state, gui_node_state::selected);
-        case gui_node_prop::visible:
-            return gui_node_state_isset(it->value->state, gui_node_state::visible);
-        case gui_node_prop::checked:
-            return gui_node_state_isset(it->value->state, gui_node_state::checked);
-        case gui_node_prop::checkable:
-            return gui_node_state_isset(it->value->state, gui_node_state::enabled);
-        case gui_node_prop::data:
-            return it->value->data;
-        case gui_node_prop::user:
-            return it->value->user;
-        }
-    }
+    if (m_data.valid(node.index))
+        return m_data.query(node.index, prop);
     return gui_variant();
 }
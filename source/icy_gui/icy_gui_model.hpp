@@ -31,45 +31,144 @@ inline bool gui_node_state_isset(const gui_node_state lhs, const gui_node_state
     return !!(uint32_t(lhs) & uint32_t(rhs));
 }
 
-struct gui_node_data
+//  Flat node storage shared by the model, its proxies and binds. A node handle (gui_node::index)
+//  is "generation << slot_bits | slot"; slot 0 is the root. Tree links, placement and state are
+//  parallel arrays indexed by slot; "data" is a dense column, "user" and the headers are sparse.
+class gui_node_pool
 {
 public:
+    enum : uint32_t
+    {
+        slot_bits = 24,
+        slot_mask = (1u << slot_bits) - 1,
+        npos = UINT32_MAX,
+    };
     struct child_type
     {
         uint32_t row;
         uint32_t col;
     };
+    static uint32_t slot(const uint32_t index) noexcept
+    {
+        return index & slot_mask;
+    }
+    //  handle the slot of "index" gets once it is freed (stale handles then fail "valid")
+    static uint32_t next_index(const uint32_t index) noexcept
+    {
+        const auto generation = ((index >> slot_bits) + 1) & (UINT32_MAX >> slot_bits);
+        return ((generation ? generation : 1) << slot_bits) | slot(index);
+    }
 public:
-    static icy::error_type insert(icy::map<uint32_t, icy::unique_ptr<gui_node_data>>& map, const uint32_t parent, const uint32_t index, const child_type& args) noexcept;
-    static void erase(icy::map<uint32_t, icy::unique_ptr<gui_node_data>>& map, const uint32_t index) noexcept;
-    gui_node_data(const gui_node_data* const parent, const uint32_t index) noexcept : parent(parent), index(index)
+    icy::error_type initialize() noexcept;
+    bool valid(const uint32_t index) const noexcept
     {
-
+        const auto k = slot(index);
+        return k < m_index.size() && m_index[k] == index && m_parent[k] != npos - 1;
+    }
+    size_t size() const noexcept
+    {
+        return m_size;
+    }
+    //  bytes held by the pool (capacity, not just live nodes)
+    size_t memory() const noexcept;
+    icy::error_type insert(const uint32_t parent, const uint32_t index, const child_type& args) noexcept;
+    //  "index" was handed out for a node that will never be inserted (its parent is gone)
+    icy::error_type discard(const uint32_t index, icy::array<uint32_t>& freed) noexcept;
+    //  appends the "next_index" handles of all freed slots to "freed"
+    icy::error_type erase(const uint32_t index, icy::array<uint32_t>& freed) noexcept;
+    icy::error_type modify(const uint32_t index, const icy::gui_node_prop prop, const icy::gui_variant& value) noexcept;
+    icy::gui_variant query(const uint32_t index, const icy::gui_node_prop prop) const noexcept;
+    //  accessors below take valid handles; tree walk returns "npos" past the end (children in insertion order)
+    uint32_t parent(const uint32_t index) const noexcept
+    {
+        const auto k = m_parent[slot(index)];
+        return k < npos - 1 ? m_index[k] : npos;
+    }
+    uint32_t first_child(const uint32_t index) const noexcept
+    {
+        const auto k = m_first[slot(index)];
+        return k != npos ? m_index[k] : npos;
+    }
+    uint32_t next_sibling(const uint32_t index) const noexcept
+    {
+        const auto k = m_next[slot(index)];
+        return k != npos ? m_index[k] : npos;
+    }
+    uint32_t row(const uint32_t index) const noexcept
+    {
+        return m_child[slot(index)].row;
+    }
+    uint32_t col(const uint32_t index) const noexcept
+    {
+        return m_child[slot(index)].col;
+    }
+    gui_node_state state(const uint32_t index) const noexcept
+    {
+        return m_state[slot(index)];
+    }
+    gui_node_state& state(const uint32_t index) noexcept
+    {
+        return m_state[slot(index)];
+    }
+    const icy::gui_variant& data(const uint32_t index) const noexcept
+    {
+        return m_data[slot(index)];
     }
-    icy::error_type modify(const icy::gui_node_prop prop, const icy::gui_variant& value) noexcept;
-    const gui_node_data* parent;
-    uint32_t index;
-    mutable icy::map<gui_node_data*, child_type> children;
-    gui_node_state state = gui_node_state::_default;
-    icy::gui_variant data;
-    icy::gui_variant user;
-    icy::gui_variant row_header;
-    icy::gui_variant col_header;
+    icy::gui_variant& data(const uint32_t index) noexcept
+    {
+        return m_data[slot(index)];
+    }
+    const icy::gui_variant& user(const uint32_t index) const noexcept
+    {
+        return find(m_user, index);
+    }
+    const icy::gui_variant& row_header(const uint32_t index) const noexcept
+    {
+        return find(m_row_header, index);
+    }
+    const icy::gui_variant& col_header(const uint32_t index) const noexcept
+    {
+        return find(m_col_header, index);
+    }
+private:
+    static const icy::gui_variant& find(const icy::map<uint32_t, icy::gui_variant>& map, const uint32_t index) noexcept;
+    static icy::error_type assign(icy::map<uint32_t, icy::gui_variant>& map, const uint32_t index, const icy::gui_variant& value) noexcept;
+    icy::error_type resize(const size_t size) noexcept;
+    void unlink(const uint32_t k) noexcept;
+private:
+    icy::array<uint32_t> m_index;       //  current handle of each slot
+    icy::array<uint32_t> m_parent;      //  slot; "npos - 1" marks a free slot, "npos" the root
+    icy::array<uint32_t> m_first;
+    icy::array<uint32_t> m_last;
+    icy::array<uint32_t> m_next;
+    icy::array<uint32_t> m_prev;
+    icy::array<child_type> m_child;
+    icy::array<gui_node_state> m_state;
+    icy::array<icy::gui_variant> m_data;
+    icy::map<uint32_t, icy::gui_variant> m_user;
+    icy::map<uint32_t, icy::gui_variant> m_row_header;
+    icy::map<uint32_t, icy::gui_variant> m_col_header;
+    size_t m_size = 0;
 };
-struct gui_model_event_type
+struct gui_model_action
 {
-    void* _unused = nullptr;
-    enum{ none, create, modify, destroy } type = none;
+    enum { none, create, modify, destroy } type = none;
     uint32_t index = 0;
     icy::gui_node_prop prop = icy::gui_node_prop::none;
     icy::gui_variant val;
-    static icy::error_type make(gui_model_event_type*& new_event, const decltype(none) type) noexcept
+};
+struct gui_model_event_type
+{
+    void* _unused = nullptr;
+    gui_model_action action;
+    icy::array<gui_model_action> actions;   //  transaction block: applied in order before "action"
+    static icy::error_type make(gui_model_event_type*& new_event, const decltype(gui_model_action::none) type) noexcept
     {
         new_event = icy::allocator_type::allocate<gui_model_event_type>(1);
         if (!new_event)
             return icy::make_stdlib_error(std::errc::not_enough_memory);
         icy::allocator_type::construct(new_event);
-        new_event->type = type;
+        new_event->action.type = type;
         return icy::error_type();
     }
     static void clear(gui_model_event_type*& new_event) noexcept
@@ -82,12 +181,6 @@ struct gui_model_event_type
         new_event = nullptr;
     }
 };
-struct gui_model_query_type
-{
-    enum { none, index, row, col, qprop } type = none;
-    const gui_node_data* node = nullptr;
-    icy::gui_node_prop prop = icy::gui_node_prop::none;
-};
 class gui_model_data_usr : public icy::gui_data_write_model
 {
 public:
@@ -98,15 +191,15 @@ public:
     ~gui_model_data_usr() noexcept;
     icy::error_type initialize() noexcept
     {
-        //icy::unique_ptr<gui_node_data> root;
-        //ICY_ERROR(icy::make_unique(gui_node_data(nullptr, 0), root));
-        //ICY_ERROR(m_data.insert(0u, std::move(root)));
+        ICY_ERROR(m_lock.initialize());
         return icy::error_type();
     }
     gui_model_event_type* next() noexcept
     {
         return static_cast<gui_model_event_type*>(m_events_sys.pop());
     }
+    //  node handles freed by the GUI thread, handed out again by "insert"
+    icy::error_type recycle(icy::array<uint32_t>&& indices) noexcept;
 private:
     //icy::error_type update() noexcept override;
     //icy::gui_node parent(const icy::gui_node node) const noexcept override;
@@ -120,14 +213,31 @@ private:
     icy::error_type modify(const icy::gui_node node, const icy::gui_node_prop prop, const icy::gui_variant& value) noexcept override;
     icy::error_type insert(const icy::gui_node parent, const uint32_t row, const uint32_t col, icy::gui_node& node) noexcept override;
     icy::error_type destroy(const icy::gui_node node) noexcept override;
+    icy::error_type begin() noexcept override;
+    icy::error_type commit() noexcept override;
+    icy::error_type append(gui_model_action&& action) noexcept;
+    //  "m_txn_modify" slot holding "key" or the empty slot to store it in (grows the table first)
+    icy::error_type find_modify(const uint64_t key, size_t& slot) noexcept;
+    //  handle the next "insert" uses (consumed once the create action is queued)
+    icy::error_type next_index(uint32_t& index) noexcept;
     void notify(gui_model_event_type*& event) noexcept;
-    icy::gui_variant process(const gui_model_query_type& query) const noexcept;
 private:
     const icy::weak_ptr<icy::gui_system> m_system;
     //icy::detail::intrusive_mpsc_queue m_events_usr;
     icy::detail::intrusive_mpsc_queue m_events_sys;
-    //icy::map<uint32_t, icy::unique_ptr<gui_node_data>> m_data;
-    uint32_t m_index = 1;
+    icy::mutex m_lock;
+    icy::array<uint32_t> m_free_shared;     //  filled by "recycle" (GUI thread)
+    icy::array<uint32_t> m_free;
+    uint32_t m_slot = 1;
+    uint32_t m_txn = 0;
+    gui_model_event_type* m_txn_event = nullptr;
+    struct txn_modify_type
+    {
+        uint64_t key = 0;               //  node << 32 | prop
+        uint32_t offset = UINT32_MAX;   //  in "m_txn_event->actions"; UINT32_MAX: empty slot
+    };
+    icy::array<txn_modify_type> m_txn_modify;   //  open addressing, power of two, at most half full
+    size_t m_txn_modify_size = 0;
 };
 
 struct gui_widget_data;
@@ -137,27 +247,28 @@ class gui_model_data_sys
 public:
     icy::error_type initialize() noexcept
     {
-        icy::unique_ptr<gui_node_data> root;
-        ICY_ERROR(icy::make_unique(gui_node_data(nullptr, 0), root));
-        ICY_ERROR(m_data.insert(0u, std::move(root)));
-        return icy::error_type();
+        return m_data.initialize();
     }
     icy::error_type process(const gui_model_event_type& event, icy::set<uint32_t>& output) noexcept;
+    icy::error_type process(const gui_model_action& action, icy::set<uint32_t>& output) noexcept;
     icy::error_type send_data(gui_window_data_sys& window, const icy::gui_widget widget, const icy::gui_node node, const icy::gui_data_bind& func, bool& erase) const noexcept;
     icy::error_type recv_data(gui_window_data_sys& window, gui_widget_data& widget, const icy::gui_node node, const icy::gui_data_bind& func, bool& erase) noexcept;
     icy::gui_node parent(const icy::gui_node node) const noexcept;
     uint32_t row(const icy::gui_node node) const noexcept;
     uint32_t col(const icy::gui_node node) const noexcept;
     icy::gui_variant query(const icy::gui_node node, const icy::gui_node_prop prop) const noexcept;
-    const gui_node_data* data(const icy::gui_node node) const noexcept
+    const gui_node_pool& data() const noexcept
+    {
+        return m_data;
+    }
+    //  handles freed since the last call (to pass back to gui_model_data_usr::recycle)
+    icy::array<uint32_t> release() noexcept
     {
-        auto it = m_data.find(node.index);
-        if (it != m_data.end())
-            return it->value.get();
-        return nullptr;
+        return std::move(m_free);
     }
 private:
-    icy::map<uint32_t, icy::unique_ptr<gui_node_data>> m_data;
+    gui_node_pool m_data;
+    icy::array<uint32_t> m_free;
 };
 
 
@@ -168,9 +279,9 @@ public:
     {
 
     }
-    const gui_node_data* data(const icy::gui_node node) const noexcept
+    const gui_node_pool& data() const noexcept
     {
-        return m_system.data(node);
+        return m_system.data();
     }
     uint32_t row(const icy::gui_node node) const noexcept override
     {
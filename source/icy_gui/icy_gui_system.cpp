@@ -50,6 +50,7 @@ gui_system_data::~gui_system_data() noexcept
 error_type gui_system_data::initialize() noexcept
 {
     ICY_ERROR(m_sync.initialize());
+    ICY_ERROR(m_stats_lock.initialize());
     ICY_ERROR(make_shared(m_render_system));
     ICY_ERROR(m_render_system->initialize());
     ICY_ERROR(make_shared(m_thread));
@@ -121,12 +122,25 @@ error_type gui_system_data::exec() noexcept
             if (auto usr = shared_ptr<gui_model_data_usr>(pair.user))
             {
                 set<uint32_t> nodes;
+                auto events = 0_z;
+                const auto beg = clock_type::now();
                 while (auto event = usr->next())
                 {
                     ICY_SCOPE_EXIT{ gui_model_event_type::clear(event); };
                     ICY_ERROR(pair.system.process(*event, nodes));
+                    ++events;
                 }
+                ICY_ERROR(usr->recycle(pair.system.release()));
+                const auto mid = clock_type::now();
                 ICY_ERROR(process_binds(pair.user, nodes));
+                if (events)
+                {
+                    ICY_LOCK_GUARD(m_stats_lock);
+                    m_stats.model_events += events;
+                    m_stats.model_nodes += nodes.size();
+                    m_stats.model_time += mid - beg;
+                    m_stats.bind_time += clock_type::now() - mid;
+                }
             }
             else
             {
@@ -491,6 +505,11 @@ error_type gui_system_data::enum_font_names(array<string>& fonts) const noexcept
 {
     return m_render_system->enum_font_names(fonts);
 }
+gui_system_stats gui_system_data::stats() const noexcept
+{
+    ICY_LOCK_GUARD(m_stats_lock);
+    return m_stats;
+}
 error_type gui_system_data::render(gui_window_data_sys& window, icy::gui_event& new_event) noexcept
 {
     ICY_ERROR(window.update());
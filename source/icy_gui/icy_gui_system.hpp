@@ -153,6 +153,7 @@ private:
     icy::error_type create_model(icy::shared_ptr<icy::gui_data_write_model>& model) noexcept override;
     icy::error_type create_window(icy::shared_ptr<icy::gui_window>& window, icy::shared_ptr<icy::window> handle, const icy::string_view json) noexcept override;
     icy::error_type enum_font_names(icy::array<icy::string>& fonts) const noexcept override;
+    icy::gui_system_stats stats() const noexcept override;
     icy::error_type render(gui_window_data_sys& window, icy::gui_event& new_event) noexcept; 
     icy::error_type process_binds(icy::weak_ptr<gui_model_data_usr> model, icy::const_array_view<uint32_t> nodes) noexcept;
     icy::error_type process_binds(const window_pair& window) noexcept;
@@ -172,6 +173,8 @@ private:
     icy::map<gui_window_data_sys*, icy::set<uint32_t>> m_change;
     icy::map<gui_window_data_sys*, std::pair<uint32_t, uint32_t>> m_select;
     icy::map<gui_window_data_sys*, std::pair<uint32_t, uint32_t>> m_context;
+    mutable icy::mutex m_stats_lock;
+    icy::gui_system_stats m_stats;
 };
 namespace icy
 {
@@ -1,4 +1,5 @@
 #include <icy_engine/core/icy_json.hpp>
+#include <icy_engine/core/icy_trace.hpp>
 #include "icy_gui_window.hpp"
 #include "icy_gui_system.hpp"
 #include "icy_gui_render.hpp"
@@ -675,6 +676,8 @@ error_type gui_window_data_sys::update() noexcept
 {
     if (m_state & gui_window_state_updated)
         return error_type();
+
+    ICY_TRACE_SCOPE("gui_window::update");
     
     const auto alloc = [](void* user, void* ptr, size_t nsize, size_t)
     {
@@ -2327,25 +2330,26 @@ error_type gui_window_data_sys::solve_item(gui_widget_data& widget, gui_widget_i
     }
     return error_type();
 }
-error_type gui_window_data_sys::make_view(const gui_model_proxy_read& proxy, const gui_node_data& node, const gui_data_bind& func, gui_widget_data& widget, const size_t level) noexcept
+error_type gui_window_data_sys::make_view(const gui_model_proxy_read& proxy, const gui_node node, const gui_data_bind& func, gui_widget_data& widget, const size_t level) noexcept
 {
-    array<const gui_node_data*> nodes;
-    for (auto&& child : node.children)
+    const auto& pool = proxy.data();
+    array<uint32_t> nodes;
+    for (auto child = pool.first_child(node.index); child != gui_node_pool::npos; child = pool.next_sibling(child))
     {
-        if (child->value.col != 0)
+        if (pool.col(child) != 0)
             continue;
 
-        if (!(gui_node_state_isset(child->key->state, gui_node_state::visible)))
+        if (!(gui_node_state_isset(pool.state(child), gui_node_state::visible)))
             continue;
 
-        if (!func.filter(proxy, gui_node{ child->key->index }))
+        if (!func.filter(proxy, gui_node{ child }))
             continue;
 
-        ICY_ERROR(nodes.push_back(child.key));
+        ICY_ERROR(nodes.push_back(child));
     }
-    const auto pred = [&proxy, &func](const gui_node_data*& lhs, const gui_node_data*& rhs)
+    const auto pred = [&proxy, &func](const uint32_t lhs, const uint32_t rhs)
     {
-        return func.compare(proxy, gui_node{ lhs->index }, gui_node{ rhs->index }) < 0;
+        return func.compare(proxy, gui_node{ lhs }, gui_node{ rhs }) < 0;
     };
     std::sort(nodes.begin(), nodes.end(), pred);
 
@@ -2360,14 +2364,14 @@ error_type gui_window_data_sys::make_view(const gui_model_proxy_read& proxy, con
     {
         gui_widget_item new_item;
         new_item.type = gui_widget_item_type::text;
-        new_item.value = child->data;
+        new_item.value = pool.data(child);
         ICY_ERROR(solve_item(widget, new_item, m_font));
         if (new_item.text)
         {
             new_item.x = widget.size_x;
             new_item.y = widget.size_y;
-            new_item.node = child->index;
-            new_item.state = child->state;
+            new_item.node = child;
+            new_item.state = pool.state(child);
 
             ICY_ERROR(widget.items.push_back(std::move(new_item)));
             if (widget.type == gui_widget_type::view_tabs)
@@ -2380,7 +2384,7 @@ error_type gui_window_data_sys::make_view(const gui_model_proxy_read& proxy, con
                 if (widget.type == gui_widget_type::view_tree)
                 {
                     widget.size_x += offset;
-                    ICY_ERROR(make_view(proxy, *child, func, widget, level + 1));
+                    ICY_ERROR(make_view(proxy, gui_node{ child }, func, widget, level + 1));
                     widget.size_x -= offset;
                 }
             }
@@ -2400,16 +2404,15 @@ error_type gui_window_data_sys::make_view(const gui_model_proxy_read& proxy, con
 
         for (auto&& item : widget.items)
         {
-            const auto node = proxy.data(gui_node{ item.node });
-            if (!node)
+            if (!pool.valid(item.node))
                 continue;
 
             const auto item_index = uint32_t(std::distance(widget.items.data(), &item));
-            if (node->row_header)
+            if (const auto& row_header = pool.row_header(item.node))
             {
                 gui_widget_item new_item;
                 new_item.type = gui_widget_item_type::row_header;
-                new_item.value = node->row_header;
+                new_item.value = row_header;
                 new_item.state = gui_node_state::enabled;
                 ICY_ERROR(solve_item(widget, new_item, m_font));
                 if (new_item.text)
@@ -2421,51 +2424,54 @@ error_type gui_window_data_sys::make_view(const gui_model_proxy_read& proxy, con
                     ICY_ERROR(row_headers.insert(item_index, std::move(new_item)));
                 }
             }
-            const auto add_col_header = [this, &col_headers, &widget](const uint32_t col, const gui_node_data& node)
+            const auto add_col_header = [this, &pool, &col_headers, &widget](const uint32_t col, const uint32_t node)
             {
-                if (node.col_header && col_headers.try_find(col) == nullptr)
+                const auto& col_header = pool.col_header(node);
+                if (col_header && col_headers.try_find(col) == nullptr)
                 {
                     gui_widget_item new_item;
                     new_item.type = gui_widget_item_type::col_header;
-                    new_item.value = node.col_header;
+                    new_item.value = col_header;
                     gui_node_state_set(new_item.state, gui_node_state::enabled);
                     ICY_ERROR(solve_item(widget, new_item, m_font));
                     if (new_item.text)
                     {
                         gui_widget_state_set(widget.state, gui_widget_state::has_col_header);
                         widget.col_header = std::max(widget.col_header, new_item.h);
-                        new_item.node = node.index;
+                        new_item.node = node;
                         ICY_ERROR(col_headers.insert(col, std::move(new_item)));
                     }
                 }
                 return error_type();
             };
-            ICY_ERROR(add_col_header(0u, *node));
+            ICY_ERROR(add_col_header(0u, item.node));
 
-            if (node->parent)
+            const auto parent = pool.parent(item.node);
+            if (parent != gui_node_pool::npos)
             {
-                const auto row = proxy.row(gui_node{ item.node });
-                for (auto&& pair : node->parent->children)
+                const auto row = pool.row(item.node);
+                for (auto child = pool.first_child(parent); child != gui_node_pool::npos; child = pool.next_sibling(child))
                 {
-                    if (pair.value.row == row && pair.value.col != 0)
+                    const auto col = pool.col(child);
+                    if (pool.row(child) == row && col != 0)
                     {
-                        ICY_ERROR(add_col_header(pair.value.col, *pair.key));
-                        if (!gui_node_state_isset(pair.key->state, gui_node_state::visible))
+                        ICY_ERROR(add_col_header(col, child));
+                        if (!gui_node_state_isset(pool.state(child), gui_node_state::visible))
                             continue;
                         
                         gui_widget_item new_item;
                         new_item.type = gui_widget_item_type::text;
-                        new_item.value = pair.key->data;
-                        new_item.state = pair.key->state;
+                        new_item.value = pool.data(child);
+                        new_item.state = pool.state(child);
                         ICY_ERROR(solve_item(widget, new_item, m_font));
                         if (new_item.text)
                         {
                             new_item.y = item.y;
                             new_item.node = item.node;
-                            auto jt = cols.find(pair.value.col);
+                            auto jt = cols.find(col);
                             if (jt == cols.end())
                             {
-                                ICY_ERROR(cols.insert(pair.value.col, map<uint32_t, gui_widget_item>(), &jt));
+                                ICY_ERROR(cols.insert(col, map<uint32_t, gui_widget_item>(), &jt));
                             }
                             ICY_ERROR(jt->value.insert(item_index, std::move(new_item)));
                         }
@@ -2515,8 +2521,8 @@ error_type gui_window_data_sys::append_menu() noexcept
     if (!model)
         return error_type();
 
-    const auto node_data = model->data(m_menu.nodes.back());
-    if (!node_data)
+    const auto node = m_menu.nodes.back();
+    if (!model->data().valid(node.index))
         return error_type();
 
     gui_widget_data widget(&m_menu.root, uint32_t(m_menu.widgets.size() + 1));
@@ -2525,7 +2531,7 @@ error_type gui_window_data_sys::append_menu() noexcept
     ICY_ERROR(widget.attr.insert(gui_widget_attr::bkcolor, colors::navy));
     gui_widget_state_unset(widget.state, gui_widget_state::vscroll_auto);
     gui_widget_state_unset(widget.state, gui_widget_state::hscroll_auto);
-    ICY_ERROR(make_view(*model, *node_data, gui_data_bind(), widget));
+    ICY_ERROR(make_view(*model, node, gui_data_bind(), widget));
     ICY_ERROR(m_menu.widgets.push_back(std::move(widget)));
     m_menu.root.children.clear();
     for (auto&& child : m_menu.widgets)
@@ -2755,8 +2761,7 @@ error_type gui_window_data_sys::process(const gui_window_event_type& event) noex
             auto model = m_system->model(pair.first);
             if (model)
             {
-                const auto node_data = model->data(pair.second);
-                if (node_data)
+                if (model->data().valid(pair.second.index))
                 {
                     m_menu.point_x = float(m_last_x);
                     m_menu.point_y = float(m_last_y);
@@ -2794,7 +2799,7 @@ error_type gui_window_data_sys::send_data(gui_model_data_sys& model, const gui_w
     ICY_ERROR(model.recv_data(*this, *it->value, node, func, erase));
     return error_type();
 }
-error_type gui_window_data_sys::recv_data(const gui_model_proxy_read& proxy, const gui_node_data& node, const gui_widget index, const gui_data_bind& func, bool& erase) noexcept
+error_type gui_window_data_sys::recv_data(const gui_model_proxy_read& proxy, const gui_node node, const gui_widget index, const gui_data_bind& func, bool& erase) noexcept
 {
     auto it = m_data.find(index.index);
     if (it == m_data.end())
@@ -2829,9 +2834,9 @@ error_type gui_window_data_sys::recv_data(const gui_model_proxy_read& proxy, con
             if (item.type == gui_widget_item_type::text)
             {
                 item.text = gui_text();
-                if (gui_node_state_isset(node.state, gui_node_state::visible) && func.filter(proxy, gui_node{ node.index }))
+                if (gui_node_state_isset(proxy.data().state(node.index), gui_node_state::visible) && func.filter(proxy, node))
                 {
-                    item.value = node.data;
+                    item.value = proxy.data().data(node.index);
                 }
                 else
                 {
@@ -2848,7 +2853,7 @@ error_type gui_window_data_sys::recv_data(const gui_model_proxy_read& proxy, con
     case gui_widget_type::view_tabs:
     {
         reset_items();
-        if (gui_node_state_isset(node.state, gui_node_state::visible) && func.filter(proxy, gui_node{ node.index }))
+        if (gui_node_state_isset(proxy.data().state(node.index), gui_node_state::visible) && func.filter(proxy, node))
         {
             ICY_ERROR(make_view(proxy, node, func, widget));
         }
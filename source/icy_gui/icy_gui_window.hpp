@@ -258,7 +258,6 @@ private:
     uint32_t m_index = 1;
 };
 
-struct gui_node_data;
 class gui_model_data_sys;
 class gui_window_data_sys
 {
@@ -295,7 +294,7 @@ public:
     }
     icy::window_size size(const uint32_t widget) const noexcept;
     icy::error_type send_data(gui_model_data_sys& model, const icy::gui_widget widget, const icy::gui_node node, const icy::gui_data_bind& func, bool& erase) noexcept;
-    icy::error_type recv_data(const gui_model_proxy_read& proxy, const gui_node_data& node, const icy::gui_widget widget, const icy::gui_data_bind& func, bool& erase) noexcept;
+    icy::error_type recv_data(const gui_model_proxy_read& proxy, const icy::gui_node node, const icy::gui_widget widget, const icy::gui_data_bind& func, bool& erase) noexcept;
     icy::error_type timer(icy::timer::pair& pair) noexcept;
     icy::error_type reset(const gui_reset_reason reason) noexcept;
 private:
@@ -412,7 +411,7 @@ private:
     icy::error_type input_mouse_double(const icy::key key, const int32_t px, const int32_t py, const icy::key_mod mods) noexcept;
     icy::error_type input_text(const icy::string_view text) noexcept;
     icy::error_type solve_item(gui_widget_data& widget, gui_widget_item& item, const gui_font& font) noexcept;
-    icy::error_type make_view(const gui_model_proxy_read& proxy, const gui_node_data& node, const icy::gui_data_bind& func, gui_widget_data& widget, size_t level = 0) noexcept;
+    icy::error_type make_view(const gui_model_proxy_read& proxy, const icy::gui_node node, const icy::gui_data_bind& func, gui_widget_data& widget, size_t level = 0) noexcept;
     icy::error_type append_menu() noexcept;
     icy::error_type push_action(gui_widget_data& widget, gui_text_action& action) noexcept;
     icy::error_type exec_action(gui_widget_data& widget, gui_text_action& action) noexcept;
@@ -17,6 +17,40 @@
 
 struct css_computed_style *table_s[TS_SIZE];
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+
+static volatile long arena_lock;
+
+void css__arena_lock(void)
+{
+	while (_InterlockedExchange(&arena_lock, 1) != 0) {
+		while (arena_lock != 0)
+			_mm_pause();
+	}
+}
+
+void css__arena_unlock(void)
+{
+	_InterlockedExchange(&arena_lock, 0);
+}
+#else
+static int arena_lock;
+
+void css__arena_lock(void)
+{
+	while (__atomic_exchange_n(&arena_lock, 1, __ATOMIC_ACQUIRE) != 0) {
+		while (__atomic_load_n(&arena_lock, __ATOMIC_RELAXED) != 0)
+			;
+	}
+}
+
+void css__arena_unlock(void)
+{
+	__atomic_store_n(&arena_lock, 0, __ATOMIC_RELEASE);
+}
+#endif
+
 
 static inline uint32_t css__arena_hash_style(struct css_computed_style *s)
 {
@@ -149,6 +183,7 @@ static inline bool css__arena_style_is_equal(
 css_error css__arena_intern_style(struct css_computed_style **style)
 {
 	struct css_computed_style *s = *style;
+	struct css_computed_style *existing = NULL;
 	uint32_t hash, index;
 
 	/* Don't try to intern an already-interned computed style */
@@ -161,6 +196,7 @@ css_error css__arena_intern_style(struct css_computed_style **style)
 	index = hash % TS_SIZE;
 	s->bin = index;
 
+	css__arena_lock();
 	if (table_s[index] == NULL) {
 		/* Can just insert */
 		table_s[index] = s;
@@ -168,7 +204,6 @@ css_error css__arena_intern_style(struct css_computed_style **style)
 	} else {
 		/* Check for existing */
 		struct css_computed_style *l = table_s[index];
-		struct css_computed_style *existing = NULL;
 
 		do {
 			if (css__arena_style_is_equal(l, s)) {
@@ -179,7 +214,6 @@ css_error css__arena_intern_style(struct css_computed_style **style)
 		} while (l != NULL);
 
 		if (existing != NULL) {
-			css_computed_style_destroy(s);
 			existing->count++;
 			*style = existing;
 		} else {
@@ -189,6 +223,12 @@ css_error css__arena_intern_style(struct css_computed_style **style)
 			s->count = 1;
 		}
 	}
+	css__arena_unlock();
+
+	/* Not interned, so destroying takes the lock only to read the count */
+	if (existing != NULL) {
+		css_computed_style_destroy(s);
+	}
 
 	return CSS_OK;
 }
@@ -31,5 +31,15 @@ enum css_error css__arena_intern_style(struct css_computed_style **style);
  */
 enum css_error css__arena_remove_style(struct css_computed_style *style);
 
+/*
+ * Serialise access to the arena and to computed style reference counts
+ *
+ * The arena is shared by every selection context, so this is what lets
+ * styles be selected, composed and destroyed on several threads at once.
+ * Interning takes the lock itself; removal expects the caller to hold it.
+ */
+void css__arena_lock(void);
+void css__arena_unlock(void);
+
 #endif
 
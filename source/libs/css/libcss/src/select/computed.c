@@ -94,13 +94,16 @@ css_error css_computed_style_destroy(css_computed_style *style)
 	if (style == NULL)
 		return CSS_BADPARM;
 
+	css__arena_lock();
 	if (style->count > 1) {
 		style->count--;
+		css__arena_unlock();
 		return CSS_OK;
 
 	} else if (style->count == 1) {
 		css__arena_remove_style(style);
 	}
+	css__arena_unlock();
 
 	if (style->counter_increment != NULL) {
 		css_computed_counter *c;
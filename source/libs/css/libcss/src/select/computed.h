@@ -11,6 +11,7 @@
 #include <libcss/computed.h>
 #include <libcss/hint.h>
 #include "autogenerated_computed.h"
+#include "select/arena.h"
 
 /**
  * Take a new reference to a computed style
@@ -24,7 +25,9 @@ static inline css_computed_style * css__computed_style_ref(
 	if (style == NULL)
 		return NULL;
 
+	css__arena_lock();
 	style->count++;
+	css__arena_unlock();
 	return style;
 }
 
@@ -644,7 +644,7 @@ static css_error css__create_node_bloom(lwc_context* ctx,
 	if (bloom == NULL) {
 		return CSS_NOMEM;
 	}
-	memset(bloom, sizeof(css_bloom) * CSS_BLOOM_SIZE, 0);
+	memset(bloom, 0, sizeof(css_bloom) * CSS_BLOOM_SIZE);
 
 	/* Add node name to bloom */
 	if (lwc_string_caseless_hash_value(ctx, state->element.name,
@@ -9,6 +9,10 @@
 #ifndef libwapcaplet_h_
 #define libwapcaplet_h_
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -25,6 +29,19 @@ extern "C"
 	 */
 	typedef uint32_t lwc_refcounter;
 
+	/**
+	 * Reference counts are updated atomically, so strings may be reffed and
+	 * unreffed from several threads.  Interning and destroying strings still
+	 * needs a single thread (or strings kept alive by another reference).
+	 */
+#if defined(_MSC_VER)
+#define lwc__refcnt_inc(ptr) ((lwc_refcounter)_InterlockedIncrement((volatile long*)(ptr)))
+#define lwc__refcnt_dec(ptr) ((lwc_refcounter)_InterlockedDecrement((volatile long*)(ptr)))
+#else
+#define lwc__refcnt_inc(ptr) __atomic_add_fetch((ptr), 1, __ATOMIC_RELAXED)
+#define lwc__refcnt_dec(ptr) __atomic_sub_fetch((ptr), 1, __ATOMIC_ACQ_REL)
+#endif
+
 	/**
 	 * The type of a hash value used in libwapcaplet.
 	 */
@@ -158,7 +175,7 @@ extern "C"
 	{
 		lwc_string* __lwc_s = (str);
 		assert(__lwc_s != NULL);
-		__lwc_s->refcnt++;
+		lwc__refcnt_inc(&__lwc_s->refcnt);
 		return __lwc_s;
 	}
 
@@ -179,10 +196,11 @@ extern "C"
 	static inline void lwc_string_unref(lwc_context* ctx, lwc_string* str)
 	{
 		lwc_string* __lwc_s = (str);
+		lwc_refcounter __lwc_n;
 		assert(__lwc_s != NULL);
-		__lwc_s->refcnt--;
-		if ((__lwc_s->refcnt == 0) ||
-			((__lwc_s->refcnt == 1) && (__lwc_s->insensitive == __lwc_s)))
+		__lwc_n = lwc__refcnt_dec(&__lwc_s->refcnt);
+		if ((__lwc_n == 0) ||
+			((__lwc_n == 1) && (__lwc_s->insensitive == __lwc_s)))
 			lwc_string_destroy(ctx, __lwc_s);
 	}
 
@@ -95,7 +95,7 @@ lwc__intern(lwc_context* ctx, const char *s, size_t slen,
 	while (str != NULL) {
 		if ((str->hash == h) && (str->len == slen)) {
 			if (compare(CSTR_OF(str), s, slen) == 0) {
-				str->refcnt++;
+				lwc__refcnt_inc(&str->refcnt);
 				*ret = str;
 				return lwc_error_ok;
 			}